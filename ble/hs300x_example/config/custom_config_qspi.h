@@ -44,7 +44,8 @@
  * FreeRTOS configuration
  */
 #define OS_FREERTOS                              /* Define this to use FreeRTOS */
-#define configTOTAL_HEAP_SIZE                    ( 50000 )   /* FreeRTOS Total Heap Size */
+#define configTOTAL_HEAP_SIZE                    ( 42000 )   /* FreeRTOS Total Heap Size */
+#define configSUPPORT_STATIC_ALLOCATION          ( 1 )       /* Application tasks and queues are static */
 
 /*************************************************************************************************\
  * Peripherals configuration
@@ -71,7 +72,22 @@
 #define dg_configBLE_GATT_CLIENT                ( 0 )
 #define dg_configBLE_OBSERVER                   ( 0 )
 #define dg_configBLE_BROADCASTER                ( 0 )
-#define dg_configBLE_L2CAP_COC                  ( 0 )
+#define dg_configBLE_L2CAP_COC                  ( 1 )
+
+/*************************************************************************************************\
+ * Application configuration
+ */
+#define APP_MEASUREMENT_BROADCAST               ( 1 )   /* Latest measurement in advertising data */
+#define APP_ESS_SERVICE                         ( 1 )   /* Environmental Sensing Service alongside the custom service */
+#define APP_BENCHMARK                           ( 0 )   /* Run the hot path benchmarks once at start up */
+#define APP_DIAG_SERVICE                        ( 1 )   /* Read only diagnostics service */
+#define APP_LATENCY_TRACE                       ( 0 )   /* Per stage sample latency percentiles, read from the diagnostics service */
+#define APP_HOTPATH_TRACE                       ( 0 )   /* Cycle count statistics of the hot path, printed every HOTPATH_TRACE_DUMP_INTERVAL samples */
+#define APP_SINGLE_TASK                         ( 0 )   /* Sample the sensor from the BLE task instead of a separate HS3001 task */
+#define APP_UART_STREAM                         ( 0 )   /* Binary sample frames on the console UART at the fastest rate, see sample_stream.h */
+#define APP_ALARM_SERVICE                       ( 1 )   /* Threshold and rate of change alarms, indicated by the alarm service */
+#define APP_STREAM_SERVICE                      ( 1 )   /* Gap free sample stream resumed from the acknowledgement of bonded clients */
+#define APP_ADV_POLICY                          ( 1 )   /* Advertising interval stepped down from fast after boot and disconnection */
 
 
 /* Include bsp default values */
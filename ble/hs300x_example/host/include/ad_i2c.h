@@ -0,0 +1,13 @@
+/*
+ * ad_i2c.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_AD_I2C_H_
+#define HOST_AD_I2C_H_
+
+/* Host build stand-in for the SDK header of the same name */
+#include "host_sdk.h"
+
+#endif /* HOST_AD_I2C_H_ */
@@ -0,0 +1,28 @@
+/*
+ * ad_nvms.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_AD_NVMS_H_
+#define HOST_AD_NVMS_H_
+
+/* Host build stand-in for the SDK header of the same name. Partitions are kept in RAM and start erased. */
+#include <stdint.h>
+
+typedef void *nvms_t;
+
+typedef enum
+{
+    NVMS_FIRMWARE_PART = 1,
+    NVMS_PARAM_PART = 2,
+    NVMS_BIN_PART = 3,
+    NVMS_LOG_PART = 4,
+    NVMS_GENERIC_PART = 5,
+} nvms_partition_id_t;
+
+nvms_t ad_nvms_open(nvms_partition_id_t id);
+int ad_nvms_read(nvms_t handle, uint32_t addr, uint8_t *buf, uint32_t len);
+int ad_nvms_write(nvms_t handle, uint32_t addr, const uint8_t *buf, uint32_t size);
+
+#endif /* HOST_AD_NVMS_H_ */
@@ -0,0 +1,13 @@
+/*
+ * ble_bufops.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_BLE_BUFOPS_H_
+#define HOST_BLE_BUFOPS_H_
+
+/* Host build stand-in for the SDK header of the same name */
+#include "host_ble.h"
+
+#endif /* HOST_BLE_BUFOPS_H_ */
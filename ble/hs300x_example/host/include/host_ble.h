@@ -0,0 +1,233 @@
+/*
+ * host_ble.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_BLE_H_
+#define HOST_BLE_H_
+
+/*
+ * Host build stand-in for the parts of the BLE API used by the services. Attribute values, storage
+ * and sent notifications are kept in tables so the runner can drive the services like a client would
+ * and count what they send. Notifications of services that handle event_sent are also queued, and
+ * only reported sent once the runner receives them with host_ble_receive_event().
+ */
+#include "host_sdk.h"
+
+#define BLE_CONN_IDX_INVALID            (0xFFFF)
+
+typedef enum {
+    BLE_STATUS_OK = 0x00,
+    BLE_ERROR_FAILED = 0x01,
+    BLE_ERROR_NOT_FOUND = 0x06,
+    BLE_ERROR_INS_RESOURCES = 0x0D,
+} ble_error_t;
+
+/* ATT */
+typedef enum {
+    ATT_ERROR_OK = 0x00,
+    ATT_ERROR_READ_NOT_PERMITTED = 0x02,
+    ATT_ERROR_WRITE_NOT_PERMITTED = 0x03,
+    ATT_ERROR_REQUEST_NOT_SUPPORTED = 0x06,
+    ATT_ERROR_INVALID_OFFSET = 0x07,
+    ATT_ERROR_ATTRIBUTE_NOT_LONG = 0x0B,
+    ATT_ERROR_INVALID_VALUE_LENGTH = 0x0D,
+    ATT_ERROR_UNLIKELY = 0x0E,
+    ATT_ERROR_INSUFFICIENT_RESOURCES = 0x11,
+    ATT_ERROR_APPLICATION_ERROR = 0x80,
+    ATT_ERROR_CCC_DESCRIPTOR_IMPROPERLY_CONFIGURED = 0xFD,
+    ATT_ERROR_OUT_OF_RANGE = 0xFF,
+} att_error_t;
+
+typedef enum {
+    ATT_PERM_NONE = 0,
+    ATT_PERM_READ = 1,
+    ATT_PERM_WRITE = 2,
+    ATT_PERM_RW = 3,
+} att_perm_t;
+
+typedef enum {
+    ATT_UUID_16,
+    ATT_UUID_128,
+} att_uuid_type_t;
+
+typedef struct {
+    att_uuid_type_t type;
+    union {
+        uint16_t uuid16;
+        uint8_t uuid128[16];
+    };
+} att_uuid_t;
+
+/* GATT */
+#define GATT_PROP_READ                  (0x02)
+#define GATT_PROP_WRITE_NO_RESP         (0x04)
+#define GATT_PROP_WRITE                 (0x08)
+#define GATT_PROP_NOTIFY                (0x10)
+#define GATT_PROP_INDICATE              (0x20)
+
+#define GATTS_FLAG_CHAR_READ_REQ        (0x01)
+
+#define GATT_CCC_NOTIFICATIONS          (0x0001)
+#define GATT_CCC_INDICATIONS            (0x0002)
+
+#define UUID_GATT_CHAR_USER_DESCRIPTION         (0x2901)
+#define UUID_GATT_CLIENT_CHAR_CONFIGURATION     (0x2902)
+
+typedef enum {
+    GATT_SERVICE_PRIMARY,
+    GATT_SERVICE_SECONDARY,
+} gatt_service_t;
+
+typedef enum {
+    GATT_EVENT_NOTIFICATION = 1,
+    GATT_EVENT_INDICATION = 2,
+} gatt_event_t;
+
+/* Events */
+typedef struct {
+    uint16_t evt_code;
+    uint16_t length;
+} ble_evt_hdr_t;
+
+typedef struct {
+    ble_evt_hdr_t hdr;
+    uint16_t conn_idx;
+} ble_evt_gap_connected_t;
+
+typedef struct {
+    ble_evt_hdr_t hdr;
+    uint16_t conn_idx;
+    uint8_t reason;
+} ble_evt_gap_disconnected_t;
+
+typedef struct {
+    ble_evt_hdr_t hdr;
+    uint16_t conn_idx;
+    uint16_t handle;
+    uint16_t offset;
+} ble_evt_gatts_read_req_t;
+
+typedef struct {
+    ble_evt_hdr_t hdr;
+    uint16_t conn_idx;
+    uint16_t handle;
+    uint16_t offset;
+    uint16_t length;
+    uint8_t value[];
+} ble_evt_gatts_write_req_t;
+
+typedef struct {
+    ble_evt_hdr_t hdr;
+    uint16_t conn_idx;
+    uint16_t handle;
+    gatt_event_t type;
+    bool status;
+} ble_evt_gatts_event_sent_t;
+
+/* GAP */
+#define BLE_GAP_MAX_CONNECTED           (8)
+
+typedef enum {
+    GAP_DEVICE_FILTER_ALL,
+    GAP_DEVICE_FILTER_CONNECTED,
+} gap_device_filter_t;
+
+typedef struct {
+    uint16_t conn_idx;
+    bool connected;
+} gap_device_t;
+
+/* Services */
+typedef struct ble_service ble_service_t;
+
+struct ble_service {
+    uint16_t start_h;
+    uint16_t end_h;
+    void (*connected_evt)(ble_service_t *svc, const ble_evt_gap_connected_t *evt);
+    void (*disconnected_evt)(ble_service_t *svc, const ble_evt_gap_disconnected_t *evt);
+    void (*read_req)(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt);
+    void (*write_req)(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt);
+    void (*event_sent)(ble_service_t *svc, const ble_evt_gatts_event_sent_t *evt);
+    void (*cleanup)(ble_service_t *svc);
+};
+
+void ble_service_add(ble_service_t *svc);
+
+/* GATT server */
+uint16_t ble_gatts_get_num_attr(uint16_t include_svcs, uint16_t chars, uint16_t descs);
+ble_error_t ble_gatts_add_service(const att_uuid_t *uuid, gatt_service_t type, uint16_t num_attrs);
+ble_error_t ble_gatts_add_characteristic(const att_uuid_t *uuid, uint8_t prop, att_perm_t perm,
+                                         uint16_t max_len, uint8_t flags, uint16_t *h_offset,
+                                         uint16_t *h_val_offset);
+ble_error_t ble_gatts_add_descriptor(const att_uuid_t *uuid, att_perm_t perm, uint16_t max_len,
+                                     uint8_t flags, uint16_t *h_offset);
+ble_error_t ble_gatts_register_service(uint16_t *handle, ...);
+ble_error_t ble_gatts_set_value(uint16_t handle, uint16_t length, const void *value);
+ble_error_t ble_gatts_get_value(uint16_t handle, uint16_t *length, void *value);
+ble_error_t ble_gatts_read_cfm(uint16_t conn_idx, uint16_t handle, att_error_t status, uint16_t length,
+                               const void *value);
+ble_error_t ble_gatts_write_cfm(uint16_t conn_idx, uint16_t handle, att_error_t status);
+ble_error_t ble_gatts_send_event(uint16_t conn_idx, uint16_t handle, gatt_event_t type, uint16_t length,
+                                 const void *value);
+
+/* GATT client */
+ble_error_t ble_gattc_get_mtu(uint16_t conn_idx, uint16_t *mtu);
+
+/* GAP */
+ble_error_t ble_gap_get_devices(gap_device_filter_t filter, const void *filter_data, size_t *length,
+                                gap_device_t *gap_devices);
+
+/* Storage */
+ble_error_t ble_storage_get_u16(uint16_t conn_idx, uint16_t key, uint16_t *value);
+ble_error_t ble_storage_get_u32(uint16_t conn_idx, uint16_t key, uint32_t *value);
+ble_error_t ble_storage_put_u32(uint16_t conn_idx, uint16_t key, uint32_t value, bool persistent);
+void ble_storage_remove_all(uint16_t key);
+
+/* UUID */
+void ble_uuid_create16(uint16_t uuid16, att_uuid_t *uuid);
+bool ble_uuid_from_string(const char *str, att_uuid_t *uuid);
+
+/* Buffer operations */
+static inline uint16_t get_u16(const uint8_t *buffer)
+{
+    return buffer[0] | (buffer[1] << 8);
+}
+
+static inline uint32_t get_u32(const uint8_t *buffer)
+{
+    return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+static inline void put_u8_inc(uint8_t **buffer, uint8_t value)
+{
+    *(*buffer)++ = value;
+}
+
+static inline void put_u16_inc(uint8_t **buffer, uint16_t value)
+{
+    put_u8_inc(buffer, value);
+    put_u8_inc(buffer, value >> 8);
+}
+
+static inline void put_u32_inc(uint8_t **buffer, uint32_t value)
+{
+    put_u16_inc(buffer, value);
+    put_u16_inc(buffer, value >> 16);
+}
+
+/* Host runner interface */
+#define HOST_BLE_MAX_EVENT_VALUE        (244)   /* Largest notification received, at an MTU of 247 */
+
+void host_ble_bond(uint16_t conn_idx);
+void host_ble_connect(uint16_t conn_idx);
+void host_ble_disconnect(uint16_t conn_idx);
+uint16_t host_ble_find_attr(uint16_t start_h, uint16_t uuid16);
+uint32_t host_ble_notification_count(uint16_t handle);
+att_error_t host_ble_read(uint16_t conn_idx, uint16_t handle, uint8_t *value, uint16_t *length);
+bool host_ble_receive_event(uint16_t conn_idx, uint16_t *handle, uint8_t *value, uint16_t *length);
+void host_ble_set_mtu(uint16_t conn_idx, uint16_t mtu);
+att_error_t host_ble_write(uint16_t conn_idx, uint16_t handle, const uint8_t *value, uint16_t length);
+
+#endif /* HOST_BLE_H_ */
@@ -0,0 +1,20 @@
+/*
+ * host_clock.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_CLOCK_H_
+#define HOST_CLOCK_H_
+
+#include <stdint.h>
+
+/*
+ * Virtual clock of the host build. Time only moves when the application delays, so a run is
+ * deterministic and takes as long on the host as the CPU work it does, not as long as the sensor
+ * conversions it waits for.
+ */
+void host_clock_advance_us(uint64_t us);
+uint64_t host_clock_now_us(void);
+
+#endif /* HOST_CLOCK_H_ */
@@ -0,0 +1,98 @@
+/*
+ * host_sdk.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_SDK_H_
+#define HOST_SDK_H_
+
+/*
+ * Minimal stand-ins for the SDK10 definitions used by the application sources. Only what the host
+ * build links against is provided. The shim headers next to this file (osal.h, ad_i2c.h, ...) include
+ * it so the application sources build unmodified.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Memory placement attributes have no meaning on the host */
+#define __RETAINED
+#define __RETAINED_RW
+#define __RETAINED_CODE
+
+#define ASSERT_ERROR(a)                 assert(a)
+#define ASSERT_WARNING(a)               assert(a);
+
+#define ARRAY_LENGTH(array)             (sizeof((array)) / sizeof((array)[0]))
+
+/* GPIO */
+typedef enum {
+    HW_GPIO_PORT_0 = 0,
+    HW_GPIO_PORT_1 = 1,
+} HW_GPIO_PORT;
+
+typedef int HW_GPIO_PIN;
+
+#define HW_GPIO_PIN_BITS                (5)
+#define HW_GPIO_PIN_1                   (1)
+#define HW_GPIO_PIN_27                  (27)
+#define HW_GPIO_PIN_28                  (28)
+#define HW_GPIO_POWER_V33               (1)
+
+typedef struct {
+    uint8_t pin;
+    uint8_t mode;
+    uint8_t func;
+    bool high;
+} gpio_config;
+
+/* I2C adapter */
+typedef void *ad_i2c_handle_t;
+
+typedef struct {
+    int id;
+    const void *io;
+    const void *drv;
+} ad_i2c_controller_conf_t;
+
+#define AD_I2C_ERROR_NONE                       (0)
+#define AD_I2C_ERROR_HANDLE_INVALID             (-1)
+#define AD_I2C_ERROR_CONTROLLER_BUSY            (-2)
+#define AD_I2C_ERROR_DRIVER_CONF_INVALID        (-3)
+#define AD_I2C_ERROR_IO_CFG_INVALID             (-4)
+
+#define HW_I2C_ABORT_7B_ADDR_NO_ACK             (0x0001)
+#define HW_I2C_ABORT_10B_ADDR1_NO_ACK           (0x0002)
+#define HW_I2C_ABORT_10B_ADDR2_NO_ACK           (0x0004)
+#define HW_I2C_ABORT_TX_DATA_NO_ACK             (0x0008)
+#define HW_I2C_ABORT_GENERAL_CALL_NO_ACK        (0x0010)
+#define HW_I2C_ABORT_GENERAL_CALL_READ          (0x0020)
+#define HW_I2C_ABORT_START_BYTE_ACK             (0x0080)
+#define HW_I2C_ABORT_10B_READ_NO_RESTART        (0x0400)
+#define HW_I2C_ABORT_MASTER_DISABLED            (0x0800)
+#define HW_I2C_ABORT_ARBITRATION_LOST           (0x1000)
+#define HW_I2C_ABORT_SLAVE_FLUSH_TX_FIFO        (0x2000)
+#define HW_I2C_ABORT_SLAVE_ARBITRATION_LOST     (0x4000)
+#define HW_I2C_ABORT_SLAVE_IN_TX                (0x8000)
+#define HW_I2C_ABORT_SW_ERROR                   (0xFF00)
+
+/*
+ * CMSIS-Core SIMD intrinsics, as the Cortex-M33 executes them. Build with -DHS300x_CONVERT_DSP=1 to run the
+ * DSP code paths on the host, hs300x.c emulates the multiply-accumulates CMSIS-Core does not provide.
+ */
+static inline uint32_t __SSUB16(uint32_t op1, uint32_t op2)
+{
+    uint16_t bottom = (uint16_t)((int16_t)op1 - (int16_t)op2);
+    uint16_t top = (uint16_t)((int16_t)(op1 >> 16) - (int16_t)(op2 >> 16));
+
+    return bottom | ((uint32_t)top << 16);
+}
+
+#define __PKHBT(ARG1, ARG2, ARG3) \
+        ((((uint32_t)(ARG1)) & 0x0000FFFFUL) | ((((uint32_t)(ARG2)) << (ARG3)) & 0xFFFF0000UL))
+
+#endif /* HOST_SDK_H_ */
@@ -0,0 +1,50 @@
+/*
+ * hs300x_sim.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HS300x_SIM_H_
+#define HS300x_SIM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Simulated HS300x on the virtual clock. Follows the datasheet behaviour the driver depends on:
+ *
+ * - programming mode can only be entered within 10 ms of power up. A late enter command is taken
+ *   as a measurement request, as on the real part
+ * - NVM register reads take 120 us before the response is valid, NVM writes take 14 ms during which
+ *   the sensor does not acknowledge its address
+ * - the humidity and temperature resolution registers (bits [11:10]) set the conversion time and the
+ *   number of valid bits in the result, and take effect on exit from programming mode
+ * - a data fetch before the conversion completes, or a second fetch of the same result, returns the
+ *   previous result with the stale status bit set
+ */
+#define HS300x_SIM_PROGRAMMING_WINDOW_us        (10000)
+#define HS300x_SIM_REGISTER_READ_us             (120)
+#define HS300x_SIM_REGISTER_WRITE_us            (14000)
+#define HS300x_SIM_WAKEUP_us                    (100)
+#define HS300x_SIM_NVM_REGISTERS                (0x20)
+
+typedef struct
+{
+    uint32_t measurements;              /**< Conversions started */
+    uint32_t valid_fetches;             /**< Data fetches returning a new result */
+    uint32_t stale_fetches;             /**< Data fetches returning the stale status */
+    uint32_t nacks;                     /**< Transfers not acknowledged */
+    uint32_t nvm_writes;                /**< NVM registers written */
+    uint32_t programming_mode_entries;  /**< Successful programming mode entries */
+} hs300x_sim_stats_t;
+
+int hs300x_sim_i2c_read(uint8_t *buffer, size_t length);
+int hs300x_sim_i2c_write(const uint8_t *buffer, size_t length);
+uint16_t hs300x_sim_get_register(uint8_t reg);
+const hs300x_sim_stats_t *hs300x_sim_get_stats(void);
+void hs300x_sim_reset(uint32_t sensor_id);
+void hs300x_sim_set_environment(float humidity_rh_pct, float temp_deg_c);
+void hs300x_sim_set_power(bool on);
+
+#endif /* HS300x_SIM_H_ */
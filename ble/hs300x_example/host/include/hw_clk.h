@@ -0,0 +1,13 @@
+/*
+ * hw_clk.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_HW_CLK_H_
+#define HOST_HW_CLK_H_
+
+/* Host build stand-in for the SDK header of the same name */
+#include "host_sdk.h"
+
+#endif /* HOST_HW_CLK_H_ */
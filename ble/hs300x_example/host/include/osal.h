@@ -0,0 +1,92 @@
+/*
+ * osal.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_OSAL_H_
+#define HOST_OSAL_H_
+
+/*
+ * Host build stand-in for the SDK OS abstraction layer. The host build is single threaded: mutexes
+ * are no-ops, queues are plain ring buffers and delays advance the virtual clock instead of blocking.
+ * One OS tick is one millisecond.
+ */
+#include "host_sdk.h"
+#include "host_clock.h"
+
+typedef int OS_BASE_TYPE;
+typedef uint32_t OS_TICK_TIME;
+typedef void *OS_TASK;
+typedef void *OS_MUTEX;
+typedef struct host_queue *OS_QUEUE;
+
+#define OS_OK                           (1)
+#define OS_FAIL                         (0)
+
+#define OS_QUEUE_OK                     (1)
+#define OS_QUEUE_FULL                   (0)
+#define OS_QUEUE_EMPTY                  (0)
+#define OS_QUEUE_NO_WAIT                (0)
+#define OS_QUEUE_FOREVER                (0xFFFFFFFF)
+
+#define OS_MUTEX_FOREVER                (0xFFFFFFFF)
+
+#define OS_NOTIFY_SET_BITS              (1)
+#define OS_TASK_NOTIFY_ALL_BITS         (0xFFFFFFFF)
+
+#define OS_ASSERT(a)                    assert(a)
+
+/* Allocations are counted so the runner can check the sample path does not allocate */
+#define OS_MALLOC(size)                 host_os_malloc(size)
+#define OS_FREE(ptr)                    free(ptr)
+
+#define OS_MS_2_TICKS(ms)               (ms)
+#define OS_TICKS_2_MS(ticks)            (ticks)
+#define OS_GET_TICK_COUNT()             ((OS_TICK_TIME)(host_clock_now_us() / 1000))
+#define OS_DELAY_MS(ms)                 host_clock_advance_us((uint64_t)(ms) * 1000)
+#define OS_DELAY(ticks)                 OS_DELAY_MS(ticks)
+
+#define OS_MUTEX_CREATE(mutex)          ((mutex) = (OS_MUTEX)1)
+#define OS_MUTEX_GET(mutex, timeout)    host_os_ok(mutex)
+#define OS_MUTEX_PUT(mutex)             host_os_ok(mutex)
+
+/* Nothing preempts the runner */
+#define OS_ENTER_CRITICAL_SECTION()
+#define OS_LEAVE_CRITICAL_SECTION()
+
+#define OS_GET_CURRENT_TASK()           ((OS_TASK)1)
+#define OS_TASK_NOTIFY(task, value, action) host_os_ok(task)
+/* Nothing else runs to send a notification, so a wait always times out */
+#define OS_TASK_NOTIFY_WAIT(entry_bits, exit_bits, value, ticks) \
+        host_os_notify_timeout((value), (ticks))
+
+#define OS_QUEUE_CREATE(queue, item_size, max_items) \
+        ((queue) = host_queue_create((item_size), (max_items)))
+#define OS_QUEUE_PUT(queue, item, timeout) host_queue_put((queue), (item))
+#define OS_QUEUE_GET(queue, item, timeout) host_queue_get((queue), (item))
+#define OS_QUEUE_MESSAGES_WAITING(queue) host_queue_count(queue)
+
+/* Operations that always succeed in a single threaded build */
+static inline OS_BASE_TYPE host_os_ok(const void *object)
+{
+    (void)object;
+    return OS_OK;
+}
+
+static inline OS_BASE_TYPE host_os_notify_timeout(uint32_t *value, uint32_t ticks)
+{
+    OS_DELAY(ticks);
+    *value = 0;
+    return OS_FAIL;
+}
+
+uint32_t host_os_alloc_count(void);
+void *host_os_malloc(size_t size);
+
+OS_QUEUE host_queue_create(size_t item_size, size_t max_items);
+OS_BASE_TYPE host_queue_put(OS_QUEUE queue, const void *item);
+OS_BASE_TYPE host_queue_get(OS_QUEUE queue, void *item);
+size_t host_queue_count(OS_QUEUE queue);
+
+#endif /* HOST_OSAL_H_ */
@@ -0,0 +1,20 @@
+/*
+ * platform_devices.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOST_PLATFORM_DEVICES_H_
+#define HOST_PLATFORM_DEVICES_H_
+
+/* Host build stand-in for config/platform_devices.h. The devices are defined in hs300x_platform_host.c */
+#include "host_sdk.h"
+
+typedef const ad_i2c_controller_conf_t* i2c_device;
+
+#define I2C_SLAVE_ADDRESS    (0x44)
+
+extern i2c_device hs300x_i2c_config;
+extern gpio_config *hs300x_power_gpio;
+
+#endif /* HOST_PLATFORM_DEVICES_H_ */
@@ -0,0 +1,645 @@
+/*
+ * ble_host.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_ble.h"
+
+#define HOST_BLE_MAX_ATTRS              (128)
+#define HOST_BLE_MAX_VALUE              (32)
+#define HOST_BLE_MAX_SERVICES           (8)
+#define HOST_BLE_MAX_CONNECTIONS        BLE_GAP_MAX_CONNECTED
+#define HOST_BLE_MAX_STORAGE            (64)
+#define HOST_BLE_MAX_READ               (512)
+#define HOST_BLE_MAX_EVENTS             (16)
+#define HOST_BLE_DEFAULT_MTU            (23)
+
+/* Attribute of the GATT database */
+typedef struct
+{
+    uint16_t uuid16;                    // 0 for 128 bit UUIDs
+    uint16_t length;
+    uint8_t value[HOST_BLE_MAX_VALUE];
+    uint32_t notifications;
+} host_ble_attr_t;
+
+/* Storage entry of a connection */
+typedef struct
+{
+    bool in_use;
+    uint16_t conn_idx;
+    uint16_t key;
+    uint32_t value;
+    bool persistent;                    // Kept across connections of a bonded client
+} host_ble_storage_t;
+
+/* Notification or indication waiting to be received by the client */
+typedef struct
+{
+    uint16_t conn_idx;
+    uint16_t handle;
+    gatt_event_t type;
+    uint16_t length;
+    uint8_t value[HOST_BLE_MAX_EVENT_VALUE];
+} host_ble_event_t;
+
+/* Private function prototypes */
+static uint16_t add_attr(const att_uuid_t *uuid);
+static host_ble_storage_t *find_storage(uint16_t conn_idx, uint16_t key);
+static ble_service_t *find_service(uint16_t handle);
+
+/* Private variables */
+static host_ble_attr_t attrs[HOST_BLE_MAX_ATTRS];
+static uint16_t next_handle = 1;
+static uint16_t service_start_h;
+static uint16_t service_handle_count;     // Handles returned by the add functions of the service being added
+static ble_service_t *services[HOST_BLE_MAX_SERVICES];
+static bool connected[HOST_BLE_MAX_CONNECTIONS];
+static bool bonded[HOST_BLE_MAX_CONNECTIONS];
+static uint16_t mtus[HOST_BLE_MAX_CONNECTIONS];
+static host_ble_event_t events[HOST_BLE_MAX_EVENTS];
+static uint32_t events_head;              // Index of the oldest event, the queue wraps
+static uint32_t events_count;
+static host_ble_storage_t storage[HOST_BLE_MAX_STORAGE];
+static att_error_t last_write_status;
+static att_error_t last_read_status;
+static uint8_t last_read_value[HOST_BLE_MAX_READ];
+static uint16_t last_read_length;
+
+/**
+ * \brief Allocate an attribute handle
+ *
+ * \param[in] uuid          UUID of the attribute
+ *
+ * \return handle offset from the start of the service being added
+ */
+static uint16_t add_attr(const att_uuid_t *uuid)
+{
+    uint16_t handle = next_handle++;
+
+    assert(handle < HOST_BLE_MAX_ATTRS);
+    attrs[handle].uuid16 = uuid->type == ATT_UUID_16 ? uuid->uuid16 : 0;
+
+    return handle - service_start_h;
+}
+
+/**
+ * \brief Find the storage entry of a connection and key
+ *
+ * \param[in] conn_idx      connection index
+ * \param[in] key           storage key
+ *
+ * \return pointer to the entry, NULL if not found
+ */
+static host_ble_storage_t *find_storage(uint16_t conn_idx, uint16_t key)
+{
+    for(int i = 0; i < HOST_BLE_MAX_STORAGE; i++)
+    {
+        if(storage[i].in_use && storage[i].conn_idx == conn_idx && storage[i].key == key)
+        {
+            return &storage[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Find the service an attribute handle belongs to
+ *
+ * \param[in] handle        attribute handle
+ *
+ * \return pointer to the service, NULL if not found
+ */
+static ble_service_t *find_service(uint16_t handle)
+{
+    for(int i = 0; i < HOST_BLE_MAX_SERVICES; i++)
+    {
+        if(services[i] && handle >= services[i]->start_h && handle <= services[i]->end_h)
+        {
+            return services[i];
+        }
+    }
+
+    return NULL;
+}
+
+void ble_service_add(ble_service_t *svc)
+{
+    for(int i = 0; i < HOST_BLE_MAX_SERVICES; i++)
+    {
+        if(!services[i])
+        {
+            services[i] = svc;
+            return;
+        }
+    }
+    assert(0);
+}
+
+uint16_t ble_gatts_get_num_attr(uint16_t include_svcs, uint16_t chars, uint16_t descs)
+{
+    return 1 + include_svcs + 2 * chars + descs;
+}
+
+ble_error_t ble_gatts_add_service(const att_uuid_t *uuid, gatt_service_t type, uint16_t num_attrs)
+{
+    service_start_h = next_handle;
+    service_handle_count = 0;
+    add_attr(uuid);
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_add_characteristic(const att_uuid_t *uuid, uint8_t prop, att_perm_t perm,
+                                         uint16_t max_len, uint8_t flags, uint16_t *h_offset,
+                                         uint16_t *h_val_offset)
+{
+    static const att_uuid_t declaration = { .type = ATT_UUID_16, .uuid16 = 0x2803 };
+    uint16_t decl = add_attr(&declaration);
+    uint16_t value = add_attr(uuid);
+
+    service_handle_count++;
+
+    if(h_offset)
+    {
+        *h_offset = decl;
+    }
+    if(h_val_offset)
+    {
+        *h_val_offset = value;
+    }
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_add_descriptor(const att_uuid_t *uuid, att_perm_t perm, uint16_t max_len,
+                                     uint8_t flags, uint16_t *h_offset)
+{
+    uint16_t desc = add_attr(uuid);
+
+    service_handle_count++;
+
+    if(h_offset)
+    {
+        *h_offset = desc;
+    }
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_register_service(uint16_t *handle, ...)
+{
+    va_list ap;
+
+    *handle = service_start_h;
+
+    /*
+     * The list is terminated by a plain 0, which is not a valid pointer vararg on a 64 bit host.
+     * Every handle returned while adding the service is expected, so only that many are read.
+     */
+    va_start(ap, handle);
+    for(uint16_t i = 0; i < service_handle_count; i++)
+    {
+        *va_arg(ap, uint16_t *) += service_start_h;
+    }
+    va_end(ap);
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_set_value(uint16_t handle, uint16_t length, const void *value)
+{
+    if(handle >= HOST_BLE_MAX_ATTRS || length > HOST_BLE_MAX_VALUE)
+    {
+        return BLE_ERROR_FAILED;
+    }
+
+    memcpy(attrs[handle].value, value, length);
+    attrs[handle].length = length;
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_get_value(uint16_t handle, uint16_t *length, void *value)
+{
+    if(handle >= HOST_BLE_MAX_ATTRS)
+    {
+        return BLE_ERROR_FAILED;
+    }
+
+    if(*length > attrs[handle].length)
+    {
+        *length = attrs[handle].length;
+    }
+    memcpy(value, attrs[handle].value, *length);
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_read_cfm(uint16_t conn_idx, uint16_t handle, att_error_t status, uint16_t length,
+                               const void *value)
+{
+    last_read_status = status;
+    last_read_length = length < HOST_BLE_MAX_READ ? length : HOST_BLE_MAX_READ;
+    if(value)
+    {
+        memcpy(last_read_value, value, last_read_length);
+    }
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_write_cfm(uint16_t conn_idx, uint16_t handle, att_error_t status)
+{
+    last_write_status = status;
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_send_event(uint16_t conn_idx, uint16_t handle, gatt_event_t type, uint16_t length,
+                                 const void *value)
+{
+    ble_service_t *svc = find_service(handle);
+
+    if(conn_idx >= HOST_BLE_MAX_CONNECTIONS || !connected[conn_idx] || handle >= HOST_BLE_MAX_ATTRS)
+    {
+        return BLE_ERROR_FAILED;
+    }
+
+    // Services that wait for event_sent get it when the runner receives the event, like from the air
+    if(svc && svc->event_sent)
+    {
+        host_ble_event_t *event;
+
+        if(events_count == HOST_BLE_MAX_EVENTS || length > HOST_BLE_MAX_EVENT_VALUE)
+        {
+            return BLE_ERROR_INS_RESOURCES;
+        }
+
+        event = &events[(events_head + events_count++) % HOST_BLE_MAX_EVENTS];
+        event->conn_idx = conn_idx;
+        event->handle = handle;
+        event->type = type;
+        event->length = length;
+        memcpy(event->value, value, length);
+    }
+
+    attrs[handle].notifications++;
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gattc_get_mtu(uint16_t conn_idx, uint16_t *mtu)
+{
+    if(conn_idx >= HOST_BLE_MAX_CONNECTIONS || !connected[conn_idx])
+    {
+        return BLE_ERROR_NOT_FOUND;
+    }
+    *mtu = mtus[conn_idx];
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_get_devices(gap_device_filter_t filter, const void *filter_data, size_t *length,
+                                gap_device_t *gap_devices)
+{
+    size_t count = 0;
+
+    (void)filter_data;
+
+    // Only connected devices are known to the host build
+    for(uint16_t i = 0; i < HOST_BLE_MAX_CONNECTIONS && count < *length; i++)
+    {
+        if(connected[i])
+        {
+            gap_devices[count].conn_idx = i;
+            gap_devices[count].connected = true;
+            count++;
+        }
+    }
+    *length = count;
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_storage_get_u16(uint16_t conn_idx, uint16_t key, uint16_t *value)
+{
+    host_ble_storage_t *entry = find_storage(conn_idx, key);
+
+    if(!entry)
+    {
+        return BLE_ERROR_NOT_FOUND;
+    }
+    *value = entry->value;
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_storage_get_u32(uint16_t conn_idx, uint16_t key, uint32_t *value)
+{
+    host_ble_storage_t *entry = find_storage(conn_idx, key);
+
+    if(!entry)
+    {
+        return BLE_ERROR_NOT_FOUND;
+    }
+    *value = entry->value;
+
+    return BLE_STATUS_OK;
+}
+
+ble_error_t ble_storage_put_u32(uint16_t conn_idx, uint16_t key, uint32_t value, bool persistent)
+{
+    host_ble_storage_t *entry = find_storage(conn_idx, key);
+
+    for(int i = 0; !entry && i < HOST_BLE_MAX_STORAGE; i++)
+    {
+        if(!storage[i].in_use)
+        {
+            entry = &storage[i];
+            entry->in_use = true;
+            entry->conn_idx = conn_idx;
+            entry->key = key;
+        }
+    }
+
+    if(!entry)
+    {
+        return BLE_ERROR_INS_RESOURCES;
+    }
+    entry->value = value;
+    entry->persistent = persistent;
+
+    return BLE_STATUS_OK;
+}
+
+void ble_storage_remove_all(uint16_t key)
+{
+    for(int i = 0; i < HOST_BLE_MAX_STORAGE; i++)
+    {
+        if(storage[i].key == key)
+        {
+            storage[i].in_use = false;
+        }
+    }
+}
+
+void ble_uuid_create16(uint16_t uuid16, att_uuid_t *uuid)
+{
+    uuid->type = ATT_UUID_16;
+    uuid->uuid16 = uuid16;
+}
+
+bool ble_uuid_from_string(const char *str, att_uuid_t *uuid)
+{
+    memset(uuid, 0, sizeof(*uuid));
+    uuid->type = ATT_UUID_128;
+
+    return true;
+}
+
+/**
+ * \brief Bond a simulated client. Its persistent storage entries are kept when it disconnects, and
+ * found again when it connects with the same connection index.
+ *
+ * \param[in] conn_idx      connection index of the client
+ *
+ * \return void
+ */
+void host_ble_bond(uint16_t conn_idx)
+{
+    assert(conn_idx < HOST_BLE_MAX_CONNECTIONS);
+    bonded[conn_idx] = true;
+}
+
+/**
+ * \brief Connect a simulated client, at the default ATT MTU. The services are told as they would be by
+ * the BLE framework.
+ *
+ * \param[in] conn_idx      connection index of the client
+ *
+ * \return void
+ */
+void host_ble_connect(uint16_t conn_idx)
+{
+    ble_evt_gap_connected_t evt = { .conn_idx = conn_idx };
+
+    assert(conn_idx < HOST_BLE_MAX_CONNECTIONS);
+    connected[conn_idx] = true;
+    mtus[conn_idx] = HOST_BLE_DEFAULT_MTU;
+
+    for(int i = 0; i < HOST_BLE_MAX_SERVICES; i++)
+    {
+        if(services[i] && services[i]->connected_evt)
+        {
+            services[i]->connected_evt(services[i], &evt);
+        }
+    }
+}
+
+/**
+ * \brief Disconnect a simulated client. The services are told as they would be by the BLE framework.
+ * Events the client has not received yet are lost.
+ *
+ * \param[in] conn_idx      connection index of the client
+ *
+ * \return void
+ */
+void host_ble_disconnect(uint16_t conn_idx)
+{
+    ble_evt_gap_disconnected_t evt = { .conn_idx = conn_idx };
+    uint32_t kept = 0;
+
+    connected[conn_idx] = false;
+
+    for(uint32_t i = 0; i < events_count; i++)
+    {
+        host_ble_event_t *event = &events[(events_head + i) % HOST_BLE_MAX_EVENTS];
+
+        if(event->conn_idx != conn_idx)
+        {
+            events[(events_head + kept++) % HOST_BLE_MAX_EVENTS] = *event;
+        }
+    }
+    events_count = kept;
+
+    for(int i = 0; i < HOST_BLE_MAX_SERVICES; i++)
+    {
+        if(services[i] && services[i]->disconnected_evt)
+        {
+            services[i]->disconnected_evt(services[i], &evt);
+        }
+    }
+
+    for(int i = 0; i < HOST_BLE_MAX_STORAGE; i++)
+    {
+        if(storage[i].conn_idx == conn_idx && !(bonded[conn_idx] && storage[i].persistent))
+        {
+            storage[i].in_use = false;
+        }
+    }
+}
+
+/**
+ * \brief Find an attribute by its 16 bit UUID
+ *
+ * \param[in] start_h       first handle to search from
+ * \param[in] uuid16        UUID of the attribute
+ *
+ * \return handle of the first matching attribute at or after start_h, 0 if not found
+ */
+uint16_t host_ble_find_attr(uint16_t start_h, uint16_t uuid16)
+{
+    for(uint16_t h = start_h; h < next_handle; h++)
+    {
+        if(attrs[h].uuid16 == uuid16)
+        {
+            return h;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Get the number of notifications and indications sent for an attribute
+ *
+ * \param[in] handle        attribute handle
+ *
+ * \return number of notifications and indications sent to any client
+ */
+uint32_t host_ble_notification_count(uint16_t handle)
+{
+    return handle < HOST_BLE_MAX_ATTRS ? attrs[handle].notifications : 0;
+}
+
+/**
+ * \brief Read an attribute as a client would, with a single read request
+ *
+ * \param[in] conn_idx      connection index of the client
+ * \param[in] handle        attribute handle
+ * \param[out] value        buffer where the value will be placed
+ * \param[in,out] length    size of value on input, length of the value read on output
+ *
+ * \return status the service responded with
+ */
+att_error_t host_ble_read(uint16_t conn_idx, uint16_t handle, uint8_t *value, uint16_t *length)
+{
+    ble_service_t *svc = find_service(handle);
+    ble_evt_gatts_read_req_t evt = { .conn_idx = conn_idx, .handle = handle };
+
+    if(!svc || !svc->read_req)
+    {
+        return ATT_ERROR_READ_NOT_PERMITTED;
+    }
+
+    last_read_status = ATT_ERROR_UNLIKELY;
+    last_read_length = 0;
+    svc->read_req(svc, &evt);
+
+    *length = last_read_length < *length ? last_read_length : *length;
+    memcpy(value, last_read_value, *length);
+
+    return last_read_status;
+}
+
+/**
+ * \brief Receive the oldest notification or indication queued for a client. The service that sent it
+ * gets its event_sent, which may queue more.
+ *
+ * \param[in] conn_idx      connection index of the client
+ * \param[out] handle       attribute handle of the event
+ * \param[out] value        buffer of at least HOST_BLE_MAX_EVENT_VALUE bytes for the value
+ * \param[out] length       length of the value
+ *
+ * \return true if an event was received, false if none is queued for the client
+ */
+bool host_ble_receive_event(uint16_t conn_idx, uint16_t *handle, uint8_t *value, uint16_t *length)
+{
+    ble_evt_gatts_event_sent_t evt = { .conn_idx = conn_idx, .status = true };
+    uint32_t i;
+
+    for(i = 0; i < events_count; i++)
+    {
+        if(events[(events_head + i) % HOST_BLE_MAX_EVENTS].conn_idx == conn_idx)
+        {
+            break;
+        }
+    }
+    if(i == events_count)
+    {
+        return false;
+    }
+
+    host_ble_event_t *event = &events[(events_head + i) % HOST_BLE_MAX_EVENTS];
+
+    *handle = event->handle;
+    *length = event->length;
+    memcpy(value, event->value, event->length);
+    evt.handle = event->handle;
+    evt.type = event->type;
+
+    // Close the gap, keeping the order of the events of the other clients
+    for(; i > 0; i--)
+    {
+        events[(events_head + i) % HOST_BLE_MAX_EVENTS] = events[(events_head + i - 1) % HOST_BLE_MAX_EVENTS];
+    }
+    events_head = (events_head + 1) % HOST_BLE_MAX_EVENTS;
+    events_count--;
+
+    ble_service_t *svc = find_service(evt.handle);
+    svc->event_sent(svc, &evt);
+
+    return true;
+}
+
+/**
+ * \brief Set the ATT MTU of a connection, as if the client had exchanged it
+ *
+ * \param[in] conn_idx      connection index of the client
+ * \param[in] mtu           new MTU
+ *
+ * \return void
+ */
+void host_ble_set_mtu(uint16_t conn_idx, uint16_t mtu)
+{
+    assert(conn_idx < HOST_BLE_MAX_CONNECTIONS);
+    mtus[conn_idx] = mtu;
+}
+
+/**
+ * \brief Write an attribute as a client would
+ *
+ * \param[in] conn_idx      connection index of the client
+ * \param[in] handle        attribute handle
+ * \param[in] value         value to write
+ * \param[in] length        length of the value
+ *
+ * \return status the service responded with
+ */
+att_error_t host_ble_write(uint16_t conn_idx, uint16_t handle, const uint8_t *value, uint16_t length)
+{
+    ble_service_t *svc = find_service(handle);
+    ble_evt_gatts_write_req_t *evt;
+
+    if(!svc || !svc->write_req)
+    {
+        return ATT_ERROR_WRITE_NOT_PERMITTED;
+    }
+
+    evt = calloc(1, sizeof(*evt) + length);
+    evt->conn_idx = conn_idx;
+    evt->handle = handle;
+    evt->length = length;
+    memcpy(evt->value, value, length);
+
+    last_write_status = ATT_ERROR_UNLIKELY;
+    svc->write_req(svc, evt);
+    free(evt);
+
+    return last_write_status;
+}
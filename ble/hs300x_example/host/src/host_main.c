@@ -0,0 +1,952 @@
+/*
+ * host_main.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "osal.h"
+#include "host_ble.h"
+#include "hs300x_sim.h"
+
+#include "alarm.h"
+#include "alarm_service.h"
+#include "burst_capture.h"
+#include "calibration.h"
+#include "diag_counters.h"
+#include "diag_service.h"
+#include "distribution.h"
+#include "ess_service.h"
+#include "hotpath_trace.h"
+#include "latency_trace.h"
+#include "hs300x_bench.h"
+#include "hs300x_task.h"
+#include "sample_bus.h"
+#include "sample_history.h"
+#include "sample_publish.h"
+#include "sensor_service.h"
+#include "stream_service.h"
+#include "time_sync.h"
+
+#define HOST_SENSOR_ID                  (0x12345678)
+#define HOST_DEFAULT_SAMPLES            (20)
+#define HOST_CONN_IDX                   (0)
+#define HOST_GATEWAY_CONN_IDX           (1)     /* Bonded client of the sample stream, dropped for a while */
+#define HOST_GATEWAY_MTU                (247)
+#define HOST_GATEWAY_EPOCH_ms           (1792281600000ULL)     /* Gateway UTC time at boot, 2026-10-18 */
+#define HOST_GATEWAY_DRIFT_PPB          (50000)     /* Device clock slower than the gateway's */
+#define HOST_GATEWAY_SYNC_PERIOD        (600)       /* Samples between two time settings by the gateway */
+#define HOST_GATEWAY_STALE_ACK          (100000)    /* Acknowledgement stored before the device rebooted */
+#define HOST_SLOW_CONSUMER_PERIOD       (20)    /* Samples between two reads of the slow bus consumer */
+#define HOST_TIME_SYNC_TOLERANCE_PPB    (2000)      /* Drift estimate error allowed, for settings 1 ms apart */
+
+/* What the gateway received from the sample stream */
+typedef struct
+{
+    uint16_t stream_h;                  // Sample Stream value handle
+    uint16_t time_h;                    // Time value handle
+    bool connected;
+    uint32_t last_seq;                  // Newest sample received, also acknowledged
+    uint32_t samples;
+    uint32_t notifications;
+    uint32_t largest;                   // Most samples in one notification
+    uint32_t reconnects;
+    uint32_t gaps;                      // Samples skipped between notifications
+    uint32_t duplicates;                // Samples received more than once
+    uint32_t max_time_error_ms;         // Largest error of the sample times, against the gateway's clock
+    uint32_t backlogs;                  // Backlogs the stream service reported draining to the gateway
+    bool draining;                      // Draining a backlog, see STREAM_SERVICE_BACKLOG_SAMPLES
+} host_gateway_t;
+
+/* Names of the latency stages, in latency_stage_t order */
+static const char * const latency_stage_names[LATENCY_STAGE_COUNT] = { "process", "wakeup", "send", "total" };
+
+/* Private function prototypes */
+static void drain_bus_consumer(sample_bus_consumer_t *consumer);
+static void drain_samples(OS_QUEUE q, const sample_publish_services_t *services);
+static uint32_t measurement_failures(void);
+static void print_alarms(uint16_t alarm_state_h, uint16_t alarm_rules_h);
+static void print_bus_consumer(const sample_bus_consumer_t *consumer);
+static void print_distribution(uint16_t distribution_h);
+static void print_health(uint16_t health_h);
+static int run_burst(uint32_t count);
+static int run_calibration(OS_QUEUE q, uint16_t calibration_h);
+static int run_time_sync(const host_gateway_t *gateway);
+static bool take_sample(OS_QUEUE q, hs300x_data_t *data);
+static void print_latency(uint16_t latency_h);
+static uint64_t gateway_time_ms(uint32_t local_ms);
+static void print_stream(const host_gateway_t *gateway);
+static void receive_stream(host_gateway_t *gateway);
+static void set_alarm_rules(uint16_t alarm_rules_h);
+static void set_environment(uint32_t sample_idx);
+static void set_gateway_time(const host_gateway_t *gateway);
+static void stream_backlog_changed(ble_service_t *svc, uint16_t conn_idx, bool draining);
+static void subscribe(uint16_t conn_idx, uint16_t value_h, uint16_t ccc_value);
+
+/* The gateway the stream service callbacks report to */
+static host_gateway_t *stream_gateway;
+
+static const stream_service_cb_t stream_service_callbacks =
+{
+    .backlog_changed_cb = stream_backlog_changed,
+};
+
+/**
+ * \brief Read all the samples waiting for a bus consumer and check they arrive in order
+ *
+ * \param[in] consumer          the consumer
+ *
+ * \return void
+ */
+static void drain_bus_consumer(sample_bus_consumer_t *consumer)
+{
+    const hs300x_sample_t *sample;
+    uint32_t last_seq = 0;
+
+    while((sample = sample_bus_peek(consumer)) != NULL)
+    {
+        uint32_t seq = sample->seq;
+
+        if(sample_bus_release(consumer))
+        {
+            OS_ASSERT(last_seq == 0 || seq > last_seq);
+            last_seq = seq;
+        }
+    }
+}
+
+/**
+ * \brief Hand the samples on the queue to the services, as the BLE task does
+ *
+ * \param[in] q                 measurement queue
+ * \param[in] services          services to publish to
+ *
+ * \return void
+ */
+static void drain_samples(OS_QUEUE q, const sample_publish_services_t *services)
+{
+    hs300x_sample_t sample;
+
+    while(OS_QUEUE_GET(q, &sample, OS_QUEUE_NO_WAIT) == OS_QUEUE_OK)
+    {
+        sample_publish(services, &sample);
+    }
+}
+
+/**
+ * \brief Get the gateway's UTC time at a local time of the device. The device clock runs slow by
+ * HOST_GATEWAY_DRIFT_PPB against it.
+ *
+ * \param[in] local_ms          local time in ms since boot
+ *
+ * \return UTC time in ms since the Unix epoch
+ */
+static uint64_t gateway_time_ms(uint32_t local_ms)
+{
+    return HOST_GATEWAY_EPOCH_ms + local_ms + (uint64_t)local_ms * HOST_GATEWAY_DRIFT_PPB / 1000000000;
+}
+
+/**
+ * \brief Get the number of failed measurements so far, stale ones included
+ *
+ * \return number of failed measurements
+ */
+static uint32_t measurement_failures(void)
+{
+    uint32_t failures = diag_counters.stale_samples;
+
+    for(int error = 0; error < DIAG_ERROR_COUNT; error++)
+    {
+        failures += diag_counters.errors[error];
+    }
+
+    return failures;
+}
+
+/**
+ * \brief Read the Alarm State and Alarm Rules characteristics of the alarm service and print them
+ *
+ * \param[in] alarm_state_h     Alarm State value handle
+ * \param[in] alarm_rules_h     Alarm Rules value handle
+ *
+ * \return void
+ */
+static void print_alarms(uint16_t alarm_state_h, uint16_t alarm_rules_h)
+{
+    uint8_t state[ALARM_STATE_SIZE];
+    uint8_t rules[ALARM_RULES_ENCODED_MAX_SIZE];
+    uint16_t state_length = sizeof(state);
+    uint16_t rules_length = sizeof(rules);
+
+    OS_ASSERT(host_ble_read(HOST_CONN_IDX, alarm_state_h, state, &state_length) == ATT_ERROR_OK);
+    OS_ASSERT(state_length == ALARM_STATE_SIZE);
+    OS_ASSERT(host_ble_read(HOST_CONN_IDX, alarm_rules_h, rules, &rules_length) == ATT_ERROR_OK);
+
+    printf("Alarms: %u rules, %lu indications, active %02X, latest change %02X at %.2f %%RH, %.2f C\r\n",
+           rules[0], (unsigned long)host_ble_notification_count(alarm_state_h), state[0], state[1],
+           get_u16(state + 2) / 100.0, (int16_t)get_u16(state + 4) / 100.0);
+}
+
+/**
+ * \brief Print the counters of a sample bus consumer
+ *
+ * \param[in] consumer          the consumer
+ *
+ * \return void
+ */
+static void print_bus_consumer(const sample_bus_consumer_t *consumer)
+{
+    printf("Bus consumer %s: received %lu, drops %lu, max lag %lu, lag %lu\r\n", consumer->name,
+           (unsigned long)consumer->received, (unsigned long)consumer->drops,
+           (unsigned long)consumer->max_lag, (unsigned long)sample_bus_lag(consumer));
+}
+
+/**
+ * \brief Read the Distribution characteristic of the custom service and print it
+ *
+ * \param[in] distribution_h    Distribution value handle
+ *
+ * \return void
+ */
+static void print_distribution(uint16_t distribution_h)
+{
+    uint8_t value[DISTRIBUTION_SUMMARY_SIZE];
+    uint16_t length = sizeof(value);
+
+    OS_ASSERT(host_ble_read(HOST_CONN_IDX, distribution_h, value, &length) == ATT_ERROR_OK);
+    OS_ASSERT(length == DISTRIBUTION_SUMMARY_SIZE);
+
+    const uint8_t *humidity = value + 7;
+    const uint8_t *temp = humidity + DISTRIBUTION_QUANTILE_COUNT * sizeof(uint16_t);
+
+    printf("Distribution: %lu samples, %.2f %% at or above %u %%RH, humidity p5/p50/p95 %.2f/%.2f/%.2f %%RH, "
+           "temperature p5/p50/p95 %.2f/%.2f/%.2f C\r\n",
+           (unsigned long)get_u32(value), get_u16(value + 5) / 100.0, value[4],
+           get_u16(humidity) / 100.0, get_u16(humidity + 2) / 100.0, get_u16(humidity + 4) / 100.0,
+           (int16_t)get_u16(temp) / 100.0, (int16_t)get_u16(temp + 2) / 100.0, (int16_t)get_u16(temp + 4) / 100.0);
+}
+
+/**
+ * \brief Read the Health characteristic of the diagnostics service and print it
+ *
+ * \param[in] health_h          Health value handle
+ *
+ * \return void
+ */
+static void print_health(uint16_t health_h)
+{
+    uint8_t value[DIAG_COUNTERS_PACK_SIZE];
+    uint16_t length = sizeof(value);
+    uint32_t errors = 0;
+
+    OS_ASSERT(host_ble_read(HOST_CONN_IDX, health_h, value, &length) == ATT_ERROR_OK);
+    OS_ASSERT(length == DIAG_COUNTERS_PACK_SIZE && value[0] == DIAG_COUNTERS_PACK_VERSION);
+
+    const uint8_t *errors_ptr = value + DIAG_COUNTERS_PACK_SIZE - DIAG_ERROR_COUNT * sizeof(uint16_t);
+    for(int error = 0; error < DIAG_ERROR_COUNT; error++)
+    {
+        errors += get_u16(errors_ptr + error * sizeof(uint16_t));
+    }
+
+    printf("Health: uptime %lu s, stale %lu, queue drops %lu, notify failures %lu, I2C/driver errors %lu\r\n",
+           (unsigned long)get_u32(value + 1), (unsigned long)get_u32(value + 5),
+           (unsigned long)get_u32(value + 9), (unsigned long)get_u32(value + 13), (unsigned long)errors);
+}
+
+/**
+ * \brief Read the Sample Latency characteristic of the diagnostics service and print it
+ *
+ * \param[in] latency_h         Sample Latency value handle
+ *
+ * \return void
+ */
+static void print_latency(uint16_t latency_h)
+{
+    uint8_t value[64];
+    uint16_t length = sizeof(value);
+
+    OS_ASSERT(host_ble_read(HOST_CONN_IDX, latency_h, value, &length) == ATT_ERROR_OK);
+    OS_ASSERT(length == sizeof(uint32_t) * (1 + 3 * LATENCY_STAGE_COUNT));
+
+    printf("Latency (us, p50/p95/p99) over %lu samples:", (unsigned long)get_u32(value));
+    for(int stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+    {
+        const uint8_t *ptr = value + sizeof(uint32_t) * (1 + 3 * stage);
+        printf(" %s %lu/%lu/%lu", latency_stage_names[stage], (unsigned long)get_u32(ptr),
+               (unsigned long)get_u32(ptr + 4), (unsigned long)get_u32(ptr + 8));
+    }
+    printf("\r\n");
+}
+
+/**
+ * \brief Print what the gateway received from the sample stream
+ *
+ * \param[in] gateway           the gateway
+ *
+ * \return void
+ */
+static void print_stream(const host_gateway_t *gateway)
+{
+    uint8_t value[STREAM_SERVICE_TIME_SIZE];
+    uint16_t length = sizeof(value);
+
+    OS_ASSERT(host_ble_read(HOST_GATEWAY_CONN_IDX, gateway->time_h, value, &length) == ATT_ERROR_OK);
+
+    int32_t drift_ppb = (int32_t)get_u32(value + 8);
+
+    printf("Stream: %lu samples in %lu notifications, largest %lu samples, %lu reconnects, gaps %lu, "
+           "duplicates %lu, backlogs %lu\r\n", (unsigned long)gateway->samples,
+           (unsigned long)gateway->notifications, (unsigned long)gateway->largest,
+           (unsigned long)gateway->reconnects, (unsigned long)gateway->gaps, (unsigned long)gateway->duplicates,
+           (unsigned long)gateway->backlogs);
+    printf("Time: %u syncs, drift %s%ld.%03ld ppm (simulated %ld.%03ld ppm), sample time error max %lu ms\r\n",
+           get_u16(value + 12), drift_ppb < 0 ? "-" : "", (long)(abs(drift_ppb) / 1000),
+           (long)(abs(drift_ppb) % 1000), (long)(HOST_GATEWAY_DRIFT_PPB / 1000),
+           (long)(HOST_GATEWAY_DRIFT_PPB % 1000), (unsigned long)gateway->max_time_error_ms);
+}
+
+/**
+ * \brief Receive the notifications of the sample stream waiting for the gateway, check the samples
+ * follow on and are timed by the gateway's clock, and acknowledge the newest one, as a gateway would
+ *
+ * \param[in,out] gateway       the gateway
+ *
+ * \return void
+ */
+static void receive_stream(host_gateway_t *gateway)
+{
+    uint8_t value[HOST_BLE_MAX_EVENT_VALUE];
+    uint16_t length;
+    uint16_t handle;
+    uint32_t last_seq = gateway->last_seq;
+
+    while(host_ble_receive_event(HOST_GATEWAY_CONN_IDX, &handle, value, &length))
+    {
+        OS_ASSERT(handle == gateway->stream_h && length >= STREAM_SERVICE_HEADER_SIZE);
+
+        uint32_t first_seq = get_u32(value);
+        uint32_t count = value[4];
+        uint64_t first_time_ms = (uint64_t)get_u32(value + 5) * 1000 + get_u16(value + 9);
+
+        OS_ASSERT(length == STREAM_SERVICE_HEADER_SIZE + count * STREAM_SERVICE_SAMPLE_SIZE);
+
+        // The true time of each sample follows from when it was taken, which the runner can look up
+        for(uint32_t i = 0; i < count; i++)
+        {
+            uint32_t seq = first_seq + i;
+            uint32_t taken_ms;
+            hs300x_raw_t raw;
+
+            OS_ASSERT(sample_history_read(&seq, &raw, &taken_ms, 1) == 1 && seq == first_seq + i);
+
+            uint64_t time_ms = first_time_ms + get_u32(value + STREAM_SERVICE_HEADER_SIZE + i * STREAM_SERVICE_SAMPLE_SIZE);
+            uint64_t true_ms = gateway_time_ms(taken_ms);
+            uint32_t error_ms = (uint32_t)(time_ms > true_ms ? time_ms - true_ms : true_ms - time_ms);
+
+            if(error_ms > gateway->max_time_error_ms)
+            {
+                gateway->max_time_error_ms = error_ms;
+            }
+        }
+
+        if(first_seq > gateway->last_seq + 1)
+        {
+            gateway->gaps += first_seq - gateway->last_seq - 1;
+        }
+        else if(first_seq <= gateway->last_seq)
+        {
+            uint32_t repeated = gateway->last_seq - first_seq + 1;
+
+            gateway->duplicates += repeated < count ? repeated : count;
+        }
+        if(first_seq + count - 1 > gateway->last_seq)
+        {
+            gateway->last_seq = first_seq + count - 1;
+        }
+        gateway->samples += count;
+        gateway->notifications++;
+        if(count > gateway->largest)
+        {
+            gateway->largest = count;
+        }
+    }
+
+    if(gateway->last_seq != last_seq)
+    {
+        uint8_t ack[sizeof(uint32_t)];
+        uint8_t *ptr = ack;
+
+        put_u32_inc(&ptr, gateway->last_seq);
+        OS_ASSERT(host_ble_write(HOST_GATEWAY_CONN_IDX, gateway->stream_h, ack, sizeof(ack)) == ATT_ERROR_OK);
+    }
+}
+
+/**
+ * \brief Run a burst at 8 bit resolution, as a client would request it over L2CAP, and print the result
+ *
+ * \param[in] count             number of conversions
+ *
+ * \return 0 if every conversion was captured in order, 1 otherwise
+ */
+static int run_burst(uint32_t count)
+{
+    burst_capture_result_t result;
+    hs300x_sample_t sample;
+    bool in_order = true;
+
+    user_humidity_resolution = HS300x_RESOLUTION_8_BITS;
+    user_temperature_resolution = HS300x_RESOLUTION_8_BITS;
+    hs300x_task_init(NULL);
+    hs300x_task_engine_start();
+
+    // The engine runs in the calling task, as with APP_SINGLE_TASK, so it only accepts short bursts
+    OS_ASSERT(!burst_capture_request(BURST_CAPTURE_MAX_SAMPLES, NULL));
+    OS_ASSERT(burst_capture_request(count, NULL));
+    hs300x_task_engine_run(&sample);
+    OS_ASSERT(burst_capture_get_result(&result));
+
+    for(uint32_t i = 1; i < result.count; i++)
+    {
+        in_order = in_order && result.samples[i].t_us > result.samples[i - 1].t_us;
+    }
+
+    printf("Burst: %u of %u conversions in %lu us, %lu per second, %lu stale reads, error %d\r\n",
+           result.count, result.requested, (unsigned long)result.duration_us,
+           (unsigned long)(result.duration_us ? (uint64_t)result.count * 1000000 / result.duration_us : 0),
+           (unsigned long)result.stale_polls, result.error);
+    for(uint32_t i = 0; i < result.count && i < 3; i++)
+    {
+        hs300x_data_t data;
+
+        hs300x_convert_raw_to_humid_temp(result.samples[i].raw, true, &data);
+        printf("  t %lu us: %.2f %%RH, %.2f C\r\n", (unsigned long)result.samples[i].t_us,
+               data.humidity_rh_pct, data.temp_deg_c);
+    }
+
+    burst_capture_release();
+
+    return (result.error != HS300x_ERROR_NONE || result.count != count || !in_order) ? 1 : 0;
+}
+
+/**
+ * \brief Calibrate the simulated sensor over BLE, as a client would, and check the samples are corrected
+ * from the next one on and after a restart
+ *
+ * \param[in] q                 measurement queue
+ * \param[in] calibration_h     Calibration value handle
+ *
+ * \return 0 if the calibration was refused for another sensor, then applied and restored, 1 otherwise
+ */
+static int run_calibration(OS_QUEUE q, uint16_t calibration_h)
+{
+    // Humidity: 2 points, +2.00 %RH at 20 %RH and none at 80 %RH. Temperature: 1 point, -0.50 C.
+    calibration_t calibration = {
+        .sensor_id = HOST_SENSOR_ID + 1,
+        .count = { 2, 1 },
+        .points = {
+            { { 2000, 2200 }, { 8000, 8000 } },
+            { { 2500, 2450 } },
+        },
+    };
+    uint8_t value[CALIBRATION_ENCODED_MAX_SIZE];
+    uint16_t length = sizeof(value);
+    hs300x_data_t before, after, restarted;
+
+    hs300x_task_init(q);
+    hs300x_sim_set_environment(50.0f, 25.0f);
+
+    OS_ASSERT(host_ble_read(HOST_CONN_IDX, calibration_h, value, &length) == ATT_ERROR_OK);
+    OS_ASSERT(length == CALIBRATION_HEADER_SIZE && get_u32(value) == HOST_SENSOR_ID);
+    bool ok = take_sample(q, &before);
+
+    // Made for another sensor: refused
+    length = calibration_encode(&calibration, value);
+    att_error_t other_sensor = host_ble_write(HOST_CONN_IDX, calibration_h, value, length);
+
+    calibration.sensor_id = HOST_SENSOR_ID;
+    length = calibration_encode(&calibration, value);
+    att_error_t written = host_ble_write(HOST_CONN_IDX, calibration_h, value, length);
+    ok = take_sample(q, &after) && ok;
+
+    // Restart: the calibration is loaded from NVMS again
+    OS_ASSERT(calibration_init(HOST_SENSOR_ID) == CALIBRATION_ERROR_NONE);
+    ok = take_sample(q, &restarted) && ok;
+
+    printf("Calibration: other sensor %02X, write %02X\r\n", other_sensor, written);
+    printf("  as read:   %.2f %%RH, %.2f C\r\n", before.humidity_rh_pct, before.temp_deg_c);
+    printf("  corrected: %.2f %%RH, %.2f C\r\n", after.humidity_rh_pct, after.temp_deg_c);
+    printf("  restarted: %.2f %%RH, %.2f C\r\n", restarted.humidity_rh_pct, restarted.temp_deg_c);
+
+    // 50 %RH is halfway between the humidity points, so 1.00 %RH is added
+    ok = ok && other_sensor == ATT_ERROR_APPLICATION_ERROR && written == ATT_ERROR_OK;
+    ok = ok && fabsf(after.humidity_rh_pct - before.humidity_rh_pct - 1.0f) < 0.02f;
+    ok = ok && fabsf(after.temp_deg_c - before.temp_deg_c + 0.5f) < 0.02f;
+    ok = ok && restarted.humidity_rh_pct == after.humidity_rh_pct && restarted.temp_deg_c == after.temp_deg_c;
+
+    return ok ? 0 : 1;
+}
+
+/**
+ * \brief Set the time over BLE a few times, as a gateway would on each connection, and check the drift
+ * estimated from the settings at least TIME_SYNC_MIN_INTERVAL_ms apart
+ *
+ * \param[in] gateway           the gateway
+ *
+ * \return 0 if every such setting gave an estimate, the drift is within HOST_TIME_SYNC_TOLERANCE_PPB of
+ *         the simulated one and the time read back is the gateway's, 1 otherwise
+ */
+static int run_time_sync(const host_gateway_t *gateway)
+{
+    // Time from the previous setting. All but the second give an estimate, it is too close.
+    static const uint32_t intervals_ms[] = {
+        TIME_SYNC_MIN_INTERVAL_ms, 60 * 1000, TIME_SYNC_MIN_INTERVAL_ms + 1234, 2 * TIME_SYNC_MIN_INTERVAL_ms,
+    };
+    uint8_t value[STREAM_SERVICE_TIME_SIZE];
+    uint16_t length = sizeof(value);
+    time_sync_status_t status;
+
+    host_ble_connect(HOST_GATEWAY_CONN_IDX);
+    set_gateway_time(gateway);
+    for(uint32_t i = 0; i < sizeof(intervals_ms) / sizeof(intervals_ms[0]); i++)
+    {
+        OS_DELAY_MS(intervals_ms[i]);
+        set_gateway_time(gateway);
+    }
+    OS_DELAY_MS(TIME_SYNC_MIN_INTERVAL_ms / 2);
+
+    time_sync_get_status(&status);
+    OS_ASSERT(host_ble_read(HOST_GATEWAY_CONN_IDX, gateway->time_h, value, &length) == ATT_ERROR_OK);
+    OS_ASSERT(length == sizeof(value));
+
+    uint64_t time_ms = get_u32(value) | ((uint64_t)get_u32(value + 4) << 32);
+    uint64_t true_ms = gateway_time_ms(time_sync_local_ms());
+    uint32_t time_error_ms = (uint32_t)(time_ms > true_ms ? time_ms - true_ms : true_ms - time_ms);
+    int32_t drift_ppb = (int32_t)get_u32(value + 8);
+    int32_t drift_error_ppb = abs(drift_ppb - HOST_GATEWAY_DRIFT_PPB);
+
+    printf("Time: %u syncs, %u drift estimates, drift %s%ld.%03ld ppm (simulated %ld.%03ld ppm), "
+           "time error %lu ms\r\n", get_u16(value + 12), status.drift_estimates, drift_ppb < 0 ? "-" : "",
+           (long)(abs(drift_ppb) / 1000), (long)(abs(drift_ppb) % 1000), (long)(HOST_GATEWAY_DRIFT_PPB / 1000),
+           (long)(HOST_GATEWAY_DRIFT_PPB % 1000), (unsigned long)time_error_ms);
+
+    return (status.drift_estimates == 3 && drift_error_ppb <= HOST_TIME_SYNC_TOLERANCE_PPB && time_error_ms <= 1) ? 0 : 1;
+}
+
+/**
+ * \brief Write alarm rules over BLE, as a client would. The humidity ramp of set_environment() crosses
+ * the humidity threshold once, the temperature triangle wave raises and clears the other two rules
+ * every period.
+ *
+ * \param[in] alarm_rules_h     Alarm Rules value handle
+ *
+ * \return void
+ */
+static void set_alarm_rules(uint16_t alarm_rules_h)
+{
+    const alarm_rule_t rules[] = {
+        // Humidity at or above 42.00 %RH for 5 s, clears below 41.50 %RH
+        { ALARM_CHANNEL_HUMIDITY, ALARM_TYPE_ABOVE, 4200, 50, 5 },
+        // Temperature at or above 27.00 C, clears below 26.50 C
+        { ALARM_CHANNEL_TEMP, ALARM_TYPE_ABOVE, 2700, 50, 0 },
+        // Temperature falling by 15.00 C per minute or faster, clears below 10.00 C per minute
+        { ALARM_CHANNEL_TEMP, ALARM_TYPE_FALL_RATE, 1500, 500, 0 },
+    };
+    uint8_t value[ALARM_RULES_ENCODED_MAX_SIZE];
+    uint16_t length = alarm_encode_rules(rules, sizeof(rules) / sizeof(rules[0]), value);
+
+    OS_ASSERT(host_ble_write(HOST_CONN_IDX, alarm_rules_h, value, length) == ATT_ERROR_OK);
+}
+
+/**
+ * \brief Set the environment the simulated sensor measures. Humidity holds for a few samples at a
+ * time and temperature follows a triangle wave, so the ESS triggers have something to suppress.
+ *
+ * \param[in] sample_idx        index of the next sample
+ *
+ * \return void
+ */
+static void set_environment(uint32_t sample_idx)
+{
+    float humidity = 40.0f + (sample_idx / 4) * 0.5f;
+    uint32_t phase = sample_idx % 20;
+    float temp = 24.0f + (phase < 10 ? phase : 20 - phase) * 0.4f;
+
+    hs300x_sim_set_environment(humidity, temp);
+}
+
+/**
+ * \brief Set the time of the device to the gateway's, as a gateway would on connect
+ *
+ * \param[in] gateway           the gateway
+ *
+ * \return void
+ */
+static void set_gateway_time(const host_gateway_t *gateway)
+{
+    uint64_t time_ms = gateway_time_ms(time_sync_local_ms());
+    uint8_t value[sizeof(uint64_t)];
+    uint8_t *ptr = value;
+
+    put_u32_inc(&ptr, (uint32_t)time_ms);
+    put_u32_inc(&ptr, (uint32_t)(time_ms >> 32));
+    OS_ASSERT(host_ble_write(HOST_GATEWAY_CONN_IDX, gateway->time_h, value, sizeof(value)) == ATT_ERROR_OK);
+}
+
+/**
+ * \brief Stream service callback, counts the backlogs drained to the gateway, for which the target
+ * requests bulk connection parameters
+ *
+ * \param[in] svc               stream service
+ * \param[in] conn_idx          connection index of the client
+ * \param[in] draining          true when a backlog starts draining, false once caught up
+ *
+ * \return void
+ */
+static void stream_backlog_changed(ble_service_t *svc, uint16_t conn_idx, bool draining)
+{
+    OS_ASSERT(conn_idx == HOST_GATEWAY_CONN_IDX && stream_gateway->draining != draining);
+
+    stream_gateway->draining = draining;
+    if(draining)
+    {
+        stream_gateway->backlogs++;
+    }
+}
+
+/**
+ * \brief Enable notifications or indications of a characteristic, as a client would
+ *
+ * \param[in] conn_idx          connection index of the client
+ * \param[in] value_h           characteristic value handle. The CCC is the next one after it.
+ * \param[in] ccc_value         GATT_CCC_NOTIFICATIONS or GATT_CCC_INDICATIONS
+ *
+ * \return void
+ */
+static void subscribe(uint16_t conn_idx, uint16_t value_h, uint16_t ccc_value)
+{
+    uint8_t ccc[] = { ccc_value & 0xFF, ccc_value >> 8 };
+    uint16_t ccc_h = host_ble_find_attr(value_h, UUID_GATT_CLIENT_CHAR_CONFIGURATION);
+
+    OS_ASSERT(ccc_h && host_ble_write(conn_idx, ccc_h, ccc, sizeof(ccc)) == ATT_ERROR_OK);
+}
+
+/**
+ * \brief Take one sample and convert it
+ *
+ * \param[in] q                 measurement queue
+ * \param[out] data             converted sample
+ *
+ * \return true if the sample was taken, false otherwise
+ */
+static bool take_sample(OS_QUEUE q, hs300x_data_t *data)
+{
+    hs300x_sample_t sample;
+
+    if(hs300x_task_sample() != HS300x_ERROR_NONE || OS_QUEUE_GET(q, &sample, OS_QUEUE_NO_WAIT) != OS_QUEUE_OK)
+    {
+        return false;
+    }
+
+    hs300x_convert_raw(&sample.raw, data);
+    return true;
+}
+
+/**
+ * \brief Host runner. Runs the sampling engine against the simulated HS300x and feeds the samples to
+ * the services with a subscribed client and a bonded gateway on the sample stream.
+ *
+ * Usage: hs300x_host [samples]
+ *        hs300x_host single [samples]
+ *        hs300x_host burst [conversions]
+ *        hs300x_host calibrate
+ *        hs300x_host time
+ *        hs300x_host bench
+ *
+ * The second form runs the sampling engine step by step, as the BLE task does with APP_SINGLE_TASK,
+ * and reports how often it woke up. The third form runs one burst capture at 8 bit resolution, with the
+ * sampling engine of the second form, so of at most 41 conversions. The fourth form writes a calibration
+ * over BLE and checks the samples are corrected. The fifth form sets the time over BLE for 45 minutes and
+ * checks the drift estimate. The last form runs the hot path benchmarks instead of the sampling engine.
+ *
+ * \return 0 if every sample was read successfully and none was stale (or every benchmark was within
+ *         its limit), 1 otherwise
+ */
+int main(int argc, char **argv)
+{
+    bool bench = argc > 1 && strcmp(argv[1], "bench") == 0;
+    bool single = argc > 1 && strcmp(argv[1], "single") == 0;
+    bool burst = argc > 1 && strcmp(argv[1], "burst") == 0;
+    bool calibrate = argc > 1 && strcmp(argv[1], "calibrate") == 0;
+    bool sync_time = argc > 1 && strcmp(argv[1], "time") == 0;
+    int samples_arg = (single || burst) ? 2 : 1;
+    uint32_t samples = (argc > samples_arg && !bench && !calibrate && !sync_time) ? strtoul(argv[samples_arg], NULL, 0) : HOST_DEFAULT_SAMPLES;
+    uint32_t errors = 0;
+    uint32_t wakeups = 0;
+    sample_bus_consumer_t slow_consumer;
+    host_gateway_t gateway = { 0 };
+    uint64_t busy_us = 0;
+    OS_QUEUE q;
+
+    hs300x_sim_reset(HOST_SENSOR_ID);
+    diag_counters_init();
+#if APP_HOTPATH_TRACE
+    hotpath_trace_init();
+#endif
+#if APP_LATENCY_TRACE
+    latency_trace_init();
+#endif
+    hs300x_task_setup_hardware();
+
+    sample_history_init();
+    sample_bus_init();
+    distribution_init();
+    alarm_init();
+    time_sync_init();
+    OS_QUEUE_CREATE(q, sizeof(hs300x_sample_t), 5);
+
+    ble_service_t *sensor_service_handle = sensor_service_init(NULL);
+    sensor_service_set_engine_sample_rate(sensor_service_handle, HS300x_TASK_DEFAULT_SAMPLE_RATE_ms);
+    ble_service_t *ess_service_handle = ess_service_init();
+    ess_service_set_update_interval(ess_service_handle, HS300x_TASK_DEFAULT_SAMPLE_RATE_ms);
+    ble_service_t *diag_service_handle = diag_service_init();
+    ble_service_t *alarm_service_handle = alarm_service_init();
+    stream_gateway = &gateway;
+    ble_service_t *stream_service_handle = stream_service_init(&stream_service_callbacks);
+    const sample_publish_services_t services = {
+        .sensor_service = sensor_service_handle,
+        .ess_service = ess_service_handle,
+        .alarm_service = alarm_service_handle,
+        .stream_service = stream_service_handle,
+    };
+
+    uint16_t ess_humidity_h = host_ble_find_attr(ess_service_handle->start_h, 0x2A6F);
+    uint16_t ess_temp_h = host_ble_find_attr(ess_service_handle->start_h, 0x2A6E);
+    // The custom service uses 128 bit UUIDs. Each CCC follows its value and the value's User Description.
+    uint16_t measurement_h = host_ble_find_attr(sensor_service_handle->start_h, UUID_GATT_CLIENT_CHAR_CONFIGURATION) - 2;
+    uint16_t derived_h = host_ble_find_attr(measurement_h + 3, UUID_GATT_CLIENT_CHAR_CONFIGURATION) - 2;
+    // Calibration is declared after the Derived Values CCC and followed by its User Description
+    uint16_t calibration_h = host_ble_find_attr(derived_h + 3, UUID_GATT_CHAR_USER_DESCRIPTION) - 1;
+    uint16_t distribution_h = host_ble_find_attr(calibration_h + 2, UUID_GATT_CHAR_USER_DESCRIPTION) - 1;
+    // Health is followed by its User Description, then the Sample Latency declaration, value and description
+    uint16_t health_h = host_ble_find_attr(diag_service_handle->start_h, UUID_GATT_CHAR_USER_DESCRIPTION) - 1;
+    uint16_t latency_h = health_h + 3;
+    // Alarm State is followed by its User Description and CCC, then the Alarm Rules declaration and value
+    uint16_t alarm_state_h = host_ble_find_attr(alarm_service_handle->start_h, UUID_GATT_CHAR_USER_DESCRIPTION) - 1;
+    uint16_t alarm_rules_h = alarm_state_h + 4;
+    // Sample Stream is followed by its User Description and CCC, then the Time declaration and value
+    gateway.stream_h = host_ble_find_attr(stream_service_handle->start_h, UUID_GATT_CHAR_USER_DESCRIPTION) - 1;
+    gateway.time_h = gateway.stream_h + 4;
+
+    host_ble_connect(HOST_CONN_IDX);
+    subscribe(HOST_CONN_IDX, measurement_h, GATT_CCC_NOTIFICATIONS);
+    subscribe(HOST_CONN_IDX, derived_h, GATT_CCC_NOTIFICATIONS);
+    subscribe(HOST_CONN_IDX, ess_humidity_h, GATT_CCC_NOTIFICATIONS);
+    subscribe(HOST_CONN_IDX, ess_temp_h, GATT_CCC_NOTIFICATIONS);
+    subscribe(HOST_CONN_IDX, alarm_state_h, GATT_CCC_INDICATIONS);
+
+    // Temperature: only notify when rising above 26.00 C, instead of on every change
+    uint16_t temp_trigger_h = host_ble_find_attr(ess_temp_h, 0x290D);
+    uint8_t threshold[] = { ESS_TRIGGER_GREATER_THAN, 2600 & 0xFF, 2600 >> 8 };
+    OS_ASSERT(host_ble_write(HOST_CONN_IDX, temp_trigger_h, threshold, sizeof(threshold)) == ATT_ERROR_OK);
+    set_alarm_rules(alarm_rules_h);
+
+    if(bench)
+    {
+        uint8_t before[2];
+        uint8_t after[2];
+        uint16_t before_length = sizeof(before);
+        uint16_t after_length = sizeof(after);
+
+        // The benchmark feeds the ESS made up samples, its value must still be the one from before it
+        ble_gatts_get_value(ess_humidity_h, &before_length, before);
+        uint32_t failed = hs300x_bench_run(sensor_service_handle, ess_service_handle);
+        ble_gatts_get_value(ess_humidity_h, &after_length, after);
+        OS_ASSERT(after_length == before_length && !memcmp(before, after, before_length));
+
+        return failed ? 1 : 0;
+    }
+
+    if(burst)
+    {
+        return run_burst(samples);
+    }
+
+    if(calibrate)
+    {
+        return run_calibration(q, calibration_h);
+    }
+
+    if(sync_time)
+    {
+        return run_time_sync(&gateway);
+    }
+
+    uint64_t init_start_us = host_clock_now_us();
+    hs300x_task_init(single ? NULL : q);
+    uint64_t init_us = host_clock_now_us() - init_start_us;
+
+    if(single)
+    {
+        hs300x_task_engine_start();
+    }
+
+    // A consumer that only reads every few samples, to show the drop accounting
+    sample_bus_subscribe(&slow_consumer, "slow", NULL, 0);
+
+    /*
+     * A bonded gateway that sets the time and streams every sample at a large MTU. It was bonded before
+     * the device rebooted, so its stored acknowledgement is ahead of the sequence numbers and history,
+     * which restarted empty. The stream must still deliver every sample taken since.
+     */
+    host_ble_bond(HOST_GATEWAY_CONN_IDX);
+    ble_storage_put_u32(HOST_GATEWAY_CONN_IDX, gateway.stream_h, HOST_GATEWAY_STALE_ACK, true);
+    host_ble_connect(HOST_GATEWAY_CONN_IDX);
+    host_ble_set_mtu(HOST_GATEWAY_CONN_IDX, HOST_GATEWAY_MTU);
+    set_gateway_time(&gateway);
+    subscribe(HOST_GATEWAY_CONN_IDX, gateway.stream_h, GATT_CCC_NOTIFICATIONS);
+    gateway.connected = true;
+
+    // Everything is allocated by now. The sample path must not allocate at all.
+    uint32_t allocs_before = host_os_alloc_count();
+
+    for(uint32_t i = 0; i < samples; i++)
+    {
+        set_environment(i);
+
+        if(i % HOST_SLOW_CONSUMER_PERIOD == 0)
+        {
+            drain_bus_consumer(&slow_consumer);
+        }
+
+        // The gateway drops its link for half of the run, losing what was in flight
+        if(samples >= 4 && i == samples / 4)
+        {
+            host_ble_disconnect(HOST_GATEWAY_CONN_IDX);
+            gateway.connected = false;
+            gateway.draining = false;
+        }
+        else if(samples >= 4 && i == samples * 3 / 4)
+        {
+            // The stream resumes on its own, the CCC and acknowledgement are bonded
+            host_ble_connect(HOST_GATEWAY_CONN_IDX);
+            host_ble_set_mtu(HOST_GATEWAY_CONN_IDX, HOST_GATEWAY_MTU);
+            set_gateway_time(&gateway);
+            gateway.connected = true;
+            gateway.reconnects++;
+        }
+        else if(gateway.connected && i > 0 && i % HOST_GATEWAY_SYNC_PERIOD == 0)
+        {
+            set_gateway_time(&gateway);
+        }
+        if(gateway.connected)
+        {
+            receive_stream(&gateway);
+        }
+
+        if(single)
+        {
+            // Sleep until the engine's next deadline, as the BLE task does, until the sample is taken or fails
+            uint32_t failures = measurement_failures();
+            hs300x_sample_t sample;
+            bool taken;
+
+            do
+            {
+                OS_DELAY(hs300x_task_engine_ticks_to_deadline());
+                wakeups++;
+
+                uint64_t start_us = host_clock_now_us();
+                taken = hs300x_task_engine_run(&sample);
+                if(taken)
+                {
+                    sample_publish(&services, &sample);
+                    hs300x_task_print_samples();
+                }
+                busy_us += host_clock_now_us() - start_us;
+            } while(!taken && measurement_failures() == failures);
+
+            if(!taken)
+            {
+                errors++;
+            }
+            continue;
+        }
+
+        uint64_t start_us = host_clock_now_us();
+        if(hs300x_task_sample() != HS300x_ERROR_NONE)
+        {
+            errors++;
+        }
+        busy_us += host_clock_now_us() - start_us;
+
+        drain_samples(q, &services);
+        hs300x_task_print_samples();
+
+        OS_DELAY_MS(hs300x_task_get_sample_rate());
+    }
+
+    uint32_t sample_allocs = host_os_alloc_count() - allocs_before;
+
+    receive_stream(&gateway);
+
+    const hs300x_sim_stats_t *stats = hs300x_sim_get_stats();
+
+    printf("\r\n");
+    printf("Init: %llu us, sensor ID %08lX, resolution registers %04X %04X\r\n",
+           (unsigned long long)init_us, (unsigned long)hs300x_task_get_sensor_id(),
+           hs300x_sim_get_register(0x06), hs300x_sim_get_register(0x11));
+    printf("Samples: %lu, errors %lu, time per sample %llu us, virtual time %llu ms\r\n",
+           (unsigned long)samples, (unsigned long)errors,
+           (unsigned long long)(samples ? busy_us / samples : 0),
+           (unsigned long long)(host_clock_now_us() / 1000));
+    printf("Sensor: %lu conversions, %lu valid, %lu stale, %lu NACK, %lu NVM writes\r\n",
+           (unsigned long)stats->measurements, (unsigned long)stats->valid_fetches,
+           (unsigned long)stats->stale_fetches, (unsigned long)stats->nacks,
+           (unsigned long)stats->nvm_writes);
+    printf("Notifications: measurement %lu, derived %lu, ESS humidity %lu, ESS temperature %lu\r\n",
+           (unsigned long)host_ble_notification_count(measurement_h),
+           (unsigned long)host_ble_notification_count(derived_h),
+           (unsigned long)host_ble_notification_count(ess_humidity_h),
+           (unsigned long)host_ble_notification_count(ess_temp_h));
+    // The client takes both values at the engine rate, through the sample_publish() the target uses
+    OS_ASSERT(host_ble_notification_count(measurement_h) == samples - errors &&
+              host_ble_notification_count(derived_h) == samples - errors);
+
+    if(single)
+    {
+        printf("Single task: %lu wakeups, %lu.%02lu per sample\r\n", (unsigned long)wakeups,
+               (unsigned long)(samples ? wakeups / samples : 0),
+               (unsigned long)(samples ? (wakeups * 100 / samples) % 100 : 0));
+    }
+    printf("Heap allocations in the sample path: %lu\r\n", (unsigned long)sample_allocs);
+    print_bus_consumer(&slow_consumer);
+    // Every published sample is received, dropped or still waiting
+    OS_ASSERT(slow_consumer.received + slow_consumer.drops + sample_bus_lag(&slow_consumer) ==
+              samples - errors);
+    print_distribution(distribution_h);
+    print_alarms(alarm_state_h, alarm_rules_h);
+    print_stream(&gateway);
+    // The gateway has every sample once, the dropped link included unless it outlasted the history
+    OS_ASSERT(gateway.duplicates == 0 && gateway.samples + gateway.gaps == samples - errors);
+    OS_ASSERT(gateway.gaps == 0 || samples / 2 > SAMPLE_HISTORY_LENGTH);
+    // Once caught up the connection policy goes back to the streaming parameters
+    OS_ASSERT(!gateway.draining);
+    // The backlog after the reconnect was timed, for the comparison with L2CAP transfers
+    stream_service_transfer_t transfer;
+    OS_ASSERT(gateway.backlogs == 0 || (stream_service_get_last_transfer(stream_service_handle, &transfer) &&
+                                        transfer.samples >= STREAM_SERVICE_BACKLOG_SAMPLES));
+    // Runs long enough for a drift estimate must have it right, see run_time_sync() for several
+    time_sync_status_t time_status;
+    time_sync_get_status(&time_status);
+    OS_ASSERT(time_status.drift_estimates == 0 ||
+              abs(time_status.drift_ppb - HOST_GATEWAY_DRIFT_PPB) <= HOST_TIME_SYNC_TOLERANCE_PPB);
+    print_health(health_h);
+    print_latency(latency_h);
+#if APP_HOTPATH_TRACE
+    hotpath_trace_dump();
+#endif
+
+    return (errors || stats->stale_fetches || sample_allocs) ? 1 : 0;
+}
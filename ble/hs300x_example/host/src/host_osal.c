@@ -0,0 +1,143 @@
+/*
+ * host_osal.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "osal.h"
+
+/* Queue of fixed size items */
+struct host_queue
+{
+    size_t item_size;
+    size_t max_items;
+    size_t head;
+    size_t count;
+    uint8_t items[];
+};
+
+/* Private variables */
+static uint64_t clock_now_us;
+static uint32_t alloc_count;
+
+/**
+ * \brief Advance the virtual clock
+ *
+ * \param[in] us            time to advance by in microseconds
+ *
+ * \return void
+ */
+void host_clock_advance_us(uint64_t us)
+{
+    clock_now_us += us;
+}
+
+/**
+ * \brief Get the virtual time since start up
+ *
+ * \return time in microseconds
+ */
+uint64_t host_clock_now_us(void)
+{
+    return clock_now_us;
+}
+
+/**
+ * \brief Get the number of OS_MALLOC() calls since start up, including those made by the host
+ * OS stand-ins
+ *
+ * \return number of allocations
+ */
+uint32_t host_os_alloc_count(void)
+{
+    return alloc_count;
+}
+
+/**
+ * \brief Allocate memory and count the allocation
+ *
+ * \param[in] size          size in bytes
+ *
+ * \return the memory, zeroed
+ */
+void *host_os_malloc(size_t size)
+{
+    alloc_count++;
+
+    return calloc(1, size);
+}
+
+/**
+ * \brief Create a queue
+ *
+ * \param[in] item_size     size of each item in bytes
+ * \param[in] max_items     number of items the queue holds
+ *
+ * \return the queue
+ */
+OS_QUEUE host_queue_create(size_t item_size, size_t max_items)
+{
+    OS_QUEUE queue = OS_MALLOC(sizeof(*queue) + item_size * max_items);
+
+    OS_ASSERT(queue);
+    queue->item_size = item_size;
+    queue->max_items = max_items;
+
+    return queue;
+}
+
+/**
+ * \brief Add an item to the back of a queue
+ *
+ * \param[in] queue         queue to add to
+ * \param[in] item          item to copy into the queue
+ *
+ * \return OS_QUEUE_OK if the item was added, OS_QUEUE_FULL otherwise
+ */
+OS_BASE_TYPE host_queue_put(OS_QUEUE queue, const void *item)
+{
+    if(queue->count == queue->max_items)
+    {
+        return OS_QUEUE_FULL;
+    }
+
+    memcpy(&queue->items[((queue->head + queue->count) % queue->max_items) * queue->item_size], item, queue->item_size);
+    queue->count++;
+
+    return OS_QUEUE_OK;
+}
+
+/**
+ * \brief Remove the item at the front of a queue
+ *
+ * \param[in] queue         queue to remove from
+ * \param[out] item         buffer the item is copied to
+ *
+ * \return OS_QUEUE_OK if an item was removed, OS_QUEUE_EMPTY otherwise
+ */
+OS_BASE_TYPE host_queue_get(OS_QUEUE queue, void *item)
+{
+    if(queue->count == 0)
+    {
+        return OS_QUEUE_EMPTY;
+    }
+
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->max_items;
+    queue->count--;
+
+    return OS_QUEUE_OK;
+}
+
+/**
+ * \brief Get the number of items in a queue
+ *
+ * \param[in] queue         queue to query
+ *
+ * \return number of items
+ */
+size_t host_queue_count(OS_QUEUE queue)
+{
+    return queue->count;
+}
@@ -0,0 +1,128 @@
+/*
+ * hs300x_platform_host.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include "host_clock.h"
+#include "hs300x_platform.h"
+#include "hs300x_sim.h"
+#include "platform_devices.h"
+
+/* Private variables */
+static const ad_i2c_controller_conf_t sim_i2c_config = { 0 };
+static gpio_config sim_power_gpio[] = { { 0 } };
+
+/* Devices of the host build, see config/platform_devices.c for the target */
+i2c_device hs300x_i2c_config = &sim_i2c_config;
+gpio_config *hs300x_power_gpio = sim_power_gpio;
+
+/**
+ * \brief Open the I2C controller of the HS300x. The host build has a single simulated sensor.
+ *
+ * \param[in] i2c_conf          unused
+ *
+ * \return non-NULL handle
+ */
+ad_i2c_handle_t hs300x_platform_i2c_open(const ad_i2c_controller_conf_t *i2c_conf)
+{
+    return (ad_i2c_handle_t)i2c_conf;
+}
+
+/**
+ * \brief Close the I2C controller of the HS300x
+ *
+ * \param[in] i2c_handle        unused
+ *
+ * \return 0
+ */
+int hs300x_platform_i2c_close(ad_i2c_handle_t i2c_handle)
+{
+    return 0;
+}
+
+/**
+ * \brief Read from the simulated HS300x
+ *
+ * \param[in] i2c_handle        unused
+ * \param[out] buffer           buffer where the data will be placed
+ * \param[in] length            number of bytes to read
+ *
+ * \return 0 on success, I2C abort code otherwise
+ */
+int hs300x_platform_i2c_read(ad_i2c_handle_t i2c_handle, uint8_t *buffer, size_t length)
+{
+    return hs300x_sim_i2c_read(buffer, length);
+}
+
+/**
+ * \brief Write to the simulated HS300x
+ *
+ * \param[in] i2c_handle        unused
+ * \param[in] buffer            data to write
+ * \param[in] length            number of bytes to write
+ *
+ * \return 0 on success, I2C abort code otherwise
+ */
+int hs300x_platform_i2c_write(ad_i2c_handle_t i2c_handle, const uint8_t *buffer, size_t length)
+{
+    return hs300x_sim_i2c_write(buffer, length);
+}
+
+/**
+ * \brief Advance the virtual clock by a number of milliseconds
+ *
+ * \param[in] ms                delay in milliseconds
+ *
+ * \return void
+ */
+void hs300x_platform_delay_ms(uint32_t ms)
+{
+    host_clock_advance_us((uint64_t)ms * 1000);
+}
+
+/**
+ * \brief Advance the virtual clock by a number of microseconds
+ *
+ * \param[in] us                delay in microseconds
+ *
+ * \return void
+ */
+void hs300x_platform_delay_us(uint32_t us)
+{
+    host_clock_advance_us(us);
+}
+
+/**
+ * \brief Switch the supply of the simulated HS300x
+ *
+ * \param[in] power_enable      unused
+ * \param[in] on                true to power the sensor, false to remove power
+ *
+ * \return void
+ */
+void hs300x_platform_power_set(gpio_config power_enable, bool on)
+{
+    hs300x_sim_set_power(on);
+}
+
+/**
+ * \brief Nothing to configure on the host
+ *
+ * \param[in] i2c_conf          unused
+ * \param[in] power_enable      unused
+ *
+ * \return void
+ */
+void hs300x_platform_setup_hardware(const ad_i2c_controller_conf_t *i2c_conf, gpio_config *power_enable)
+{
+}
+
+/**
+ * \brief Get the virtual clock
+ *
+ * \return virtual time in microseconds, wrapping at 32 bits
+ */
+uint32_t hs300x_platform_time_us(void)
+{
+    return (uint32_t)host_clock_now_us();
+}
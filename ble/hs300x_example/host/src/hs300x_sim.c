@@ -0,0 +1,338 @@
+/*
+ * hs300x_sim.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "host_sdk.h"
+#include "host_clock.h"
+#include "hs300x_sim.h"
+
+#define SIM_CODE_MAX                    ((1 << 14) - 1)
+#define SIM_REGISTER_HUMIDITY_RES       (0x06)
+#define SIM_REGISTER_TEMPERATURE_RES    (0x11)
+#define SIM_REGISTER_SENSOR_ID_UPPER    (0x1E)
+#define SIM_REGISTER_SENSOR_ID_LOWER    (0x1F)
+#define SIM_REGISTER_RES_MASK           (0x0C00)
+#define SIM_REGISTER_RES_SHIFT          (10)
+#define SIM_REGISTER_READ_FIRST         (0x00)
+#define SIM_REGISTER_WRITE_FIRST        (0x40)
+#define SIM_COMMAND_ENTER               (0xA0)
+#define SIM_COMMAND_EXIT                (0x80)
+#define SIM_STATUS_SUCCESS              (0x81)
+#define SIM_DATA_STATUS_STALE           (0x01)
+
+/* Private function prototypes */
+static uint16_t conversion_code(float value, float offset, float span, uint8_t res);
+static uint32_t conversion_time_us(uint8_t res);
+static uint8_t register_resolution(uint8_t reg);
+static void start_conversion(void);
+static void update_conversion(void);
+
+/* Private variables */
+static struct
+{
+    bool powered;
+    uint64_t power_on_us;
+    bool programming_mode;
+    uint16_t nvm[HS300x_SIM_NVM_REGISTERS];
+
+    // Register read response
+    uint8_t response[3];
+    uint64_t response_ready_us;
+    uint64_t busy_until_us;             // NVM write in progress
+
+    // Conversion
+    uint8_t humidity_res;               // Resolutions in effect, set on exit from programming mode
+    uint8_t temp_res;
+    bool converting;
+    uint64_t conversion_done_us;
+    bool fetched;
+    uint16_t humidity_code;
+    uint16_t temp_code;
+
+    float env_humidity_rh_pct;
+    float env_temp_deg_c;
+
+    hs300x_sim_stats_t stats;
+} sim;
+
+/* Conversion time per resolution (8, 10, 12, 14 bits), datasheet Table 3 typical values */
+static const uint32_t conversion_time_table_us[] = { 550, 1310, 4500, 16900 };
+
+/**
+ * \brief Convert a physical value to the code the sensor reports at a resolution
+ *
+ * \param[in] value         physical value
+ * \param[in] offset        value that maps to code 0
+ * \param[in] span          range of values covered by the 14 bit code
+ * \param[in] res           resolution register value (0: 8 bits ... 3: 14 bits)
+ *
+ * \return 14 bit code, with the bits below the resolution cleared
+ */
+static uint16_t conversion_code(float value, float offset, float span, uint8_t res)
+{
+    float scaled = (value - offset) * SIM_CODE_MAX / span + 0.5f;
+    uint16_t code = scaled < 0 ? 0 : (scaled > SIM_CODE_MAX ? SIM_CODE_MAX : (uint16_t)scaled);
+    uint8_t dropped_bits = 14 - (8 + 2 * res);
+
+    return code & ~((1 << dropped_bits) - 1);
+}
+
+/**
+ * \brief Get the conversion time of one channel
+ *
+ * \param[in] res           resolution register value
+ *
+ * \return conversion time in microseconds
+ */
+static uint32_t conversion_time_us(uint8_t res)
+{
+    return conversion_time_table_us[res & 0x03];
+}
+
+/**
+ * \brief Get the resolution stored in a resolution register
+ *
+ * \param[in] reg           register address
+ *
+ * \return resolution register value (0: 8 bits ... 3: 14 bits)
+ */
+static uint8_t register_resolution(uint8_t reg)
+{
+    return (sim.nvm[reg] & SIM_REGISTER_RES_MASK) >> SIM_REGISTER_RES_SHIFT;
+}
+
+/**
+ * \brief Start a humidity and temperature conversion
+ *
+ * \return void
+ */
+static void start_conversion(void)
+{
+    sim.converting = true;
+    sim.conversion_done_us = host_clock_now_us() + HS300x_SIM_WAKEUP_us +
+                             conversion_time_us(sim.humidity_res) + conversion_time_us(sim.temp_res);
+    sim.stats.measurements++;
+}
+
+/**
+ * \brief Latch the result of a conversion that has completed by now
+ *
+ * \return void
+ */
+static void update_conversion(void)
+{
+    if(sim.converting && host_clock_now_us() >= sim.conversion_done_us)
+    {
+        // The environment is sampled when the conversion completes
+        sim.humidity_code = conversion_code(sim.env_humidity_rh_pct, 0.0f, 100.0f, sim.humidity_res);
+        sim.temp_code = conversion_code(sim.env_temp_deg_c, -40.0f, 165.0f, sim.temp_res);
+        sim.converting = false;
+        sim.fetched = false;
+    }
+}
+
+/**
+ * \brief Read from the simulated sensor
+ *
+ * \param[out] buffer       buffer where the data will be placed
+ * \param[in] length        number of bytes to read
+ *
+ * \return 0 on success, HW_I2C_ABORT_7B_ADDR_NO_ACK if the sensor does not acknowledge
+ */
+int hs300x_sim_i2c_read(uint8_t *buffer, size_t length)
+{
+    uint64_t now = host_clock_now_us();
+    uint8_t data[4];
+
+    if(!sim.powered || now < sim.busy_until_us)
+    {
+        sim.stats.nacks++;
+        return HW_I2C_ABORT_7B_ADDR_NO_ACK;
+    }
+
+    if(sim.programming_mode)
+    {
+        // Until the command has been processed the response does not carry the success status
+        memcpy(data, sim.response, sizeof(sim.response));
+        data[3] = 0;
+        if(now < sim.response_ready_us)
+        {
+            data[0] = 0;
+        }
+    }
+    else
+    {
+        update_conversion();
+
+        bool stale = sim.converting || sim.fetched;
+        if(stale)
+        {
+            sim.stats.stale_fetches++;
+        }
+        else
+        {
+            sim.stats.valid_fetches++;
+        }
+        sim.fetched = true;
+
+        data[0] = ((stale ? SIM_DATA_STATUS_STALE : 0) << 6) | (sim.humidity_code >> 8);
+        data[1] = sim.humidity_code & 0xFF;
+        data[2] = sim.temp_code >> 6;
+        data[3] = (sim.temp_code & 0x3F) << 2;
+    }
+
+    memcpy(buffer, data, length < sizeof(data) ? length : sizeof(data));
+    return 0;
+}
+
+/**
+ * \brief Write to the simulated sensor
+ *
+ * \param[in] buffer        data to write
+ * \param[in] length        number of bytes to write
+ *
+ * \return 0 on success, HW_I2C_ABORT_7B_ADDR_NO_ACK if the sensor does not acknowledge
+ */
+int hs300x_sim_i2c_write(const uint8_t *buffer, size_t length)
+{
+    uint64_t now = host_clock_now_us();
+
+    if(!sim.powered || now < sim.busy_until_us)
+    {
+        sim.stats.nacks++;
+        return HW_I2C_ABORT_7B_ADDR_NO_ACK;
+    }
+
+    if(!sim.programming_mode)
+    {
+        if(length == 3 && buffer[0] == SIM_COMMAND_ENTER &&
+           now - sim.power_on_us <= HS300x_SIM_PROGRAMMING_WINDOW_us)
+        {
+            sim.programming_mode = true;
+            sim.stats.programming_mode_entries++;
+            memset(sim.response, 0, sizeof(sim.response));
+        }
+        else
+        {
+            // Any other write is a measurement request
+            start_conversion();
+        }
+        return 0;
+    }
+
+    if(length != 3)
+    {
+        return 0;
+    }
+
+    uint8_t cmd = buffer[0];
+    if(cmd == SIM_COMMAND_EXIT)
+    {
+        sim.programming_mode = false;
+        sim.humidity_res = register_resolution(SIM_REGISTER_HUMIDITY_RES);
+        sim.temp_res = register_resolution(SIM_REGISTER_TEMPERATURE_RES);
+    }
+    else if(cmd < SIM_REGISTER_READ_FIRST + HS300x_SIM_NVM_REGISTERS)
+    {
+        sim.response[0] = SIM_STATUS_SUCCESS;
+        sim.response[1] = sim.nvm[cmd] >> 8;
+        sim.response[2] = sim.nvm[cmd] & 0xFF;
+        sim.response_ready_us = now + HS300x_SIM_REGISTER_READ_us;
+    }
+    else if(cmd >= SIM_REGISTER_WRITE_FIRST && cmd < SIM_REGISTER_WRITE_FIRST + HS300x_SIM_NVM_REGISTERS)
+    {
+        sim.nvm[cmd - SIM_REGISTER_WRITE_FIRST] = (buffer[1] << 8) | buffer[2];
+        sim.busy_until_us = now + HS300x_SIM_REGISTER_WRITE_us;
+        sim.stats.nvm_writes++;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Get the value of an NVM register
+ *
+ * \param[in] reg           register address
+ *
+ * \return register value
+ */
+uint16_t hs300x_sim_get_register(uint8_t reg)
+{
+    return sim.nvm[reg % HS300x_SIM_NVM_REGISTERS];
+}
+
+/**
+ * \brief Get the transfer statistics of the simulated sensor
+ *
+ * \return pointer to the statistics
+ */
+const hs300x_sim_stats_t *hs300x_sim_get_stats(void)
+{
+    return &sim.stats;
+}
+
+/**
+ * \brief Reset the simulated sensor to its factory state: unpowered, 14 bit resolution
+ *
+ * \param[in] sensor_id     sensor ID stored in the NVM
+ *
+ * \return void
+ */
+void hs300x_sim_reset(uint32_t sensor_id)
+{
+    memset(&sim, 0, sizeof(sim));
+
+    // Other bits of the resolution registers are reserved and must be preserved by the driver
+    sim.nvm[SIM_REGISTER_HUMIDITY_RES] = 0x0C00 | 0x2051;
+    sim.nvm[SIM_REGISTER_TEMPERATURE_RES] = 0x0C00 | 0x1082;
+    sim.nvm[SIM_REGISTER_SENSOR_ID_UPPER] = sensor_id >> 16;
+    sim.nvm[SIM_REGISTER_SENSOR_ID_LOWER] = sensor_id & 0xFFFF;
+    sim.humidity_res = register_resolution(SIM_REGISTER_HUMIDITY_RES);
+    sim.temp_res = register_resolution(SIM_REGISTER_TEMPERATURE_RES);
+    sim.fetched = true;
+
+    sim.env_humidity_rh_pct = 50.0f;
+    sim.env_temp_deg_c = 25.0f;
+}
+
+/**
+ * \brief Set the humidity and temperature the next conversions measure
+ *
+ * \param[in] humidity_rh_pct       relative humidity in %RH
+ * \param[in] temp_deg_c            temperature in degrees C
+ *
+ * \return void
+ */
+void hs300x_sim_set_environment(float humidity_rh_pct, float temp_deg_c)
+{
+    sim.env_humidity_rh_pct = humidity_rh_pct;
+    sim.env_temp_deg_c = temp_deg_c;
+}
+
+/**
+ * \brief Switch the supply of the simulated sensor. Removing power loses programming mode and any
+ * conversion result, resolutions are reloaded from the NVM on power up.
+ *
+ * \param[in] on            true to power the sensor, false to remove power
+ *
+ * \return void
+ */
+void hs300x_sim_set_power(bool on)
+{
+    if(on && !sim.powered)
+    {
+        sim.power_on_us = host_clock_now_us();
+        sim.humidity_res = register_resolution(SIM_REGISTER_HUMIDITY_RES);
+        sim.temp_res = register_resolution(SIM_REGISTER_TEMPERATURE_RES);
+    }
+    else if(!on)
+    {
+        sim.programming_mode = false;
+        sim.converting = false;
+        sim.fetched = true;
+        sim.busy_until_us = 0;
+    }
+    sim.powered = on;
+}
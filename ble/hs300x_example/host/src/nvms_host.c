@@ -0,0 +1,89 @@
+/*
+ * nvms_host.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdbool.h>
+#include <string.h>
+#include "ad_nvms.h"
+
+/* Size of the generic partition, the only one the host build has */
+#define HOST_NVMS_GENERIC_SIZE          (4096)
+
+typedef struct
+{
+    uint8_t data[HOST_NVMS_GENERIC_SIZE];
+    bool erased;
+} host_nvms_t;
+
+/* Private variables */
+static host_nvms_t generic_part;
+
+/**
+ * \brief Open a partition
+ *
+ * \param[in] id                partition
+ *
+ * \return handle of the partition, NULL if the host build does not have it
+ */
+nvms_t ad_nvms_open(nvms_partition_id_t id)
+{
+    if(id != NVMS_GENERIC_PART)
+    {
+        return NULL;
+    }
+
+    if(!generic_part.erased)
+    {
+        memset(generic_part.data, 0xFF, sizeof(generic_part.data));
+        generic_part.erased = true;
+    }
+
+    return &generic_part;
+}
+
+/**
+ * \brief Read from a partition
+ *
+ * \param[in] handle            partition
+ * \param[in] addr              offset in the partition
+ * \param[out] buf              buffer where the data will be placed
+ * \param[in] len               number of bytes to read
+ *
+ * \return number of bytes read, -1 if out of the partition
+ */
+int ad_nvms_read(nvms_t handle, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    host_nvms_t *part = handle;
+
+    if(addr > sizeof(part->data) || len > sizeof(part->data) - addr)
+    {
+        return -1;
+    }
+
+    memcpy(buf, &part->data[addr], len);
+    return len;
+}
+
+/**
+ * \brief Write to a partition. Like a partition with VES, the write does not need an erase first.
+ *
+ * \param[in] handle            partition
+ * \param[in] addr              offset in the partition
+ * \param[in] buf               data to write
+ * \param[in] size              number of bytes to write
+ *
+ * \return number of bytes written, -1 if out of the partition
+ */
+int ad_nvms_write(nvms_t handle, uint32_t addr, const uint8_t *buf, uint32_t size)
+{
+    host_nvms_t *part = handle;
+
+    if(addr > sizeof(part->data) || size > sizeof(part->data) - addr)
+    {
+        return -1;
+    }
+
+    memcpy(&part->data[addr], buf, size);
+    return size;
+}
@@ -0,0 +1,178 @@
+/*
+ * adv_policy_sim.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "adv_policy.h"
+
+/* Gateway scanning for the node after an outage, one channel per scan interval */
+#define SCAN_INTERVAL_ms                (100.0)
+#define SCAN_WINDOW_ms                  (30.0)
+#define SCAN_MISS_PCT                   (10)
+
+/* Random delay the stack adds to each advertising event */
+#define ADV_DELAY_MAX_ms                (10.0)
+
+#define TRIALS                          (200)
+
+typedef struct
+{
+    double interval_min_ms;
+    double interval_max_ms;
+    double duration_ms;                 /**< 0 for the last stage */
+} stage_t;
+
+typedef struct
+{
+    const char *name;
+    stage_t stages[ADV_POLICY_STAGE_COUNT];
+} policy_t;
+
+static const policy_t policies[] = {
+    { "fixed fast", { { ADV_POLICY_FAST_INTERVAL_MIN_ms, ADV_POLICY_FAST_INTERVAL_MAX_ms, 0 } } },
+    { "fixed medium", { { ADV_POLICY_MEDIUM_INTERVAL_MIN_ms, ADV_POLICY_MEDIUM_INTERVAL_MAX_ms, 0 } } },
+    { "fixed slow", { { ADV_POLICY_SLOW_INTERVAL_MIN_ms, ADV_POLICY_SLOW_INTERVAL_MAX_ms, 0 } } },
+    { "adv_policy.h", {
+        { ADV_POLICY_FAST_INTERVAL_MIN_ms, ADV_POLICY_FAST_INTERVAL_MAX_ms, ADV_POLICY_FAST_DURATION_ms },
+        { ADV_POLICY_MEDIUM_INTERVAL_MIN_ms, ADV_POLICY_MEDIUM_INTERVAL_MAX_ms, ADV_POLICY_MEDIUM_DURATION_ms },
+        { ADV_POLICY_SLOW_INTERVAL_MIN_ms, ADV_POLICY_SLOW_INTERVAL_MAX_ms, 0 } } },
+};
+
+/* Time from the disconnection to the gateway scanning again */
+static const double outages_ms[] = { 0, 10 * 1000.0, 60 * 1000.0, 10 * 60 * 1000.0, 60 * 60 * 1000.0 };
+
+static uint32_t rng_state = 0x2545F491;
+
+/**
+ * \brief Order doubles for qsort()
+ *
+ * \return negative, zero or positive as a is below, equal to or above b
+ */
+static int compare_double(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+
+    return (da > db) - (da < db);
+}
+
+/**
+ * \brief Uniform random number, from a xorshift generator with a fixed seed so runs repeat
+ *
+ * \param[in] min               lower bound
+ * \param[in] max               upper bound
+ *
+ * \return number between min and max
+ */
+static double uniform(double min, double max)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+
+    return min + (max - min) * (rng_state / 4294967296.0);
+}
+
+/**
+ * \brief Simulate one disconnection: the node advertises from time 0 following the policy, the gateway
+ * scans from the end of the outage and connects on the first advertising event it receives.
+ *
+ * \param[in] policy            advertising policy of the node
+ * \param[in] outage_ms         time the gateway starts scanning
+ * \param[out] events           advertising events until the connection
+ *
+ * \return time from the end of the outage to the connection, in ms
+ */
+static double simulate(const policy_t *policy, double outage_ms, uint32_t *events)
+{
+    double scan_phase_ms = uniform(0.0, SCAN_INTERVAL_ms);
+    double t = uniform(0.0, ADV_DELAY_MAX_ms);
+    double stage_end_ms = policy->stages[0].duration_ms;
+    int stage = 0;
+
+    *events = 0;
+
+    for(;;)
+    {
+        // The stage changes with the first event after its end, as the stack restarts advertising
+        while(policy->stages[stage].duration_ms && t >= stage_end_ms)
+        {
+            stage++;
+            stage_end_ms += policy->stages[stage].duration_ms;
+        }
+
+        (*events)++;
+
+        if(t >= outage_ms && fmod(t - scan_phase_ms + SCAN_INTERVAL_ms, SCAN_INTERVAL_ms) < SCAN_WINDOW_ms &&
+           uniform(0.0, 100.0) >= SCAN_MISS_PCT)
+        {
+            return t - outage_ms;
+        }
+
+        t += uniform(policy->stages[stage].interval_min_ms, policy->stages[stage].interval_max_ms) +
+             uniform(0.0, ADV_DELAY_MAX_ms);
+    }
+}
+
+/**
+ * \brief Simulate the policies of adv_policy.h, and each of its stages used alone, against a gateway
+ * back from outages of several lengths. Prints as a table the time to reconnect once the gateway scans
+ * again, the advertising duty cycle from the disconnection to the reconnection, and the duty cycle of
+ * a node left unconnected.
+ *
+ * Usage: adv_policy_sim
+ *
+ * \return 0
+ */
+int main(void)
+{
+    static double reconnect_ms[TRIALS];
+
+    printf("Scan %.0f ms window every %.0f ms, %d %% of packets missed, %d us per advertising event\n\n",
+           SCAN_WINDOW_ms, SCAN_INTERVAL_ms, SCAN_MISS_PCT, ADV_POLICY_EVENT_RADIO_us);
+    printf("| Policy | Outage (s) | Reconnect mean (ms) | Reconnect p95 (ms) | Duty until reconnected (%%) | Unconnected duty (%%) |\n");
+    printf("|--------|------------|---------------------|--------------------|----------------------------|-----------------------|\n");
+
+    for(size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++)
+    {
+        const policy_t *policy = &policies[p];
+        const stage_t *last = &policy->stages[0];
+
+        while(last->duration_ms)
+        {
+            last++;
+        }
+
+        // Once in the last stage the node stays there
+        double idle_duty = ADV_POLICY_EVENT_RADIO_us / 1000.0 /
+                           ((last->interval_min_ms + last->interval_max_ms + ADV_DELAY_MAX_ms) / 2.0) * 100.0;
+
+        for(size_t o = 0; o < sizeof(outages_ms) / sizeof(outages_ms[0]); o++)
+        {
+            double total_ms = 0.0;
+            double elapsed_ms = 0.0;
+            double total_events = 0.0;
+
+            for(int trial = 0; trial < TRIALS; trial++)
+            {
+                uint32_t events;
+
+                reconnect_ms[trial] = simulate(policy, outages_ms[o], &events);
+                total_ms += reconnect_ms[trial];
+                elapsed_ms += outages_ms[o] + reconnect_ms[trial];
+                total_events += events;
+            }
+
+            qsort(reconnect_ms, TRIALS, sizeof(reconnect_ms[0]), compare_double);
+
+            printf("| %s | %.0f | %.0f | %.0f | %.3f | %.3f |\n",
+                   policy->name, outages_ms[o] / 1000.0, total_ms / TRIALS, reconnect_ms[TRIALS * 95 / 100],
+                   total_events * ADV_POLICY_EVENT_RADIO_us / 1000.0 / elapsed_ms * 100.0, idle_duty);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * psychro_accuracy.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <math.h>
+#include <stdio.h>
+#include "psychro.h"
+
+/* Grid of inputs compared, in hundredths */
+#define GRID_TEMP_STEP_x100             (25)
+#define GRID_HUMIDITY_STEP_x100         (50)
+
+/* Relative errors of absolute humidity are only counted above this, below it the 0.01 g/m3 resolution dominates */
+#define AH_RELATIVE_MIN                 (5.0)
+
+typedef struct
+{
+    int32_t temp_min_x100;
+    int32_t temp_max_x100;
+    uint32_t points;
+    uint32_t below_range;       /**< Dew points below PSYCHRO_DEW_POINT_MIN_x100, not compared */
+    double dew_point;
+    double abs_humidity;
+    double abs_humidity_rel;
+    double heat_index;
+} band_t;
+
+static band_t bands[] = {
+    { .temp_min_x100 = -4000, .temp_max_x100 = -25 },
+    { .temp_min_x100 = 0, .temp_max_x100 = 3975 },
+    { .temp_min_x100 = 4000, .temp_max_x100 = 7975 },
+    { .temp_min_x100 = 8000, .temp_max_x100 = 12500 },
+};
+
+/**
+ * \brief NOAA heat index in double precision, see psychro.h
+ *
+ * \param[in] temp              temperature in degrees C
+ * \param[in] rh                relative humidity in %RH
+ *
+ * \return heat index in degrees C
+ */
+static double reference_heat_index(double temp, double rh)
+{
+    double t = temp * 1.8 + 32.0;
+    double hi = 0.5 * (t + 61.0 + (t - 68.0) * 1.2 + rh * 0.094);
+
+    if((hi + t) / 2.0 >= 80.0)
+    {
+        hi = -42.379 + 2.04901523 * t + 10.14333127 * rh - 0.22475541 * t * rh - 0.00683783 * t * t
+             - 0.05481717 * rh * rh + 0.00122874 * t * t * rh + 0.00085282 * t * rh * rh
+             - 0.00000199 * t * t * rh * rh;
+
+        if(rh < 13.0 && t >= 80.0 && t <= 112.0)
+        {
+            hi -= ((13.0 - rh) / 4.0) * sqrt((17.0 - fabs(t - 95.0)) / 17.0);
+        }
+        else if(rh > 85.0 && t >= 80.0 && t <= 87.0)
+        {
+            hi += ((rh - 85.0) / 10.0) * ((87.0 - t) / 5.0);
+        }
+    }
+
+    return (hi - 32.0) / 1.8;
+}
+
+/**
+ * \brief Keep the larger of a running maximum and a new error
+ *
+ * \param[in,out] max           running maximum
+ * \param[in] error             new error, of either sign
+ *
+ * \return void
+ */
+static void update_max(double *max, double error)
+{
+    if(fabs(error) > *max)
+    {
+        *max = fabs(error);
+    }
+}
+
+/**
+ * \brief Compare psychro_compute() with a double precision implementation of the same formulas over a
+ * grid of temperatures and humidities, and print the largest errors per temperature band as a table.
+ * Heat indexes above 100 C are left out, the regression means nothing there.
+ *
+ * Usage: psychro_accuracy
+ *
+ * \return 0
+ */
+int main(void)
+{
+    for(size_t b = 0; b < sizeof(bands) / sizeof(bands[0]); b++)
+    {
+        band_t *band = &bands[b];
+
+        for(int32_t temp_x100 = band->temp_min_x100; temp_x100 <= band->temp_max_x100; temp_x100 += GRID_TEMP_STEP_x100)
+        {
+            for(int32_t humidity_x100 = 0; humidity_x100 <= 10000; humidity_x100 += GRID_HUMIDITY_STEP_x100)
+            {
+                hs300x_fixed_t fixed = { .humidity_x100 = humidity_x100, .temp_x100 = temp_x100 };
+                psychro_t derived;
+                double temp = temp_x100 / 100.0;
+                double rh = humidity_x100 / 100.0;
+
+                psychro_compute(&fixed, &derived);
+                band->points++;
+
+                double gamma = log(rh / 100.0) + 17.62 * temp / (243.12 + temp);
+                double dew_point = 243.12 * gamma / (17.62 - gamma);
+                double vapour_pressure = rh / 100.0 * 611.2 * exp(17.62 * temp / (243.12 + temp));
+                double abs_humidity = 2.16679 * vapour_pressure / (temp + 273.15);
+                double heat_index = reference_heat_index(temp, rh);
+
+                if(humidity_x100 == 0 || dew_point * 100.0 < PSYCHRO_DEW_POINT_MIN_x100)
+                {
+                    band->below_range++;
+                }
+                else
+                {
+                    update_max(&band->dew_point, derived.dew_point_x100 / 100.0 - dew_point);
+                }
+
+                if(abs_humidity < UINT16_MAX / 100.0)
+                {
+                    update_max(&band->abs_humidity, derived.abs_humidity_x100 / 100.0 - abs_humidity);
+                    if(abs_humidity >= AH_RELATIVE_MIN)
+                    {
+                        update_max(&band->abs_humidity_rel, (derived.abs_humidity_x100 / 100.0 - abs_humidity) / abs_humidity * 100.0);
+                    }
+                }
+
+                if(heat_index < 100.0)
+                {
+                    update_max(&band->heat_index, derived.heat_index_x100 / 100.0 - heat_index);
+                }
+            }
+        }
+    }
+
+    printf("| Temperature (C) | Points | Dew point below -80 C | Dew point (C) | Abs. humidity (g/m3) | Abs. humidity >= 5 g/m3 (%%) | Heat index (C) |\n");
+    printf("|-----------------|--------|-----------------------|---------------|----------------------|------------------------------|----------------|\n");
+    for(size_t b = 0; b < sizeof(bands) / sizeof(bands[0]); b++)
+    {
+        const band_t *band = &bands[b];
+
+        printf("| %.2f to %.2f | %lu | %lu | %.3f | %.3f | %.3f | %.3f |\n",
+               band->temp_min_x100 / 100.0, band->temp_max_x100 / 100.0, (unsigned long)band->points,
+               (unsigned long)band->below_range, band->dew_point, band->abs_humidity, band->abs_humidity_rel,
+               band->heat_index);
+    }
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * sample_stream_decode.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdio.h>
+#include "sample_stream.h"
+
+/**
+ * \brief Decode a binary sample stream (APP_UART_STREAM) and print the records as CSV. Bytes that are
+ * not part of a valid frame, such as text printed by the firmware, are skipped.
+ *
+ * Usage: sample_stream_decode < capture.bin
+ *        stty -F /dev/ttyUSB0 115200 raw && sample_stream_decode < /dev/ttyUSB0
+ *
+ * The counters of the decoder are printed on stderr at the end of the input.
+ *
+ * \return 0 if no frame failed its CRC and no record is missing, 1 otherwise
+ */
+int main(void)
+{
+    sample_stream_decoder_t decoder;
+    sample_stream_record_t record;
+    int c;
+
+    sample_stream_decoder_init(&decoder);
+
+    printf("seq,time_ms,humidity_rh_pct,temp_deg_c\n");
+
+    while((c = getchar()) != EOF)
+    {
+        if(sample_stream_decode_byte(&decoder, (uint8_t)c, &record))
+        {
+            printf("%lu,%lu,%.3f,%.3f\n", (unsigned long)record.seq, (unsigned long)record.time_ms,
+                   record.humidity_rh_pct, record.temp_deg_c);
+        }
+    }
+
+    fprintf(stderr, "records %lu, missing %lu, CRC errors %lu, bad frames %lu\n",
+            (unsigned long)decoder.records, (unsigned long)decoder.missing,
+            (unsigned long)decoder.crc_errors, (unsigned long)decoder.bad_frames);
+
+    return (decoder.crc_errors || decoder.missing) ? 1 : 0;
+}
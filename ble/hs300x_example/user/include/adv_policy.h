@@ -0,0 +1,90 @@
+/*
+ * adv_policy.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef ADV_POLICY_H_
+#define ADV_POLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Advertising policy. Advertising dominates the idle current of a node nobody is connected to, so
+ * the interval steps down over time:
+ *
+ * - fast:   for ADV_POLICY_FAST_DURATION_ms after boot, after a disconnection and after a boost, so a
+ *           gateway that lost the link, or was waiting for the node, reconnects within a scan window.
+ * - medium: for ADV_POLICY_MEDIUM_DURATION_ms after that, for a gateway back from a short outage.
+ * - slow:   until the next connection, disconnection or boost.
+ *
+ * Once a client is connected the stack advertises at the slow interval, for further clients.
+ *
+ * A boost goes back to the fast stage when the node has something to deliver, an alarm raised or the
+ * unacknowledged backlog of the sample stream close to the size of the history, and nobody connected
+ * to deliver it to. Boosts closer than ADV_POLICY_BOOST_HOLDOFF_ms are ignored, so a condition that
+ * lasts does not keep the node fast.
+ *
+ * Intervals are the advertising interval range given to the stack, which adds its 0 to 10 ms random
+ * delay to each event.
+ */
+#define ADV_POLICY_FAST_INTERVAL_MIN_ms         (20)
+#define ADV_POLICY_FAST_INTERVAL_MAX_ms         (30)
+#define ADV_POLICY_FAST_DURATION_ms             (30 * 1000)
+
+#define ADV_POLICY_MEDIUM_INTERVAL_MIN_ms       (150)
+#define ADV_POLICY_MEDIUM_INTERVAL_MAX_ms       (210)
+#define ADV_POLICY_MEDIUM_DURATION_ms           (5 * 60 * 1000)
+
+#define ADV_POLICY_SLOW_INTERVAL_MIN_ms         (1000)
+#define ADV_POLICY_SLOW_INTERVAL_MAX_ms         (1280)
+
+#define ADV_POLICY_BOOST_HOLDOFF_ms             (10 * 60 * 1000)
+
+/* Boost once the unacknowledged backlog reaches this share of SAMPLE_HISTORY_LENGTH, in % */
+#define ADV_POLICY_BOOST_BACKLOG_PCT            (75)
+
+/*
+ * Radio time of an advertising event: a legacy PDU with 31 bytes of data on each of the three primary
+ * channels, and the receive window for a request after each. Used to estimate the duty cycle.
+ */
+#define ADV_POLICY_EVENT_RADIO_us               (1500)
+
+/* Notified to the BLE task when the current stage is over, see hs300x_task.h for the other bits */
+#define ADV_POLICY_NOTIFY_MASK                  (1 << 3)
+
+typedef enum
+{
+    ADV_POLICY_STAGE_FAST,
+    ADV_POLICY_STAGE_MEDIUM,
+    ADV_POLICY_STAGE_SLOW,
+    ADV_POLICY_STAGE_COUNT
+} adv_policy_stage_t;
+
+/*
+ * Time to connect runs from the start of the latest fast stage to the next connection. The duty cycle
+ * while advertising is adv_events * ADV_POLICY_EVENT_RADIO_us / (advertising_ms * 1000).
+ */
+typedef struct
+{
+    uint32_t connections;               /**< Connections made since the start of a fast stage */
+    uint32_t last_connect_ms;           /**< Time to connect of the latest of them */
+    uint32_t total_connect_ms;          /**< Sum of their times to connect, for the mean */
+    uint32_t max_connect_ms;            /**< Longest of their times to connect */
+    uint32_t advertising_ms;            /**< Time spent advertising */
+    uint32_t adv_events;                /**< Advertising events, estimated from the mean interval of each stage */
+    uint32_t boosts;                    /**< Boosts that went back to the fast stage */
+    uint8_t stage;                      /**< Current stage, as adv_policy_stage_t */
+} adv_policy_stats_t;
+
+void adv_policy_adv_completed(void);
+void adv_policy_boost(void);
+void adv_policy_connected(void);
+void adv_policy_disconnected(void);
+void adv_policy_get_stats(adv_policy_stats_t *stats);
+void adv_policy_init(void);
+void adv_policy_stage_expired(void);
+void adv_policy_start(void);
+
+#endif /* ADV_POLICY_H_ */
@@ -0,0 +1,110 @@
+/*
+ * alarm.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef ALARM_H_
+#define ALARM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hs300x.h"
+
+/*
+ * Alarm rules evaluated on every sample, after calibration. The engine reads the samples from the sample
+ * bus in the BLE task, so evaluating them adds nothing to the sampling path. Each rule watches
+ * one channel and raises when:
+ *
+ * - ALARM_TYPE_ABOVE: the value is at or above the threshold
+ * - ALARM_TYPE_BELOW: the value is at or below the threshold
+ * - ALARM_TYPE_RISE_RATE: the value rises at or faster than the threshold, per minute
+ * - ALARM_TYPE_FALL_RATE: the value falls at or faster than the threshold, per minute
+ *
+ * The condition must hold for min_duration_s before the rule raises. A raised rule clears as soon as the
+ * value, or rate, is back more than the hysteresis on the other side of the threshold.
+ *
+ * Rates are per channel, the change between two samples scaled to a minute and smoothed over about
+ * 1 << ALARM_RATE_SMOOTHING_SHIFT samples, so a rate rule follows a sustained change rather than noise.
+ *
+ * The rules are stored in the generic NVMS partition and loaded by alarm_init().
+ */
+#define ALARM_MAX_RULES                         (8)
+#define ALARM_RATE_SMOOTHING_SHIFT              (2)
+
+/*
+ * Encoded rules, as stored and as read or written over BLE. All fields little endian:
+ *
+ *   uint8_t  count                     number of rules, up to ALARM_MAX_RULES
+ *   each rule:
+ *     uint8_t  channel                 alarm_channel_t
+ *     uint8_t  type                    alarm_type_t
+ *     int16_t  threshold_x100          level in 0.01 %RH or 0.01 C, or rate magnitude in the same units per minute
+ *     uint16_t hysteresis_x100         same unit as the threshold
+ *     uint16_t min_duration_s          time the condition must hold before the rule raises, 0 to raise at once
+ */
+#define ALARM_RULE_SIZE                         (8)
+#define ALARM_RULES_ENCODED_MAX_SIZE            (1 + ALARM_MAX_RULES * ALARM_RULE_SIZE)
+
+/*
+ * Encoded state, as read and indicated over BLE. All fields little endian:
+ *
+ *   uint8_t  active                    bit n set while rule n is raised
+ *   uint8_t  changed                   bit n set if rule n raised or cleared since the previous state
+ *   uint16_t humidity_x100             measurement of the latest change, 0.01 %RH
+ *   int16_t  temp_x100                 0.01 C
+ */
+#define ALARM_STATE_SIZE                        (6)
+
+typedef enum
+{
+    ALARM_CHANNEL_HUMIDITY,
+    ALARM_CHANNEL_TEMP,
+    ALARM_CHANNEL_COUNT,
+} alarm_channel_t;
+
+typedef enum
+{
+    ALARM_TYPE_ABOVE,
+    ALARM_TYPE_BELOW,
+    ALARM_TYPE_RISE_RATE,
+    ALARM_TYPE_FALL_RATE,
+    ALARM_TYPE_COUNT,
+} alarm_type_t;
+
+typedef enum
+{
+    ALARM_ERROR_NONE,
+    ALARM_ERROR_LENGTH,                 /**< Encoded length does not match the rule count */
+    ALARM_ERROR_INVALID,                /**< Channel, type or threshold out of range, or stored copy corrupted */
+    ALARM_ERROR_STORAGE,                /**< NVMS read or write failed */
+} alarm_error_t;
+
+typedef struct
+{
+    uint8_t channel;
+    uint8_t type;
+    int16_t threshold_x100;
+    uint16_t hysteresis_x100;
+    uint16_t min_duration_s;
+} alarm_rule_t;
+
+typedef struct
+{
+    uint8_t active;
+    uint8_t changed;
+    uint16_t humidity_x100;
+    int16_t temp_x100;
+} alarm_state_t;
+
+alarm_error_t alarm_decode_rules(const uint8_t *buf, uint16_t length, alarm_rule_t *rules, uint8_t *count);
+uint16_t alarm_encode_rules(const alarm_rule_t *rules, uint8_t count, uint8_t *buf);
+uint16_t alarm_encode_state(const alarm_state_t *state, uint8_t *buf);
+void alarm_evaluate(const hs300x_raw_t *raw, uint32_t time_ms);
+uint8_t alarm_get_rules(alarm_rule_t *rules);
+alarm_error_t alarm_init(void);
+void alarm_process_samples(void);
+alarm_error_t alarm_set_rules(const alarm_rule_t *rules, uint8_t count);
+bool alarm_take_changes(alarm_state_t *state);
+
+#endif /* ALARM_H_ */
@@ -0,0 +1,29 @@
+/*
+ * alarm_service.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef ALARM_SERVICE_H_
+#define ALARM_SERVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_service.h>
+
+/*
+ * Alarm service. Exposes the rule engine of alarm.h:
+ *
+ * Alarm State: read and indicate. The state encoded as described in alarm.h. Indicated to every client
+ * that enabled indications when a rule raises or clears, never while the rules keep their state. A read
+ * returns the latest state indicated.
+ *
+ * Alarm Rules: read and write. The rules encoded as described in alarm.h. A write replaces all the rules,
+ * stores them and applies them from the next sample. Out of range rules are rejected with
+ * ATT_ERROR_OUT_OF_RANGE and nothing is changed. The whole value must be written at once.
+ */
+ble_service_t *alarm_service_init(void);
+bool alarm_service_indicate_changes(ble_service_t *svc);
+bool alarm_service_indications_enabled(ble_service_t *svc, uint16_t conn_idx);
+
+#endif /* ALARM_SERVICE_H_ */
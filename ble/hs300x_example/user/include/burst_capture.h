@@ -0,0 +1,76 @@
+/*
+ * burst_capture.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef BURST_CAPTURE_H_
+#define BURST_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <osal.h>
+#include "hs300x.h"
+
+/*
+ * Burst capture: a number of back to back conversions at the fastest rate the resolution allows, for
+ * transients that periodic sampling is too slow for. A burst is requested by a client (see
+ * l2cap_history.h), run by the task that owns the sensor with burst_capture_run(), and the requester is
+ * notified once the buffer is ready to upload. Only one burst is held at a time.
+ *
+ * The periodic samples stop for the duration of the burst. The sampling task busy waits for each
+ * conversion, so tasks of lower priority do not run either. When the sampling engine runs in the BLE task
+ * (APP_SINGLE_TASK) no BLE event is handled during the burst either, so bursts are limited to the
+ * conversions that fit in BURST_CAPTURE_SINGLE_TASK_MAX_us at the configured resolution.
+ */
+
+/* Size of the capture buffer, in conversions. Each takes sizeof(burst_sample_t) bytes of RAM. */
+#ifndef BURST_CAPTURE_MAX_SAMPLES
+#define BURST_CAPTURE_MAX_SAMPLES               (256)
+#endif
+
+/* Longest a burst may busy wait in the BLE task, when the sampling engine runs in it. At least one
+ * conversion is always allowed. */
+#ifndef BURST_CAPTURE_SINGLE_TASK_MAX_us
+#define BURST_CAPTURE_SINGLE_TASK_MAX_us        (50000)
+#endif
+
+/* Reads of a conversion that is still stale before the burst is aborted */
+#define BURST_CAPTURE_MAX_POLLS                 (20)
+
+/* Notification bit set in the task running the sampling engine when a burst is requested, and in the
+ * requesting task when the burst is complete */
+#define BURST_CAPTURE_NOTIFY_MASK               (1 << 2)
+
+typedef struct
+{
+    uint32_t t_us;              /**< Start of the conversion, in microseconds from the start of the burst */
+    uint8_t raw[HS300x_MEASUREMENT_LENGTH_HUMIDITY_AND_TEMP];  /**< Measurement as read, see hs300x_fetch_raw() */
+} burst_sample_t;
+
+typedef enum
+{
+    BURST_CAPTURE_STATE_IDLE,           /**< No burst, a new one can be requested */
+    BURST_CAPTURE_STATE_REQUESTED,      /**< Waiting for the sampling task */
+    BURST_CAPTURE_STATE_RUNNING,        /**< Conversions in progress */
+    BURST_CAPTURE_STATE_DONE,           /**< Samples ready to upload, release them with burst_capture_release() */
+} burst_capture_state_t;
+
+typedef struct
+{
+    const burst_sample_t *samples;
+    uint16_t count;             /**< Conversions captured */
+    uint16_t requested;         /**< Conversions requested */
+    uint32_t duration_us;       /**< Time from the start of the first conversion to the end of the last */
+    uint32_t stale_polls;       /**< Reads that found the conversion still in progress */
+    hs300x_error_t error;       /**< HS300x_ERROR_NONE, or the error the burst was aborted on */
+} burst_capture_result_t;
+
+bool burst_capture_get_result(burst_capture_result_t *result);
+burst_capture_state_t burst_capture_get_state(void);
+void burst_capture_register_task(OS_TASK task, uint16_t max_samples);
+void burst_capture_release(void);
+bool burst_capture_request(uint16_t count, OS_TASK requester);
+bool burst_capture_run(hs300x_handle_t *hs300x_handle);
+
+#endif /* BURST_CAPTURE_H_ */
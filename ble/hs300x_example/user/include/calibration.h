@@ -0,0 +1,94 @@
+/*
+ * calibration.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hs300x.h"
+
+/*
+ * Per sensor calibration. Each channel, humidity and temperature, has up to CALIBRATION_MAX_POINTS points
+ * pairing a reading of this sensor with the reference it should have read. Between two points the
+ * correction is linear, below the first point and above the last it extends the first and last segment.
+ * One point is a pure offset, no point leaves the channel as read.
+ *
+ * The correction is applied to the conversion codes by the sampling engine, before a sample is stored or
+ * published, so every consumer gets corrected values. Burst captures keep the bytes as read.
+ *
+ * The calibration is stored in the generic NVMS partition with the sensor ID it was made for. It is only
+ * applied while that sensor is fitted.
+ */
+
+/* Most points per channel */
+#define CALIBRATION_MAX_POINTS                  (8)
+
+/*
+ * The codes are split in buckets of 1 << CALIBRATION_BUCKET_SHIFT codes, each pointing at the segment
+ * its first code falls in. Points of a channel must be at least one bucket apart, 1.56 %RH or 2.52 C,
+ * so the segment of a code is found with one lookup and at most one comparison.
+ */
+#define CALIBRATION_BUCKET_SHIFT                (8)
+
+/* Gain of a segment between two points, reference over measured, in percent */
+#define CALIBRATION_GAIN_MIN_PCT                (50)
+#define CALIBRATION_GAIN_MAX_PCT                (200)
+
+/*
+ * Encoded calibration, as stored and as read or written over BLE. All fields little endian:
+ *
+ *   uint32_t sensor_id
+ *   uint8_t  humidity point count
+ *   uint8_t  temperature point count
+ *   humidity points, then temperature points, each:
+ *     int16_t measured_x100     reading of this sensor, 0.01 %RH or 0.01 C
+ *     int16_t reference_x100    reference reading, same unit
+ *
+ * Points are in increasing order of measured value.
+ */
+#define CALIBRATION_HEADER_SIZE                 (6)
+#define CALIBRATION_POINT_SIZE                  (4)
+#define CALIBRATION_ENCODED_MAX_SIZE            (CALIBRATION_HEADER_SIZE + \
+                                                 CALIBRATION_CHANNEL_COUNT * CALIBRATION_MAX_POINTS * CALIBRATION_POINT_SIZE)
+
+typedef enum
+{
+    CALIBRATION_CHANNEL_HUMIDITY,
+    CALIBRATION_CHANNEL_TEMP,
+    CALIBRATION_CHANNEL_COUNT,
+} calibration_channel_t;
+
+typedef enum
+{
+    CALIBRATION_ERROR_NONE,
+    CALIBRATION_ERROR_LENGTH,           /**< Encoded length does not match the point counts */
+    CALIBRATION_ERROR_INVALID,          /**< Point out of range, out of order, too close, gain out of range or stored copy corrupted */
+    CALIBRATION_ERROR_SENSOR_ID,        /**< Made for another sensor */
+    CALIBRATION_ERROR_STORAGE,          /**< NVMS read or write failed */
+} calibration_error_t;
+
+typedef struct
+{
+    int16_t measured_x100;
+    int16_t reference_x100;
+} calibration_point_t;
+
+typedef struct
+{
+    uint32_t sensor_id;
+    uint8_t count[CALIBRATION_CHANNEL_COUNT];
+    calibration_point_t points[CALIBRATION_CHANNEL_COUNT][CALIBRATION_MAX_POINTS];
+} calibration_t;
+
+void calibration_apply(hs300x_raw_t *raw);
+calibration_error_t calibration_decode(const uint8_t *buf, uint16_t length, calibration_t *calibration);
+uint16_t calibration_encode(const calibration_t *calibration, uint8_t *buf);
+void calibration_get(calibration_t *calibration);
+calibration_error_t calibration_init(uint32_t sensor_id);
+calibration_error_t calibration_set(const calibration_t *calibration);
+
+#endif /* CALIBRATION_H_ */
@@ -0,0 +1,72 @@
+/*
+ * conn_policy.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CONN_POLICY_H_
+#define CONN_POLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_common.h>
+#include <ble_gap.h>
+
+/*
+ * Connection policy. Requests connection parameters, PHY and data length per connection based on
+ * what the connection is used for:
+ *
+ * - idle:      connected without notifications or indications. Long interval and slave latency.
+ * - streaming: notifications or indications enabled on any service, written on the connection or
+ *              stored for a bonded client. Interval and slave latency follow the rate the connection
+ *              receives samples at, so the radio wakes about once per sample.
+ * - bulk:      bulk history transfer active, or the sample stream draining a backlog. Short interval,
+ *              2M PHY and maximum data length.
+ *
+ * A new connection keeps the parameters the central chose while it discovers the services, exchanges
+ * the MTU and writes the CCCs, which would crawl at idle parameters. The policy applies once the client
+ * enables notifications, see conn_policy_client_ready(), or CONN_POLICY_SETTLE_TIMEOUT_ms after the
+ * connection, or as soon as a bulk transfer or backlog starts.
+ */
+#define CONN_POLICY_MAX_CONNECTIONS             (4)
+
+#define CONN_POLICY_PREFERRED_MTU               (247)
+#define CONN_POLICY_DATA_LENGTH_MAX             (251)
+#define CONN_POLICY_DATA_TIME_MAX_us            (2120)
+
+/* Bulk transfer parameters */
+#define CONN_POLICY_BULK_INTERVAL_MIN_ms        (15)
+#define CONN_POLICY_BULK_INTERVAL_MAX_ms        (30)
+
+/* Idle parameters */
+#define CONN_POLICY_IDLE_INTERVAL_MIN_ms        (500)
+#define CONN_POLICY_IDLE_INTERVAL_MAX_ms        (1000)
+#define CONN_POLICY_IDLE_SLAVE_LATENCY          (4)
+
+/* Limits for streaming parameters */
+#define CONN_POLICY_STREAM_INTERVAL_MIN_ms      (15)
+#define CONN_POLICY_STREAM_INTERVAL_MAX_ms      (400)
+#define CONN_POLICY_SLAVE_LATENCY_MAX           (30)
+
+#define CONN_POLICY_SUPERVISION_TIMEOUT_MIN_ms  (2000)
+#define CONN_POLICY_SUPERVISION_TIMEOUT_MAX_ms  (32000)
+
+/* Time left to a new connection for its set up before the policy applies */
+#define CONN_POLICY_SETTLE_TIMEOUT_ms           (10000)
+
+/* Notified to the BLE task when the set up time of a connection is over, see hs300x_task.h for the other bits */
+#define CONN_POLICY_NOTIFY_MASK                 (1 << 4)
+
+void conn_policy_client_ready(uint16_t conn_idx);
+void conn_policy_connected(const ble_evt_gap_connected_t *evt);
+void conn_policy_disconnected(uint16_t conn_idx);
+void conn_policy_handle_event(const ble_evt_hdr_t *hdr);
+void conn_policy_init(uint32_t sample_rate_ms);
+void conn_policy_set_backlog(uint16_t conn_idx, bool draining);
+void conn_policy_set_bulk(uint16_t conn_idx, bool active);
+void conn_policy_set_conn_sample_rate(uint16_t conn_idx, uint32_t sample_rate_ms);
+void conn_policy_set_sample_rate(uint32_t sample_rate_ms);
+void conn_policy_set_streaming(uint16_t conn_idx, bool enabled);
+void conn_policy_settle_expired(void);
+
+#endif /* CONN_POLICY_H_ */
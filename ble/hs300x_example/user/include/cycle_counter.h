@@ -0,0 +1,76 @@
+/*
+ * cycle_counter.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CYCLE_COUNTER_H_
+#define CYCLE_COUNTER_H_
+
+#include <stdint.h>
+
+/*
+ * Free running counter for timing short code sections. On the DA1469x this is the DWT cycle counter
+ * of the Cortex-M33, counting CPU clock cycles. On the host build it is CLOCK_MONOTONIC in
+ * nanoseconds. Both wrap at 32 bits, so take the difference of two readings as an unsigned value.
+ *
+ * The DWT is powered down in extended sleep, which stops and clears the count and the enable set by
+ * cycle_counter_init(). Builds that trace with it (APP_HOTPATH_TRACE, APP_LATENCY_TRACE) keep the
+ * system in pm_mode_active, see main.c. The benchmarks run without blocking and start it themselves.
+ */
+#if defined(__arm__)
+
+#include "sdk_defs.h"
+#include "sys_clock_mgr.h"
+
+#define CYCLE_COUNTER_UNIT      "cycles"
+
+/* Pick the limit that applies to this counter: CPU cycles on the target, nanoseconds on the host */
+#define CYCLE_COUNTER_LIMIT(cycles, ns)     (cycles)
+
+static inline void cycle_counter_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t cycle_counter_read(void)
+{
+    return DWT->CYCCNT;
+}
+
+/* The CPU clock may be changed by the clock manager, so convert with the clock running now */
+static inline uint32_t cycle_counter_to_us(uint32_t count)
+{
+    return count / cm_cpu_clk_get_fromISR();
+}
+
+#else
+
+#include <time.h>
+
+#define CYCLE_COUNTER_UNIT      "ns"
+
+#define CYCLE_COUNTER_LIMIT(cycles, ns)     (ns)
+
+static inline void cycle_counter_init(void)
+{
+}
+
+static inline uint32_t cycle_counter_read(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+static inline uint32_t cycle_counter_to_us(uint32_t count)
+{
+    return count / 1000;
+}
+
+#endif
+
+#endif /* CYCLE_COUNTER_H_ */
@@ -0,0 +1,98 @@
+/*
+ * diag_counters.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef DIAG_COUNTERS_H_
+#define DIAG_COUNTERS_H_
+
+#include <stdint.h>
+#include <osal.h>
+#include "hs300x.h"
+
+/*
+ * Health counters of the application. The counters are plain increments on the hot path: each one
+ * is only updated from one task (or from the power manager with interrupts disabled), so they are
+ * not locked. A reader may see a count that is one behind.
+ */
+
+/* Measurement errors by hs300x_error_t code */
+typedef enum
+{
+    DIAG_ERROR_I2C_IO_CONFIG_INVALID,
+    DIAG_ERROR_I2C_CONTROLLER_BUSY,
+    DIAG_ERROR_I2C_DRIVER_CONF_INVALID,
+    DIAG_ERROR_I2C_HANDLE_INVALID,
+    DIAG_ERROR_I2C_ABORT_7B_ADDR_NO_ACK,
+    DIAG_ERROR_I2C_ABORT_10B_ADDR1_NO_ACK,
+    DIAG_ERROR_I2C_ABORT_10B_ADDR2_NO_ACK,
+    DIAG_ERROR_I2C_ABORT_TX_DATA_NO_ACK,
+    DIAG_ERROR_I2C_ABORT_GENERAL_CALL_NO_ACK,
+    DIAG_ERROR_I2C_ABORT_GENERAL_CALL_READ,
+    DIAG_ERROR_I2C_ABORT_START_BYTE_ACK,
+    DIAG_ERROR_I2C_ABORT_10B_READ_NO_RESTART,
+    DIAG_ERROR_I2C_ABORT_MASTER_DISABLED,
+    DIAG_ERROR_I2C_ABORT_ARBITRATION_LOST,
+    DIAG_ERROR_I2C_ABORT_SLAVE_FLUSH_TX_FIFO,
+    DIAG_ERROR_I2C_ABORT_SLAVE_ARBITRATION_LOST,
+    DIAG_ERROR_I2C_ABORT_SLAVE_IN_TX,
+    DIAG_ERROR_I2C_ABORT_SW_ERROR,
+    DIAG_ERROR_DATA_ACCESS_FAIL,
+    DIAG_ERROR_OTHER,                   /**< Any other code, e.g. several abort sources at once */
+    DIAG_ERROR_COUNT,
+} diag_error_t;
+
+/* Tasks whose stack is monitored */
+typedef enum
+{
+    DIAG_TASK_BLE,
+    DIAG_TASK_HS300x,
+    DIAG_TASK_COUNT,
+} diag_task_t;
+
+typedef struct
+{
+    uint32_t errors[DIAG_ERROR_COUNT];  /**< Failed measurements by error code */
+    uint32_t stale_samples;             /**< Measurements returning HS300x_ERROR_STALE_DATA */
+    uint32_t queue_drops;               /**< Samples dropped because the sample queue was full */
+    uint32_t notify_failures;           /**< Notifications ble_gatts_send_event() did not accept */
+    uint32_t sleep_count;               /**< Times the system went to sleep */
+    uint32_t wake_count;                /**< Times the system woke up */
+    uint32_t ble_events;                /**< Events handled by the BLE task */
+    uint32_t ble_wakeups;               /**< Times the BLE task woke up to handle events */
+} diag_counters_t;
+
+/*
+ * Packed health record, as read from the Health characteristic of the diagnostics service.
+ * Little endian:
+ *
+ *   u8  format version (DIAG_COUNTERS_PACK_VERSION)
+ *   u32 uptime in seconds
+ *   u32 stale samples
+ *   u32 queue drops
+ *   u32 notification send failures
+ *   u32 sleep count
+ *   u32 wake count
+ *   u32 BLE events handled
+ *   u32 BLE task wakeups for events; BLE events / wakeups is the average batch
+ *   u32 free heap in bytes
+ *   u32 minimum free heap since boot in bytes
+ *   u32 heap size in bytes (configTOTAL_HEAP_SIZE)
+ *   u16 minimum free stack since boot in bytes, for each diag_task_t
+ *   u16 measurement error count for each diag_error_t, saturating at 0xFFFF
+ */
+#define DIAG_COUNTERS_PACK_VERSION              (2)
+#define DIAG_COUNTERS_PACK_SIZE                 (1 + 11 * sizeof(uint32_t) + \
+                                                 (DIAG_TASK_COUNT + DIAG_ERROR_COUNT) * sizeof(uint16_t))
+
+extern diag_counters_t diag_counters;
+
+#define DIAG_COUNTER_INC(counter)               (diag_counters.counter++)
+
+void diag_counters_init(void);
+void diag_counters_measurement_error(hs300x_error_t error);
+uint16_t diag_counters_pack(uint8_t *buf);
+void diag_counters_register_task(diag_task_t task, OS_TASK handle);
+
+#endif /* DIAG_COUNTERS_H_ */
@@ -0,0 +1,34 @@
+/*
+ * diag_service.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef DIAG_SERVICE_H_
+#define DIAG_SERVICE_H_
+
+#include <stdint.h>
+#include <ble_service.h>
+
+/*
+ * Diagnostics service. Read only characteristics for looking into a unit in the field without a
+ * debugger. All values are little endian.
+ *
+ * Health: the packed health record described in diag_counters.h.
+ *
+ * Sample Latency: u32 number of samples recorded, then for each latency_stage_t in order the u32
+ * p50, p95 and p99 latency in microseconds. All zero unless APP_LATENCY_TRACE is set.
+ *
+ * Hot Path Trace: for each hotpath_site_t in order the u32 count, min, mean and max in cycle counter
+ * units. All zero unless APP_HOTPATH_TRACE is set.
+ *
+ * Advertising: the advertising policy statistics of adv_policy.h, u32 connections, last, mean and max
+ * time to connect in ms, advertising time in ms, advertising events and boosts, then the u8 current
+ * stage. All zero unless APP_ADV_POLICY is set.
+ *
+ * The values are longer than the default ATT MTU. Clients either exchange a larger MTU (see
+ * CONN_POLICY_PREFERRED_MTU) or read them with Read Blob requests.
+ */
+ble_service_t *diag_service_init(void);
+
+#endif /* DIAG_SERVICE_H_ */
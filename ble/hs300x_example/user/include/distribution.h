@@ -0,0 +1,64 @@
+/*
+ * distribution.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef DISTRIBUTION_H_
+#define DISTRIBUTION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hs300x.h"
+
+/*
+ * Long term distribution of the samples since the last reset, in fixed RAM whatever the run time:
+ *
+ * - a histogram of humidity in 1 %RH bins, for the share of samples at or above a threshold
+ * - P2 estimators (Jain and Chlamtac) of DISTRIBUTION_QUANTILE_COUNT quantiles of each channel
+ *
+ * The samples are read from the sample bus in the BLE task, see distribution_process_samples(), so the
+ * sampling engine only publishes them. Each sample costs a histogram increment and one update per estimator, none of which depends on the
+ * number of samples. The shares are of samples, which is the share of time while the sample rate is fixed.
+ */
+
+/* Quantiles estimated for each channel, in percent */
+#define DISTRIBUTION_QUANTILES                  { 5, 50, 95 }
+#define DISTRIBUTION_QUANTILE_COUNT             (3)
+
+#define DISTRIBUTION_HUMIDITY_BINS              (100)
+
+/* Threshold of the humidity share until another one is set, in %RH */
+#define DISTRIBUTION_DEFAULT_THRESHOLD_PCT      (60)
+
+/*
+ * Summary as read over BLE, all fields little endian:
+ *
+ *   uint32_t samples                   samples since the last reset
+ *   uint8_t  threshold_pct             humidity threshold, %RH
+ *   uint16_t above_threshold_x100      share of samples at or above it, 0.01 %
+ *   uint16_t humidity_x100[3]          humidity quantiles, in DISTRIBUTION_QUANTILES order, 0.01 %RH
+ *   int16_t  temp_x100[3]              temperature quantiles, 0.01 C
+ *
+ * 19 bytes, so it fits one read at the default ATT MTU.
+ */
+#define DISTRIBUTION_SUMMARY_SIZE               (7 + 4 * DISTRIBUTION_QUANTILE_COUNT)
+
+typedef struct
+{
+    uint32_t samples;
+    uint8_t threshold_pct;
+    uint16_t above_threshold_x100;
+    uint16_t humidity_x100[DISTRIBUTION_QUANTILE_COUNT];
+    int16_t temp_x100[DISTRIBUTION_QUANTILE_COUNT];
+} distribution_summary_t;
+
+uint16_t distribution_encode_summary(const distribution_summary_t *summary, uint8_t *buf);
+void distribution_get_summary(distribution_summary_t *summary);
+void distribution_init(void);
+void distribution_process_samples(void);
+void distribution_put(const hs300x_raw_t *raw);
+void distribution_reset(void);
+bool distribution_set_threshold(uint8_t threshold_pct);
+
+#endif /* DISTRIBUTION_H_ */
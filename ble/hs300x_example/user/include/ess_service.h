@@ -0,0 +1,52 @@
+/*
+ * ess_service.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef ESS_SERVICE_H_
+#define ESS_SERVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_service.h>
+#include "hs300x.h"
+
+/*
+ * Environmental Sensing Service (0x181A) exposing Humidity and Temperature characteristics.
+ *
+ * Each characteristic has an ES Measurement descriptor, two ES Trigger Setting descriptors and an
+ * ES Configuration descriptor combining them. Notifications are only sent when the triggers fire:
+ *
+ *   0x00 trigger inactive
+ *   0x01 fixed time interval (operand: seconds, u24)
+ *   0x02 no less than the specified time between transmissions (operand: seconds, u24)
+ *   0x03 value changed
+ *   0x04 - 0x09 value crosses a threshold (less than, less or equal, greater than, greater or equal,
+ *        equal, not equal. Operand: threshold in characteristic units). Fires when the comparison
+ *        becomes true.
+ */
+#define ESS_TRIGGERS_PER_CHAR                   (2)
+
+#define ESS_TRIGGER_INACTIVE                    (0x00)
+#define ESS_TRIGGER_FIXED_INTERVAL              (0x01)
+#define ESS_TRIGGER_MIN_INTERVAL                (0x02)
+#define ESS_TRIGGER_VALUE_CHANGED               (0x03)
+#define ESS_TRIGGER_LESS_THAN                   (0x04)
+#define ESS_TRIGGER_LESS_OR_EQUAL               (0x05)
+#define ESS_TRIGGER_GREATER_THAN                (0x06)
+#define ESS_TRIGGER_GREATER_OR_EQUAL            (0x07)
+#define ESS_TRIGGER_EQUAL                       (0x08)
+#define ESS_TRIGGER_NOT_EQUAL                   (0x09)
+
+#define ESS_TRIGGER_LOGIC_OR                    (0x00)
+#define ESS_TRIGGER_LOGIC_AND                   (0x01)
+
+ble_service_t *ess_service_init(void);
+bool ess_service_notifications_enabled(ble_service_t *svc, uint16_t conn_idx);
+void ess_service_restore_state(ble_service_t *svc);
+void ess_service_save_state(ble_service_t *svc);
+void ess_service_set_update_interval(ble_service_t *svc, uint32_t rate_ms);
+void ess_service_update(ble_service_t *svc, const hs300x_data_t *value);
+
+#endif /* ESS_SERVICE_H_ */
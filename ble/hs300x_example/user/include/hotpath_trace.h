@@ -0,0 +1,77 @@
+/*
+ * hotpath_trace.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HOTPATH_TRACE_H_
+#define HOTPATH_TRACE_H_
+
+#include <stdint.h>
+#include "cycle_counter.h"
+
+/*
+ * Trace points around the sample hot path. Each point takes a cycle_counter stamp when the section
+ * starts and records the elapsed count in the statistics of its site when it ends. The statistics
+ * live in RAM and are printed over the console UART by hotpath_trace_dump().
+ *
+ * Sections that block, where the task may be switched out and the system may sleep, are not CPU
+ * time. Their trace points use the OS tick count instead (HOTPATH_TRACE_TICKS_START/STOP) and their
+ * statistics are reported in ticks, apart from the cycle counts.
+ *
+ * With APP_HOTPATH_TRACE set to 0 the trace points compile to nothing.
+ */
+#ifndef APP_HOTPATH_TRACE
+#define APP_HOTPATH_TRACE                       (0)
+#endif
+
+/* Number of samples between two dumps of the statistics by the sampling task, 0 to disable */
+#ifndef HOTPATH_TRACE_DUMP_INTERVAL
+#define HOTPATH_TRACE_DUMP_INTERVAL             (60)
+#endif
+
+/* Histogram bin n counts durations in [2^n, 2^(n+1)). Bin 0 also counts 0. The last bin is open ended. */
+#define HOTPATH_TRACE_HIST_BINS                 (24)
+
+typedef enum
+{
+    HOTPATH_SITE_I2C_READ,              /**< hs300x_read() */
+    HOTPATH_SITE_I2C_WRITE,             /**< hs300x_write() */
+    HOTPATH_SITE_MEASUREMENT_DELAY,     /**< Wait for the conversion to complete, in ticks */
+    HOTPATH_SITE_QUEUE_PUT,             /**< Sampling task puts a sample on the queue */
+    HOTPATH_SITE_QUEUE_GET,             /**< BLE task gets a sample from the queue */
+    HOTPATH_SITE_BLE_EVENT,             /**< BLE task handles one BLE event */
+    HOTPATH_SITE_NOTIFY_SEND,           /**< A notification is sent with ble_gatts_send_event() */
+    HOTPATH_SITE_BUS_PUBLISH,           /**< Sampling engine publishes a sample on the sample bus */
+    HOTPATH_SITE_COUNT,
+} hotpath_site_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t hist[HOTPATH_TRACE_HIST_BINS];
+} hotpath_site_stats_t;
+
+#if APP_HOTPATH_TRACE
+#define HOTPATH_TRACE_START(stamp)              uint32_t stamp = cycle_counter_read()
+#define HOTPATH_TRACE_STOP(site, stamp)         hotpath_trace_record((site), cycle_counter_read() - (stamp))
+#define HOTPATH_TRACE_TICKS_START(stamp)        uint32_t stamp = hotpath_trace_ticks()
+#define HOTPATH_TRACE_TICKS_STOP(site, stamp)   hotpath_trace_record((site), hotpath_trace_ticks() - (stamp))
+#else
+#define HOTPATH_TRACE_START(stamp)
+#define HOTPATH_TRACE_STOP(site, stamp)
+#define HOTPATH_TRACE_TICKS_START(stamp)
+#define HOTPATH_TRACE_TICKS_STOP(site, stamp)
+#endif
+
+void hotpath_trace_dump(void);
+void hotpath_trace_get(hotpath_site_t site, hotpath_site_stats_t *stats);
+void hotpath_trace_init(void);
+void hotpath_trace_record(hotpath_site_t site, uint32_t elapsed);
+void hotpath_trace_reset(void);
+uint32_t hotpath_trace_ticks(void);
+
+#endif /* HOTPATH_TRACE_H_ */
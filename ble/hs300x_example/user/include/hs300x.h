@@ -37,6 +37,20 @@
 #define HS300x_CALC_TEMP_C_VALUE_165              (165.0F)
 #define HS300x_CALC_TEMP_C_VALUE_40               (40.0F)
 
+/* Definitions for Calculation in hundredths, see hs300x_convert_raw_fixed() */
+#define HS300x_FIXED_HUMD_SCALE_Q15               (20001)       /* 10000 / 16383 in Q15 */
+#define HS300x_FIXED_TEMP_SCALE_Q14               (16501)       /* 16500 / 16383 in Q14 */
+#define HS300x_FIXED_TEMP_OFFSET                  (4000)
+
+/* Use the DSP extension of the Cortex-M33 in hs300x_convert_raw_fixed_batch() when the compiler targets it */
+#ifndef HS300x_CONVERT_DSP
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define HS300x_CONVERT_DSP                        (1)
+#else
+#define HS300x_CONVERT_DSP                        (0)
+#endif
+#endif
+
 
 /* Definitions for Programming mode */
 #define HS300x_PROGRAMMING_MODE_ENTER                   (0xA0)
@@ -93,6 +107,25 @@ typedef struct
     float temp_deg_c;
 } hs300x_data_t;
 
+/*
+ * Conversion codes of a measurement, status bits removed. Half the size of hs300x_data_t, so samples are
+ * carried and stored as codes and converted with hs300x_convert_raw() only where units are needed.
+ */
+typedef struct
+{
+    uint16_t humidity;          /**< 14 bit humidity code */
+    uint16_t temp;              /**< 14 bit temperature code */
+} hs300x_raw_t;
+
+/*
+ * Measurement in hundredths of a unit, the resolution of the ESS characteristics and the broadcast
+ */
+typedef struct
+{
+    uint16_t humidity_x100;     /**< Relative humidity in 0.01 %RH */
+    int16_t temp_x100;          /**< Temperature in 0.01 degrees C */
+} hs300x_fixed_t;
+
 typedef struct
 {
     ad_i2c_handle_t i2c_handle;          /**< I2C handle for the sensor*/
@@ -126,15 +159,28 @@ typedef enum
     HS300x_ERROR_I2C_ABORT_SLAVE_IN_TX = HW_I2C_ABORT_SLAVE_IN_TX,                           /**< (slave mode) request for data replied with read request */
     HS300x_ERROR_I2C_ABORT_SW_ERROR = HW_I2C_ABORT_SW_ERROR,
 	HS300x_ERROR_DATA_ACCESS_FAIL,
+	HS300x_ERROR_STALE_DATA,                /**< measurement was read before a new conversion completed. The data is that of the previous measurement */
 } hs300x_error_t;
 
 void hs300x_close(hs300x_handle_t* hs300x_handle);
+void hs300x_convert_raw(const hs300x_raw_t *raw, hs300x_data_t *calculated_data);
+void hs300x_convert_raw_batch(const hs300x_raw_t *raw, hs300x_data_t *calculated_data, size_t count);
+void hs300x_convert_raw_fixed(const hs300x_raw_t *raw, hs300x_fixed_t *fixed);
+void hs300x_convert_raw_fixed_batch(const hs300x_raw_t *raw, hs300x_fixed_t *fixed, size_t count);
+void hs300x_convert_raw_to_humid_temp(const uint8_t *raw_data, bool data_includes_temp, hs300x_data_t *calculated_data);
 hs300x_error_t hs300x_enter_programming_mode(hs300x_handle_t* hs300x_handle);
 hs300x_error_t hs300x_exit_programming_mode(hs300x_handle_t* hs300x_handle);
+hs300x_error_t hs300x_fetch_measurement(hs300x_handle_t* hs300x_handle, bool data_includes_temp, hs300x_data_t *calculated_data);
+hs300x_error_t hs300x_fetch_measurement_raw(hs300x_handle_t* hs300x_handle, bool data_includes_temp, hs300x_raw_t *raw);
+hs300x_error_t hs300x_fetch_raw(hs300x_handle_t* hs300x_handle, bool data_includes_temp, uint8_t *raw_data);
+uint32_t hs300x_get_conversion_time_us(const hs300x_handle_t* hs300x_handle);
 hs300x_error_t hs300x_get_measurement(hs300x_handle_t* hs300x_handle, bool data_includes_temp, hs300x_data_t *calculated_data);
+uint32_t hs300x_get_measurement_delay_ms(const hs300x_handle_t* hs300x_handle);
+hs300x_error_t hs300x_get_measurement_raw(hs300x_handle_t* hs300x_handle, bool data_includes_temp, hs300x_raw_t *raw);
 hs300x_error_t hs300x_get_resolution(hs300x_handle_t* hs300x_handle, hs300x_resolution_type_t type, hs300x_resolution_t *resolution);
 hs300x_error_t hs300x_get_sensor_id(hs300x_handle_t* hs300x_handle, uint32_t *id);
 ad_i2c_handle_t hs300x_open(const ad_i2c_controller_conf_t *i2c_conf);
+void hs300x_parse_raw(const uint8_t *raw_data, bool data_includes_temp, hs300x_raw_t *raw);
 void hs300x_power_cycle_sensor(gpio_config power_enable);
 hs300x_error_t hs300x_read(hs300x_handle_t* hs300x_handle, uint8_t *response_buffer, size_t response_length);
 hs300x_error_t hs300x_set_resolution(hs300x_handle_t* hs300x_handle, hs300x_resolution_t resolution, hs300x_resolution_type_t type);
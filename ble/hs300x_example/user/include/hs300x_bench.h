@@ -0,0 +1,27 @@
+/*
+ * hs300x_bench.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HS300x_BENCH_H_
+#define HS300x_BENCH_H_
+
+#include <stdint.h>
+#include "ble_service.h"
+
+/*
+ * Microbenchmarks of the sample hot path: conversion, console formatting, the queue hand-off to the
+ * BLE task, the notification fan-out and the ESS payload encoding.
+ *
+ * Every benchmark prints one line:
+ *
+ *     BENCH,<name>,<iterations>,<min>,<mean>,<max>,<limit>,<unit>,<PASS|FAIL>
+ *
+ * min/mean/max are per iteration, with the overhead of reading the counter removed. A benchmark fails
+ * when its mean exceeds its limit. The run ends with BENCH_SUMMARY,<passed>,<failed>.
+ */
+
+uint32_t hs300x_bench_run(ble_service_t *sensor_svc, ble_service_t *ess_svc);
+
+#endif /* HS300x_BENCH_H_ */
@@ -0,0 +1,32 @@
+/*
+ * hs300x_platform.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef HS300x_PLATFORM_H_
+#define HS300x_PLATFORM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <ad_i2c.h>
+#include <hw_gpio.h>
+
+/*
+ * Platform services used by the HS300x driver. The driver does not call the I2C adapter, GPIO or
+ * clock drivers directly, so it can be linked against either the DA1469x implementation
+ * (hs300x_platform.c) or the simulated sensor of the host build (host/hs300x_platform_host.c).
+ */
+
+ad_i2c_handle_t hs300x_platform_i2c_open(const ad_i2c_controller_conf_t *i2c_conf);
+int hs300x_platform_i2c_close(ad_i2c_handle_t i2c_handle);
+int hs300x_platform_i2c_read(ad_i2c_handle_t i2c_handle, uint8_t *buffer, size_t length);
+int hs300x_platform_i2c_write(ad_i2c_handle_t i2c_handle, const uint8_t *buffer, size_t length);
+void hs300x_platform_delay_ms(uint32_t ms);
+void hs300x_platform_delay_us(uint32_t us);
+void hs300x_platform_power_set(gpio_config power_enable, bool on);
+void hs300x_platform_setup_hardware(const ad_i2c_controller_conf_t *i2c_conf, gpio_config *power_enable);
+uint32_t hs300x_platform_time_us(void);
+
+#endif /* HS300x_PLATFORM_H_ */
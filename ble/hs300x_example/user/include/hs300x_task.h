@@ -13,18 +13,51 @@
 #include <stdbool.h>
 #include <osal.h>
 #include "hs300x.h"
+#include "latency_trace.h"
 
 /*
  * Notification bits reservation
  *
  * Bit #0 is always assigned to BLE event queue notification.
+ * Bit #2 is BURST_CAPTURE_NOTIFY_MASK, see burst_capture.h.
+ * Bit #3 is ADV_POLICY_NOTIFY_MASK, see adv_policy.h.
+ * Bit #4 is CONN_POLICY_NOTIFY_MASK, see conn_policy.h.
  */
 #define HS3001_MEASUREMENT_NOTIFY_MASK       (1 << 1)
 
+#define HS300x_TASK_DEFAULT_SAMPLE_RATE_ms   (1000)
+
+/* Size of a console line produced by hs300x_task_format_sample() */
+#define HS300x_TASK_SAMPLE_LINE_LEN          (80)
+
+/*
+ * A measurement as it travels from the sampling task to its consumers
+ */
+typedef struct
+{
+    uint32_t seq;               /**< Sequence number assigned when the sample is taken. The first sample is 1 */
+    uint32_t time_ms;           /**< Time the sample was taken, from time_sync_local_ms(). See time_sync.h for UTC */
+    hs300x_raw_t raw;           /**< Conversion codes of the sample, see hs300x_convert_raw() */
+#if APP_LATENCY_TRACE
+    uint32_t stamps[LATENCY_STAMP_COUNT];       /**< Time the sample passed each stage, see latency_trace.h */
+#endif
+} hs300x_sample_t;
+
+/* Resolutions set by hs300x_task_init() */
+extern hs300x_resolution_t user_humidity_resolution;
+extern hs300x_resolution_t user_temperature_resolution;
+
+bool hs300x_task_engine_run(hs300x_sample_t *sample);
+void hs300x_task_engine_start(void);
+OS_TICK_TIME hs300x_task_engine_ticks_to_deadline(void);
 void hs300x_task_event_queue_register(const OS_TASK task_handle);
+int hs300x_task_format_sample(char *buf, size_t size, uint32_t rate_ms, const hs300x_data_t *data);
 void hs300x_task(void *pvParameters);
 uint32_t hs300x_task_get_sensor_id();
 uint32_t hs300x_task_get_sample_rate();
+void hs300x_task_init(OS_QUEUE q);
+void hs300x_task_print_samples(void);
+hs300x_error_t hs300x_task_sample(void);
 void hs300x_task_set_sample_rate(uint32_t rate);
 void hs300x_task_setup_hardware();
 
@@ -0,0 +1,71 @@
+/*
+ * l2cap_history.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef L2CAP_HISTORY_H_
+#define L2CAP_HISTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_common.h>
+#include <ble_service.h>
+
+/*
+ * Bulk transfer of the sample history over an LE credit based L2CAP connection oriented channel.
+ *
+ * Protocol (all fields little endian):
+ *
+ * Client -> device
+ *   START  [0x01][start_seq u32]      stream all stored samples from start_seq onwards
+ *   STOP   [0x02]                     abort the current transfer
+ *   BURST  [0x03][count u16]          capture count conversions back to back (see burst_capture.h), then
+ *                                     send them with BURST_DATA and BURST_END
+ *
+ * Device -> client
+ *   DATA   [0x81][first_seq u32][count u8][count x (humidity float, temperature float)]
+ *                                     samples first_seq .. first_seq + count - 1. first_seq is later than
+ *                                     requested if older samples have already been overwritten.
+ *   END    [0x82][next_seq u32][samples u32][elapsed_ms u32]
+ *                                     transfer complete. A client resumes after a disconnection by
+ *                                     sending START with the last next_seq (or last DATA seq + 1) it saw.
+ *   BURST_DATA [0x83][first_index u16][count u8][count x (t_us u32, raw 4 bytes)]
+ *                                     conversions first_index .. first_index + count - 1 of the burst.
+ *                                     t_us is the start of the conversion from the start of the burst,
+ *                                     raw the measurement as read from the sensor, status bits included.
+ *   BURST_END  [0x84][status u8][samples u16][duration_us u32][stale_polls u32]
+ *                                     burst complete. status is one of L2CAP_HISTORY_BURST_STATUS_*.
+ */
+#define L2CAP_HISTORY_PSM                       (0x0081)
+
+#define L2CAP_HISTORY_OPCODE_START              (0x01)
+#define L2CAP_HISTORY_OPCODE_STOP               (0x02)
+#define L2CAP_HISTORY_OPCODE_DATA               (0x81)
+#define L2CAP_HISTORY_OPCODE_END                (0x82)
+#define L2CAP_HISTORY_OPCODE_BURST              (0x03)
+#define L2CAP_HISTORY_OPCODE_BURST_DATA         (0x83)
+#define L2CAP_HISTORY_OPCODE_BURST_END          (0x84)
+
+#define L2CAP_HISTORY_BURST_STATUS_OK           (0x00)  /**< All the conversions requested were captured */
+#define L2CAP_HISTORY_BURST_STATUS_REJECTED     (0x01)  /**< Count out of range (see burst_capture.h), or another burst in progress */
+#define L2CAP_HISTORY_BURST_STATUS_SENSOR_ERROR (0x02)  /**< Aborted on a sensor error, samples holds those captured */
+
+/* Credits granted to the client for sending requests */
+#define L2CAP_HISTORY_INITIAL_CREDITS           (4)
+
+/* Largest SDU the device will send. Further limited by the MTU of the channel */
+#define L2CAP_HISTORY_SDU_MAX                   (244)
+
+/* Number of SDUs handed to the BLE manager before waiting for a sent event */
+#define L2CAP_HISTORY_MAX_IN_FLIGHT             (4)
+
+#define L2CAP_HISTORY_MAX_CHANNELS              (2)
+
+void l2cap_history_burst_complete(void);
+void l2cap_history_connected(uint16_t conn_idx);
+void l2cap_history_disconnected(uint16_t conn_idx);
+bool l2cap_history_handle_event(const ble_evt_hdr_t *hdr);
+void l2cap_history_init(ble_service_t *stream_service);
+
+#endif /* L2CAP_HISTORY_H_ */
@@ -0,0 +1,64 @@
+/*
+ * latency_trace.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef LATENCY_TRACE_H_
+#define LATENCY_TRACE_H_
+
+#include <stdint.h>
+#include "cycle_counter.h"
+
+/*
+ * End to end latency of the samples. Each sample carries a cycle_counter stamp for every stage it
+ * passes; when the BLE task is done with it the stage latencies go into histograms kept on the
+ * device, from which the percentiles are read.
+ *
+ * With APP_LATENCY_TRACE set to 0 the stamps are not part of hs300x_sample_t and the stamping
+ * compiles to nothing. Note the stamps make every sample on the queue and the sample bus 16 bytes larger.
+ */
+#ifndef APP_LATENCY_TRACE
+#define APP_LATENCY_TRACE                       (0)
+#endif
+
+/* Points a sample passes, in order */
+typedef enum
+{
+    LATENCY_STAMP_READ,                 /**< Conversion read from the sensor */
+    LATENCY_STAMP_QUEUED,               /**< Put on the sample queue */
+    LATENCY_STAMP_DEQUEUED,             /**< Taken from the queue by the BLE task */
+    LATENCY_STAMP_SENT,                 /**< Handed to the BLE stack with ble_gatts_send_event() */
+    LATENCY_STAMP_COUNT,
+} latency_stamp_t;
+
+/* Time between two stamps */
+typedef enum
+{
+    LATENCY_STAGE_PROCESS,              /**< READ to QUEUED: printing and storing the sample */
+    LATENCY_STAGE_WAKEUP,               /**< QUEUED to DEQUEUED: notifying and scheduling the BLE task */
+    LATENCY_STAGE_SEND,                 /**< DEQUEUED to SENT: the services encoding and sending */
+    LATENCY_STAGE_TOTAL,                /**< READ to SENT */
+    LATENCY_STAGE_COUNT,
+} latency_stage_t;
+
+typedef struct
+{
+    uint32_t count;                     /**< Samples recorded */
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+} latency_percentiles_t;
+
+#if APP_LATENCY_TRACE
+#define LATENCY_TRACE_STAMP(sample, stamp)      ((sample)->stamps[(stamp)] = cycle_counter_read())
+#else
+#define LATENCY_TRACE_STAMP(sample, stamp)
+#endif
+
+void latency_trace_get(latency_stage_t stage, latency_percentiles_t *percentiles);
+void latency_trace_init(void);
+void latency_trace_record(const uint32_t *stamps);
+void latency_trace_reset(void);
+
+#endif /* LATENCY_TRACE_H_ */
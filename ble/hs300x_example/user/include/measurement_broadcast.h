@@ -0,0 +1,34 @@
+/*
+ * measurement_broadcast.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MEASUREMENT_BROADCAST_H_
+#define MEASUREMENT_BROADCAST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hs300x_task.h"
+
+/*
+ * Connectionless broadcast of the latest measurement in the advertising data, so passive scanners
+ * can collect measurements without connecting. The local name moves to the scan response to make
+ * room for the measurement.
+ *
+ * Manufacturer specific data (little endian):
+ *   [company id u16][version u8][sensor id hash u16][seq u16][humidity u16][temperature s16]
+ *
+ *   sensor id hash     upper and lower halves of the HS300x sensor ID XORed together
+ *   seq                lower 16 bits of the sample sequence number. 0 until the first sample
+ *   humidity           0.01 %RH
+ *   temperature        0.01 degrees C
+ */
+#define MEASUREMENT_BROADCAST_COMPANY_ID        (0x00D2)
+#define MEASUREMENT_BROADCAST_VERSION           (0x01)
+#define MEASUREMENT_BROADCAST_DATA_SIZE         (11)
+
+void measurement_broadcast_start(const char *name, size_t name_len);
+void measurement_broadcast_update(const hs300x_sample_t *sample);
+
+#endif /* MEASUREMENT_BROADCAST_H_ */
@@ -0,0 +1,43 @@
+/*
+ * nvms_record.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef NVMS_RECORD_H_
+#define NVMS_RECORD_H_
+
+#include <stdint.h>
+
+/*
+ * Settings kept in the generic NVMS partition. Each setting has a fixed slot holding one record:
+ *
+ *   uint32_t magic                     identifies the setting and its format version
+ *   uint16_t length                    payload length
+ *   uint8_t  payload[length]
+ *   uint16_t crc                       sample_stream_crc16() of the payload
+ *
+ * All fields little endian. A slot that does not start with the magic holds nothing yet.
+ */
+#define NVMS_RECORD_PARTITION                   (NVMS_GENERIC_PART)
+#define NVMS_RECORD_SLOT_SIZE                   (128)
+#define NVMS_RECORD_OVERHEAD                    (8)
+#define NVMS_RECORD_MAX_PAYLOAD                 (NVMS_RECORD_SLOT_SIZE - NVMS_RECORD_OVERHEAD)
+
+/* Slots */
+#define NVMS_RECORD_ADDR_CALIBRATION            (0 * NVMS_RECORD_SLOT_SIZE)
+#define NVMS_RECORD_ADDR_ALARM_RULES            (1 * NVMS_RECORD_SLOT_SIZE)
+
+typedef enum
+{
+    NVMS_RECORD_OK,
+    NVMS_RECORD_EMPTY,                  /**< Nothing stored in the slot */
+    NVMS_RECORD_INVALID,                /**< Length too large for the buffer or CRC mismatch */
+    NVMS_RECORD_STORAGE_ERROR,          /**< NVMS open, read or write failed */
+} nvms_record_status_t;
+
+nvms_record_status_t nvms_record_read(uint32_t addr, uint32_t magic, uint8_t *payload, uint16_t max_length,
+                                      uint16_t *length);
+nvms_record_status_t nvms_record_write(uint32_t addr, uint32_t magic, const uint8_t *payload, uint16_t length);
+
+#endif /* NVMS_RECORD_H_ */
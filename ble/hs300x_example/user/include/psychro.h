@@ -0,0 +1,36 @@
+/*
+ * psychro.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYCHRO_H_
+#define PSYCHRO_H_
+
+#include <stdint.h>
+#include "hs300x.h"
+
+/*
+ * Values derived from a measurement, so clients do not each have to compute them.
+ *
+ * Dew point and absolute humidity use the Magnus formula over water (6.112 hPa, 17.62, 243.12 C).
+ * The saturation vapour pressure is read from a table at 1 C steps and interpolated, and the dew point
+ * is found by searching the same table, so neither needs logf() or expf(). The heat index is the NOAA
+ * algorithm: the Rothfusz regression with its adjustments above 80 F, the simple formula below. It is
+ * close to the air temperature in cool weather. See the Readme for the error against a double precision
+ * implementation.
+ */
+
+/* Lowest dew point in the table. Drier air reports this value. */
+#define PSYCHRO_DEW_POINT_MIN_x100              (-8000)
+
+typedef struct
+{
+    int16_t dew_point_x100;             /**< Dew point in 0.01 degrees C, at least PSYCHRO_DEW_POINT_MIN_x100 */
+    uint16_t abs_humidity_x100;         /**< Absolute humidity in 0.01 g/m3, saturates at 655.35 */
+    int16_t heat_index_x100;            /**< Heat index in 0.01 degrees C */
+} psychro_t;
+
+void psychro_compute(const hs300x_fixed_t *fixed, psychro_t *derived);
+
+#endif /* PSYCHRO_H_ */
@@ -0,0 +1,69 @@
+/*
+ * sample_bus.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SAMPLE_BUS_H_
+#define SAMPLE_BUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <osal.h>
+#include "hs300x_task.h"
+
+/*
+ * Sample bus. The sampling engine publishes each sample once into a ring of slots indexed by a
+ * running count. Every consumer has its own cursor into the ring and reads the samples in place, at
+ * its own pace, so publishing costs the same however many consumers there are and never waits for
+ * them. A consumer that falls more than SAMPLE_BUS_LENGTH samples behind loses the oldest ones, which
+ * are counted as drops.
+ *
+ * There is a single producer. Consumers may run in other tasks: a sample read in place is only valid if
+ * sample_bus_release() returns true afterwards, the slot may have been reused during the read otherwise.
+ *
+ *     const hs300x_sample_t *sample;
+ *
+ *     while((sample = sample_bus_peek(&consumer)) != NULL)
+ *     {
+ *         ... read sample, keep the results aside ...
+ *         if(sample_bus_release(&consumer))
+ *         {
+ *             ... use the results ...
+ *         }
+ *     }
+ */
+
+/* Number of slots, a power of two. Also the most a consumer can fall behind without losing samples. */
+#ifndef SAMPLE_BUS_LENGTH
+#define SAMPLE_BUS_LENGTH                       (16)
+#endif
+
+/* Number of consumers that can subscribe */
+#ifndef SAMPLE_BUS_MAX_CONSUMERS
+#define SAMPLE_BUS_MAX_CONSUMERS                (6)
+#endif
+
+/*
+ * A consumer of the bus. The storage is provided by the consumer and must stay valid once subscribed.
+ * The counters are only written by the consumer itself.
+ */
+typedef struct
+{
+    const char *name;           /**< Name, for debug only */
+    OS_TASK task;               /**< Task notified of new samples, or NULL to poll */
+    uint32_t notify_mask;       /**< Notification bits set in the task */
+    uint32_t cursor;            /**< Index of the next sample to read */
+    uint32_t received;          /**< Samples read and released intact */
+    uint32_t drops;             /**< Samples overwritten before they were read */
+    uint32_t max_lag;           /**< Largest number of samples waiting when sample_bus_peek() was called */
+} sample_bus_consumer_t;
+
+void sample_bus_init(void);
+uint32_t sample_bus_lag(const sample_bus_consumer_t *consumer);
+const hs300x_sample_t *sample_bus_peek(sample_bus_consumer_t *consumer);
+void sample_bus_publish(const hs300x_sample_t *sample);
+bool sample_bus_release(sample_bus_consumer_t *consumer);
+void sample_bus_subscribe(sample_bus_consumer_t *consumer, const char *name, OS_TASK task, uint32_t notify_mask);
+
+#endif /* SAMPLE_BUS_H_ */
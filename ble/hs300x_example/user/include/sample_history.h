@@ -0,0 +1,28 @@
+/*
+ * sample_history.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SAMPLE_HISTORY_H_
+#define SAMPLE_HISTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hs300x_task.h"
+
+/*
+ * Number of samples kept in RAM. Once full, the oldest sample is overwritten. Only the conversion codes
+ * and the time each sample was taken are stored, sizeof(hs300x_raw_t) + 4 bytes per sample; the sequence
+ * number follows from the position.
+ */
+#ifndef SAMPLE_HISTORY_LENGTH
+#define SAMPLE_HISTORY_LENGTH                   (1024)
+#endif
+
+void sample_history_init(void);
+void sample_history_put(const hs300x_sample_t *sample);
+bool sample_history_get_range(uint32_t *oldest_seq, uint32_t *newest_seq);
+uint32_t sample_history_read(uint32_t *first_seq, hs300x_raw_t *samples, uint32_t *times_ms, uint32_t max_samples);
+
+#endif /* SAMPLE_HISTORY_H_ */
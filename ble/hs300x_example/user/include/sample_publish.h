@@ -0,0 +1,29 @@
+/*
+ * sample_publish.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SAMPLE_PUBLISH_H_
+#define SAMPLE_PUBLISH_H_
+
+#include <ble_service.h>
+#include "hs300x.h"
+
+/*
+ * Hands each sample to the GATT services, in the order the BLE task publishes it: the custom sensor
+ * service, the ESS, the alarm service, then the sample stream. The distribution and the alarm rules
+ * are updated first, with the samples they read from the sample bus. The BLE task and the host runner both
+ * publish through sample_publish(), so host runs follow the same path as the target.
+ */
+typedef struct
+{
+    ble_service_t *sensor_service;      /**< Custom sensor service */
+    ble_service_t *ess_service;         /**< Environmental sensing service, NULL if not built */
+    ble_service_t *alarm_service;       /**< Alarm service, NULL if not built */
+    ble_service_t *stream_service;      /**< Sample stream service, NULL if not built */
+} sample_publish_services_t;
+
+void sample_publish(const sample_publish_services_t *services, hs300x_sample_t *sample);
+
+#endif /* SAMPLE_PUBLISH_H_ */
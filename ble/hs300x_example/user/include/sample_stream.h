@@ -0,0 +1,66 @@
+/*
+ * sample_stream.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SAMPLE_STREAM_H_
+#define SAMPLE_STREAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Binary sample stream, written to the console UART instead of text when APP_UART_STREAM is set.
+ * This file has no dependency on the SDK, so the decoder can be built on a PC as well, see
+ * host/tools/sample_stream_decode.c.
+ *
+ * Each record is, little endian:
+ *
+ *   u8  record type (SAMPLE_STREAM_RECORD_SAMPLE)
+ *   u32 sequence number of the sample, incrementing by one
+ *   u32 time the sample was taken, in milliseconds since boot (see time_sync_local_ms())
+ *   f32 humidity in %RH
+ *   f32 temperature in degrees C
+ *   u16 CRC-16/CCITT-FALSE of the bytes above
+ *
+ * The record is COBS encoded, so it contains no 0x00 byte, and written between two 0x00 delimiters.
+ * Anything else on the line, such as text printed by other code, is rejected by the decoder as a
+ * bad frame without losing the frames around it.
+ */
+#define SAMPLE_STREAM_RECORD_SAMPLE             (0x01)
+
+#define SAMPLE_STREAM_RECORD_SIZE               (1 + 4 * sizeof(uint32_t) + sizeof(uint16_t))
+
+/* Largest frame written by sample_stream_encode(): COBS adds one byte per 254, plus the two delimiters */
+#define SAMPLE_STREAM_FRAME_SIZE                (SAMPLE_STREAM_RECORD_SIZE + SAMPLE_STREAM_RECORD_SIZE / 254 + 1 + 2)
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t time_ms;
+    float humidity_rh_pct;
+    float temp_deg_c;
+} sample_stream_record_t;
+
+/* Decoder state. Clear it with sample_stream_decoder_init() before use. */
+typedef struct
+{
+    uint8_t frame[SAMPLE_STREAM_FRAME_SIZE];
+    size_t length;
+    bool overflow;              /**< Bytes of the current frame were lost */
+    bool synced;                /**< A record has been decoded, last_seq is valid */
+    uint32_t last_seq;
+    uint32_t records;           /**< Records decoded */
+    uint32_t bad_frames;        /**< Frames rejected: wrong length, COBS error, unknown type */
+    uint32_t crc_errors;        /**< Frames rejected by the CRC */
+    uint32_t missing;           /**< Records missing between decoded records, by sequence number */
+} sample_stream_decoder_t;
+
+uint16_t sample_stream_crc16(const uint8_t *data, size_t length);
+bool sample_stream_decode_byte(sample_stream_decoder_t *decoder, uint8_t byte, sample_stream_record_t *record);
+void sample_stream_decoder_init(sample_stream_decoder_t *decoder);
+size_t sample_stream_encode(const sample_stream_record_t *record, uint8_t *frame);
+
+#endif /* SAMPLE_STREAM_H_ */
@@ -16,6 +16,7 @@
 typedef void (* sensor_svc_get_sample_rate_cb_t) (ble_service_t *svc, uint16_t conn_idx);
 typedef void (* sensor_svc_get_sensor_id_cb_t) (ble_service_t *svc, uint16_t conn_idx);
 typedef void (* sensor_svc_set_sample_rate_cb_t) (ble_service_t *svc, uint16_t conn_idx, const uint32_t value);
+typedef void (* sensor_svc_sample_rate_required_cb_t) (ble_service_t *svc, uint32_t rate);
 
 /* User-defined callback function structure */
 typedef struct {
@@ -29,13 +30,21 @@ typedef struct {
         // Write request handler for sensor sample rate
         sensor_svc_set_sample_rate_cb_t set_sample_rate_cb;
 
+        // Notification that the fastest sample rate required by the connected clients has changed
+        // because a client disconnected. 0 if no client has a requirement.
+        sensor_svc_sample_rate_required_cb_t sample_rate_required_cb;
+
 } sensor_service_cb_t;
 
 ble_service_t *sensor_service_init(const sensor_service_cb_t *cb);
+uint32_t sensor_service_get_conn_sample_rate(ble_service_t *svc, uint16_t conn_idx);
+uint32_t sensor_service_get_required_sample_rate(ble_service_t *svc);
 void sensor_service_get_sample_rate_cfm(ble_service_t *svc, uint16_t conn_idx, att_error_t status, const uint32_t *value);
 void sensor_service_get_sensor_id_cfm(ble_service_t *svc, uint16_t conn_idx, att_error_t status, const uint32_t *value);
+bool sensor_service_notifications_enabled(ble_service_t *svc, uint16_t conn_idx);
 void sensor_service_notify_measurement(ble_service_t *svc, uint16_t conn_idx, const hs300x_data_t *value);
 void sensor_service_notify_measurement_to_all_connected(ble_service_t *svc, const hs300x_data_t *value);
+void sensor_service_set_engine_sample_rate(ble_service_t *svc, uint32_t rate_ms);
 void sensor_service_set_sample_rate_cfm(ble_service_t *svc, uint16_t conn_idx, att_error_t status);
 
 #endif /* SENSOR_SERVICE_H_ */
@@ -0,0 +1,50 @@
+/*
+ * static_alloc.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef STATIC_ALLOC_H_
+#define STATIC_ALLOC_H_
+
+#include <stdint.h>
+#include <osal.h>
+
+/*
+ * Creation of OS objects in memory provided by the application instead of the FreeRTOS heap. Needs
+ * configSUPPORT_STATIC_ALLOCATION in the configuration. The storage is declared next to the handle,
+ * so it shows up in the footprint report (make footprint) and is fixed at link time.
+ */
+#ifdef OS_FREERTOS
+
+typedef StaticSemaphore_t static_mutex_t;
+typedef StaticQueue_t static_queue_t;
+typedef StaticTask_t static_task_t;
+typedef StaticTimer_t static_timer_t;
+
+/* Stack of stack_size bytes for STATIC_TASK_CREATE() */
+#define STATIC_STACK(name, stack_size)          StackType_t name[(stack_size) / sizeof(StackType_t)]
+
+#define STATIC_MUTEX_CREATE(mutex, storage)     ((mutex) = xSemaphoreCreateMutexStatic(&(storage)))
+
+/* buffer holds the items, its size must be a multiple of item_size */
+#define STATIC_QUEUE_CREATE(queue, item_size, buffer, storage) \
+        ((queue) = xQueueCreateStatic(sizeof(buffer) / (item_size), (item_size), (uint8_t *)(buffer), &(storage)))
+
+#define STATIC_TASK_CREATE(name, task_func, arg, stack, priority, storage, task) \
+        ((task) = xTaskCreateStatic((task_func), (name), ARRAY_LENGTH(stack), (arg), (priority), (stack), &(storage)))
+
+/* Same arguments as OS_TIMER_CREATE(), followed by the storage */
+#define STATIC_TIMER_CREATE(timer, name, period, reload, timer_id, callback, storage) \
+        ((timer) = xTimerCreateStatic((name), (period), (reload), (timer_id), (callback), &(storage)))
+
+#else
+
+/* The host build is single threaded and only needs the mutexes */
+typedef uint8_t static_mutex_t;
+
+#define STATIC_MUTEX_CREATE(mutex, storage)     ((void)(storage), OS_MUTEX_CREATE(mutex))
+
+#endif /* OS_FREERTOS */
+
+#endif /* STATIC_ALLOC_H_ */
@@ -0,0 +1,114 @@
+/*
+ * stream_service.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef STREAM_SERVICE_H_
+#define STREAM_SERVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_service.h>
+
+/*
+ * Sample stream service. Streams every sample of the sample history to a client without gaps, across
+ * reconnects, with the time each sample was taken:
+ *
+ * Sample Stream: notify, write and read.
+ *
+ * - Notifications carry consecutive samples, as many as fit the ATT MTU of the connection:
+ *
+ *     uint32_t first_seq               sequence number of the first sample
+ *     uint8_t  count                   number of samples
+ *     uint32_t first_time_s            UTC time the first sample was taken, s since the Unix epoch, 0 if
+ *                                      the time has not been set
+ *     uint16_t first_time_ms           ms part of that time, 0 to 999
+ *     each sample:
+ *       uint32_t offset_ms             time the sample was taken after the first one
+ *       uint16_t humidity              conversion codes, as hs300x_raw_t, see hs300x.h to convert them
+ *       uint16_t temp
+ *
+ * - A client writes the uint32_t sequence number of the last sample it received, its acknowledgement.
+ *   Bonded clients keep it across connections. A sequence number newer than the newest sample is
+ *   rejected with ATT_ERROR_OUT_OF_RANGE.
+ *
+ * - A read returns the uint32_t acknowledgement (0 if none), then the oldest and newest sequence numbers
+ *   in the history.
+ *
+ * When notifications are enabled, or a bonded client reconnects with them enabled, the stream starts
+ * after the acknowledgement: the backlog is sent packed from the history, then each new sample as it is
+ * taken, with no duplicates and no gaps within the connection. Without an acknowledgement the stream
+ * starts at the next sample. Sequence numbers restart at 1 on a reboot, so an acknowledgement newer
+ * than the newest sample is from before one: the stream then starts at the oldest sample, and the
+ * acknowledgement is set just before it. A client that reconnects only after the new sequence numbers
+ * passed its old acknowledgement cannot be told apart, and misses the samples up to it.
+ * Samples the client received but had not acknowledged when the link
+ * dropped are sent again after the reconnect, the sequence numbers let it discard them. Samples
+ * overwritten in the history before they could be sent show up as a jump in first_seq.
+ *
+ * A notification holds one sample at the default ATT MTU, and 29 at the MTU offered by conn_policy.h.
+ *
+ * At most STREAM_SERVICE_MAX_IN_FLIGHT notifications per connection are handed to the stack at a time,
+ * the next ones are sent as these go out, so a long backlog does not exhaust the stack's buffers.
+ */
+#define STREAM_SERVICE_MAX_IN_FLIGHT            (4)
+
+/*
+ * A connection is reported draining a backlog when, with STREAM_SERVICE_MAX_IN_FLIGHT notifications
+ * handed to the stack, this many samples or more are still to be sent. It is reported caught up once
+ * every sample has been handed to the stack.
+ */
+#define STREAM_SERVICE_BACKLOG_SAMPLES          (32)
+
+/* ATT opcode and handle in front of each notification value */
+#define STREAM_SERVICE_ATT_HEADER_SIZE          (3)
+
+/*
+ * Time: read and write. A client, typically a gateway on connect, writes the uint64_t UTC time in ms since
+ * the Unix epoch. It sets the mapping of time_sync.h, which times the samples taken before the setting as
+ * well as after it. A read returns:
+ *
+ *   uint64_t time_ms                   current UTC time, 0 if it has not been set
+ *   int32_t  drift_ppb                 estimated drift of the local clock, see time_sync.h
+ *   uint16_t syncs                     times the time has been set since boot
+ */
+#define STREAM_SERVICE_TIME_SIZE                (14)
+
+#define STREAM_SERVICE_HEADER_SIZE              (11)
+#define STREAM_SERVICE_SAMPLE_SIZE              (8)
+
+/* Largest notification, at the MTU offered by conn_policy.h */
+#define STREAM_SERVICE_MAX_MTU                  (247)
+#define STREAM_SERVICE_NOTIFICATION_MAX_SIZE    (STREAM_SERVICE_MAX_MTU - STREAM_SERVICE_ATT_HEADER_SIZE)
+#define STREAM_SERVICE_MAX_SAMPLES              ((STREAM_SERVICE_NOTIFICATION_MAX_SIZE - STREAM_SERVICE_HEADER_SIZE) / \
+                                                 STREAM_SERVICE_SAMPLE_SIZE)
+
+#define STREAM_SERVICE_STATUS_SIZE              (12)
+
+/* A transfer of the stream, see stream_service_get_last_transfer() */
+typedef struct {
+        uint32_t samples;
+        uint32_t bytes;                         // Notification PDUs, ATT header included
+        uint32_t elapsed_ms;
+} stream_service_transfer_t;
+
+/* User-defined callback functions prototypes */
+typedef void (* stream_svc_backlog_changed_cb_t) (ble_service_t *svc, uint16_t conn_idx, bool draining);
+
+/* User-defined callback function structure */
+typedef struct {
+
+        // Notification that a connection started draining a backlog of samples, or caught up with
+        // the history, see STREAM_SERVICE_BACKLOG_SAMPLES. Not called when the connection drops.
+        stream_svc_backlog_changed_cb_t backlog_changed_cb;
+
+} stream_service_cb_t;
+
+bool stream_service_get_last_transfer(ble_service_t *svc, stream_service_transfer_t *transfer);
+ble_service_t *stream_service_init(const stream_service_cb_t *cb);
+uint32_t stream_service_get_unacknowledged(ble_service_t *svc);
+bool stream_service_notifications_enabled(ble_service_t *svc, uint16_t conn_idx);
+void stream_service_send_new_samples(ble_service_t *svc);
+
+#endif /* STREAM_SERVICE_H_ */
@@ -0,0 +1,46 @@
+/*
+ * time_sync.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef TIME_SYNC_H_
+#define TIME_SYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Mapping of the local time base, milliseconds since boot from time_sync_local_ms(), to UTC. A client
+ * sets the UTC time, and the mapping runs from the latest setting, corrected by the drift of the local
+ * clock.
+ *
+ * The drift is estimated from successive settings, as the difference between the UTC time and local
+ * time elapsed between them, smoothed over about 1 << TIME_SYNC_DRIFT_SMOOTHING_SHIFT estimates. The
+ * delay of the setting over the link errs by up to a connection interval each time, so settings closer
+ * than TIME_SYNC_MIN_INTERVAL_ms only move the mapping, and estimates beyond TIME_SYNC_MAX_DRIFT_PPB
+ * are discarded as such errors.
+ *
+ * Local times are mapped as a signed distance from the latest setting, so they must be within about
+ * 24 days of it.
+ */
+#define TIME_SYNC_MIN_INTERVAL_ms               (10 * 60 * 1000)
+#define TIME_SYNC_MAX_DRIFT_PPB                 (500000)
+#define TIME_SYNC_DRIFT_SMOOTHING_SHIFT         (2)
+
+typedef struct
+{
+    bool synced;                        /**< The time has been set since boot */
+    uint16_t syncs;                     /**< Times the time has been set */
+    uint16_t drift_estimates;           /**< Settings used to estimate the drift */
+    int32_t drift_ppb;                  /**< Local clock slower than UTC by this, in parts per billion */
+} time_sync_status_t;
+
+void time_sync_get_status(time_sync_status_t *status);
+void time_sync_init(void);
+uint32_t time_sync_local_ms(void);
+uint64_t time_sync_local_ticks(void);
+void time_sync_set(uint64_t utc_ms, uint32_t local_ms);
+bool time_sync_to_utc(uint32_t local_ms, uint64_t *utc_ms);
+
+#endif /* TIME_SYNC_H_ */
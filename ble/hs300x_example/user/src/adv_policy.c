@@ -0,0 +1,310 @@
+/*
+ * adv_policy.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdbool.h>
+#include <string.h>
+#include "osal.h"
+#include "ble_common.h"
+#include "ble_gap.h"
+
+#include "adv_policy.h"
+#include "static_alloc.h"
+#include "time_sync.h"
+
+/* Interval range and duration of a stage, 0 for a stage that lasts until the next event */
+typedef struct
+{
+    uint16_t interval_min_ms;
+    uint16_t interval_max_ms;
+    uint32_t duration_ms;
+} adv_policy_stage_params_t;
+
+/* Private function prototypes */
+static void account(uint32_t now_ms);
+static void enter_stage(adv_policy_stage_t new_stage, uint32_t now_ms);
+static uint32_t now_ms(void);
+static void stage_timer_cb(OS_TIMER timer);
+static void start_advertising(void);
+
+/* Private variables */
+static const adv_policy_stage_params_t stage_params[ADV_POLICY_STAGE_COUNT] =
+{
+    [ADV_POLICY_STAGE_FAST]   = { ADV_POLICY_FAST_INTERVAL_MIN_ms, ADV_POLICY_FAST_INTERVAL_MAX_ms,
+                                  ADV_POLICY_FAST_DURATION_ms },
+    [ADV_POLICY_STAGE_MEDIUM] = { ADV_POLICY_MEDIUM_INTERVAL_MIN_ms, ADV_POLICY_MEDIUM_INTERVAL_MAX_ms,
+                                  ADV_POLICY_MEDIUM_DURATION_ms },
+    [ADV_POLICY_STAGE_SLOW]   = { ADV_POLICY_SLOW_INTERVAL_MIN_ms, ADV_POLICY_SLOW_INTERVAL_MAX_ms, 0 },
+};
+
+__RETAINED static adv_policy_stats_t stats;
+__RETAINED static OS_TIMER stage_timer;
+__RETAINED static static_timer_t stage_timer_storage;
+__RETAINED static OS_TASK policy_task;
+__RETAINED static bool advertising;             // Started by the policy and not completed yet
+__RETAINED static bool connect_pending;         // A fast stage started and nobody connected since
+__RETAINED static uint8_t connected;           // Clients connected
+__RETAINED static bool boosted;                 // boost_ms is valid
+__RETAINED static uint32_t boost_ms;            // Time of the latest boost
+__RETAINED static uint32_t stage_start_ms;      // Time the current stage was entered
+__RETAINED static uint32_t window_start_ms;     // Time the latest fast stage was entered
+__RETAINED static uint32_t accounted_ms;        // Time advertising was last accounted up to
+__RETAINED static uint32_t event_credit;        // Remainder of the event estimate, in ms * 2
+
+/**
+ * \brief Add the advertising time since the last call to the statistics, with the events it took at
+ * the mean interval of the current stage. Called before any change of stage or of the advertising state.
+ *
+ * \param[in] now_ms        current time in ms
+ *
+ * \return void
+ */
+static void account(uint32_t now_ms)
+{
+    if(advertising)
+    {
+        const adv_policy_stage_params_t *params = &stage_params[stats.stage];
+        uint32_t elapsed = now_ms - accounted_ms;
+
+        stats.advertising_ms += elapsed;
+
+        // The mean interval is (min + max) / 2, keep the remainder so frequent calls do not lose events
+        event_credit += elapsed * 2;
+        stats.adv_events += event_credit / (params->interval_min_ms + params->interval_max_ms);
+        event_credit %= params->interval_min_ms + params->interval_max_ms;
+    }
+
+    accounted_ms = now_ms;
+}
+
+/**
+ * \brief Move to a stage. Advertising already running is stopped, and restarted with the intervals
+ * of the new stage once the stack reports it completed.
+ *
+ * \param[in] new_stage     stage to enter
+ * \param[in] now_ms        current time in ms
+ *
+ * \return void
+ */
+static void enter_stage(adv_policy_stage_t new_stage, uint32_t now_ms)
+{
+    account(now_ms);
+
+    stats.stage = new_stage;
+    stage_start_ms = now_ms;
+
+    if(new_stage == ADV_POLICY_STAGE_FAST)
+    {
+        window_start_ms = now_ms;
+        connect_pending = true;
+    }
+
+    if(stage_params[new_stage].duration_ms)
+    {
+        // Also starts the timer
+        OS_TIMER_CHANGE_PERIOD(stage_timer, OS_MS_2_TICKS(stage_params[new_stage].duration_ms), OS_TIMER_FOREVER);
+    }
+    else
+    {
+        OS_TIMER_STOP(stage_timer, OS_TIMER_FOREVER);
+    }
+
+    if(advertising)
+    {
+        ble_gap_adv_stop();
+    }
+    else
+    {
+        start_advertising();
+    }
+}
+
+/**
+ * \brief Current time in ms, from the local time base of time_sync.h so differences across its wrap hold
+ *
+ * \return time in ms, wrapping at 2^32
+ */
+static uint32_t now_ms(void)
+{
+    return time_sync_local_ms();
+}
+
+/**
+ * \brief Timer callback, runs in the timer task. The stage changes in the BLE task.
+ *
+ * \param[in] timer         expired timer
+ *
+ * \return void
+ */
+static void stage_timer_cb(OS_TIMER timer)
+{
+    OS_TASK_NOTIFY(policy_task, ADV_POLICY_NOTIFY_MASK, OS_NOTIFY_SET_BITS);
+}
+
+/**
+ * \brief Start advertising with the intervals of the current stage. Fails, and is tried again on
+ * the next disconnection, when the stack takes no more connections.
+ *
+ * \return void
+ */
+static void start_advertising(void)
+{
+    const adv_policy_stage_params_t *params = &stage_params[stats.stage];
+
+    ble_gap_adv_intv_set(BLE_ADV_INTERVAL_FROM_MS(params->interval_min_ms),
+                         BLE_ADV_INTERVAL_FROM_MS(params->interval_max_ms));
+
+    if(ble_gap_adv_start(GAP_CONN_MODE_UNDIRECTED) == BLE_STATUS_OK)
+    {
+        advertising = true;
+        accounted_ms = now_ms();
+    }
+}
+
+/**
+ * \brief To be called on the advertising completed event. Advertising stops on a connection or
+ * when the policy changes stage, it is restarted with the intervals of the current stage.
+ *
+ * \return void
+ */
+void adv_policy_adv_completed(void)
+{
+    account(now_ms());
+    advertising = false;
+
+    start_advertising();
+}
+
+/**
+ * \brief Go back to the fast stage because the node has something to deliver. Ignored while a client
+ * is connected, while in the fast stage, and within ADV_POLICY_BOOST_HOLDOFF_ms of the previous boost.
+ *
+ * \return void
+ */
+void adv_policy_boost(void)
+{
+    uint32_t now = now_ms();
+
+    if(connected || stats.stage == ADV_POLICY_STAGE_FAST || (boosted && now - boost_ms < ADV_POLICY_BOOST_HOLDOFF_ms))
+    {
+        return;
+    }
+
+    boosted = true;
+    boost_ms = now;
+    stats.boosts++;
+
+    enter_stage(ADV_POLICY_STAGE_FAST, now);
+}
+
+/**
+ * \brief To be called on a connection. Records the time to connect, further clients are advertised
+ * for at the slow interval once the stack reports advertising completed.
+ *
+ * \return void
+ */
+void adv_policy_connected(void)
+{
+    uint32_t now = now_ms();
+
+    account(now);
+    connected++;
+
+    if(connect_pending)
+    {
+        uint32_t connect_ms = now - window_start_ms;
+
+        stats.connections++;
+        stats.last_connect_ms = connect_ms;
+        stats.total_connect_ms += connect_ms;
+        if(connect_ms > stats.max_connect_ms)
+        {
+            stats.max_connect_ms = connect_ms;
+        }
+        connect_pending = false;
+    }
+
+    // Advertising stopped with the connection, the completed event restarts it
+    stats.stage = ADV_POLICY_STAGE_SLOW;
+    stage_start_ms = now;
+    OS_TIMER_STOP(stage_timer, OS_TIMER_FOREVER);
+}
+
+/**
+ * \brief To be called on a disconnection, the client may want to reconnect soon
+ *
+ * \return void
+ */
+void adv_policy_disconnected(void)
+{
+    if(connected)
+    {
+        connected--;
+    }
+
+    enter_stage(ADV_POLICY_STAGE_FAST, now_ms());
+}
+
+/**
+ * \brief Get the statistics of the policy
+ *
+ * \param[out] stats_out    where the statistics will be placed
+ *
+ * \return void
+ */
+void adv_policy_get_stats(adv_policy_stats_t *stats_out)
+{
+    // Bring the advertising time of the current stage up to date
+    account(now_ms());
+    *stats_out = stats;
+}
+
+/**
+ * \brief Initialize the policy, must be called from the BLE task before any other adv_policy API.
+ * The task must call adv_policy_stage_expired() when notified with ADV_POLICY_NOTIFY_MASK.
+ *
+ * \return void
+ */
+void adv_policy_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    advertising = false;
+    connect_pending = false;
+    connected = 0;
+    boosted = false;
+    event_credit = 0;
+
+    policy_task = OS_GET_CURRENT_TASK();
+    STATIC_TIMER_CREATE(stage_timer, "adv_policy", OS_MS_2_TICKS(ADV_POLICY_FAST_DURATION_ms), OS_TIMER_ONCE,
+                        NULL, stage_timer_cb, stage_timer_storage);
+    OS_ASSERT(stage_timer);
+}
+
+/**
+ * \brief To be called when notified with ADV_POLICY_NOTIFY_MASK, moves to the next stage once the
+ * current one is over. A notification left from a stage since restarted or ended is ignored, the timer
+ * may expire a tick early so half the duration tells the two apart.
+ *
+ * \return void
+ */
+void adv_policy_stage_expired(void)
+{
+    uint32_t now = now_ms();
+    uint32_t duration_ms = stage_params[stats.stage].duration_ms;
+
+    if(duration_ms && now - stage_start_ms >= duration_ms / 2)
+    {
+        enter_stage(stats.stage + 1, now);
+    }
+}
+
+/**
+ * \brief Start advertising at the fast stage, on boot once the advertising data is set
+ *
+ * \return void
+ */
+void adv_policy_start(void)
+{
+    enter_stage(ADV_POLICY_STAGE_FAST, now_ms());
+}
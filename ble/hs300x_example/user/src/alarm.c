@@ -0,0 +1,477 @@
+/*
+ * alarm.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "osal.h"
+#include "alarm.h"
+#include "ble_bufops.h"
+#include "nvms_record.h"
+#include "sample_bus.h"
+#include "static_alloc.h"
+
+/* Magic of the stored rules, see nvms_record.h */
+#define ALARM_MAGIC                             (0x31524C41)    /* "ALR1" */
+
+/* Range of the thresholds and hysteresis, in hundredths */
+#define ALARM_HUMIDITY_MAX_x100                 (10000)
+#define ALARM_TEMP_MIN_x100                     (-HS300x_FIXED_TEMP_OFFSET)
+#define ALARM_TEMP_MAX_x100                     (12500)
+#define ALARM_HYSTERESIS_MAX_x100               (10000)
+
+typedef struct
+{
+    uint8_t samples;            /**< Samples seen, up to 2: a rate needs two */
+    int32_t last_x100;          /**< Previous value */
+    uint32_t last_time_ms;      /**< Time of the previous value */
+    int32_t rate_x100;          /**< Smoothed rate, hundredths per minute */
+} channel_rate_t;
+
+typedef struct
+{
+    bool pending;               /**< The condition holds but not for min_duration_s yet */
+    uint32_t pending_since_ms;  /**< Time the condition started to hold */
+} rule_state_t;
+
+/* Private function prototypes */
+static bool rule_valid(const alarm_rule_t *rule);
+static bool update_rule(uint8_t idx, const int32_t *values, uint32_t time_ms);
+static void update_rate(channel_rate_t *rate, int32_t value_x100, uint32_t time_ms);
+
+/* Private variables */
+__RETAINED static alarm_rule_t current_rules[ALARM_MAX_RULES];
+__RETAINED static uint8_t current_count;
+__RETAINED static rule_state_t rule_states[ALARM_MAX_RULES];
+__RETAINED static channel_rate_t rates[ALARM_CHANNEL_COUNT];
+__RETAINED static uint8_t active;
+__RETAINED static uint8_t changed;
+__RETAINED static hs300x_fixed_t changed_value;
+__RETAINED static OS_MUTEX alarm_mutex;
+__RETAINED static static_mutex_t alarm_mutex_storage;
+__RETAINED static sample_bus_consumer_t alarm_consumer;
+
+/**
+ * \brief Check a rule is in range
+ *
+ * \param[in] rule              rule to check
+ *
+ * \return true if the rule can be evaluated, false otherwise
+ */
+static bool rule_valid(const alarm_rule_t *rule)
+{
+    if(rule->channel >= ALARM_CHANNEL_COUNT || rule->type >= ALARM_TYPE_COUNT ||
+       rule->hysteresis_x100 > ALARM_HYSTERESIS_MAX_x100)
+    {
+        return false;
+    }
+
+    // A rate is a magnitude, the type gives the direction
+    if(rule->type == ALARM_TYPE_RISE_RATE || rule->type == ALARM_TYPE_FALL_RATE)
+    {
+        return rule->threshold_x100 > 0;
+    }
+
+    if(rule->channel == ALARM_CHANNEL_HUMIDITY)
+    {
+        return rule->threshold_x100 >= 0 && rule->threshold_x100 <= ALARM_HUMIDITY_MAX_x100;
+    }
+
+    return rule->threshold_x100 >= ALARM_TEMP_MIN_x100 && rule->threshold_x100 <= ALARM_TEMP_MAX_x100;
+}
+
+/**
+ * \brief Evaluate one rule against a new sample. Must be called with the mutex held.
+ *
+ * \param[in] idx               index of the rule
+ * \param[in] values            value of each channel, hundredths
+ * \param[in] time_ms           time of the sample
+ *
+ * \return true if the rule raised or cleared, false otherwise
+ */
+static bool update_rule(uint8_t idx, const int32_t *values, uint32_t time_ms)
+{
+    const alarm_rule_t *rule = &current_rules[idx];
+    const channel_rate_t *rate = &rates[rule->channel];
+    rule_state_t *state = &rule_states[idx];
+    uint8_t mask = 1 << idx;
+    int32_t value;
+    int32_t threshold = rule->threshold_x100;
+
+    // A rate needs two samples
+    if((rule->type == ALARM_TYPE_RISE_RATE || rule->type == ALARM_TYPE_FALL_RATE) && rate->samples < 2)
+    {
+        return false;
+    }
+
+    // Turn every type into "value at or above threshold"
+    switch(rule->type)
+    {
+        case ALARM_TYPE_ABOVE:
+            value = values[rule->channel];
+            break;
+        case ALARM_TYPE_BELOW:
+            value = -values[rule->channel];
+            threshold = -threshold;
+            break;
+        case ALARM_TYPE_RISE_RATE:
+            value = rate->rate_x100;
+            break;
+        default:
+            value = -rate->rate_x100;
+            break;
+    }
+
+    if(active & mask)
+    {
+        if(value >= threshold - rule->hysteresis_x100)
+        {
+            return false;
+        }
+
+        active &= ~mask;
+        state->pending = false;
+        return true;
+    }
+
+    if(value < threshold)
+    {
+        state->pending = false;
+        return false;
+    }
+
+    if(!state->pending)
+    {
+        state->pending = true;
+        state->pending_since_ms = time_ms;
+    }
+
+    if(time_ms - state->pending_since_ms < (uint32_t)rule->min_duration_s * 1000)
+    {
+        return false;
+    }
+
+    active |= mask;
+    state->pending = false;
+    return true;
+}
+
+/**
+ * \brief Update the rate of a channel with a new value. Must be called with the mutex held.
+ *
+ * \param[in,out] rate          rate of the channel
+ * \param[in] value_x100        new value
+ * \param[in] time_ms           time of the new value
+ *
+ * \return void
+ */
+static void update_rate(channel_rate_t *rate, int32_t value_x100, uint32_t time_ms)
+{
+    uint32_t elapsed_ms = time_ms - rate->last_time_ms;
+
+    // Two samples within the same millisecond give no rate, keep the first
+    if(rate->samples && !elapsed_ms)
+    {
+        return;
+    }
+
+    if(rate->samples)
+    {
+        // Full scale over a millisecond still fits: 16500 x 60000 < 2^31
+        int32_t instant = (value_x100 - rate->last_x100) * 60000 / (int32_t)elapsed_ms;
+
+        if(rate->samples < 2)
+        {
+            rate->rate_x100 = instant;
+            rate->samples = 2;
+        }
+        else
+        {
+            rate->rate_x100 += (instant - rate->rate_x100) / (1 << ALARM_RATE_SMOOTHING_SHIFT);
+        }
+    }
+    else
+    {
+        rate->samples = 1;
+    }
+
+    rate->last_x100 = value_x100;
+    rate->last_time_ms = time_ms;
+}
+
+/**
+ * \brief Decode rules, see alarm.h for the format
+ *
+ * \param[in] buf               encoded rules
+ * \param[in] length            length of the encoded rules
+ * \param[out] rules            array of ALARM_MAX_RULES rules
+ * \param[out] count            number of rules decoded
+ *
+ * \return ALARM_ERROR_NONE if the rules are valid, the reason they are not otherwise
+ */
+alarm_error_t alarm_decode_rules(const uint8_t *buf, uint16_t length, alarm_rule_t *rules, uint8_t *count)
+{
+    const uint8_t *ptr = buf;
+
+    if(length < 1 || buf[0] > ALARM_MAX_RULES || length != 1 + buf[0] * ALARM_RULE_SIZE)
+    {
+        return ALARM_ERROR_LENGTH;
+    }
+
+    *count = *ptr++;
+    for(int i = 0; i < *count; i++)
+    {
+        rules[i].channel = ptr[0];
+        rules[i].type = ptr[1];
+        rules[i].threshold_x100 = (int16_t)get_u16(ptr + 2);
+        rules[i].hysteresis_x100 = get_u16(ptr + 4);
+        rules[i].min_duration_s = get_u16(ptr + 6);
+        ptr += ALARM_RULE_SIZE;
+
+        if(!rule_valid(&rules[i]))
+        {
+            return ALARM_ERROR_INVALID;
+        }
+    }
+
+    return ALARM_ERROR_NONE;
+}
+
+/**
+ * \brief Encode rules, see alarm.h for the format
+ *
+ * \param[in] rules             rules to encode
+ * \param[in] count             number of rules
+ * \param[out] buf              buffer of at least ALARM_RULES_ENCODED_MAX_SIZE bytes
+ *
+ * \return length of the encoded rules
+ */
+uint16_t alarm_encode_rules(const alarm_rule_t *rules, uint8_t count, uint8_t *buf)
+{
+    uint8_t *ptr = buf;
+
+    put_u8_inc(&ptr, count);
+    for(int i = 0; i < count; i++)
+    {
+        put_u8_inc(&ptr, rules[i].channel);
+        put_u8_inc(&ptr, rules[i].type);
+        put_u16_inc(&ptr, (uint16_t)rules[i].threshold_x100);
+        put_u16_inc(&ptr, rules[i].hysteresis_x100);
+        put_u16_inc(&ptr, rules[i].min_duration_s);
+    }
+
+    return ptr - buf;
+}
+
+/**
+ * \brief Encode a state, see alarm.h for the format
+ *
+ * \param[in] state             state to encode
+ * \param[out] buf              buffer of at least ALARM_STATE_SIZE bytes
+ *
+ * \return length of the encoded state
+ */
+uint16_t alarm_encode_state(const alarm_state_t *state, uint8_t *buf)
+{
+    uint8_t *ptr = buf;
+
+    put_u8_inc(&ptr, state->active);
+    put_u8_inc(&ptr, state->changed);
+    put_u16_inc(&ptr, state->humidity_x100);
+    put_u16_inc(&ptr, (uint16_t)state->temp_x100);
+
+    return ptr - buf;
+}
+
+/**
+ * \brief Evaluate the rules against a new sample. Called for every sample read from the sample bus, see
+ * alarm_process_samples().
+ *
+ * \param[in] raw               conversion codes of the sample, calibrated
+ * \param[in] time_ms           time the sample was taken
+ *
+ * \return void
+ */
+void alarm_evaluate(const hs300x_raw_t *raw, uint32_t time_ms)
+{
+    hs300x_fixed_t fixed;
+    uint8_t changes = 0;
+
+    hs300x_convert_raw_fixed(raw, &fixed);
+
+    const int32_t values[ALARM_CHANNEL_COUNT] = { fixed.humidity_x100, fixed.temp_x100 };
+
+    OS_MUTEX_GET(alarm_mutex, OS_MUTEX_FOREVER);
+
+    for(int channel = 0; channel < ALARM_CHANNEL_COUNT; channel++)
+    {
+        update_rate(&rates[channel], values[channel], time_ms);
+    }
+
+    for(uint8_t i = 0; i < current_count; i++)
+    {
+        if(update_rule(i, values, time_ms))
+        {
+            changes |= 1 << i;
+        }
+    }
+
+    if(changes)
+    {
+        changed |= changes;
+        changed_value = fixed;
+    }
+
+    OS_MUTEX_PUT(alarm_mutex);
+}
+
+/**
+ * \brief Get the rules in use
+ *
+ * \param[out] rules            array of ALARM_MAX_RULES rules
+ *
+ * \return number of rules
+ */
+uint8_t alarm_get_rules(alarm_rule_t *rules)
+{
+    OS_MUTEX_GET(alarm_mutex, OS_MUTEX_FOREVER);
+
+    uint8_t count = current_count;
+    memcpy(rules, current_rules, count * sizeof(rules[0]));
+
+    OS_MUTEX_PUT(alarm_mutex);
+
+    return count;
+}
+
+/**
+ * \brief Initialize the alarms, subscribe to the sample bus and load the stored rules. Must be called
+ * after sample_bus_init() and before any other alarm API. Without valid stored rules there are none.
+ *
+ * \return ALARM_ERROR_NONE if stored rules were loaded or none are stored, the reason they were not loaded otherwise
+ */
+alarm_error_t alarm_init(void)
+{
+    uint8_t payload[ALARM_RULES_ENCODED_MAX_SIZE];
+    uint16_t length;
+
+    STATIC_MUTEX_CREATE(alarm_mutex, alarm_mutex_storage);
+    current_count = 0;
+    active = 0;
+    changed = 0;
+    memset(rule_states, 0, sizeof(rule_states));
+    memset(rates, 0, sizeof(rates));
+    sample_bus_subscribe(&alarm_consumer, "alarm", NULL, 0);
+
+    switch(nvms_record_read(NVMS_RECORD_ADDR_ALARM_RULES, ALARM_MAGIC, payload, sizeof(payload), &length))
+    {
+        case NVMS_RECORD_OK:
+            break;
+        case NVMS_RECORD_EMPTY:
+            // Nothing stored yet
+            return ALARM_ERROR_NONE;
+        case NVMS_RECORD_INVALID:
+            return ALARM_ERROR_INVALID;
+        default:
+            return ALARM_ERROR_STORAGE;
+    }
+
+    alarm_error_t error = alarm_decode_rules(payload, length, current_rules, &current_count);
+    if(error != ALARM_ERROR_NONE)
+    {
+        current_count = 0;
+    }
+
+    return error;
+}
+
+/**
+ * \brief Evaluate the rules against the samples published on the sample bus since the previous call.
+ * The BLE task calls it before indicating the changes, see sample_publish(). A sample the BLE task fell
+ * too far behind to read is counted as a drop of the "alarm" consumer and not evaluated.
+ *
+ * \return void
+ */
+void alarm_process_samples(void)
+{
+    const hs300x_sample_t *sample;
+
+    while((sample = sample_bus_peek(&alarm_consumer)) != NULL)
+    {
+        hs300x_raw_t raw = sample->raw;
+        uint32_t time_ms = sample->time_ms;
+
+        if(sample_bus_release(&alarm_consumer))
+        {
+            alarm_evaluate(&raw, time_ms);
+        }
+    }
+}
+
+/**
+ * \brief Check rules, store them and evaluate them from the next sample. The raised rules are reported
+ * as cleared, the new rules start cleared.
+ *
+ * \param[in] rules             rules to use
+ * \param[in] count             number of rules, 0 to remove all
+ *
+ * \return ALARM_ERROR_NONE if the rules are stored and in use, the reason they are not otherwise
+ */
+alarm_error_t alarm_set_rules(const alarm_rule_t *rules, uint8_t count)
+{
+    uint8_t payload[ALARM_RULES_ENCODED_MAX_SIZE];
+
+    if(count > ALARM_MAX_RULES)
+    {
+        return ALARM_ERROR_LENGTH;
+    }
+    for(int i = 0; i < count; i++)
+    {
+        if(!rule_valid(&rules[i]))
+        {
+            return ALARM_ERROR_INVALID;
+        }
+    }
+
+    // Stored before taking the mutex, so the sampling engine does not wait for NVMS
+    uint16_t length = alarm_encode_rules(rules, count, payload);
+    if(nvms_record_write(NVMS_RECORD_ADDR_ALARM_RULES, ALARM_MAGIC, payload, length) != NVMS_RECORD_OK)
+    {
+        return ALARM_ERROR_STORAGE;
+    }
+
+    OS_MUTEX_GET(alarm_mutex, OS_MUTEX_FOREVER);
+
+    memcpy(current_rules, rules, count * sizeof(rules[0]));
+    current_count = count;
+    memset(rule_states, 0, sizeof(rule_states));
+    changed |= active;
+    active = 0;
+
+    OS_MUTEX_PUT(alarm_mutex);
+
+    return ALARM_ERROR_NONE;
+}
+
+/**
+ * \brief Take the rule changes since the previous call
+ *
+ * \param[out] state            active rules, rules changed since the previous call and the measurement
+ *                              of the latest change
+ *
+ * \return true if a rule raised or cleared since the previous call, false otherwise
+ */
+bool alarm_take_changes(alarm_state_t *state)
+{
+    OS_MUTEX_GET(alarm_mutex, OS_MUTEX_FOREVER);
+
+    state->active = active;
+    state->changed = changed;
+    state->humidity_x100 = changed_value.humidity_x100;
+    state->temp_x100 = changed_value.temp_x100;
+    changed = 0;
+
+    OS_MUTEX_PUT(alarm_mutex);
+
+    return state->changed != 0;
+}
@@ -0,0 +1,427 @@
+/*
+ * alarm_service.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "osal.h"
+#include "alarm.h"
+#include "alarm_service.h"
+#include "ble_att.h"
+#include "ble_bufops.h"
+#include "ble_common.h"
+#include "ble_gap.h"
+#include "ble_gatt.h"
+#include "ble_gatts.h"
+#include "ble_storage.h"
+#include "ble_uuid.h"
+#include "diag_counters.h"
+
+/* Alarm service structure */
+typedef struct {
+        ble_service_t svc;
+
+        // Attribute handles of BLE service
+        uint16_t state_value_h;                 // Alarm State Value
+        uint16_t state_user_desc_h;             // Alarm State User Description
+        uint16_t state_ccc_h;                   // Alarm State Client Characteristic Configuration Descriptor
+
+        uint16_t rules_value_h;                 // Alarm Rules Value
+        uint16_t rules_user_desc_h;             // Alarm Rules User Description
+
+        // Latest state indicated, returned by reads
+        uint8_t state[ALARM_STATE_SIZE];
+} alarm_service_t;
+
+
+/* Private function prototypes */
+static att_error_t alarm_att_error(alarm_error_t error);
+static void cleanup(ble_service_t *svc);
+static void handle_ccc_read(alarm_service_t *alarm_service_handle, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_ccc_write(alarm_service_t *alarm_service_handle, const ble_evt_gatts_write_req_t *evt);
+static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt);
+static void handle_rules_read(alarm_service_t *alarm_service_handle, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_rules_write(alarm_service_t *alarm_service_handle, const ble_evt_gatts_write_req_t *evt);
+static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt);
+
+/* Service Constants */
+static const char state_char_user_description[]  = "Alarm State";
+static const char rules_char_user_description[]  = "Alarm Rules";
+
+/* Private variables */
+__RETAINED static alarm_service_t alarm_service;
+
+/**
+ * \brief Map the outcome of a rules write to the error reported to the client
+ *
+ * \param[in] error          outcome of the write
+ *
+ * \return att_error_t to respond with
+ */
+static att_error_t alarm_att_error(alarm_error_t error)
+{
+	switch (error)
+	{
+	case ALARM_ERROR_NONE:
+		return ATT_ERROR_OK;
+	case ALARM_ERROR_LENGTH:
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	case ALARM_ERROR_INVALID:
+		return ATT_ERROR_OUT_OF_RANGE;
+	default:
+		return ATT_ERROR_UNLIKELY;
+	}
+}
+
+/**
+ * \brief Service cleanup function.
+ *
+ * \param[in] svc          pointer BLE service
+ *
+ * \return void
+ */
+static void cleanup(ble_service_t *svc)
+{
+	alarm_service_t *alarm_service_handle = (alarm_service_t *) svc;
+
+	ble_storage_remove_all(alarm_service_handle->state_ccc_h);
+}
+
+/**
+ * \brief This function is called when their is a read request for the Alarm State CCC
+ *
+ * \param[in] alarm_service_handle      pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_ccc_read(alarm_service_t *alarm_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	uint16_t ccc = 0x0000;
+
+	// Extract the CCC value from the ble storage
+	ble_storage_get_u16(evt->conn_idx, alarm_service_handle->state_ccc_h, &ccc);
+
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, sizeof(ccc), &ccc);
+}
+
+/**
+ * \brief This function is called when their is a write request for the Alarm State CCC
+ *
+ * \param[in] alarm_service_handle      pointer service handle
+ * \param[in] evt                       pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_ccc_write(alarm_service_t *alarm_service_handle, const ble_evt_gatts_write_req_t *evt)
+{
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+	if(evt->length != sizeof(uint16_t))
+	{
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	}
+
+	ble_storage_put_u32(evt->conn_idx, alarm_service_handle->state_ccc_h, get_u16(evt->value), true);
+	ble_gatts_write_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK);
+
+	return ATT_ERROR_OK;
+}
+
+/**
+ * \brief This function is called when their is a read request for any attribute of the service
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the read request
+ *
+ * \return void
+ */
+static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt)
+{
+	alarm_service_t *alarm_service_handle = (alarm_service_t *) svc;
+
+	if (evt->handle == alarm_service_handle->state_value_h)
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, sizeof(alarm_service_handle->state),
+		                   alarm_service_handle->state);
+	}
+	else if (evt->handle == alarm_service_handle->state_ccc_h)
+	{
+		handle_ccc_read(alarm_service_handle, evt);
+	}
+	else if (evt->handle == alarm_service_handle->rules_value_h)
+	{
+		handle_rules_read(alarm_service_handle, evt);
+	}
+	// Otherwise read operations are not permitted
+	else
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_READ_NOT_PERMITTED, 0, NULL);
+	}
+}
+
+/**
+ * \brief This function is called when their is a read request for the Alarm Rules
+ *
+ * \param[in] alarm_service_handle      pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_rules_read(alarm_service_t *alarm_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	alarm_rule_t rules[ALARM_MAX_RULES];
+	uint8_t value[ALARM_RULES_ENCODED_MAX_SIZE];
+	uint16_t length;
+
+	length = alarm_encode_rules(rules, alarm_get_rules(rules), value);
+
+	if (evt->offset > length)
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_INVALID_OFFSET, 0, NULL);
+		return;
+	}
+
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, length - evt->offset, value + evt->offset);
+}
+
+/**
+ * \brief This function is called when their is a write request for the Alarm Rules. The rules are
+ * stored and used from the next sample.
+ *
+ * \param[in] alarm_service_handle      pointer service handle
+ * \param[in] evt                       pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_rules_write(alarm_service_t *alarm_service_handle, const ble_evt_gatts_write_req_t *evt)
+{
+	alarm_rule_t rules[ALARM_MAX_RULES];
+	uint8_t count;
+	att_error_t error;
+
+	// The whole set of rules must be written at once, so a client needs an MTU that fits it
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+
+	error = alarm_att_error(alarm_decode_rules(evt->value, evt->length, rules, &count));
+	if(error == ATT_ERROR_OK)
+	{
+		error = alarm_att_error(alarm_set_rules(rules, count));
+	}
+
+	if(error == ATT_ERROR_OK)
+	{
+		ble_gatts_write_cfm(evt->conn_idx, evt->handle, error);
+	}
+
+	return error;
+}
+
+/**
+ * \brief This function is called when their is a write request for an attribute in the service
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the write request
+ *
+ * \return void
+ */
+static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt)
+{
+	alarm_service_t *alarm_service_handle = (alarm_service_t *) svc;
+	att_error_t status = ATT_ERROR_WRITE_NOT_PERMITTED;
+
+	if (evt->handle == alarm_service_handle->state_ccc_h)
+	{
+		status = handle_ccc_write(alarm_service_handle, evt);
+	}
+	else if (evt->handle == alarm_service_handle->rules_value_h)
+	{
+		status = handle_rules_write(alarm_service_handle, evt);
+	}
+
+	/* If the status is anything other than ATT_ERROR_OK, inform the client the write is rejected.
+	 * Otherwise the write handlers above have already responded. */
+	if (status != ATT_ERROR_OK)
+	{
+		ble_gatts_write_cfm(evt->conn_idx, evt->handle, status);
+	}
+}
+
+/**
+ * \brief Initialize the alarm service. alarm_init() must have been called.
+ *
+ * \return pointer to the handle created for this service
+ */
+ble_service_t *alarm_service_init(void)
+{
+	alarm_service_t *alarm_service_handle;
+	uint16_t num_attr;
+	att_uuid_t uuid;
+
+	// The service handle is statically allocated, there is a single instance of the service
+	alarm_service_handle = &alarm_service;
+	memset(alarm_service_handle, 0, sizeof(alarm_service_t));
+
+	// Declare handlers for specific BLE events
+	alarm_service_handle->svc.read_req  = handle_read_req;
+	alarm_service_handle->svc.write_req = handle_write_req;
+	alarm_service_handle->svc.cleanup   = cleanup;
+
+	/*
+	 * 0 --> Number of Included Services
+	 * 2 --> Number of Characteristic Declarations
+	 * 3 --> Number of Descriptors
+	 */
+	num_attr = ble_gatts_get_num_attr(0, 2, 3);
+
+	// Service declaration
+	ble_uuid_from_string("AAAAAAAA-1111-2222-3333-444444444444", &uuid);
+	ble_gatts_add_service(&uuid, GATT_SERVICE_PRIMARY, num_attr);
+
+	// Characteristic declaration for Alarm State
+	ble_uuid_from_string("AAAAAAAA-5555-6666-7777-888888888888", &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_READ | GATT_PROP_INDICATE,
+	                             ATT_PERM_READ,
+	                             ALARM_STATE_SIZE,
+	                             GATTS_FLAG_CHAR_READ_REQ,
+	                             NULL,
+	                             &alarm_service_handle->state_value_h);
+
+	// Define descriptor of type Characteristic User Description for Alarm State
+	ble_uuid_create16(UUID_GATT_CHAR_USER_DESCRIPTION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_READ,
+	                         sizeof(state_char_user_description)-1, // -1 to account for NULL char
+	                         0,
+	                         &alarm_service_handle->state_user_desc_h);
+
+	// Define descriptor of type Client Characteristic Configuration Descriptor for Alarm State
+	ble_uuid_create16(UUID_GATT_CLIENT_CHAR_CONFIGURATION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_RW,
+	                         2,
+	                         0,
+	                         &alarm_service_handle->state_ccc_h);
+
+	// Characteristic declaration for Alarm Rules
+	ble_uuid_from_string("AAAAAAAA-9999-BBBB-CCCC-DDDDDDDDDDDD", &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_READ | GATT_PROP_WRITE,
+	                             ATT_PERM_RW,
+	                             ALARM_RULES_ENCODED_MAX_SIZE,
+	                             GATTS_FLAG_CHAR_READ_REQ,
+	                             NULL,
+	                             &alarm_service_handle->rules_value_h);
+
+	// Define descriptor of type Characteristic User Description for Alarm Rules
+	ble_uuid_create16(UUID_GATT_CHAR_USER_DESCRIPTION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_READ,
+	                         sizeof(rules_char_user_description)-1, // -1 to account for NULL char
+	                         0,
+	                         &alarm_service_handle->rules_user_desc_h);
+
+	/*
+	 * Register all the attribute handles so that they can be updated
+	 * by the BLE manager automatically.
+	 */
+	ble_gatts_register_service(&alarm_service_handle->svc.start_h,
+	                           &alarm_service_handle->state_value_h,
+	                           &alarm_service_handle->state_user_desc_h,
+	                           &alarm_service_handle->state_ccc_h,
+	                           &alarm_service_handle->rules_value_h,
+	                           &alarm_service_handle->rules_user_desc_h,
+	                           0);
+
+	// Calculate the last attribute handle of the BLE service
+	alarm_service_handle->svc.end_h = alarm_service_handle->svc.start_h + num_attr;
+
+	// Set default values for User Descriptions
+	ble_gatts_set_value(alarm_service_handle->state_user_desc_h,
+	                    sizeof(state_char_user_description)-1,
+	                    state_char_user_description);
+
+	ble_gatts_set_value(alarm_service_handle->rules_user_desc_h,
+	                    sizeof(rules_char_user_description)-1,
+	                    rules_char_user_description);
+
+	// Register the BLE service in BLE framework
+	ble_service_add(&alarm_service_handle->svc);
+
+	// Return the service handle
+	return &alarm_service_handle->svc;
+}
+
+/**
+ * \brief This function should be called by the application after each sample. If a rule raised or
+ * cleared since the previous call, the new state is indicated to every connected client that enabled
+ * indications of the Alarm State.
+ *
+ * \param[in] svc          pointer to service handle
+ *
+ * \return true if a rule raised since the previous call, false otherwise
+ */
+bool alarm_service_indicate_changes(ble_service_t *svc)
+{
+	alarm_service_t *alarm_service_handle = (alarm_service_t *) svc;
+	alarm_state_t state;
+
+	if (!alarm_take_changes(&state))
+	{
+		return false;
+	}
+
+	alarm_encode_state(&state, alarm_service_handle->state);
+
+	gap_device_t devices[BLE_GAP_MAX_CONNECTED];
+	size_t num_conn = ARRAY_LENGTH(devices);
+
+	ble_gap_get_devices(GAP_DEVICE_FILTER_CONNECTED, NULL, &num_conn, devices);
+
+	while ((num_conn--) > 0)
+	{
+		uint16_t ccc = 0x0000;
+
+		ble_storage_get_u16(devices[num_conn].conn_idx, alarm_service_handle->state_ccc_h, &ccc);
+		if (ccc & GATT_CCC_INDICATIONS)
+		{
+			if (ble_gatts_send_event(devices[num_conn].conn_idx, alarm_service_handle->state_value_h,
+			                         GATT_EVENT_INDICATION, sizeof(alarm_service_handle->state),
+			                         alarm_service_handle->state) != BLE_STATUS_OK)
+			{
+				DIAG_COUNTER_INC(notify_failures);
+			}
+		}
+	}
+
+	return (state.changed & state.active) != 0;
+}
+
+/**
+ * \brief Check whether a client has indications of the Alarm State enabled, whether it wrote the CCC on
+ * this connection or it was stored when the client bonded
+ *
+ * \param[in] svc          pointer to service handle
+ * \param[in] conn_idx     connection index of the client
+ *
+ * \return true if indications are enabled
+ */
+bool alarm_service_indications_enabled(ble_service_t *svc, uint16_t conn_idx)
+{
+	alarm_service_t *alarm_service_handle = (alarm_service_t *) svc;
+	uint16_t ccc = 0x0000;
+
+	ble_storage_get_u16(conn_idx, alarm_service_handle->state_ccc_h, &ccc);
+
+	return (ccc & GATT_CCC_INDICATIONS) != 0;
+}
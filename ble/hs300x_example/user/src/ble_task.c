@@ -13,18 +13,42 @@
 #include "ble_gap.h"
 #include "ble_gatts.h"
 
+#include "adv_policy.h"
+#include "alarm_service.h"
 #include "ble_task.h"
+#include "burst_capture.h"
+#include "conn_policy.h"
+#include "diag_counters.h"
+#include "diag_service.h"
+#include "ess_service.h"
+#include "hotpath_trace.h"
+#include "hs300x_bench.h"
 #include "sensor_service.h"
+#include "stream_service.h"
 #include "hs300x_task.h"
+#include "l2cap_history.h"
+#include "sample_publish.h"
+#include "measurement_broadcast.h"
+
+/*
+ * Most BLE events handled per wakeup of the task. Events left over are handled after the queued
+ * samples, on the next pass of the loop.
+ */
+#define BLE_TASK_EVENT_BUDGET           (8)
 
 /* Private function prototypes */
+static void apply_engine_sample_rate(ble_service_t *svc, uint32_t required_rate);
 static void get_sample_rate(ble_service_t *svc, uint16_t conn_idx);
 static void get_sensor_id(ble_service_t *svc, uint16_t conn_idx);
+static void handle_ble_event(ble_evt_hdr_t *hdr);
 static void handle_evt_gap_adv_completed(ble_evt_gap_adv_completed_t *evt);
 static void handle_evt_gap_connected(ble_evt_gap_connected_t *evt);
 static void handle_evt_gap_disconnected(ble_evt_gap_disconnected_t *evt);
 static void handle_evt_gap_pair_req(ble_evt_gap_pair_req_t *evt);
+static void sample_rate_required(ble_service_t *svc, uint32_t rate);
 static void set_sample_rate(ble_service_t *svc, uint16_t conn_idx, const uint32_t new_rate);
+static void stream_backlog_changed(ble_service_t *svc, uint16_t conn_idx, bool draining);
+static bool update_streaming(uint16_t conn_idx);
 
 /* Private variables */
 // Step 6.1 - Update the device name to something unique
@@ -35,12 +59,30 @@ static const sensor_service_cb_t sensor_service_callbacks =
 	.get_sensor_id_cb = get_sensor_id,
 	.get_sample_rate_cb = get_sample_rate,
 	.set_sample_rate_cb = set_sample_rate,
+	.sample_rate_required_cb = sample_rate_required,
 };
 
+#if APP_STREAM_SERVICE
+static const stream_service_cb_t stream_service_callbacks =
+{
+	.backlog_changed_cb = stream_backlog_changed,
+};
+#endif
+
+__RETAINED static ble_service_t *sensor_service_handle;
+#if APP_ESS_SERVICE
+__RETAINED static ble_service_t *ess_service_handle;
+#endif
+
+/* Services each sample is published to, the ones not built are NULL */
+__RETAINED static sample_publish_services_t publish_services;
+
+#if !APP_MEASUREMENT_BROADCAST
 static const gap_adv_ad_struct_t adv_data[] = {
 
 	GAP_ADV_AD_STRUCT(GAP_DATA_TYPE_LOCAL_NAME, sizeof(device_name), device_name)
 };
+#endif
 
 /**
  * \brief BLE task. This task handles BLE communication for the application
@@ -64,6 +106,7 @@ void ble_task(void *pvParameters)
 
 	/* Register task to BLE framework to receive BLE event notifications */
 	// Step 6.4 add the appropriate API to register the application to receive BLE event notifications
+	ble_register_app();
 
 
 	/* Set device name */
@@ -79,7 +122,54 @@ void ble_task(void *pvParameters)
 	 * Initialize BLE services
 	 */
 	/* Add custom sensor service */
-	ble_service_t* sensor_service_handle = sensor_service_init(&sensor_service_callbacks);
+	sensor_service_handle = sensor_service_init(&sensor_service_callbacks);
+	publish_services.sensor_service = sensor_service_handle;
+
+#if APP_ESS_SERVICE
+	/* Add Environmental Sensing Service */
+	ess_service_handle = ess_service_init();
+	ess_service_set_update_interval(ess_service_handle, HS300x_TASK_DEFAULT_SAMPLE_RATE_ms);
+	publish_services.ess_service = ess_service_handle;
+#endif
+
+#if APP_DIAG_SERVICE
+	/* Add diagnostics service */
+	diag_service_init();
+#endif
+
+#if APP_ALARM_SERVICE
+	/* Add alarm service */
+	publish_services.alarm_service = alarm_service_init();
+#endif
+
+#if APP_STREAM_SERVICE
+	/* Add sample stream service */
+	publish_services.stream_service = stream_service_init(&stream_service_callbacks);
+#endif
+
+#if dg_configBLE_L2CAP_COC
+	/* Bulk history transfers log their throughput next to the stream's */
+	l2cap_history_init(publish_services.stream_service);
+#endif
+
+	/* Connection parameters, PHY and data length follow the sample rate and use of each connection */
+	conn_policy_init(HS300x_TASK_DEFAULT_SAMPLE_RATE_ms);
+	sensor_service_set_engine_sample_rate(sensor_service_handle, HS300x_TASK_DEFAULT_SAMPLE_RATE_ms);
+
+#if APP_SINGLE_TASK
+	/* There is no sampling task, the sampling engine runs in the event loop below */
+	hs300x_task_init(NULL);
+	hs300x_task_engine_start();
+#endif
+
+#if APP_BENCHMARK
+	/* Nobody is connected yet, so the fan-out benchmark only covers the connection lookup */
+#if APP_ESS_SERVICE
+	hs300x_bench_run(sensor_service_handle, ess_service_handle);
+#else
+	hs300x_bench_run(sensor_service_handle, NULL);
+#endif
+#endif
 
 	/*************************************************************************************************\
 	 * Start advertising
@@ -89,8 +179,21 @@ void ble_task(void *pvParameters)
 	 * By default, advertising interval is set to "fast connect" and a timer is started to
 	 * switch to "reduced power" interval afterwards.
 	 */
+#if APP_ADV_POLICY
+	adv_policy_init();
+#endif
+#if APP_MEASUREMENT_BROADCAST
+	/* The advertising data carries the latest measurement, the local name is in the scan response */
+	measurement_broadcast_start(device_name, sizeof(device_name));
+#else
 	ble_gap_adv_ad_struct_set(ARRAY_LENGTH(adv_data), adv_data, 0 , NULL);
+#endif
 	// Step 6.8 add the appropriate API to start the advertising in undirected mode
+#if APP_ADV_POLICY
+	adv_policy_start();
+#else
+	ble_gap_adv_start(GAP_CONN_MODE_UNDIRECTED);
+#endif
 
 
 
@@ -98,6 +201,18 @@ void ble_task(void *pvParameters)
 	{
 		uint32_t notif;
 
+#if APP_SINGLE_TASK
+		/*
+		 * Wait on any of the notification bits, then clear them all. Wake up in time for the next
+		 * step of the sampling engine as well.
+		 */
+		OS_BASE_TYPE ret = OS_TASK_NOTIFY_WAIT(0, OS_TASK_NOTIFY_ALL_BITS, &notif,
+		                                       hs300x_task_engine_ticks_to_deadline());
+		if (ret != OS_OK)
+		{
+			notif = 0;
+		}
+#else
 		/*
 		 * Wait on any of the notification bits, then clear them all
 		 */
@@ -106,79 +221,125 @@ void ble_task(void *pvParameters)
 		 * always be OS_OK
 		 */
 		OS_ASSERT(ret == OS_OK);
+#endif
 
 		/* Notified from BLE manager */
 		if (notif & BLE_APP_NOTIFY_MASK)
 		{
 			ble_evt_hdr_t *hdr;
-			hdr = ble_get_event(false);
+			uint32_t budget = BLE_TASK_EVENT_BUDGET;
 
-			if (hdr)
+			DIAG_COUNTER_INC(ble_wakeups);
+
+			/*
+			 * Handle the pending events in one go rather than one per notification. The budget
+			 * keeps a burst of events, e.g. several centrals connecting and discovering at once,
+			 * from holding back the samples below.
+			 */
+			while (budget-- > 0 && (hdr = ble_get_event(false)) != NULL)
 			{
-				/*
-				 * First, the application needs to check if the event is handled by the
-				 * ble_service framework. If it is not handled, the application may handle
-				 * it by defining a case for it in the `switch ()` statement below. If the
-				 * event is not handled by the application either, it is handled by the
-				 * default event handler.
-				 */
-				if (!ble_service_handle_event(hdr)) {
-					switch (hdr->evt_code)
-					{
-						case BLE_EVT_GAP_CONNECTED:
-							handle_evt_gap_connected((ble_evt_gap_connected_t *) hdr);
-							break;
-						case BLE_EVT_GAP_DISCONNECTED:
-							handle_evt_gap_disconnected((ble_evt_gap_disconnected_t *) hdr);
-							break;
-						case BLE_EVT_GAP_ADV_COMPLETED:
-							handle_evt_gap_adv_completed((ble_evt_gap_adv_completed_t *) hdr);
-							break;
-						case BLE_EVT_GAP_PAIR_REQ:
-							handle_evt_gap_pair_req((ble_evt_gap_pair_req_t *) hdr);
-							break;
-						default:
-							ble_handle_event_default(hdr);
-							break;
-					}
-				}
-
-				/* Free event buffer (it's not needed anymore) */
-				OS_FREE(hdr);
+				handle_ble_event(hdr);
 			}
 
-
 			/*
 			 * If there are more events waiting in queue, application should process
-			 * them now.
+			 * them after the samples.
 			 */
 			if (ble_has_event()) {
 				OS_TASK_NOTIFY(OS_GET_CURRENT_TASK(), BLE_APP_NOTIFY_MASK, OS_NOTIFY_SET_BITS);
 			}
 		}
 
+                /* Notified when the set up time of a new connection is over */
+                if (notif & CONN_POLICY_NOTIFY_MASK)
+                {
+                        conn_policy_settle_expired();
+                }
+
+#if APP_ADV_POLICY
+                /* Notified when the current advertising stage is over */
+                if (notif & ADV_POLICY_NOTIFY_MASK)
+                {
+                        adv_policy_stage_expired();
+                }
+#endif
+
+#if dg_configBLE_L2CAP_COC
+                /* Notified when a burst requested over L2CAP has been captured */
+                if (notif & BURST_CAPTURE_NOTIFY_MASK)
+                {
+                        l2cap_history_burst_complete();
+                }
+#endif
+
                 /* Notified HS3001 Task */
                 if (notif & HS3001_MEASUREMENT_NOTIFY_MASK)
                 {
                         // Process all items on the measurement queue
                         OS_BASE_TYPE q_status = OS_QUEUE_OK;
+                        hs300x_sample_t sample = {0};
+                        bool sample_received = false;
                         while (q_status != OS_QUEUE_EMPTY)
                         {
                                 // Get a measurement from the queue
-                                hs300x_data_t sample = {0};
+                                HOTPATH_TRACE_START(get_start);
                                 q_status = OS_QUEUE_GET(sample_q, &sample, OS_QUEUE_NO_WAIT);
+                                HOTPATH_TRACE_STOP(HOTPATH_SITE_QUEUE_GET, get_start);
 
                                 // if a measurement is available, notify all connected clients
                                 if(q_status == OS_QUEUE_OK)
                                 {
-                                       /* Step 7.6
-                                          Add the appropriate API from sensor_service.h to notify all connected clients
-                                          that a new sample measurement is available
-                                       */
-
+                                        sample_publish(&publish_services, &sample);
+                                        sample_received = true;
                                 }
                         }
+
+#if APP_MEASUREMENT_BROADCAST
+                        // Only the latest measurement is broadcast
+                        if (sample_received)
+                        {
+                                measurement_broadcast_update(&sample);
+                        }
+#endif
+                }
+
+#if APP_SINGLE_TASK
+                /* Run the sampling engine if its deadline has passed, whatever woke the task up */
+                hs300x_sample_t engine_sample;
+                if (hs300x_task_engine_run(&engine_sample))
+                {
+                        sample_publish(&publish_services, &engine_sample);
+#if APP_MEASUREMENT_BROADCAST
+                        measurement_broadcast_update(&engine_sample);
+#endif
+                        // The console is a consumer of the sample bus, printed once the clients are notified
+                        hs300x_task_print_samples();
                 }
+#endif
+	}
+}
+
+/**
+ * \brief Run the sampling engine at the fastest rate required by any client, or at the default rate
+ * if no client has a requirement
+ *
+ * \param[in] svc      		service handle
+ * \param[in] required_rate      	fastest rate required in milliseconds, 0 if none
+ *
+ * \return void
+ */
+static void apply_engine_sample_rate(ble_service_t *svc, uint32_t required_rate)
+{
+	uint32_t rate = required_rate ? required_rate : HS300x_TASK_DEFAULT_SAMPLE_RATE_ms;
+
+	if (rate != hs300x_task_get_sample_rate())
+	{
+		hs300x_task_set_sample_rate(rate);
+		sensor_service_set_engine_sample_rate(svc, rate);
+		conn_policy_set_sample_rate(rate);
+#if APP_ESS_SERVICE
+		ess_service_set_update_interval(ess_service_handle, rate);
+#endif
 	}
 }
 
@@ -192,7 +353,12 @@ void ble_task(void *pvParameters)
  */
 static void get_sample_rate(ble_service_t *svc, uint16_t conn_idx)
 {
-	uint32_t sample_rate_ms = hs300x_task_get_sample_rate();
+	// Report the rate this client receives samples at
+	uint32_t sample_rate_ms = sensor_service_get_conn_sample_rate(svc, conn_idx);
+	if (sample_rate_ms < hs300x_task_get_sample_rate())
+	{
+		sample_rate_ms = hs300x_task_get_sample_rate();
+	}
 	sensor_service_get_sample_rate_cfm(svc, conn_idx, ATT_ERROR_OK, &sample_rate_ms);
 }
 
@@ -216,6 +382,72 @@ static void get_sensor_id(ble_service_t *svc, uint16_t conn_idx)
 
 }
 
+/**
+ * \brief Handle an event from the BLE manager and free it
+ *
+ * \param[in] hdr          event to handle
+ *
+ * \return void
+ */
+static void handle_ble_event(ble_evt_hdr_t *hdr)
+{
+	HOTPATH_TRACE_START(event_start);
+
+	DIAG_COUNTER_INC(ble_events);
+
+	/*
+	 * First, the application needs to check if the event is handled by the
+	 * ble_service framework. If it is not handled, the application may handle
+	 * it by defining a case for it in the `switch ()` statement below. If the
+	 * event is not handled by the application either, it is handled by the
+	 * default event handler.
+	 */
+	bool handled = false;
+
+	/* Negotiation outcomes are logged, the events still go to the services and the default handler */
+	conn_policy_handle_event(hdr);
+
+#if dg_configBLE_L2CAP_COC
+	/* L2CAP events of the bulk transfer channel are not handled by the ble_service framework */
+	handled = l2cap_history_handle_event(hdr);
+#endif
+	if (!handled && !ble_service_handle_event(hdr)) {
+		switch (hdr->evt_code)
+		{
+			case BLE_EVT_GAP_CONNECTED:
+				handle_evt_gap_connected((ble_evt_gap_connected_t *) hdr);
+				break;
+			case BLE_EVT_GAP_DISCONNECTED:
+				handle_evt_gap_disconnected((ble_evt_gap_disconnected_t *) hdr);
+				break;
+			case BLE_EVT_GAP_ADV_COMPLETED:
+				handle_evt_gap_adv_completed((ble_evt_gap_adv_completed_t *) hdr);
+				break;
+			case BLE_EVT_GAP_PAIR_REQ:
+				handle_evt_gap_pair_req((ble_evt_gap_pair_req_t *) hdr);
+				break;
+			default:
+				ble_handle_event_default(hdr);
+				break;
+		}
+	}
+
+	/* A CCC write may have enabled or disabled notifications or indications of any service */
+	if (hdr->evt_code == BLE_EVT_GATTS_WRITE_REQ) {
+		uint16_t conn_idx = ((ble_evt_gatts_write_req_t *) hdr)->conn_idx;
+
+		if (update_streaming(conn_idx)) {
+			/* The client is set up, no need to wait for the settle timeout */
+			conn_policy_client_ready(conn_idx);
+		}
+	}
+
+	/* Free event buffer (it's not needed anymore) */
+	OS_FREE(hdr);
+
+	HOTPATH_TRACE_STOP(HOTPATH_SITE_BLE_EVENT, event_start);
+}
+
 /**
  * \brief Handler for advertising completed event
  *
@@ -229,7 +461,11 @@ static void handle_evt_gap_adv_completed(ble_evt_gap_adv_completed_t *evt)
 	 * If advertising is completed, just restart it. It's either because a new client connected
 	 * or it was cancelled in order to change the interval values.
 	 */
+#if APP_ADV_POLICY
+	adv_policy_adv_completed();
+#else
 	ble_gap_adv_start(GAP_CONN_MODE_UNDIRECTED);
+#endif
 }
 
 /**
@@ -242,6 +478,15 @@ static void handle_evt_gap_adv_completed(ble_evt_gap_adv_completed_t *evt)
 static void handle_evt_gap_connected(ble_evt_gap_connected_t *evt)
 {
 	// Manage behavior upon connection
+	conn_policy_connected(evt);
+	/* A bonded client may have notifications enabled from a previous connection */
+	update_streaming(evt->conn_idx);
+#if APP_ADV_POLICY
+	adv_policy_connected();
+#endif
+#if dg_configBLE_L2CAP_COC
+	l2cap_history_connected(evt->conn_idx);
+#endif
 }
 
 /**
@@ -255,9 +500,17 @@ static void handle_evt_gap_disconnected(ble_evt_gap_disconnected_t *evt)
 {
 
 	// Manage behavior upon disconnection
+	conn_policy_disconnected(evt->conn_idx);
+#if dg_configBLE_L2CAP_COC
+	l2cap_history_disconnected(evt->conn_idx);
+#endif
 
 	// Restart advertising
+#if APP_ADV_POLICY
+	adv_policy_disconnected();
+#else
 	ble_gap_adv_start(GAP_CONN_MODE_UNDIRECTED);
+#endif
 }
 
 /**
@@ -272,6 +525,19 @@ static void handle_evt_gap_pair_req(ble_evt_gap_pair_req_t *evt)
 	ble_gap_pair_reply(evt->conn_idx, true, evt->bond);
 }
 
+/**
+ * \brief Callback to handle a change of the fastest sample rate required by the connected clients
+ *
+ * \param[in] svc      		service handle
+ * \param[in] rate      		fastest rate required in milliseconds, 0 if none
+ *
+ * \return void
+ */
+static void sample_rate_required(ble_service_t *svc, uint32_t rate)
+{
+	apply_engine_sample_rate(svc, rate);
+}
+
 /**
  * \brief Callback to handle Sample Rate write requests
  *
@@ -287,5 +553,51 @@ static void set_sample_rate(ble_service_t *svc, uint16_t conn_idx, const uint32_
           Then add the appropriate API from sensor_service.h to confirm with the client
           the write has been processed
        */
+	sensor_service_set_sample_rate_cfm(svc, conn_idx, ATT_ERROR_OK);
+
+	// The rate applies to this client only. The engine runs at the fastest rate any client needs.
+	conn_policy_set_conn_sample_rate(conn_idx, new_rate);
+	apply_engine_sample_rate(svc, sensor_service_get_required_sample_rate(svc));
+}
+
+/**
+ * \brief Callback to handle a connection of the sample stream starting to drain a backlog, or
+ * catching up with the history
+ *
+ * \param[in] svc      		service handle
+ * \param[in] conn_idx      	connection index of the client
+ * \param[in] draining      	true while the backlog is being sent
+ *
+ * \return void
+ */
+static void stream_backlog_changed(ble_service_t *svc, uint16_t conn_idx, bool draining)
+{
+	conn_policy_set_backlog(conn_idx, draining);
+}
+
+/**
+ * \brief Let the connection policy know whether a client receives notifications or indications from
+ * any service, from the CCCs it wrote or the ones stored for it when it bonded
+ *
+ * \param[in] conn_idx      	connection index of the client
+ *
+ * \return true if notifications or indications are enabled on any service
+ */
+static bool update_streaming(uint16_t conn_idx)
+{
+	bool enabled = sensor_service_notifications_enabled(sensor_service_handle, conn_idx);
+
+	if (publish_services.ess_service) {
+		enabled = enabled || ess_service_notifications_enabled(publish_services.ess_service, conn_idx);
+	}
+	if (publish_services.alarm_service) {
+		enabled = enabled || alarm_service_indications_enabled(publish_services.alarm_service, conn_idx);
+	}
+	if (publish_services.stream_service) {
+		enabled = enabled || stream_service_notifications_enabled(publish_services.stream_service, conn_idx);
+	}
+
+	conn_policy_set_streaming(conn_idx, enabled);
 
+	return enabled;
 }
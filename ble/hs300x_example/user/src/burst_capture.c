@@ -0,0 +1,167 @@
+/*
+ * burst_capture.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "osal.h"
+#include "burst_capture.h"
+#include "hs300x_platform.h"
+
+/* Wait between two reads of a conversion that is still stale */
+#define BURST_CAPTURE_POLL_INTERVAL_us          (50)
+
+/* Private variables */
+__RETAINED static burst_sample_t burst_samples[BURST_CAPTURE_MAX_SAMPLES];
+__RETAINED static burst_capture_result_t burst_result;
+__RETAINED_RW static volatile burst_capture_state_t burst_state = BURST_CAPTURE_STATE_IDLE;
+__RETAINED_RW static OS_TASK sampling_task = NULL;
+__RETAINED_RW static OS_TASK requester_task = NULL;
+__RETAINED_RW static uint16_t max_request = BURST_CAPTURE_MAX_SAMPLES;
+
+/**
+ * \brief Get the samples of the last burst
+ *
+ * \param[out] result           where the result will be placed
+ *
+ * \return true if a burst is complete and result is valid, false otherwise
+ */
+bool burst_capture_get_result(burst_capture_result_t *result)
+{
+    if(burst_state != BURST_CAPTURE_STATE_DONE)
+    {
+        return false;
+    }
+
+    *result = burst_result;
+    return true;
+}
+
+/**
+ * \brief Get the state of the burst capture
+ *
+ * \return the state
+ */
+burst_capture_state_t burst_capture_get_state(void)
+{
+    return burst_state;
+}
+
+/**
+ * \brief Register the task running the sampling engine, so it is woken up when a burst is requested
+ *
+ * \param[in] task              handle of the task
+ * \param[in] max_samples       longest burst the task accepts, at most BURST_CAPTURE_MAX_SAMPLES
+ *
+ * \return void
+ */
+void burst_capture_register_task(OS_TASK task, uint16_t max_samples)
+{
+    sampling_task = task;
+    max_request = (max_samples < BURST_CAPTURE_MAX_SAMPLES) ? max_samples : BURST_CAPTURE_MAX_SAMPLES;
+}
+
+/**
+ * \brief Free the capture buffer once the samples have been uploaded, or are no longer wanted
+ *
+ * \return void
+ */
+void burst_capture_release(void)
+{
+    if(burst_state == BURST_CAPTURE_STATE_DONE)
+    {
+        burst_state = BURST_CAPTURE_STATE_IDLE;
+    }
+}
+
+/**
+ * \brief Request a burst
+ *
+ * \param[in] count             number of conversions, 1 to the limit given to burst_capture_register_task()
+ * \param[in] requester         task to notify with BURST_CAPTURE_NOTIFY_MASK once the burst is complete
+ *
+ * \return true if the burst will be run, false if count is out of range or a burst is already held
+ */
+bool burst_capture_request(uint16_t count, OS_TASK requester)
+{
+    if(count == 0 || count > max_request || burst_state != BURST_CAPTURE_STATE_IDLE)
+    {
+        return false;
+    }
+
+    memset(&burst_result, 0, sizeof(burst_result));
+    burst_result.samples = burst_samples;
+    burst_result.requested = count;
+    requester_task = requester;
+    burst_state = BURST_CAPTURE_STATE_REQUESTED;
+
+    if(sampling_task)
+    {
+        OS_TASK_NOTIFY(sampling_task, BURST_CAPTURE_NOTIFY_MASK, OS_NOTIFY_SET_BITS);
+    }
+
+    return true;
+}
+
+/**
+ * \brief Run the requested burst, if any. Must be called by the task that owns the sensor, between two
+ * periodic measurements. Each conversion is read as soon as its typical conversion time has passed, and
+ * read again while it is stale.
+ *
+ * \param[in] hs300x_handle     handle of the HS300x
+ *
+ * \return true if a burst was run, false if none was requested
+ */
+bool burst_capture_run(hs300x_handle_t *hs300x_handle)
+{
+    if(burst_state != BURST_CAPTURE_STATE_REQUESTED)
+    {
+        return false;
+    }
+
+    burst_state = BURST_CAPTURE_STATE_RUNNING;
+
+    uint32_t conversion_us = hs300x_get_conversion_time_us(hs300x_handle);
+    uint32_t start_us = hs300x_platform_time_us();
+    hs300x_error_t error = HS300x_ERROR_NONE;
+
+    while(burst_result.count < burst_result.requested && error == HS300x_ERROR_NONE)
+    {
+        burst_sample_t *sample = &burst_samples[burst_result.count];
+
+        sample->t_us = hs300x_platform_time_us() - start_us;
+        error = hs300x_start_measurement(hs300x_handle);
+        if(error != HS300x_ERROR_NONE)
+        {
+            break;
+        }
+
+        hs300x_platform_delay_us(conversion_us);
+        for(uint32_t polls = 0; ; polls++)
+        {
+            error = hs300x_fetch_raw(hs300x_handle, true, sample->raw);
+            if(error != HS300x_ERROR_STALE_DATA || polls == BURST_CAPTURE_MAX_POLLS)
+            {
+                break;
+            }
+            burst_result.stale_polls++;
+            hs300x_platform_delay_us(BURST_CAPTURE_POLL_INTERVAL_us);
+        }
+
+        if(error == HS300x_ERROR_NONE)
+        {
+            burst_result.count++;
+        }
+    }
+
+    burst_result.duration_us = hs300x_platform_time_us() - start_us;
+    burst_result.error = error;
+    burst_state = BURST_CAPTURE_STATE_DONE;
+
+    if(requester_task)
+    {
+        OS_TASK_NOTIFY(requester_task, BURST_CAPTURE_NOTIFY_MASK, OS_NOTIFY_SET_BITS);
+    }
+
+    return true;
+}
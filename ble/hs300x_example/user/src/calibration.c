@@ -0,0 +1,422 @@
+/*
+ * calibration.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "osal.h"
+#include "ble_bufops.h"
+#include "calibration.h"
+#include "nvms_record.h"
+
+/* Magic of the stored calibration, see nvms_record.h */
+#define CALIBRATION_MAGIC                       (0x314C4143)    /* "CAL1" */
+
+#define CALIBRATION_CODES                       (HS300x_CALC_14BIT_MAX + 1)
+#define CALIBRATION_BUCKETS                     (CALIBRATION_CODES >> CALIBRATION_BUCKET_SHIFT)
+
+/* Range of the measured and reference values, in hundredths */
+#define CALIBRATION_HUMIDITY_MAX_x100           (10000)
+#define CALIBRATION_TEMP_MIN_x100               (-HS300x_FIXED_TEMP_OFFSET)
+#define CALIBRATION_TEMP_MAX_x100               (12500)
+
+typedef struct
+{
+    uint16_t end;               /**< First code past the segment */
+    uint16_t measured;          /**< Code of the point the segment starts from */
+    int32_t reference;          /**< Corrected code at that point */
+    int32_t gain_q16;           /**< Reference over measured, Q16 */
+} segment_t;
+
+typedef struct
+{
+    bool calibrated;                                    /**< false to leave the codes as read */
+    uint8_t buckets[CALIBRATION_BUCKETS];               /**< Segment holding the first code of each bucket */
+    segment_t segments[CALIBRATION_MAX_POINTS];
+} channel_table_t;
+
+/* Private function prototypes */
+static uint16_t apply_channel(const channel_table_t *table, uint16_t code);
+static bool build_channel(calibration_channel_t channel, const calibration_point_t *points, uint8_t count,
+                          channel_table_t *table);
+static bool to_code(calibration_channel_t channel, int16_t value_x100, int32_t *code);
+static void use_calibration(const calibration_t *calibration);
+
+/* Private variables */
+/* Two sets of tables: the sampling task reads the active set while a new calibration is built in the other */
+__RETAINED static channel_table_t tables[2][CALIBRATION_CHANNEL_COUNT];
+__RETAINED_RW static volatile uint8_t active_tables = 0;
+__RETAINED static calibration_t current;
+__RETAINED_RW static uint32_t fitted_sensor_id = HS300x_UNKNOWN_SENSOR_ID;
+
+/**
+ * \brief Correct the code of one channel
+ *
+ * \param[in] table             tables of the channel
+ * \param[in] code              code as read
+ *
+ * \return corrected code, clamped to the range of the sensor
+ */
+static uint16_t apply_channel(const channel_table_t *table, uint16_t code)
+{
+    if(!table->calibrated)
+    {
+        return code;
+    }
+
+    // Points are at least one bucket apart, so the code is in the bucket's segment or the next one
+    const segment_t *segment = &table->segments[table->buckets[code >> CALIBRATION_BUCKET_SHIFT]];
+    if(code >= segment->end)
+    {
+        segment++;
+    }
+
+    int64_t delta = (int64_t)((int32_t)code - segment->measured) * segment->gain_q16;
+    int32_t corrected = segment->reference + (int32_t)((delta + (1 << 15)) >> 16);
+
+    if(corrected < 0)
+    {
+        return 0;
+    }
+    if(corrected > HS300x_CALC_14BIT_MAX)
+    {
+        return HS300x_CALC_14BIT_MAX;
+    }
+    return (uint16_t)corrected;
+}
+
+/**
+ * \brief Check the points of one channel and build its tables
+ *
+ * \param[in] channel           channel the points are for
+ * \param[in] points            points in increasing order of measured value
+ * \param[in] count             number of points, 0 to leave the channel uncorrected
+ * \param[out] table            tables of the channel, may be NULL to only check the points
+ *
+ * \return true if the points are valid, false otherwise
+ */
+static bool build_channel(calibration_channel_t channel, const calibration_point_t *points, uint8_t count,
+                          channel_table_t *table)
+{
+    int32_t measured[CALIBRATION_MAX_POINTS];
+    int32_t reference[CALIBRATION_MAX_POINTS];
+    segment_t segments[CALIBRATION_MAX_POINTS];
+    uint8_t segment_count = count > 1 ? count - 1 : 1;
+
+    if(count > CALIBRATION_MAX_POINTS)
+    {
+        return false;
+    }
+
+    for(uint8_t i = 0; i < count; i++)
+    {
+        if(!to_code(channel, points[i].measured_x100, &measured[i]) ||
+           !to_code(channel, points[i].reference_x100, &reference[i]))
+        {
+            return false;
+        }
+        if(i > 0 && measured[i] - measured[i - 1] < (1 << CALIBRATION_BUCKET_SHIFT))
+        {
+            return false;
+        }
+    }
+
+    if(count == 1)
+    {
+        segments[0].end = CALIBRATION_CODES;
+        segments[0].measured = measured[0];
+        segments[0].reference = reference[0];
+        segments[0].gain_q16 = 1 << 16;
+    }
+
+    for(uint8_t i = 0; i + 1 < count; i++)
+    {
+        int32_t gain_q16 = (reference[i + 1] - reference[i]) * 65536 / (measured[i + 1] - measured[i]);
+
+        if(gain_q16 * 100LL < (CALIBRATION_GAIN_MIN_PCT << 16) || gain_q16 * 100LL > (CALIBRATION_GAIN_MAX_PCT << 16))
+        {
+            return false;
+        }
+
+        // The first and last segments extend to the ends of the range
+        segments[i].end = (i + 2 == count) ? CALIBRATION_CODES : measured[i + 1];
+        segments[i].measured = measured[i];
+        segments[i].reference = reference[i];
+        segments[i].gain_q16 = gain_q16;
+    }
+
+    if(!table)
+    {
+        return true;
+    }
+
+    memset(table, 0, sizeof(*table));
+    if(count == 0)
+    {
+        return true;
+    }
+
+    memcpy(table->segments, segments, segment_count * sizeof(segments[0]));
+    for(uint32_t bucket = 0, segment = 0; bucket < CALIBRATION_BUCKETS; bucket++)
+    {
+        while((bucket << CALIBRATION_BUCKET_SHIFT) >= table->segments[segment].end)
+        {
+            segment++;
+        }
+        table->buckets[bucket] = segment;
+    }
+    table->calibrated = true;
+
+    return true;
+}
+
+/**
+ * \brief Convert a value in hundredths to the code the sensor would read for it
+ *
+ * \param[in] channel           channel of the value
+ * \param[in] value_x100        value in 0.01 %RH or 0.01 C
+ * \param[out] code             code
+ *
+ * \return true if the value is in the range of the sensor, false otherwise
+ */
+static bool to_code(calibration_channel_t channel, int16_t value_x100, int32_t *code)
+{
+    if(channel == CALIBRATION_CHANNEL_HUMIDITY)
+    {
+        if(value_x100 < 0 || value_x100 > CALIBRATION_HUMIDITY_MAX_x100)
+        {
+            return false;
+        }
+        *code = (value_x100 * HS300x_CALC_14BIT_MAX + CALIBRATION_HUMIDITY_MAX_x100 / 2) / CALIBRATION_HUMIDITY_MAX_x100;
+        return true;
+    }
+
+    if(value_x100 < CALIBRATION_TEMP_MIN_x100 || value_x100 > CALIBRATION_TEMP_MAX_x100)
+    {
+        return false;
+    }
+    *code = ((value_x100 - CALIBRATION_TEMP_MIN_x100) * HS300x_CALC_14BIT_MAX +
+             (CALIBRATION_TEMP_MAX_x100 - CALIBRATION_TEMP_MIN_x100) / 2) /
+            (CALIBRATION_TEMP_MAX_x100 - CALIBRATION_TEMP_MIN_x100);
+    return true;
+}
+
+/**
+ * \brief Build the tables of a valid calibration in the inactive set, then switch to it
+ *
+ * \param[in] calibration       calibration, already checked
+ *
+ * \return void
+ */
+static void use_calibration(const calibration_t *calibration)
+{
+    uint8_t next = active_tables ^ 1;
+
+    for(int channel = 0; channel < CALIBRATION_CHANNEL_COUNT; channel++)
+    {
+        build_channel(channel, calibration->points[channel], calibration->count[channel], &tables[next][channel]);
+    }
+
+    current = *calibration;
+    active_tables = next;
+}
+
+/**
+ * \brief Correct a measurement. Takes one table lookup and one multiply per channel, whatever the
+ * number of points.
+ *
+ * \param[in,out] raw           conversion codes as read, replaced with the corrected codes
+ *
+ * \return void
+ */
+void calibration_apply(hs300x_raw_t *raw)
+{
+    const channel_table_t *active = tables[active_tables];
+
+    raw->humidity = apply_channel(&active[CALIBRATION_CHANNEL_HUMIDITY], raw->humidity);
+    raw->temp = apply_channel(&active[CALIBRATION_CHANNEL_TEMP], raw->temp);
+}
+
+/**
+ * \brief Decode a calibration, see calibration.h for the format. The points are not checked.
+ *
+ * \param[in] buf               encoded calibration
+ * \param[in] length            length of buf
+ * \param[out] calibration      decoded calibration
+ *
+ * \return CALIBRATION_ERROR_NONE, or CALIBRATION_ERROR_LENGTH or CALIBRATION_ERROR_INVALID if the counts
+ *         do not match the length or are out of range
+ */
+calibration_error_t calibration_decode(const uint8_t *buf, uint16_t length, calibration_t *calibration)
+{
+    if(length < CALIBRATION_HEADER_SIZE)
+    {
+        return CALIBRATION_ERROR_LENGTH;
+    }
+
+    memset(calibration, 0, sizeof(*calibration));
+    calibration->sensor_id = get_u32(buf);
+    buf += 4;
+
+    uint16_t points = 0;
+    for(int channel = 0; channel < CALIBRATION_CHANNEL_COUNT; channel++)
+    {
+        calibration->count[channel] = *buf++;
+        if(calibration->count[channel] > CALIBRATION_MAX_POINTS)
+        {
+            return CALIBRATION_ERROR_INVALID;
+        }
+        points += calibration->count[channel];
+    }
+
+    if(length != CALIBRATION_HEADER_SIZE + points * CALIBRATION_POINT_SIZE)
+    {
+        return CALIBRATION_ERROR_LENGTH;
+    }
+
+    for(int channel = 0; channel < CALIBRATION_CHANNEL_COUNT; channel++)
+    {
+        for(uint8_t i = 0; i < calibration->count[channel]; i++)
+        {
+            calibration->points[channel][i].measured_x100 = (int16_t)get_u16(buf);
+            calibration->points[channel][i].reference_x100 = (int16_t)get_u16(buf + 2);
+            buf += CALIBRATION_POINT_SIZE;
+        }
+    }
+
+    return CALIBRATION_ERROR_NONE;
+}
+
+/**
+ * \brief Encode a calibration, see calibration.h for the format
+ *
+ * \param[in] calibration       calibration to encode
+ * \param[out] buf              buffer of at least CALIBRATION_ENCODED_MAX_SIZE bytes
+ *
+ * \return length of the encoded calibration
+ */
+uint16_t calibration_encode(const calibration_t *calibration, uint8_t *buf)
+{
+    uint8_t *ptr = buf;
+
+    put_u32_inc(&ptr, calibration->sensor_id);
+    for(int channel = 0; channel < CALIBRATION_CHANNEL_COUNT; channel++)
+    {
+        put_u8_inc(&ptr, calibration->count[channel]);
+    }
+
+    for(int channel = 0; channel < CALIBRATION_CHANNEL_COUNT; channel++)
+    {
+        for(uint8_t i = 0; i < calibration->count[channel]; i++)
+        {
+            put_u16_inc(&ptr, (uint16_t)calibration->points[channel][i].measured_x100);
+            put_u16_inc(&ptr, (uint16_t)calibration->points[channel][i].reference_x100);
+        }
+    }
+
+    return ptr - buf;
+}
+
+/**
+ * \brief Get the calibration applied. Without one, no points and the ID of the sensor fitted.
+ *
+ * \param[out] calibration      where the calibration will be placed
+ *
+ * \return void
+ */
+void calibration_get(calibration_t *calibration)
+{
+    *calibration = current;
+}
+
+/**
+ * \brief Load the calibration stored for the sensor fitted. Call before the first measurement.
+ *
+ * \param[in] sensor_id         ID of the sensor fitted, see hs300x_get_sensor_id()
+ *
+ * \return CALIBRATION_ERROR_NONE if the stored calibration is applied or none is stored,
+ *         CALIBRATION_ERROR_SENSOR_ID if it was made for another sensor, or the reason it is not valid.
+ *         Measurements are left uncorrected unless CALIBRATION_ERROR_NONE is returned.
+ */
+calibration_error_t calibration_init(uint32_t sensor_id)
+{
+    uint8_t payload[CALIBRATION_ENCODED_MAX_SIZE];
+    uint16_t length;
+    calibration_t stored;
+
+    fitted_sensor_id = sensor_id;
+    memset(&stored, 0, sizeof(stored));
+    stored.sensor_id = sensor_id;
+    use_calibration(&stored);
+
+    switch(nvms_record_read(NVMS_RECORD_ADDR_CALIBRATION, CALIBRATION_MAGIC, payload, sizeof(payload), &length))
+    {
+        case NVMS_RECORD_OK:
+            break;
+        case NVMS_RECORD_EMPTY:
+            // Nothing stored yet
+            return CALIBRATION_ERROR_NONE;
+        case NVMS_RECORD_INVALID:
+            return CALIBRATION_ERROR_INVALID;
+        default:
+            return CALIBRATION_ERROR_STORAGE;
+    }
+
+    calibration_error_t error = calibration_decode(payload, length, &stored);
+    if(error != CALIBRATION_ERROR_NONE)
+    {
+        return error;
+    }
+    if(stored.sensor_id != sensor_id)
+    {
+        return CALIBRATION_ERROR_SENSOR_ID;
+    }
+
+    for(int channel = 0; channel < CALIBRATION_CHANNEL_COUNT; channel++)
+    {
+        if(!build_channel(channel, stored.points[channel], stored.count[channel], NULL))
+        {
+            return CALIBRATION_ERROR_INVALID;
+        }
+    }
+
+    use_calibration(&stored);
+
+    return CALIBRATION_ERROR_NONE;
+}
+
+/**
+ * \brief Check a calibration, store it and apply it from the next measurement. A calibration without
+ * points removes the stored one.
+ *
+ * \param[in] calibration       calibration for the sensor fitted
+ *
+ * \return CALIBRATION_ERROR_NONE if the calibration is stored and applied, the reason it is not otherwise
+ */
+calibration_error_t calibration_set(const calibration_t *calibration)
+{
+    uint8_t payload[CALIBRATION_ENCODED_MAX_SIZE];
+
+    if(calibration->sensor_id != fitted_sensor_id)
+    {
+        return CALIBRATION_ERROR_SENSOR_ID;
+    }
+
+    for(int channel = 0; channel < CALIBRATION_CHANNEL_COUNT; channel++)
+    {
+        if(!build_channel(channel, calibration->points[channel], calibration->count[channel], NULL))
+        {
+            return CALIBRATION_ERROR_INVALID;
+        }
+    }
+
+    uint16_t length = calibration_encode(calibration, payload);
+    if(nvms_record_write(NVMS_RECORD_ADDR_CALIBRATION, CALIBRATION_MAGIC, payload, length) != NVMS_RECORD_OK)
+    {
+        return CALIBRATION_ERROR_STORAGE;
+    }
+
+    use_calibration(calibration);
+
+    return CALIBRATION_ERROR_NONE;
+}
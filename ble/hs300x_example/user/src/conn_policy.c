@@ -0,0 +1,488 @@
+/*
+ * conn_policy.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "ble_common.h"
+#include "ble_gap.h"
+#include "ble_gatt.h"
+
+#include "conn_policy.h"
+#include "static_alloc.h"
+
+typedef enum
+{
+    CONN_POLICY_MODE_IDLE = 0,
+    CONN_POLICY_MODE_STREAMING = 1,
+    CONN_POLICY_MODE_BULK = 2,
+} conn_policy_mode_t;
+
+/* Policy state of a connection */
+typedef struct
+{
+    bool in_use;
+    bool settled;                       // Set up done or timed out, the policy applies
+    bool streaming;                     // Notifications or indications enabled on any service
+    bool bulk;                          // Bulk transfer active
+    bool backlog;                       // Sample stream draining a backlog
+    bool fast_phy_requested;            // 2M PHY and data length already requested
+    uint16_t conn_idx;
+    uint32_t sample_rate_ms;            // Rate the connection receives samples at, 0 to follow the engine
+    gap_conn_params_t requested;        // Last parameters requested, to avoid repeating requests
+} conn_policy_conn_t;
+
+/* Private function prototypes */
+static void apply_policy(conn_policy_conn_t *conn);
+static uint32_t clamp(uint32_t value, uint32_t min, uint32_t max);
+static void compute_params(const conn_policy_conn_t *conn, conn_policy_mode_t mode, gap_conn_params_t *params);
+static void end_settling(conn_policy_conn_t *conn);
+static conn_policy_conn_t *find_conn(uint16_t conn_idx);
+static const char * phy_to_string(ble_gap_phy_t phy);
+static void settle_timer_cb(OS_TIMER timer);
+
+/* Private variables */
+__RETAINED static conn_policy_conn_t conns[CONN_POLICY_MAX_CONNECTIONS];
+__RETAINED_RW static uint32_t policy_sample_rate_ms = 1000;
+__RETAINED static OS_TASK policy_task;
+__RETAINED static OS_TIMER settle_timers[CONN_POLICY_MAX_CONNECTIONS];
+__RETAINED static static_timer_t settle_timer_storage[CONN_POLICY_MAX_CONNECTIONS];
+// Set by the timer task when the set up time of a connection slot is over
+__RETAINED static volatile bool settle_pending[CONN_POLICY_MAX_CONNECTIONS];
+
+/**
+ * \brief Request the parameters matching the current use of a connection. Nothing is requested while a
+ * new connection is being set up.
+ *
+ * \param[in] conn          connection to apply the policy to
+ *
+ * \return void
+ */
+static void apply_policy(conn_policy_conn_t *conn)
+{
+    if(!conn->settled)
+    {
+        return;
+    }
+
+    conn_policy_mode_t mode = (conn->bulk || conn->backlog) ? CONN_POLICY_MODE_BULK :
+                              conn->streaming ? CONN_POLICY_MODE_STREAMING : CONN_POLICY_MODE_IDLE;
+    gap_conn_params_t params;
+
+    compute_params(conn, mode, &params);
+
+    if(memcmp(&params, &conn->requested, sizeof(params)) != 0)
+    {
+        if(ble_gap_conn_param_update(conn->conn_idx, &params) == BLE_STATUS_OK)
+        {
+            conn->requested = params;
+        }
+    }
+
+    // Bulk transfers benefit from the faster PHY and longer packets. These are kept afterwards as
+    // they also shorten the radio on time of every notification.
+    if(mode == CONN_POLICY_MODE_BULK && !conn->fast_phy_requested)
+    {
+        ble_gap_phy_set(conn->conn_idx, BLE_GAP_PHY_PREF_2M, BLE_GAP_PHY_PREF_2M);
+        ble_gap_data_length_set(conn->conn_idx, CONN_POLICY_DATA_LENGTH_MAX, CONN_POLICY_DATA_TIME_MAX_us);
+        conn->fast_phy_requested = true;
+    }
+}
+
+/**
+ * \brief Clamp a value to a range
+ *
+ * \return the clamped value
+ */
+static uint32_t clamp(uint32_t value, uint32_t min, uint32_t max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+/**
+ * \brief Compute the connection parameters for a mode
+ *
+ * \param[in] conn          connection to compute the parameters for
+ * \param[in] mode          how the connection is being used
+ * \param[out] params       computed connection parameters
+ *
+ * \return void
+ *
+ * \note
+ * For streaming, the maximum interval tracks the sample rate so a notification waits at most one
+ * interval, and slave latency lets the device skip the connection events between samples.
+ */
+static void compute_params(const conn_policy_conn_t *conn, conn_policy_mode_t mode, gap_conn_params_t *params)
+{
+    // A connection never receives samples faster than the engine takes them
+    uint32_t sample_rate_ms = conn->sample_rate_ms > policy_sample_rate_ms ? conn->sample_rate_ms : policy_sample_rate_ms;
+    uint32_t interval_min_ms;
+    uint32_t interval_max_ms;
+    uint32_t latency;
+
+    switch(mode)
+    {
+        case CONN_POLICY_MODE_BULK:
+            interval_min_ms = CONN_POLICY_BULK_INTERVAL_MIN_ms;
+            interval_max_ms = CONN_POLICY_BULK_INTERVAL_MAX_ms;
+            latency = 0;
+            break;
+        case CONN_POLICY_MODE_STREAMING:
+            interval_max_ms = clamp(sample_rate_ms, CONN_POLICY_STREAM_INTERVAL_MIN_ms, CONN_POLICY_STREAM_INTERVAL_MAX_ms);
+            interval_min_ms = clamp(interval_max_ms / 2, CONN_POLICY_STREAM_INTERVAL_MIN_ms, interval_max_ms);
+            latency = sample_rate_ms / interval_max_ms;
+            latency = latency > 0 ? latency - 1 : 0;
+            break;
+        case CONN_POLICY_MODE_IDLE:
+        default:
+            interval_min_ms = CONN_POLICY_IDLE_INTERVAL_MIN_ms;
+            interval_max_ms = CONN_POLICY_IDLE_INTERVAL_MAX_ms;
+            latency = CONN_POLICY_IDLE_SLAVE_LATENCY;
+            break;
+    }
+
+    // The supervision timeout must exceed (1 + latency) * interval * 2. Limit the latency so a
+    // valid timeout exists, then leave twice the required margin.
+    uint32_t latency_max = CONN_POLICY_SUPERVISION_TIMEOUT_MAX_ms / (4 * interval_max_ms);
+    latency_max = latency_max > 0 ? latency_max - 1 : 0;
+    latency = clamp(latency, 0, latency_max < CONN_POLICY_SLAVE_LATENCY_MAX ? latency_max : CONN_POLICY_SLAVE_LATENCY_MAX);
+
+    uint32_t timeout_ms = clamp((1 + latency) * interval_max_ms * 4,
+                                CONN_POLICY_SUPERVISION_TIMEOUT_MIN_ms, CONN_POLICY_SUPERVISION_TIMEOUT_MAX_ms);
+
+    params->interval_min = BLE_CONN_INTERVAL_FROM_MS(interval_min_ms);
+    params->interval_max = BLE_CONN_INTERVAL_FROM_MS(interval_max_ms);
+    params->slave_latency = latency;
+    params->sup_timeout = BLE_SUPERVISION_TMO_FROM_MS(timeout_ms);
+}
+
+/**
+ * \brief End the set up time of a connection, the policy applies from the next apply_policy()
+ *
+ * \param[in] conn          connection being set up
+ *
+ * \return void
+ */
+static void end_settling(conn_policy_conn_t *conn)
+{
+    OS_TIMER_STOP(settle_timers[conn - conns], OS_TIMER_FOREVER);
+    conn->settled = true;
+}
+
+/**
+ * \brief Find the policy state of a connection
+ *
+ * \param[in] conn_idx      connection index
+ *
+ * \return pointer to the connection state, NULL if the connection is unknown
+ */
+static conn_policy_conn_t *find_conn(uint16_t conn_idx)
+{
+    for(int i = 0; i < CONN_POLICY_MAX_CONNECTIONS; i++)
+    {
+        if(conns[i].in_use && conns[i].conn_idx == conn_idx)
+        {
+            return &conns[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Convenience function to convert ble_gap_phy_t to a string
+ *
+ * \param[in] phy       PHY to convert
+ *
+ * \return a string with the corresponding PHY
+ */
+static const char * phy_to_string(ble_gap_phy_t phy)
+{
+    if(phy == BLE_GAP_PHY_1M)
+        return "1M";
+    else if(phy == BLE_GAP_PHY_2M)
+        return "2M";
+    else if(phy == BLE_GAP_PHY_CODED)
+        return "Coded";
+    else
+        return "unknown";
+}
+
+/**
+ * \brief Timer callback, runs in the timer task. The policy is applied in the BLE task.
+ *
+ * \param[in] timer         expired timer, its ID is the index of the connection slot
+ *
+ * \return void
+ */
+static void settle_timer_cb(OS_TIMER timer)
+{
+    settle_pending[(uintptr_t)OS_TIMER_GET_TIMER_ID(timer)] = true;
+    OS_TASK_NOTIFY(policy_task, CONN_POLICY_NOTIFY_MASK, OS_NOTIFY_SET_BITS);
+}
+
+/**
+ * \brief Initialize the connection policy, must be called from the BLE task. The task must call
+ * conn_policy_settle_expired() when notified with CONN_POLICY_NOTIFY_MASK.
+ *
+ * \param[in] sample_rate_ms    current sample rate in milliseconds
+ *
+ * \return void
+ */
+void conn_policy_init(uint32_t sample_rate_ms)
+{
+    memset(conns, 0, sizeof(conns));
+    policy_sample_rate_ms = sample_rate_ms;
+
+    policy_task = OS_GET_CURRENT_TASK();
+    for(uint32_t i = 0; i < CONN_POLICY_MAX_CONNECTIONS; i++)
+    {
+        settle_pending[i] = false;
+        STATIC_TIMER_CREATE(settle_timers[i], "conn_policy", OS_MS_2_TICKS(CONN_POLICY_SETTLE_TIMEOUT_ms),
+                            OS_TIMER_ONCE, (void *)(uintptr_t)i, settle_timer_cb, settle_timer_storage[i]);
+        OS_ASSERT(settle_timers[i]);
+    }
+
+    // The central starts the MTU exchange. Make sure it is offered a large MTU.
+    ble_gap_mtu_size_set(CONN_POLICY_PREFERRED_MTU);
+}
+
+/**
+ * \brief Indicate a client is set up, because it enabled notifications, so the policy applies to its
+ * connection without waiting for CONN_POLICY_SETTLE_TIMEOUT_ms
+ *
+ * \param[in] conn_idx      connection index
+ *
+ * \return void
+ */
+void conn_policy_client_ready(uint16_t conn_idx)
+{
+    conn_policy_conn_t *conn = find_conn(conn_idx);
+    if(conn && !conn->settled)
+    {
+        end_settling(conn);
+        apply_policy(conn);
+    }
+}
+
+/**
+ * \brief Start tracking a new connection. The policy applies once it is set up, see conn_policy.h.
+ *
+ * \param[in] evt           pointer to the connected event
+ *
+ * \return void
+ */
+void conn_policy_connected(const ble_evt_gap_connected_t *evt)
+{
+    printf("Conn %d: connected, interval %d.%02d ms, latency %d, timeout %d ms\r\n",
+           evt->conn_idx,
+           (evt->conn_params.interval_max * 125) / 100, (evt->conn_params.interval_max * 125) % 100,
+           evt->conn_params.slave_latency, evt->conn_params.sup_timeout * 10);
+
+    for(int i = 0; i < CONN_POLICY_MAX_CONNECTIONS; i++)
+    {
+        if(!conns[i].in_use)
+        {
+            memset(&conns[i], 0, sizeof(conns[i]));
+            conns[i].in_use = true;
+            conns[i].conn_idx = evt->conn_idx;
+            conns[i].requested = evt->conn_params;
+            settle_pending[i] = false;
+            OS_TIMER_START(settle_timers[i], OS_TIMER_FOREVER);
+            return;
+        }
+    }
+}
+
+/**
+ * \brief Stop applying the policy to a terminated connection
+ *
+ * \param[in] conn_idx      connection index
+ *
+ * \return void
+ */
+void conn_policy_disconnected(uint16_t conn_idx)
+{
+    conn_policy_conn_t *conn = find_conn(conn_idx);
+    if(conn)
+    {
+        OS_TIMER_STOP(settle_timers[conn - conns], OS_TIMER_FOREVER);
+        conn->in_use = false;
+    }
+}
+
+/**
+ * \brief Log the outcome of connection parameter, PHY, data length and MTU negotiations
+ *
+ * \param[in] hdr           pointer to the BLE event
+ *
+ * \return void
+ *
+ * \note
+ * The events are only logged, not consumed, so the services and ble_handle_event_default() still see them.
+ */
+void conn_policy_handle_event(const ble_evt_hdr_t *hdr)
+{
+    switch(hdr->evt_code)
+    {
+        case BLE_EVT_GAP_CONN_PARAM_UPDATED:
+        {
+            const ble_evt_gap_conn_param_updated_t *evt = (const ble_evt_gap_conn_param_updated_t *) hdr;
+            printf("Conn %d: interval %d.%02d ms, latency %d, timeout %d ms\r\n",
+                   evt->conn_idx,
+                   (evt->conn_params.interval_max * 125) / 100, (evt->conn_params.interval_max * 125) % 100,
+                   evt->conn_params.slave_latency, evt->conn_params.sup_timeout * 10);
+            break;
+        }
+        case BLE_EVT_GAP_PHY_CHANGED:
+        {
+            const ble_evt_gap_phy_changed_t *evt = (const ble_evt_gap_phy_changed_t *) hdr;
+            printf("Conn %d: PHY tx %s, rx %s\r\n", evt->conn_idx, phy_to_string(evt->tx_phy), phy_to_string(evt->rx_phy));
+            break;
+        }
+        case BLE_EVT_GAP_DATA_LENGTH_CHANGED:
+        {
+            const ble_evt_gap_data_length_changed_t *evt = (const ble_evt_gap_data_length_changed_t *) hdr;
+            printf("Conn %d: data length tx %d, rx %d\r\n", evt->conn_idx, evt->max_tx_length, evt->max_rx_length);
+            break;
+        }
+        case BLE_EVT_GATT_MTU_CHANGED:
+        {
+            const ble_evt_gatt_mtu_changed_t *evt = (const ble_evt_gatt_mtu_changed_t *) hdr;
+            printf("Conn %d: MTU %d\r\n", evt->conn_idx, evt->mtu);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * \brief Indicate the sample stream started or finished draining a backlog on a connection. It is
+ * sent with the bulk transfer parameters.
+ *
+ * \param[in] conn_idx      connection index
+ * \param[in] draining      true while a backlog is being sent
+ *
+ * \return void
+ */
+void conn_policy_set_backlog(uint16_t conn_idx, bool draining)
+{
+    conn_policy_conn_t *conn = find_conn(conn_idx);
+    if(conn && conn->backlog != draining)
+    {
+        conn->backlog = draining;
+        if(draining && !conn->settled)
+        {
+            // A bonded client resuming its stream is set up
+            end_settling(conn);
+        }
+        apply_policy(conn);
+    }
+}
+
+/**
+ * \brief Indicate a bulk transfer has started or finished on a connection
+ *
+ * \param[in] conn_idx      connection index
+ * \param[in] active        true if a bulk transfer is in progress
+ *
+ * \return void
+ */
+void conn_policy_set_bulk(uint16_t conn_idx, bool active)
+{
+    conn_policy_conn_t *conn = find_conn(conn_idx);
+    if(conn && conn->bulk != active)
+    {
+        conn->bulk = active;
+        if(active && !conn->settled)
+        {
+            // A client starting a transfer is set up
+            end_settling(conn);
+        }
+        apply_policy(conn);
+    }
+}
+
+/**
+ * \brief Set the rate a connection receives samples at
+ *
+ * \param[in] conn_idx          connection index
+ * \param[in] sample_rate_ms    rate in milliseconds, 0 if the connection receives every sample
+ *
+ * \return void
+ */
+void conn_policy_set_conn_sample_rate(uint16_t conn_idx, uint32_t sample_rate_ms)
+{
+    conn_policy_conn_t *conn = find_conn(conn_idx);
+    if(conn && conn->sample_rate_ms != sample_rate_ms)
+    {
+        conn->sample_rate_ms = sample_rate_ms;
+        apply_policy(conn);
+    }
+}
+
+/**
+ * \brief Update the parameters of all connections after the sampling engine rate changed
+ *
+ * \param[in] sample_rate_ms    new sample rate in milliseconds
+ *
+ * \return void
+ */
+void conn_policy_set_sample_rate(uint32_t sample_rate_ms)
+{
+    policy_sample_rate_ms = sample_rate_ms;
+
+    for(int i = 0; i < CONN_POLICY_MAX_CONNECTIONS; i++)
+    {
+        if(conns[i].in_use)
+        {
+            apply_policy(&conns[i]);
+        }
+    }
+}
+
+/**
+ * \brief Indicate whether a client receives notifications or indications from any service
+ *
+ * \param[in] conn_idx      connection index
+ * \param[in] enabled       true if notifications or indications are enabled
+ *
+ * \return void
+ */
+void conn_policy_set_streaming(uint16_t conn_idx, bool enabled)
+{
+    conn_policy_conn_t *conn = find_conn(conn_idx);
+    if(conn && conn->streaming != enabled)
+    {
+        conn->streaming = enabled;
+        apply_policy(conn);
+    }
+}
+
+/**
+ * \brief To be called when notified with CONN_POLICY_NOTIFY_MASK, applies the policy to the connections
+ * whose set up time is over
+ *
+ * \return void
+ */
+void conn_policy_settle_expired(void)
+{
+    for(int i = 0; i < CONN_POLICY_MAX_CONNECTIONS; i++)
+    {
+        if(!settle_pending[i])
+        {
+            continue;
+        }
+
+        settle_pending[i] = false;
+        if(conns[i].in_use && !conns[i].settled)
+        {
+            conns[i].settled = true;
+            apply_policy(&conns[i]);
+        }
+    }
+}
@@ -0,0 +1,223 @@
+/*
+ * diag_counters.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdint.h>
+#include <string.h>
+#include "osal.h"
+#include "ble_bufops.h"
+#ifdef OS_FREERTOS
+#include "sys_power_mgr.h"
+#endif
+
+#include "diag_counters.h"
+#include "time_sync.h"
+
+/* Private function prototypes */
+static diag_error_t error_to_diag(hs300x_error_t error);
+#ifdef OS_FREERTOS
+static bool pm_prepare_for_sleep(void);
+static void pm_sleep_canceled(void);
+static void pm_wake_up_ind(bool arg);
+static void pm_xtalm_ready_ind(void);
+#endif
+
+/* Private variables */
+__RETAINED_RW static OS_TASK task_handles[DIAG_TASK_COUNT] = { NULL };
+
+#ifdef OS_FREERTOS
+/* The power manager tells its adapters about every sleep and wake up, so count them there */
+static const adapter_call_backs_t pm_callbacks = {
+    .ad_prepare_for_sleep = pm_prepare_for_sleep,
+    .ad_sleep_canceled = pm_sleep_canceled,
+    .ad_wake_up_ind = pm_wake_up_ind,
+    .ad_xtalm_ready_ind = pm_xtalm_ready_ind,
+    .ad_sleep_preparation_time = 0,
+};
+#endif
+
+__RETAINED diag_counters_t diag_counters;
+
+/**
+ * \brief Map a measurement error to its counter
+ *
+ * \param[in] error             error returned by the driver
+ *
+ * \return counter for the error
+ */
+static diag_error_t error_to_diag(hs300x_error_t error)
+{
+    switch(error)
+    {
+    case HS300x_ERROR_I2C_IO_CONFIG_INVALID:            return DIAG_ERROR_I2C_IO_CONFIG_INVALID;
+    case HS300x_ERROR_I2C_ERROR_CONTROLLER_BUSY:        return DIAG_ERROR_I2C_CONTROLLER_BUSY;
+    case HS300x_ERROR_I2C_ERROR_DRIVER_CONF_INVALID:    return DIAG_ERROR_I2C_DRIVER_CONF_INVALID;
+    case HS300x_ERROR_I2C_ERROR_HANDLE_INVALID:         return DIAG_ERROR_I2C_HANDLE_INVALID;
+    case HS300x_ERROR_I2C_ABORT_7B_ADDR_NO_ACK:         return DIAG_ERROR_I2C_ABORT_7B_ADDR_NO_ACK;
+    case HS300x_ERROR_I2C_ABORT_10B_ADDR1_NO_ACK:       return DIAG_ERROR_I2C_ABORT_10B_ADDR1_NO_ACK;
+    case HS300x_ERROR_I2C_ABORT_10B_ADDR2_NO_ACK:       return DIAG_ERROR_I2C_ABORT_10B_ADDR2_NO_ACK;
+    case HS300x_ERROR_I2C_ABORT_TX_DATA_NO_ACK:         return DIAG_ERROR_I2C_ABORT_TX_DATA_NO_ACK;
+    case HS300x_ERROR_I2C_ABORT_GENERAL_CALL_NO_ACK:    return DIAG_ERROR_I2C_ABORT_GENERAL_CALL_NO_ACK;
+    case HS300x_ERROR_I2C_ABORT_GENERAL_CALL_READ:      return DIAG_ERROR_I2C_ABORT_GENERAL_CALL_READ;
+    case HS300x_ERROR_I2C_ABORT_START_BYTE_ACK:         return DIAG_ERROR_I2C_ABORT_START_BYTE_ACK;
+    case HS300x_ERROR_I2C_ABORT_10B_READ_NO_RESTART:    return DIAG_ERROR_I2C_ABORT_10B_READ_NO_RESTART;
+    case HS300x_ERROR_I2C_ABORT_MASTER_DISABLED:        return DIAG_ERROR_I2C_ABORT_MASTER_DISABLED;
+    case HS300x_ERROR_I2C_ABORT_ARBITRATION_LOST:       return DIAG_ERROR_I2C_ABORT_ARBITRATION_LOST;
+    case HS300x_ERROR_I2C_ABORT_SLAVE_FLUSH_TX_FIFO:    return DIAG_ERROR_I2C_ABORT_SLAVE_FLUSH_TX_FIFO;
+    case HS300x_ERROR_I2C_ABORT_SLAVE_ARBITRATION_LOST: return DIAG_ERROR_I2C_ABORT_SLAVE_ARBITRATION_LOST;
+    case HS300x_ERROR_I2C_ABORT_SLAVE_IN_TX:            return DIAG_ERROR_I2C_ABORT_SLAVE_IN_TX;
+    case HS300x_ERROR_I2C_ABORT_SW_ERROR:               return DIAG_ERROR_I2C_ABORT_SW_ERROR;
+    case HS300x_ERROR_DATA_ACCESS_FAIL:                 return DIAG_ERROR_DATA_ACCESS_FAIL;
+    default:                                            return DIAG_ERROR_OTHER;
+    }
+}
+
+#ifdef OS_FREERTOS
+/**
+ * \brief Called by the power manager before the system goes to sleep
+ *
+ * \return true, sleep is never blocked
+ */
+static bool pm_prepare_for_sleep(void)
+{
+    diag_counters.sleep_count++;
+    return true;
+}
+
+/**
+ * \brief Called by the power manager when sleep is aborted after pm_prepare_for_sleep()
+ *
+ * \return void
+ */
+static void pm_sleep_canceled(void)
+{
+    diag_counters.sleep_count--;
+}
+
+/**
+ * \brief Called by the power manager when the system wakes up
+ *
+ * \param[in] arg          unused
+ *
+ * \return void
+ */
+static void pm_wake_up_ind(bool arg)
+{
+    diag_counters.wake_count++;
+}
+
+/**
+ * \brief Called by the power manager when the XTAL32M has settled. Not used.
+ *
+ * \return void
+ */
+static void pm_xtalm_ready_ind(void)
+{
+}
+#endif
+
+/**
+ * \brief Clear the counters and start counting sleep and wake ups. Call before the tasks are started.
+ *
+ * \return void
+ */
+void diag_counters_init(void)
+{
+    memset(&diag_counters, 0, sizeof(diag_counters));
+
+#ifdef OS_FREERTOS
+    pm_register_adapter(&pm_callbacks);
+#endif
+}
+
+/**
+ * \brief Count a failed measurement
+ *
+ * \param[in] error             error returned by the driver, other than HS300x_ERROR_NONE
+ *
+ * \return void
+ */
+void diag_counters_measurement_error(hs300x_error_t error)
+{
+    if(error == HS300x_ERROR_STALE_DATA)
+    {
+        diag_counters.stale_samples++;
+    }
+    else
+    {
+        diag_counters.errors[error_to_diag(error)]++;
+    }
+}
+
+/**
+ * \brief Pack the counters, heap and stack usage into a health record. See diag_counters.h for the
+ * format.
+ *
+ * \param[out] buf              buffer of at least DIAG_COUNTERS_PACK_SIZE bytes
+ *
+ * \return number of bytes written
+ */
+uint16_t diag_counters_pack(uint8_t *buf)
+{
+    uint8_t *ptr = buf;
+    uint32_t free_heap = 0;
+    uint32_t min_free_heap = 0;
+    uint32_t heap_size = 0;
+
+#ifdef OS_FREERTOS
+    free_heap = xPortGetFreeHeapSize();
+    min_free_heap = xPortGetMinimumEverFreeHeapSize();
+    heap_size = configTOTAL_HEAP_SIZE;
+#endif
+
+    put_u8_inc(&ptr, DIAG_COUNTERS_PACK_VERSION);
+    // Counted on the 64 bit tick count, converting the 32 bit one to ms overflows long before it wraps
+    put_u32_inc(&ptr, (uint32_t)(time_sync_local_ticks() / OS_MS_2_TICKS(1000)));
+    put_u32_inc(&ptr, diag_counters.stale_samples);
+    put_u32_inc(&ptr, diag_counters.queue_drops);
+    put_u32_inc(&ptr, diag_counters.notify_failures);
+    put_u32_inc(&ptr, diag_counters.sleep_count);
+    put_u32_inc(&ptr, diag_counters.wake_count);
+    put_u32_inc(&ptr, diag_counters.ble_events);
+    put_u32_inc(&ptr, diag_counters.ble_wakeups);
+    put_u32_inc(&ptr, free_heap);
+    put_u32_inc(&ptr, min_free_heap);
+    put_u32_inc(&ptr, heap_size);
+
+    for(int task = 0; task < DIAG_TASK_COUNT; task++)
+    {
+        uint32_t free_stack = 0;
+
+#ifdef OS_FREERTOS
+        if(task_handles[task])
+        {
+            free_stack = uxTaskGetStackHighWaterMark(task_handles[task]) * sizeof(StackType_t);
+        }
+#endif
+        put_u16_inc(&ptr, free_stack < UINT16_MAX ? free_stack : UINT16_MAX);
+    }
+
+    for(int error = 0; error < DIAG_ERROR_COUNT; error++)
+    {
+        uint32_t count = diag_counters.errors[error];
+        put_u16_inc(&ptr, count < UINT16_MAX ? count : UINT16_MAX);
+    }
+
+    return ptr - buf;
+}
+
+/**
+ * \brief Register a task so its stack usage is reported
+ *
+ * \param[in] task              which task
+ * \param[in] handle            handle of the task
+ *
+ * \return void
+ */
+void diag_counters_register_task(diag_task_t task, OS_TASK handle)
+{
+    OS_ASSERT(task < DIAG_TASK_COUNT);
+
+    task_handles[task] = handle;
+}
@@ -0,0 +1,341 @@
+/*
+ * diag_service.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "osal.h"
+#include "ble_att.h"
+#include "ble_bufops.h"
+#include "ble_common.h"
+#include "ble_gatt.h"
+#include "ble_gatts.h"
+#include "ble_uuid.h"
+#include "adv_policy.h"
+#include "diag_counters.h"
+#include "diag_service.h"
+#include "hotpath_trace.h"
+#include "latency_trace.h"
+
+/* Service Defines */
+#define ADV_CHAR_SIZE                           (7 * sizeof(uint32_t) + sizeof(uint8_t))
+#define HEALTH_CHAR_SIZE                        DIAG_COUNTERS_PACK_SIZE
+#define LATENCY_CHAR_SIZE                       (sizeof(uint32_t) + LATENCY_STAGE_COUNT * 3 * sizeof(uint32_t))
+#define TRACE_CHAR_SIZE                         (HOTPATH_SITE_COUNT * 4 * sizeof(uint32_t))
+
+/* Diagnostics service structure */
+typedef struct {
+        ble_service_t svc;
+
+        // Attribute handles of BLE service
+        uint16_t health_value_h;                // Health Value
+        uint16_t health_user_desc_h;            // Health User Description
+
+        uint16_t latency_value_h;               // Sample Latency Value
+        uint16_t latency_user_desc_h;           // Sample Latency User Description
+
+        uint16_t trace_value_h;                 // Hot Path Trace Value
+        uint16_t trace_user_desc_h;             // Hot Path Trace User Description
+
+        uint16_t adv_value_h;                   // Advertising Value
+        uint16_t adv_user_desc_h;               // Advertising User Description
+} diag_service_t;
+
+
+/* Private function prototypes */
+static void add_char(const char *uuid_str, uint16_t size, uint16_t *value_h, uint16_t *user_desc_h, const char *user_desc);
+static void handle_adv_read(diag_service_t *diag_service_handle, const ble_evt_gatts_read_req_t *evt);
+static void handle_health_read(diag_service_t *diag_service_handle, const ble_evt_gatts_read_req_t *evt);
+static void handle_latency_read(diag_service_t *diag_service_handle, const ble_evt_gatts_read_req_t *evt);
+static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt);
+static void handle_trace_read(diag_service_t *diag_service_handle, const ble_evt_gatts_read_req_t *evt);
+static void read_cfm_long(const ble_evt_gatts_read_req_t *evt, const uint8_t *value, uint16_t length);
+
+/* Service Constants */
+static const char adv_char_user_description[]  = "Advertising";
+static const char health_char_user_description[]  = "Health";
+static const char latency_char_user_description[]  = "Sample Latency";
+static const char trace_char_user_description[]  = "Hot Path Trace";
+
+/* Private variables */
+__RETAINED static diag_service_t diag_service;
+
+/**
+ * \brief Add a read only characteristic with a Characteristic User Description
+ *
+ * \param[in] uuid_str         128 bit UUID of the characteristic
+ * \param[in] size             maximum size of the value
+ * \param[out] value_h         handle of the value
+ * \param[out] user_desc_h     handle of the User Description
+ * \param[in] user_desc        User Description
+ *
+ * \return void
+ */
+static void add_char(const char *uuid_str, uint16_t size, uint16_t *value_h, uint16_t *user_desc_h, const char *user_desc)
+{
+	att_uuid_t uuid;
+
+	ble_uuid_from_string(uuid_str, &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_READ,
+	                             ATT_PERM_READ,
+	                             size,
+	                             GATTS_FLAG_CHAR_READ_REQ,
+	                             NULL,
+	                             value_h);
+
+	ble_uuid_create16(UUID_GATT_CHAR_USER_DESCRIPTION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_READ,
+	                         strlen(user_desc),
+	                         0,
+	                         user_desc_h);
+}
+
+/**
+ * \brief This function is called when their is a read request for the Advertising
+ *
+ * \param[in] diag_service_handle       pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_adv_read(diag_service_t *diag_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	uint8_t value[ADV_CHAR_SIZE];
+	uint8_t *ptr = value;
+	adv_policy_stats_t stats;
+
+#if APP_ADV_POLICY
+	adv_policy_get_stats(&stats);
+#else
+	memset(&stats, 0, sizeof(stats));
+#endif
+
+	put_u32_inc(&ptr, stats.connections);
+	put_u32_inc(&ptr, stats.last_connect_ms);
+	put_u32_inc(&ptr, stats.connections ? stats.total_connect_ms / stats.connections : 0);
+	put_u32_inc(&ptr, stats.max_connect_ms);
+	put_u32_inc(&ptr, stats.advertising_ms);
+	put_u32_inc(&ptr, stats.adv_events);
+	put_u32_inc(&ptr, stats.boosts);
+	put_u8_inc(&ptr, stats.stage);
+
+	read_cfm_long(evt, value, sizeof(value));
+}
+
+/**
+ * \brief This function is called when their is a read request for the Health
+ *
+ * \param[in] diag_service_handle       pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_health_read(diag_service_t *diag_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	uint8_t value[HEALTH_CHAR_SIZE];
+
+	read_cfm_long(evt, value, diag_counters_pack(value));
+}
+
+/**
+ * \brief This function is called when their is a read request for the Sample Latency
+ *
+ * \param[in] diag_service_handle       pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_latency_read(diag_service_t *diag_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	uint8_t value[LATENCY_CHAR_SIZE];
+	uint8_t *ptr = value;
+	latency_percentiles_t percentiles;
+
+	latency_trace_get(LATENCY_STAGE_TOTAL, &percentiles);
+	put_u32_inc(&ptr, percentiles.count);
+
+	for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+	{
+		latency_trace_get(stage, &percentiles);
+		put_u32_inc(&ptr, percentiles.p50_us);
+		put_u32_inc(&ptr, percentiles.p95_us);
+		put_u32_inc(&ptr, percentiles.p99_us);
+	}
+
+	read_cfm_long(evt, value, sizeof(value));
+}
+
+/**
+ * \brief This function is called when their is a read request for any attribute of the service
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the read request
+ *
+ * \return void
+ */
+static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt)
+{
+	diag_service_t *diag_service_handle = (diag_service_t *) svc;
+
+	if (evt->handle == diag_service_handle->health_value_h)
+	{
+		handle_health_read(diag_service_handle, evt);
+	}
+	else if (evt->handle == diag_service_handle->latency_value_h)
+	{
+		handle_latency_read(diag_service_handle, evt);
+	}
+	else if (evt->handle == diag_service_handle->trace_value_h)
+	{
+		handle_trace_read(diag_service_handle, evt);
+	}
+	else if (evt->handle == diag_service_handle->adv_value_h)
+	{
+		handle_adv_read(diag_service_handle, evt);
+	}
+	// Otherwise read operations are not permitted
+	else
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_READ_NOT_PERMITTED, 0, NULL);
+	}
+}
+
+/**
+ * \brief This function is called when their is a read request for the Hot Path Trace
+ *
+ * \param[in] diag_service_handle       pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_trace_read(diag_service_t *diag_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	uint8_t value[TRACE_CHAR_SIZE];
+	uint8_t *ptr = value;
+
+	for (int site = 0; site < HOTPATH_SITE_COUNT; site++)
+	{
+		hotpath_site_stats_t stats;
+
+		hotpath_trace_get(site, &stats);
+		put_u32_inc(&ptr, stats.count);
+		put_u32_inc(&ptr, stats.min);
+		put_u32_inc(&ptr, stats.count ? stats.total / stats.count : 0);
+		put_u32_inc(&ptr, stats.max);
+	}
+
+	read_cfm_long(evt, value, sizeof(value));
+}
+
+/**
+ * \brief Respond to a read request for a value that may be longer than the ATT MTU. The value is
+ * built again for each Read Blob request, so a client reading it in parts may get parts of two
+ * different snapshots.
+ *
+ * \param[in] evt          pointer to the read request
+ * \param[in] value        whole value of the attribute
+ * \param[in] length       length of the value
+ *
+ * \return void
+ */
+static void read_cfm_long(const ble_evt_gatts_read_req_t *evt, const uint8_t *value, uint16_t length)
+{
+	if (evt->offset > length)
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_INVALID_OFFSET, 0, NULL);
+		return;
+	}
+
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, length - evt->offset, value + evt->offset);
+}
+
+/**
+ * \brief Initialize the diagnostics service
+ *
+ * \return pointer to the handle created for this service
+ */
+ble_service_t *diag_service_init(void)
+{
+	diag_service_t *diag_service_handle;
+	uint16_t num_attr;
+	att_uuid_t uuid;
+
+	// The service handle is statically allocated, there is a single instance of the service
+	diag_service_handle = &diag_service;
+	memset(diag_service_handle, 0, sizeof(diag_service_t));
+
+	// Declare handlers for specific BLE events
+	diag_service_handle->svc.read_req = handle_read_req;
+
+	/*
+	 * 0 --> Number of Included Services
+	 * 4 --> Number of Characteristic Declarations
+	 * 4 --> Number of Descriptors
+	 */
+	num_attr = ble_gatts_get_num_attr(0, 4, 4);
+
+	// Service declaration
+	ble_uuid_from_string("DDDDDDDD-1111-2222-3333-444444444444", &uuid);
+	ble_gatts_add_service(&uuid, GATT_SERVICE_PRIMARY, num_attr);
+
+	// Characteristics with their User Descriptions
+	add_char("DDDDDDDD-9999-AAAA-BBBB-CCCCCCCCCCCC", HEALTH_CHAR_SIZE,
+	         &diag_service_handle->health_value_h, &diag_service_handle->health_user_desc_h,
+	         health_char_user_description);
+	add_char("DDDDDDDD-5555-6666-7777-888888888888", LATENCY_CHAR_SIZE,
+	         &diag_service_handle->latency_value_h, &diag_service_handle->latency_user_desc_h,
+	         latency_char_user_description);
+	add_char("DDDDDDDD-EEEE-FFFF-0000-111111111111", TRACE_CHAR_SIZE,
+	         &diag_service_handle->trace_value_h, &diag_service_handle->trace_user_desc_h,
+	         trace_char_user_description);
+	add_char("DDDDDDDD-2222-3333-4444-555555555555", ADV_CHAR_SIZE,
+	         &diag_service_handle->adv_value_h, &diag_service_handle->adv_user_desc_h,
+	         adv_char_user_description);
+
+	/*
+	 * Register all the attribute handles so that they can be updated
+	 * by the BLE manager automatically.
+	 */
+	ble_gatts_register_service(&diag_service_handle->svc.start_h,
+	                           &diag_service_handle->health_value_h,
+	                           &diag_service_handle->health_user_desc_h,
+	                           &diag_service_handle->latency_value_h,
+	                           &diag_service_handle->latency_user_desc_h,
+	                           &diag_service_handle->trace_value_h,
+	                           &diag_service_handle->trace_user_desc_h,
+	                           &diag_service_handle->adv_value_h,
+	                           &diag_service_handle->adv_user_desc_h,
+	                           0);
+
+	// Calculate the last attribute handle of the BLE service
+	diag_service_handle->svc.end_h = diag_service_handle->svc.start_h + num_attr;
+
+	// Set default values for User Descriptions
+	ble_gatts_set_value(diag_service_handle->health_user_desc_h,
+	                    sizeof(health_char_user_description)-1,
+	                    health_char_user_description);
+
+	ble_gatts_set_value(diag_service_handle->latency_user_desc_h,
+	                    sizeof(latency_char_user_description)-1,
+	                    latency_char_user_description);
+
+	ble_gatts_set_value(diag_service_handle->trace_user_desc_h,
+	                    sizeof(trace_char_user_description)-1,
+	                    trace_char_user_description);
+
+	ble_gatts_set_value(diag_service_handle->adv_user_desc_h,
+	                    sizeof(adv_char_user_description)-1,
+	                    adv_char_user_description);
+
+	// Register the BLE service in BLE framework
+	ble_service_add(&diag_service_handle->svc);
+
+	// Return the service handle
+	return &diag_service_handle->svc;
+}
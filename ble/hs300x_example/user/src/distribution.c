@@ -0,0 +1,345 @@
+/*
+ * distribution.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "osal.h"
+#include "ble_bufops.h"
+#include "distribution.h"
+#include "sample_bus.h"
+#include "static_alloc.h"
+
+/* Markers of a P2 estimator */
+#define P2_MARKERS                              (5)
+
+typedef struct
+{
+    float heights[P2_MARKERS];          /**< Estimates of the minimum, p/2, p, (1+p)/2 quantiles and maximum */
+    int32_t positions[P2_MARKERS];      /**< Actual marker positions, 0 based */
+    float desired[P2_MARKERS];          /**< Desired marker positions */
+    float increments[P2_MARKERS];       /**< Desired position increments per sample */
+} p2_estimator_t;
+
+/* Private function prototypes */
+static float p2_estimate(const p2_estimator_t *estimator, uint32_t samples);
+static void p2_init(p2_estimator_t *estimator, float p);
+static void p2_put(p2_estimator_t *estimator, uint32_t samples, float value);
+static void reset(void);
+
+/* Private variables */
+static const uint8_t quantiles_pct[DISTRIBUTION_QUANTILE_COUNT] = DISTRIBUTION_QUANTILES;
+
+__RETAINED static uint32_t humidity_bins[DISTRIBUTION_HUMIDITY_BINS];
+__RETAINED static p2_estimator_t humidity_estimators[DISTRIBUTION_QUANTILE_COUNT];
+__RETAINED static p2_estimator_t temp_estimators[DISTRIBUTION_QUANTILE_COUNT];
+__RETAINED static uint32_t sample_count;
+__RETAINED_RW static uint8_t threshold_pct = DISTRIBUTION_DEFAULT_THRESHOLD_PCT;
+__RETAINED static OS_MUTEX distribution_mutex;
+__RETAINED static static_mutex_t distribution_mutex_storage;
+__RETAINED static sample_bus_consumer_t distribution_consumer;
+
+/**
+ * \brief Get the estimate of a P2 estimator. Until it has seen all its markers, the samples it holds
+ * are the exact distribution, and the nearest rank is returned.
+ *
+ * \param[in] estimator         the estimator
+ * \param[in] samples           samples it has seen, at least one
+ *
+ * \return estimated quantile
+ */
+static float p2_estimate(const p2_estimator_t *estimator, uint32_t samples)
+{
+    if(samples >= P2_MARKERS)
+    {
+        return estimator->heights[2];
+    }
+
+    // The first samples are kept sorted in the heights, the quantile is increments[2]
+    uint32_t rank = (uint32_t)(estimator->increments[2] * (samples - 1) + 0.5f);
+
+    return estimator->heights[rank];
+}
+
+/**
+ * \brief Initialize a P2 estimator
+ *
+ * \param[out] estimator        the estimator
+ * \param[in] p                 quantile to estimate, 0 to 1
+ *
+ * \return void
+ */
+static void p2_init(p2_estimator_t *estimator, float p)
+{
+    const float increments[P2_MARKERS] = { 0.0f, p / 2.0f, p, (1.0f + p) / 2.0f, 1.0f };
+
+    memset(estimator, 0, sizeof(*estimator));
+    for(int i = 0; i < P2_MARKERS; i++)
+    {
+        estimator->positions[i] = i;
+        estimator->desired[i] = increments[i] * (P2_MARKERS - 1);
+        estimator->increments[i] = increments[i];
+    }
+}
+
+/**
+ * \brief Add a sample to a P2 estimator. The markers are adjusted with a piecewise parabolic
+ * interpolation, or a linear one where the parabola would leave them out of order.
+ *
+ * \param[in,out] estimator     the estimator
+ * \param[in] samples           samples it has seen before this one
+ * \param[in] value             the sample
+ *
+ * \return void
+ */
+static void p2_put(p2_estimator_t *estimator, uint32_t samples, float value)
+{
+    float *q = estimator->heights;
+    int32_t *n = estimator->positions;
+    int k;
+
+    // The first samples are inserted in order, they are the initial heights
+    if(samples < P2_MARKERS)
+    {
+        int i = samples;
+
+        for(; i > 0 && q[i - 1] > value; i--)
+        {
+            q[i] = q[i - 1];
+        }
+        q[i] = value;
+        return;
+    }
+
+    // Find the cell the sample falls in, extending the extremes if needed
+    if(value < q[0])
+    {
+        q[0] = value;
+        k = 0;
+    }
+    else if(value >= q[P2_MARKERS - 1])
+    {
+        q[P2_MARKERS - 1] = value;
+        k = P2_MARKERS - 2;
+    }
+    else
+    {
+        k = 0;
+        while(value >= q[k + 1])
+        {
+            k++;
+        }
+    }
+
+    for(int i = k + 1; i < P2_MARKERS; i++)
+    {
+        n[i]++;
+    }
+    for(int i = 0; i < P2_MARKERS; i++)
+    {
+        estimator->desired[i] += estimator->increments[i];
+    }
+
+    // Move the middle markers that are a position or more away from where they should be
+    for(int i = 1; i < P2_MARKERS - 1; i++)
+    {
+        float d = estimator->desired[i] - n[i];
+
+        if((d >= 1.0f && n[i + 1] - n[i] > 1) || (d <= -1.0f && n[i - 1] - n[i] < -1))
+        {
+            int s = d > 0 ? 1 : -1;
+            float parabolic = q[i] + (float)s / (n[i + 1] - n[i - 1]) *
+                              ((n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+                               (n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+
+            if(q[i - 1] < parabolic && parabolic < q[i + 1])
+            {
+                q[i] = parabolic;
+            }
+            else
+            {
+                q[i] += s * (q[i + s] - q[i]) / (n[i + s] - n[i]);
+            }
+            n[i] += s;
+        }
+    }
+}
+
+/**
+ * \brief Clear the histogram and the estimators. Must be called with the mutex held.
+ *
+ * \return void
+ */
+static void reset(void)
+{
+    memset(humidity_bins, 0, sizeof(humidity_bins));
+    for(int i = 0; i < DISTRIBUTION_QUANTILE_COUNT; i++)
+    {
+        p2_init(&humidity_estimators[i], quantiles_pct[i] / 100.0f);
+        p2_init(&temp_estimators[i], quantiles_pct[i] / 100.0f);
+    }
+    sample_count = 0;
+}
+
+/**
+ * \brief Encode a summary, see distribution.h for the format
+ *
+ * \param[in] summary           summary to encode
+ * \param[out] buf              buffer of at least DISTRIBUTION_SUMMARY_SIZE bytes
+ *
+ * \return length of the encoded summary
+ */
+uint16_t distribution_encode_summary(const distribution_summary_t *summary, uint8_t *buf)
+{
+    uint8_t *ptr = buf;
+
+    put_u32_inc(&ptr, summary->samples);
+    put_u8_inc(&ptr, summary->threshold_pct);
+    put_u16_inc(&ptr, summary->above_threshold_x100);
+    for(int i = 0; i < DISTRIBUTION_QUANTILE_COUNT; i++)
+    {
+        put_u16_inc(&ptr, summary->humidity_x100[i]);
+    }
+    for(int i = 0; i < DISTRIBUTION_QUANTILE_COUNT; i++)
+    {
+        put_u16_inc(&ptr, (uint16_t)summary->temp_x100[i]);
+    }
+
+    return ptr - buf;
+}
+
+/**
+ * \brief Summarize the distribution since the last reset. The quantiles are 0 before the first sample.
+ *
+ * \param[out] summary          where the summary will be placed
+ *
+ * \return void
+ */
+void distribution_get_summary(distribution_summary_t *summary)
+{
+    uint32_t above = 0;
+
+    memset(summary, 0, sizeof(*summary));
+
+    OS_MUTEX_GET(distribution_mutex, OS_MUTEX_FOREVER);
+
+    summary->samples = sample_count;
+    summary->threshold_pct = threshold_pct;
+    for(int bin = threshold_pct; bin < DISTRIBUTION_HUMIDITY_BINS; bin++)
+    {
+        above += humidity_bins[bin];
+    }
+
+    for(int i = 0; i < DISTRIBUTION_QUANTILE_COUNT && sample_count; i++)
+    {
+        // The estimators work on conversion codes, convert the estimates like a measurement
+        hs300x_raw_t raw = {
+            .humidity = (uint16_t)(p2_estimate(&humidity_estimators[i], sample_count) + 0.5f),
+            .temp = (uint16_t)(p2_estimate(&temp_estimators[i], sample_count) + 0.5f),
+        };
+        hs300x_fixed_t fixed;
+
+        hs300x_convert_raw_fixed(&raw, &fixed);
+        summary->humidity_x100[i] = fixed.humidity_x100;
+        summary->temp_x100[i] = fixed.temp_x100;
+    }
+
+    OS_MUTEX_PUT(distribution_mutex);
+
+    summary->above_threshold_x100 = summary->samples ? (uint16_t)((uint64_t)above * 10000 / summary->samples) : 0;
+}
+
+/**
+ * \brief Initialize the distribution and subscribe to the sample bus. Must be called after
+ * sample_bus_init() and before any other distribution API
+ *
+ * \return void
+ */
+void distribution_init(void)
+{
+    STATIC_MUTEX_CREATE(distribution_mutex, distribution_mutex_storage);
+    reset();
+    sample_bus_subscribe(&distribution_consumer, "distribution", NULL, 0);
+}
+
+/**
+ * \brief Add the samples published on the sample bus since the previous call. The BLE task calls it for
+ * each sample it publishes, see sample_publish(). A sample the BLE task fell too far behind to read is
+ * counted as a drop of the "distribution" consumer and left out.
+ *
+ * \return void
+ */
+void distribution_process_samples(void)
+{
+    const hs300x_sample_t *sample;
+
+    while((sample = sample_bus_peek(&distribution_consumer)) != NULL)
+    {
+        hs300x_raw_t raw = sample->raw;
+
+        if(sample_bus_release(&distribution_consumer))
+        {
+            distribution_put(&raw);
+        }
+    }
+}
+
+/**
+ * \brief Add a measurement to the distribution. Called for every sample read from the sample bus, see
+ * distribution_process_samples().
+ *
+ * \param[in] raw               conversion codes of the measurement
+ *
+ * \return void
+ */
+void distribution_put(const hs300x_raw_t *raw)
+{
+    // 1 %RH bins, 100 %RH is counted in the last one
+    uint32_t bin = ((uint32_t)raw->humidity * DISTRIBUTION_HUMIDITY_BINS) >> 14;
+
+    OS_MUTEX_GET(distribution_mutex, OS_MUTEX_FOREVER);
+
+    humidity_bins[bin]++;
+    for(int i = 0; i < DISTRIBUTION_QUANTILE_COUNT; i++)
+    {
+        p2_put(&humidity_estimators[i], sample_count, raw->humidity);
+        p2_put(&temp_estimators[i], sample_count, raw->temp);
+    }
+    sample_count++;
+
+    OS_MUTEX_PUT(distribution_mutex);
+}
+
+/**
+ * \brief Clear the distribution. The threshold is kept.
+ *
+ * \return void
+ */
+void distribution_reset(void)
+{
+    OS_MUTEX_GET(distribution_mutex, OS_MUTEX_FOREVER);
+    reset();
+    OS_MUTEX_PUT(distribution_mutex);
+}
+
+/**
+ * \brief Set the humidity threshold of the summary. The histogram is kept, so the share of samples at
+ * or above the new threshold covers all the samples since the last reset.
+ *
+ * \param[in] threshold         threshold in %RH, 1 to 99
+ *
+ * \return true if the threshold was set, false if it is out of range
+ */
+bool distribution_set_threshold(uint8_t threshold)
+{
+    if(threshold == 0 || threshold >= DISTRIBUTION_HUMIDITY_BINS)
+    {
+        return false;
+    }
+
+    OS_MUTEX_GET(distribution_mutex, OS_MUTEX_FOREVER);
+    threshold_pct = threshold;
+    OS_MUTEX_PUT(distribution_mutex);
+
+    return true;
+}
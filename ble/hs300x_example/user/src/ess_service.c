@@ -0,0 +1,803 @@
+/*
+ * ess_service.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "osal.h"
+#include "ble_att.h"
+#include "ble_bufops.h"
+#include "ble_common.h"
+#include "ble_gap.h"
+#include "ble_gatt.h"
+#include "ble_gatts.h"
+#include "ble_storage.h"
+#include "ble_uuid.h"
+#include "diag_counters.h"
+#include "ess_service.h"
+#include "hotpath_trace.h"
+#include "time_sync.h"
+
+/* Service Defines */
+#define UUID_SERVICE_ESS                        0x181A
+#define UUID_CHAR_TEMPERATURE                   0x2A6E
+#define UUID_CHAR_HUMIDITY                      0x2A6F
+#define UUID_DESC_ES_CONFIGURATION              0x290B
+#define UUID_DESC_ES_MEASUREMENT                0x290C
+#define UUID_DESC_ES_TRIGGER_SETTING            0x290D
+
+#define ESS_VALUE_CHAR_SIZE                     sizeof(uint16_t)
+#define ES_MEASUREMENT_DESC_SIZE                11
+#define ES_TRIGGER_SETTING_DESC_MAX_SIZE        4       // Condition plus a 24 bit time operand
+#define ES_CONFIGURATION_DESC_SIZE              1
+
+#define ES_MEASUREMENT_SAMPLING_INSTANTANEOUS   0x01
+#define ES_MEASUREMENT_APPLICATION_AIR          0x01
+#define ES_MEASUREMENT_UNCERTAINTY_HUMIDITY     0x03    // +-1.5 %RH, in 0.5 % steps
+#define ES_MEASUREMENT_UNCERTAINTY_UNKNOWN      0xFF
+
+// ESS application error code for an unsupported trigger condition
+#define ESS_ERROR_CONDITION_NOT_SUPPORTED       0x81
+
+/* Characteristics of the service */
+typedef enum {
+        ESS_CHAR_HUMIDITY,
+        ESS_CHAR_TEMPERATURE,
+        ESS_CHAR_COUNT
+} ess_char_id_t;
+
+/* Trigger setting of a characteristic */
+typedef struct {
+        uint8_t condition;
+        uint32_t operand;               // Seconds for time based conditions, characteristic units otherwise
+        bool state;                     // Last result of a comparison condition, used to detect crossings
+} ess_trigger_t;
+
+/* Characteristic of the service */
+typedef struct {
+        // Attribute handles
+        uint16_t value_h;               // Value
+        uint16_t ccc_h;                 // Client Characteristic Configuration Descriptor. Used for notifications
+        uint16_t measurement_h;         // ES Measurement Descriptor
+        uint16_t trigger_h[ESS_TRIGGERS_PER_CHAR];      // ES Trigger Setting Descriptors
+        uint16_t config_h;              // ES Configuration Descriptor
+
+        ess_trigger_t trigger[ESS_TRIGGERS_PER_CHAR];
+        uint8_t trigger_logic;
+        bool is_signed;                 // Value is a sint16 rather than a uint16
+
+        // Last value notified, the triggers are evaluated against it
+        bool notified;
+        int32_t last_value;
+        uint64_t last_time;             // Extended tick count, time conditions span up to 2^24 s
+} ess_char_t;
+
+/* Environmental sensing service structure */
+typedef struct {
+        ble_service_t svc;
+
+        ess_char_t chars[ESS_CHAR_COUNT];
+
+        uint32_t update_interval_s;     // Internal update interval reported in the ES Measurement Descriptors
+} ess_service_t;
+
+
+/* Private function prototypes */
+static void add_char(ess_char_t *ch, uint16_t uuid16);
+static void cleanup(ble_service_t *svc);
+static bool evaluate_trigger(const ess_char_t *ch, ess_trigger_t *trigger, int32_t value, uint64_t now);
+static ess_char_t *find_char(ess_service_t *ess_service_handle, uint16_t handle, int *trigger_idx);
+static void handle_ccc_read(ess_char_t *ch, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_ccc_write(ess_char_t *ch, const ble_evt_gatts_write_req_t *evt);
+static att_error_t handle_config_write(ess_char_t *ch, const ble_evt_gatts_write_req_t *evt);
+static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_trigger_write(ess_char_t *ch, int trigger_idx, const ble_evt_gatts_write_req_t *evt);
+static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt);
+static void set_measurement_desc(ess_service_t *ess_service_handle, ess_char_t *ch);
+static void set_trigger_desc(ess_char_t *ch, int trigger_idx);
+static bool should_notify(ess_char_t *ch, int32_t value, uint64_t now);
+static void update_char(ess_char_t *ch, int32_t value);
+
+/* Private variables */
+__RETAINED static ess_service_t ess_service;
+
+// Copy kept by ess_service_save_state()
+__RETAINED static ess_char_t saved_chars[ESS_CHAR_COUNT];
+__RETAINED static uint8_t saved_values[ESS_CHAR_COUNT][ESS_VALUE_CHAR_SIZE];
+__RETAINED static uint16_t saved_lengths[ESS_CHAR_COUNT];
+
+/**
+ * \brief Add a characteristic with its CCC, ES Measurement, ES Trigger Setting and ES Configuration descriptors
+ *
+ * \param[in] ch            characteristic to add
+ * \param[in] uuid16        16 bit UUID of the characteristic
+ *
+ * \return void
+ */
+static void add_char(ess_char_t *ch, uint16_t uuid16)
+{
+	att_uuid_t uuid;
+
+	ble_uuid_create16(uuid16, &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_READ | GATT_PROP_NOTIFY,
+	                             ATT_PERM_READ,
+	                             ESS_VALUE_CHAR_SIZE,
+	                             0,
+	                             NULL,
+	                             &ch->value_h);
+
+	ble_uuid_create16(UUID_GATT_CLIENT_CHAR_CONFIGURATION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_RW,
+	                         2,
+	                         0,
+	                         &ch->ccc_h);
+
+	ble_uuid_create16(UUID_DESC_ES_MEASUREMENT, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_READ,
+	                         ES_MEASUREMENT_DESC_SIZE,
+	                         0,
+	                         &ch->measurement_h);
+
+	for (int i = 0; i < ESS_TRIGGERS_PER_CHAR; i++)
+	{
+		ble_uuid_create16(UUID_DESC_ES_TRIGGER_SETTING, &uuid);
+		ble_gatts_add_descriptor(&uuid,
+		                         ATT_PERM_RW,
+		                         ES_TRIGGER_SETTING_DESC_MAX_SIZE,
+		                         0,
+		                         &ch->trigger_h[i]);
+	}
+
+	// Required when a characteristic has more than one trigger setting
+	ble_uuid_create16(UUID_DESC_ES_CONFIGURATION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_RW,
+	                         ES_CONFIGURATION_DESC_SIZE,
+	                         0,
+	                         &ch->config_h);
+}
+
+/**
+ * \brief Service cleanup function.
+ *
+ * \param[in] svc          pointer BLE service
+ *
+ * \return void
+ */
+static void cleanup(ble_service_t *svc)
+{
+	ess_service_t *ess_service_handle = (ess_service_t *) svc;
+
+	for (int i = 0; i < ESS_CHAR_COUNT; i++)
+	{
+		ble_storage_remove_all(ess_service_handle->chars[i].ccc_h);
+	}
+}
+
+/**
+ * \brief Evaluate a single trigger condition for a new value
+ *
+ * \param[in] ch            characteristic the trigger belongs to
+ * \param[in] trigger       trigger to evaluate. The crossing state of comparison conditions is updated.
+ * \param[in] value         new value in characteristic units
+ * \param[in] now           current tick count, from time_sync_local_ticks()
+ *
+ * \return true if the trigger fires, false otherwise
+ */
+static bool evaluate_trigger(const ess_char_t *ch, ess_trigger_t *trigger, int32_t value, uint64_t now)
+{
+	// The operand of time conditions is up to 2^24 - 1 s, which overflows 32 bits in ms or ticks
+	uint64_t elapsed = now - ch->last_time;
+	uint64_t interval = (uint64_t)trigger->operand * OS_MS_2_TICKS(1000);
+	int32_t operand = ch->is_signed ? (int16_t)trigger->operand : (int32_t)trigger->operand;
+	bool state;
+
+	switch (trigger->condition)
+	{
+	case ESS_TRIGGER_FIXED_INTERVAL:
+		return !ch->notified || elapsed >= interval;
+	case ESS_TRIGGER_MIN_INTERVAL:
+		return !ch->notified || (value != ch->last_value && elapsed >= interval);
+	case ESS_TRIGGER_VALUE_CHANGED:
+		return !ch->notified || value != ch->last_value;
+	case ESS_TRIGGER_LESS_THAN:
+		state = value < operand;
+		break;
+	case ESS_TRIGGER_LESS_OR_EQUAL:
+		state = value <= operand;
+		break;
+	case ESS_TRIGGER_GREATER_THAN:
+		state = value > operand;
+		break;
+	case ESS_TRIGGER_GREATER_OR_EQUAL:
+		state = value >= operand;
+		break;
+	case ESS_TRIGGER_EQUAL:
+		state = value == operand;
+		break;
+	case ESS_TRIGGER_NOT_EQUAL:
+		state = value != operand;
+		break;
+	default:
+		return false;
+	}
+
+	// Comparison conditions only fire on entering the condition, not while it holds
+	bool fired = state && !trigger->state;
+	trigger->state = state;
+
+	return fired;
+}
+
+/**
+ * \brief Find the characteristic an attribute handle belongs to
+ *
+ * \param[in] ess_service_handle    pointer service handle
+ * \param[in] handle                attribute handle
+ * \param[out] trigger_idx          index of the trigger setting if the handle is an ES Trigger Setting Descriptor, -1 otherwise
+ *
+ * \return pointer to the characteristic, NULL if the handle is not part of a characteristic
+ */
+static ess_char_t *find_char(ess_service_t *ess_service_handle, uint16_t handle, int *trigger_idx)
+{
+	*trigger_idx = -1;
+
+	for (int i = 0; i < ESS_CHAR_COUNT; i++)
+	{
+		ess_char_t *ch = &ess_service_handle->chars[i];
+
+		if (handle >= ch->value_h && handle <= ch->config_h)
+		{
+			for (int t = 0; t < ESS_TRIGGERS_PER_CHAR; t++)
+			{
+				if (handle == ch->trigger_h[t])
+				{
+					*trigger_idx = t;
+				}
+			}
+			return ch;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * \brief This function is called when their is a read request for a CCC
+ *
+ * \param[in] ch           characteristic the CCC belongs to
+ * \param[in] evt          pointer to the read request
+ *
+ * \return void
+ */
+static void handle_ccc_read(ess_char_t *ch, const ble_evt_gatts_read_req_t *evt)
+{
+	uint16_t ccc = 0x0000;
+
+	// Extract the CCC value from the ble storage
+	ble_storage_get_u16(evt->conn_idx, ch->ccc_h, &ccc);
+
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, sizeof(ccc), &ccc);
+}
+
+/**
+ * \brief This function is called when their is a write request for a CCC
+ *
+ * \param[in] ch           characteristic the CCC belongs to
+ * \param[in] evt          pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_ccc_write(ess_char_t *ch, const ble_evt_gatts_write_req_t *evt)
+{
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+	if(evt->length != sizeof(uint16_t))
+	{
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	}
+
+	ble_storage_put_u32(evt->conn_idx, ch->ccc_h, get_u16(evt->value), true);
+	ble_gatts_write_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK);
+
+	return ATT_ERROR_OK;
+}
+
+/**
+ * \brief This function is called when their is a write request for an ES Configuration Descriptor
+ *
+ * \param[in] ch           characteristic the descriptor belongs to
+ * \param[in] evt          pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_config_write(ess_char_t *ch, const ble_evt_gatts_write_req_t *evt)
+{
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+	if(evt->length != ES_CONFIGURATION_DESC_SIZE)
+	{
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	}
+	if(evt->value[0] != ESS_TRIGGER_LOGIC_OR && evt->value[0] != ESS_TRIGGER_LOGIC_AND)
+	{
+		return ATT_ERROR_OUT_OF_RANGE;
+	}
+
+	ch->trigger_logic = evt->value[0];
+	ble_gatts_set_value(ch->config_h, ES_CONFIGURATION_DESC_SIZE, &ch->trigger_logic);
+	ble_gatts_write_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK);
+
+	return ATT_ERROR_OK;
+}
+
+/**
+ * \brief This function is called when their is a read request for an attribute in the service.
+ * Values and ES descriptors are read by the BLE manager directly, only the CCCs need the application.
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the read request
+ *
+ * \return void
+ */
+static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt)
+{
+	ess_service_t *ess_service_handle = (ess_service_t *) svc;
+	int trigger_idx;
+	ess_char_t *ch = find_char(ess_service_handle, evt->handle, &trigger_idx);
+
+	if(ch && evt->handle == ch->ccc_h)
+	{
+		handle_ccc_read(ch, evt);
+	}
+	// Otherwise read operations are not permitted
+	else
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_READ_NOT_PERMITTED, 0, NULL);
+	}
+}
+
+/**
+ * \brief This function is called when their is a write request for an ES Trigger Setting Descriptor
+ *
+ * \param[in] ch           characteristic the descriptor belongs to
+ * \param[in] trigger_idx  index of the trigger setting
+ * \param[in] evt          pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_trigger_write(ess_char_t *ch, int trigger_idx, const ble_evt_gatts_write_req_t *evt)
+{
+	ess_trigger_t *trigger = &ch->trigger[trigger_idx];
+	uint16_t operand_len;
+
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+	if(evt->length < 1)
+	{
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	}
+
+	switch (evt->value[0])
+	{
+	case ESS_TRIGGER_INACTIVE:
+	case ESS_TRIGGER_VALUE_CHANGED:
+		operand_len = 0;
+		break;
+	case ESS_TRIGGER_FIXED_INTERVAL:
+	case ESS_TRIGGER_MIN_INTERVAL:
+		operand_len = 3;
+		break;
+	case ESS_TRIGGER_LESS_THAN:
+	case ESS_TRIGGER_LESS_OR_EQUAL:
+	case ESS_TRIGGER_GREATER_THAN:
+	case ESS_TRIGGER_GREATER_OR_EQUAL:
+	case ESS_TRIGGER_EQUAL:
+	case ESS_TRIGGER_NOT_EQUAL:
+		operand_len = ESS_VALUE_CHAR_SIZE;
+		break;
+	default:
+		return ESS_ERROR_CONDITION_NOT_SUPPORTED;
+	}
+
+	if(evt->length != 1 + operand_len)
+	{
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	}
+
+	trigger->condition = evt->value[0];
+	trigger->operand = 0;
+	for (int i = operand_len - 1; i >= 0; i--)
+	{
+		trigger->operand = (trigger->operand << 8) | evt->value[1 + i];
+	}
+	// A threshold the value is already beyond fires on the next sample
+	trigger->state = false;
+
+	set_trigger_desc(ch, trigger_idx);
+	ble_gatts_write_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK);
+
+	return ATT_ERROR_OK;
+}
+
+/**
+ * \brief This function is called when their is a write request for an attribute in the service
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the write request
+ *
+ * \return void
+ */
+static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt)
+{
+	ess_service_t *ess_service_handle = (ess_service_t *) svc;
+	att_error_t status = ATT_ERROR_WRITE_NOT_PERMITTED;
+	int trigger_idx;
+	ess_char_t *ch = find_char(ess_service_handle, evt->handle, &trigger_idx);
+
+	if(ch && evt->handle == ch->ccc_h)
+	{
+		status = handle_ccc_write(ch, evt);
+	}
+	else if(ch && trigger_idx >= 0)
+	{
+		status = handle_trigger_write(ch, trigger_idx, evt);
+	}
+	else if(ch && evt->handle == ch->config_h)
+	{
+		status = handle_config_write(ch, evt);
+	}
+
+	/* If the status is anything other than ATT_ERROR_OK, inform the client the write is rejected.
+	 * Otherwise the write handlers above have already responded. */
+	if (status != ATT_ERROR_OK)
+	{
+		ble_gatts_write_cfm(evt->conn_idx, evt->handle, status);
+	}
+}
+
+/**
+ * \brief Set the value of the ES Measurement Descriptor of a characteristic
+ *
+ * \param[in] ess_service_handle    pointer service handle
+ * \param[in] ch                    characteristic to set the descriptor of
+ *
+ * \return void
+ */
+static void set_measurement_desc(ess_service_t *ess_service_handle, ess_char_t *ch)
+{
+	uint8_t desc[ES_MEASUREMENT_DESC_SIZE];
+	uint8_t *ptr = desc;
+	uint8_t uncertainty = (ch == &ess_service_handle->chars[ESS_CHAR_HUMIDITY]) ?
+	                      ES_MEASUREMENT_UNCERTAINTY_HUMIDITY : ES_MEASUREMENT_UNCERTAINTY_UNKNOWN;
+
+	put_u16_inc(&ptr, 0x0000);                                      // Flags
+	put_u8_inc(&ptr, ES_MEASUREMENT_SAMPLING_INSTANTANEOUS);        // Sampling function
+	put_u8_inc(&ptr, 0);                                            // Measurement period, not in use
+	put_u16_inc(&ptr, 0);
+	put_u8_inc(&ptr, ess_service_handle->update_interval_s);        // Internal update interval
+	put_u16_inc(&ptr, ess_service_handle->update_interval_s >> 8);
+	put_u8_inc(&ptr, ES_MEASUREMENT_APPLICATION_AIR);               // Application
+	put_u8_inc(&ptr, uncertainty);                                  // Measurement uncertainty
+
+	ble_gatts_set_value(ch->measurement_h, sizeof(desc), desc);
+}
+
+/**
+ * \brief Set the value of an ES Trigger Setting Descriptor from the trigger setting
+ *
+ * \param[in] ch            characteristic the descriptor belongs to
+ * \param[in] trigger_idx   index of the trigger setting
+ *
+ * \return void
+ */
+static void set_trigger_desc(ess_char_t *ch, int trigger_idx)
+{
+	const ess_trigger_t *trigger = &ch->trigger[trigger_idx];
+	uint8_t desc[ES_TRIGGER_SETTING_DESC_MAX_SIZE];
+	uint8_t *ptr = desc;
+
+	put_u8_inc(&ptr, trigger->condition);
+	if (trigger->condition == ESS_TRIGGER_FIXED_INTERVAL || trigger->condition == ESS_TRIGGER_MIN_INTERVAL)
+	{
+		put_u16_inc(&ptr, trigger->operand);
+		put_u8_inc(&ptr, trigger->operand >> 16);
+	}
+	else if (trigger->condition >= ESS_TRIGGER_LESS_THAN)
+	{
+		put_u16_inc(&ptr, trigger->operand);
+	}
+
+	ble_gatts_set_value(ch->trigger_h[trigger_idx], ptr - desc, desc);
+}
+
+/**
+ * \brief Combine the trigger settings of a characteristic for a new value
+ *
+ * \param[in] ch            characteristic to evaluate
+ * \param[in] value         new value in characteristic units
+ * \param[in] now           current tick count, from time_sync_local_ticks()
+ *
+ * \return true if the value should be notified, false otherwise
+ */
+static bool should_notify(ess_char_t *ch, int32_t value, uint64_t now)
+{
+	bool any_active = false;
+	bool any_fired = false;
+	bool all_fired = true;
+
+	// Every trigger is evaluated so that comparison conditions track crossings on every sample
+	for (int i = 0; i < ESS_TRIGGERS_PER_CHAR; i++)
+	{
+		if (ch->trigger[i].condition != ESS_TRIGGER_INACTIVE)
+		{
+			bool fired = evaluate_trigger(ch, &ch->trigger[i], value, now);
+
+			any_active = true;
+			any_fired |= fired;
+			all_fired &= fired;
+		}
+	}
+
+	// With all triggers inactive nothing is notified
+	if (!any_active)
+	{
+		return false;
+	}
+
+	return ch->trigger_logic == ESS_TRIGGER_LOGIC_AND ? all_fired : any_fired;
+}
+
+/**
+ * \brief Update the value of a characteristic and notify subscribed clients if its triggers fire
+ *
+ * \param[in] ch            characteristic to update
+ * \param[in] value         new value in characteristic units
+ *
+ * \return void
+ */
+static void update_char(ess_char_t *ch, int32_t value)
+{
+	uint64_t now = time_sync_local_ticks();
+	uint8_t buf[ESS_VALUE_CHAR_SIZE];
+	uint8_t *ptr = buf;
+
+	put_u16_inc(&ptr, (uint16_t)value);
+
+	// Reads always return the latest value
+	ble_gatts_set_value(ch->value_h, sizeof(buf), buf);
+
+	if (!should_notify(ch, value, now))
+	{
+		return;
+	}
+
+	ch->notified = true;
+	ch->last_value = value;
+	ch->last_time = now;
+
+	gap_device_t devices[BLE_GAP_MAX_CONNECTED];
+	size_t num_conn = ARRAY_LENGTH(devices);
+
+	ble_gap_get_devices(GAP_DEVICE_FILTER_CONNECTED, NULL, &num_conn, devices);
+
+	while ((num_conn--) > 0)
+	{
+		uint16_t ccc = 0x0000;
+
+		ble_storage_get_u16(devices[num_conn].conn_idx, ch->ccc_h, &ccc);
+		if (ccc & GATT_CCC_NOTIFICATIONS)
+		{
+			HOTPATH_TRACE_START(send_start);
+			if (ble_gatts_send_event(devices[num_conn].conn_idx, ch->value_h, GATT_EVENT_NOTIFICATION, sizeof(buf), buf) != BLE_STATUS_OK)
+			{
+				DIAG_COUNTER_INC(notify_failures);
+			}
+			HOTPATH_TRACE_STOP(HOTPATH_SITE_NOTIFY_SEND, send_start);
+		}
+	}
+}
+
+/**
+ * \brief Initialize the Environmental Sensing Service
+ *
+ * By default each characteristic notifies when its value changes.
+ *
+ * \return pointer to the handle created for this service
+ */
+ble_service_t *ess_service_init(void)
+{
+	ess_service_t *ess_service_handle;
+	uint16_t num_attr;
+	att_uuid_t uuid;
+
+	// The service handle is statically allocated, there is a single instance of the service
+	ess_service_handle = &ess_service;
+	memset(ess_service_handle, 0, sizeof(ess_service_t));
+
+	// Declare handlers for specific BLE events
+	ess_service_handle->svc.read_req  = handle_read_req;
+	ess_service_handle->svc.write_req = handle_write_req;
+	ess_service_handle->svc.cleanup   = cleanup;
+
+	ess_service_handle->chars[ESS_CHAR_TEMPERATURE].is_signed = true;
+
+	/*
+	 * 0 --> Number of Included Services
+	 * 2 --> Number of Characteristic Declarations
+	 * 2 x (3 + ESS_TRIGGERS_PER_CHAR) --> Number of Descriptors
+	 */
+	num_attr = ble_gatts_get_num_attr(0, ESS_CHAR_COUNT, ESS_CHAR_COUNT * (3 + ESS_TRIGGERS_PER_CHAR));
+
+	// Service declaration
+	ble_uuid_create16(UUID_SERVICE_ESS, &uuid);
+	ble_gatts_add_service(&uuid, GATT_SERVICE_PRIMARY, num_attr);
+
+	add_char(&ess_service_handle->chars[ESS_CHAR_HUMIDITY], UUID_CHAR_HUMIDITY);
+	add_char(&ess_service_handle->chars[ESS_CHAR_TEMPERATURE], UUID_CHAR_TEMPERATURE);
+
+	/*
+	 * Register all the attribute handles so that they can be updated
+	 * by the BLE manager automatically.
+	 */
+	ess_char_t *hum = &ess_service_handle->chars[ESS_CHAR_HUMIDITY];
+	ess_char_t *temp = &ess_service_handle->chars[ESS_CHAR_TEMPERATURE];
+	ble_gatts_register_service(&ess_service_handle->svc.start_h,
+	                           &hum->value_h, &hum->ccc_h, &hum->measurement_h,
+	                           &hum->trigger_h[0], &hum->trigger_h[1], &hum->config_h,
+	                           &temp->value_h, &temp->ccc_h, &temp->measurement_h,
+	                           &temp->trigger_h[0], &temp->trigger_h[1], &temp->config_h,
+	                           0);
+
+	// Calculate the last attribute handle of the BLE service
+	ess_service_handle->svc.end_h = ess_service_handle->svc.start_h + num_attr;
+
+	// Set default descriptor values
+	for (int i = 0; i < ESS_CHAR_COUNT; i++)
+	{
+		ess_char_t *ch = &ess_service_handle->chars[i];
+
+		ch->trigger[0].condition = ESS_TRIGGER_VALUE_CHANGED;
+		ch->trigger_logic = ESS_TRIGGER_LOGIC_OR;
+
+		set_measurement_desc(ess_service_handle, ch);
+		for (int t = 0; t < ESS_TRIGGERS_PER_CHAR; t++)
+		{
+			set_trigger_desc(ch, t);
+		}
+		ble_gatts_set_value(ch->config_h, ES_CONFIGURATION_DESC_SIZE, &ch->trigger_logic);
+	}
+
+	// Register the BLE service in BLE framework
+	ble_service_add(&ess_service_handle->svc);
+
+	// Return the service handle
+	return &ess_service_handle->svc;
+}
+
+/**
+ * \brief This function should be called by the application when the sampling engine rate changes.
+ * The rate is reported as the internal update interval of the ES Measurement Descriptors.
+ *
+ * \param[in] svc         	pointer to service handle
+ * \param[in] rate_ms           rate of the sampling engine in milliseconds
+ *
+ * \return void
+ */
+void ess_service_set_update_interval(ble_service_t *svc, uint32_t rate_ms)
+{
+	ess_service_t *ess_service_handle = (ess_service_t *) svc;
+
+	// Reported in whole seconds, rounded up so a sub-second rate is not reported as "not in use"
+	ess_service_handle->update_interval_s = (rate_ms + 999) / 1000;
+
+	for (int i = 0; i < ESS_CHAR_COUNT; i++)
+	{
+		set_measurement_desc(ess_service_handle, &ess_service_handle->chars[i]);
+	}
+}
+
+/**
+ * \brief Check whether a client has notifications enabled on any characteristic, whether it wrote the
+ * CCC on this connection or it was stored when the client bonded
+ *
+ * \param[in] svc               pointer to service handle
+ * \param[in] conn_idx          connection index of the client
+ *
+ * \return true if notifications are enabled on the Humidity or Temperature
+ */
+bool ess_service_notifications_enabled(ble_service_t *svc, uint16_t conn_idx)
+{
+	ess_service_t *ess_service_handle = (ess_service_t *) svc;
+
+	for (int i = 0; i < ESS_CHAR_COUNT; i++)
+	{
+		uint16_t ccc = 0x0000;
+
+		ble_storage_get_u16(conn_idx, ess_service_handle->chars[i].ccc_h, &ccc);
+		if (ccc & GATT_CCC_NOTIFICATIONS)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * \brief Restore the state saved by ess_service_save_state(): the trigger crossing states, the last
+ * value notified and the value returned by reads
+ *
+ * \param[in] svc               pointer to service handle
+ *
+ * \return void
+ */
+void ess_service_restore_state(ble_service_t *svc)
+{
+	ess_service_t *ess_service_handle = (ess_service_t *) svc;
+
+	for (int i = 0; i < ESS_CHAR_COUNT; i++)
+	{
+		ess_service_handle->chars[i] = saved_chars[i];
+		ble_gatts_set_value(saved_chars[i].value_h, saved_lengths[i], saved_values[i]);
+	}
+}
+
+/**
+ * \brief Save the state ess_service_update() changes, so measurements that are not real ones, as the
+ * benchmarks feed, can be taken back with ess_service_restore_state(). The trigger settings written
+ * by a client in between are lost, so save and restore from the BLE task without handling events
+ * in between.
+ *
+ * \param[in] svc               pointer to service handle
+ *
+ * \return void
+ */
+void ess_service_save_state(ble_service_t *svc)
+{
+	ess_service_t *ess_service_handle = (ess_service_t *) svc;
+
+	for (int i = 0; i < ESS_CHAR_COUNT; i++)
+	{
+		saved_chars[i] = ess_service_handle->chars[i];
+		saved_lengths[i] = sizeof(saved_values[i]);
+		if (ble_gatts_get_value(saved_chars[i].value_h, &saved_lengths[i], saved_values[i]) != BLE_STATUS_OK)
+		{
+			saved_lengths[i] = 0;
+		}
+	}
+}
+
+/**
+ * \brief This function should be called by the application for every new measurement. Subscribed
+ * clients are notified of each characteristic whose trigger settings fire.
+ *
+ * \param[in] svc         	pointer to service handle
+ * \param[in] value             new measurement
+ *
+ * \return void
+ */
+void ess_service_update(ble_service_t *svc, const hs300x_data_t *value)
+{
+	ess_service_t *ess_service_handle = (ess_service_t *) svc;
+
+	// Round to the nearest 0.01 unit
+	int32_t humidity = (int32_t)(value->humidity_rh_pct * 100.0f + 0.5f);
+	int32_t temp = (int32_t)(value->temp_deg_c * 100.0f + (value->temp_deg_c < 0 ? -0.5f : 0.5f));
+
+	update_char(&ess_service_handle->chars[ESS_CHAR_HUMIDITY], humidity);
+	update_char(&ess_service_handle->chars[ESS_CHAR_TEMPERATURE], temp);
+}
@@ -0,0 +1,166 @@
+/*
+ * hotpath_trace.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+
+#include "hotpath_trace.h"
+
+/* Private function prototypes */
+static uint8_t hist_bin(uint32_t elapsed);
+
+/*
+ * Private variables
+ *
+ * Each site is only recorded from one task, so the statistics are updated without a lock. A reader
+ * in another task may see a site in the middle of an update, which only skews that one read.
+ */
+__RETAINED static hotpath_site_stats_t site_stats[HOTPATH_SITE_COUNT];
+
+static const char * const site_names[HOTPATH_SITE_COUNT] = {
+    [HOTPATH_SITE_I2C_READ] = "i2c_read",
+    [HOTPATH_SITE_I2C_WRITE] = "i2c_write",
+    [HOTPATH_SITE_MEASUREMENT_DELAY] = "measurement_delay",
+    [HOTPATH_SITE_QUEUE_PUT] = "queue_put",
+    [HOTPATH_SITE_QUEUE_GET] = "queue_get",
+    [HOTPATH_SITE_BLE_EVENT] = "ble_event",
+    [HOTPATH_SITE_NOTIFY_SEND] = "notify_send",
+    [HOTPATH_SITE_BUS_PUBLISH] = "bus_publish",
+};
+
+/* Unit of the sites timed with HOTPATH_TRACE_TICKS_START/STOP, the others are in CYCLE_COUNTER_UNIT */
+static const char * const site_units[HOTPATH_SITE_COUNT] = {
+    [HOTPATH_SITE_MEASUREMENT_DELAY] = "ticks",
+};
+
+/**
+ * \brief Histogram bin of a duration
+ *
+ * \param[in] elapsed           duration in counter units, or in ticks for the sites that block
+ *
+ * \return floor(log2(elapsed)), limited to the last bin
+ */
+static uint8_t hist_bin(uint32_t elapsed)
+{
+    if(elapsed < 2)
+    {
+        return 0;
+    }
+
+    uint8_t bin = 31 - __builtin_clz(elapsed);
+    return bin < HOTPATH_TRACE_HIST_BINS ? bin : HOTPATH_TRACE_HIST_BINS - 1;
+}
+
+/**
+ * \brief Print the statistics of every site that has been recorded. Each site is one line:
+ *
+ *     TRACE,<site>,<count>,<min>,<mean>,<max>,<unit>,<bin>:<count> ...
+ *
+ * where only the non-empty histogram bins are listed. Sites that block are in ticks.
+ *
+ * \return void
+ */
+void hotpath_trace_dump(void)
+{
+    for(uint8_t site = 0; site < HOTPATH_SITE_COUNT; site++)
+    {
+        hotpath_site_stats_t stats;
+        hotpath_trace_get(site, &stats);
+
+        if(stats.count == 0)
+        {
+            continue;
+        }
+
+        printf("TRACE,%s,%lu,%lu,%lu,%lu,%s,", site_names[site], (unsigned long)stats.count,
+               (unsigned long)stats.min, (unsigned long)(stats.total / stats.count),
+               (unsigned long)stats.max, site_units[site] ? site_units[site] : CYCLE_COUNTER_UNIT);
+
+        for(uint8_t bin = 0; bin < HOTPATH_TRACE_HIST_BINS; bin++)
+        {
+            if(stats.hist[bin])
+            {
+                printf(" %u:%lu", bin, (unsigned long)stats.hist[bin]);
+            }
+        }
+        printf("\r\n");
+    }
+}
+
+/**
+ * \brief Get a copy of the statistics of a site
+ *
+ * \param[in] site              trace site
+ * \param[out] stats            buffer where the statistics will be placed
+ *
+ * \return void
+ */
+void hotpath_trace_get(hotpath_site_t site, hotpath_site_stats_t *stats)
+{
+    OS_ASSERT(site < HOTPATH_SITE_COUNT);
+
+    memcpy(stats, &site_stats[site], sizeof(*stats));
+}
+
+/**
+ * \brief Start the cycle counter and clear the statistics. Call before the tasks using the trace
+ * points are started.
+ *
+ * \return void
+ */
+void hotpath_trace_init(void)
+{
+    cycle_counter_init();
+    hotpath_trace_reset();
+}
+
+/**
+ * \brief Add a duration to the statistics of a site. Normally called through HOTPATH_TRACE_STOP()
+ * or HOTPATH_TRACE_TICKS_STOP().
+ *
+ * \param[in] site              trace site
+ * \param[in] elapsed           duration in counter units, or in ticks for the sites that block
+ *
+ * \return void
+ */
+void hotpath_trace_record(hotpath_site_t site, uint32_t elapsed)
+{
+    hotpath_site_stats_t *stats = &site_stats[site];
+
+    if(stats->count == 0 || elapsed < stats->min)
+    {
+        stats->min = elapsed;
+    }
+    if(elapsed > stats->max)
+    {
+        stats->max = elapsed;
+    }
+    stats->total += elapsed;
+    stats->hist[hist_bin(elapsed)]++;
+    stats->count++;
+}
+
+/**
+ * \brief Clear the statistics of all sites
+ *
+ * \return void
+ */
+void hotpath_trace_reset(void)
+{
+    memset(site_stats, 0, sizeof(site_stats));
+}
+
+/**
+ * \brief Current OS tick count, for the sites that block. Normally called through
+ * HOTPATH_TRACE_TICKS_START() and HOTPATH_TRACE_TICKS_STOP().
+ *
+ * \return tick count, wrapping at 2^32
+ */
+uint32_t hotpath_trace_ticks(void)
+{
+    return (uint32_t)OS_GET_TICK_COUNT();
+}
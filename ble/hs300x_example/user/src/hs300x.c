@@ -5,12 +5,17 @@
  *      Author: a5137667
  */
 #include "hs300x.h"
+#include "hotpath_trace.h"
+#include "hs300x_platform.h"
 
 /* Private function prototypes */
 static float calc_measurement_time(hs300x_resolution_t humidity_res, hs300x_resolution_t temp_res);
-static void convert_raw_to_humid_temp(uint8_t *raw_data, bool data_includes_temp, hs300x_data_t *calculated_data);
 static float measurement_time_from_resolution(hs300x_resolution_t res);
 static hs300x_error_t send_programming_mode_enter(hs300x_handle_t* hs300x_handle);
+#if HS300x_CONVERT_DSP
+static inline uint32_t smlabb(uint32_t op1, uint32_t op2, uint32_t op3);
+static inline uint32_t smlatt(uint32_t op1, uint32_t op2, uint32_t op3);
+#endif
 
 /**
  * \brief Calculate the time for a measurement based on the resolution settings
@@ -31,41 +36,166 @@ static float calc_measurement_time(hs300x_resolution_t humidity_res, hs300x_reso
 }
 
 /**
- * \brief Close the I2C controller for the HS300x
+ * \brief Convert a raw measurement to relative humidity percentage and degrees C. See datasheet Section 7.
  *
- * \param[in] i2c_handle        I2C handle of the controller to close
+ * \param[in] raw_data              raw measurement as read from the HS300x
+ * \param[in] data_includes_temp    a boolean value indicating if the measurement includes temperature data
+ * \param[out] calculated_data      a pointer to a buffer where the data will be placed
  *
  * \return void
  *
  */
-static void convert_raw_to_humid_temp(uint8_t *raw_data, bool data_includes_temp, hs300x_data_t *calculated_data)
+void hs300x_convert_raw_to_humid_temp(const uint8_t *raw_data, bool data_includes_temp, hs300x_data_t *calculated_data)
 {
-    float humidity = ((raw_data[0] & HS300x_MASK_HUMIDITY_UPPER_0X3F) << 8) | raw_data[1];
-    calculated_data->humidity_rh_pct = (humidity * HS300x_CALC_HUMD_VALUE_100) / (HS300x_CALC_14BIT_MAX);
+    hs300x_raw_t raw;
+
+    hs300x_parse_raw(raw_data, data_includes_temp, &raw);
+    calculated_data->humidity_rh_pct = (raw.humidity * HS300x_CALC_HUMD_VALUE_100) / (HS300x_CALC_14BIT_MAX);
 
     if(data_includes_temp)
     {
-        float temp = ((raw_data[2] << 8) | (raw_data[3] & HS300x_MASK_TEMPERATURE_LOWER_0XFC)) >> 2;
-        calculated_data->temp_deg_c = (temp * HS300x_CALC_TEMP_C_VALUE_165)/(HS300x_CALC_14BIT_MAX) - HS300x_CALC_TEMP_C_VALUE_40;
+        calculated_data->temp_deg_c = (raw.temp * HS300x_CALC_TEMP_C_VALUE_165)/(HS300x_CALC_14BIT_MAX) - HS300x_CALC_TEMP_C_VALUE_40;
     }
 }
 
 /**
- * \brief Extract the port/pin from a gpio_config
+ * \brief Convert conversion codes to relative humidity percentage and degrees C. See datasheet Section 7.
  *
- * \param[in] config        gpio_config to extract information from
- * \param[out] port         pointer where port information will be placed
- * \param[out] pin        	pointer where pin information will be placed
+ * \param[in] raw                   conversion codes, see hs300x_parse_raw()
+ * \param[out] calculated_data      a pointer to a buffer where the data will be placed
  *
  * \return void
  *
- * \sa ad_i2c_close()
+ */
+void hs300x_convert_raw(const hs300x_raw_t *raw, hs300x_data_t *calculated_data)
+{
+    calculated_data->humidity_rh_pct = (raw->humidity * HS300x_CALC_HUMD_VALUE_100) / (HS300x_CALC_14BIT_MAX);
+    calculated_data->temp_deg_c = (raw->temp * HS300x_CALC_TEMP_C_VALUE_165)/(HS300x_CALC_14BIT_MAX) - HS300x_CALC_TEMP_C_VALUE_40;
+}
+
+/**
+ * \brief Convert a block of conversion codes, such as a dump of the sample history. The divisions of
+ * hs300x_convert_raw() are replaced by multiplications, so a result may differ from it in the last bit.
+ *
+ * \param[in] raw                   conversion codes, see hs300x_parse_raw()
+ * \param[out] calculated_data      buffer of count entries where the data will be placed
+ * \param[in] count                 number of measurements to convert
+ *
+ * \return void
+ *
+ */
+void hs300x_convert_raw_batch(const hs300x_raw_t *raw, hs300x_data_t *calculated_data, size_t count)
+{
+    const float humidity_scale = HS300x_CALC_HUMD_VALUE_100 / HS300x_CALC_14BIT_MAX;
+    const float temp_scale = HS300x_CALC_TEMP_C_VALUE_165 / HS300x_CALC_14BIT_MAX;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        calculated_data[i].humidity_rh_pct = raw[i].humidity * humidity_scale;
+        calculated_data[i].temp_deg_c = raw[i].temp * temp_scale - HS300x_CALC_TEMP_C_VALUE_40;
+    }
+}
+
+/**
+ * \brief Convert conversion codes to hundredths of %RH and degrees C without floating point. The result
+ * is within 0.01 of hs300x_convert_raw() rounded to hundredths. This is the reference for
+ * hs300x_convert_raw_fixed_batch(), which gives the same result bit for bit.
+ *
+ * \param[in] raw                   conversion codes, see hs300x_parse_raw()
+ * \param[out] fixed                a pointer to a buffer where the data will be placed
+ *
+ * \return void
+ *
+ */
+void hs300x_convert_raw_fixed(const hs300x_raw_t *raw, hs300x_fixed_t *fixed)
+{
+    fixed->humidity_x100 = (raw->humidity * HS300x_FIXED_HUMD_SCALE_Q15 + (1 << 14)) >> 15;
+    fixed->temp_x100 = ((raw->temp * HS300x_FIXED_TEMP_SCALE_Q14 + (1 << 13)) >> 14) - HS300x_FIXED_TEMP_OFFSET;
+}
+
+#if HS300x_CONVERT_DSP
+/*
+ * SMLABB and SMLATT have no CMSIS-Core intrinsic, so they are issued with inline assembly the way
+ * cmsis_gcc.h issues the others. Elsewhere they are computed as the Cortex-M33 executes them, so the DSP
+ * path can be checked on the host.
+ */
+
+/**
+ * \brief Multiply the signed bottom halfwords of op1 and op2 and add op3, as SMLABB
+ *
+ * \return op1[15:0] * op2[15:0] + op3
+ */
+static inline uint32_t smlabb(uint32_t op1, uint32_t op2, uint32_t op3)
+{
+#if defined(__arm__)
+    uint32_t result;
+
+    __asm volatile ("smlabb %0, %1, %2, %3" : "=r" (result) : "r" (op1), "r" (op2), "r" (op3));
+    return result;
+#else
+    return (uint32_t)((int16_t)op1 * (int16_t)op2 + (int32_t)op3);
+#endif
+}
+
+/**
+ * \brief Multiply the signed top halfwords of op1 and op2 and add op3, as SMLATT
  *
+ * \return op1[31:16] * op2[31:16] + op3
  */
-static void gpio_config_to_port_and_pin(gpio_config config, HW_GPIO_PORT *port, HW_GPIO_PIN *pin)
+static inline uint32_t smlatt(uint32_t op1, uint32_t op2, uint32_t op3)
 {
-    *port = (config.pin & 0x3F) >> HW_GPIO_PIN_BITS;
-    *pin = (config.pin) & ((1 << HW_GPIO_PIN_BITS) - 1);
+#if defined(__arm__)
+    uint32_t result;
+
+    __asm volatile ("smlatt %0, %1, %2, %3" : "=r" (result) : "r" (op1), "r" (op2), "r" (op3));
+    return result;
+#else
+    return (uint32_t)((int16_t)(op1 >> 16) * (int16_t)(op2 >> 16) + (int32_t)op3);
+#endif
+}
+#endif
+
+/**
+ * \brief Convert a block of conversion codes to hundredths, such as a dump of the sample history. Same
+ * result as hs300x_convert_raw_fixed() on each measurement.
+ *
+ * With HS300x_CONVERT_DSP, a measurement is loaded as one word holding both codes. Each code is scaled
+ * and rounded with one 16 x 16 multiply-accumulate, both results are packed back into one word and the
+ * temperature offset is removed from both halves with one SSUB16.
+ *
+ * \param[in] raw                   conversion codes, see hs300x_parse_raw()
+ * \param[out] fixed                buffer of count entries where the data will be placed
+ * \param[in] count                 number of measurements to convert
+ *
+ * \return void
+ *
+ */
+void hs300x_convert_raw_fixed_batch(const hs300x_raw_t *raw, hs300x_fixed_t *fixed, size_t count)
+{
+#if HS300x_CONVERT_DSP
+    // Humidity in the bottom halfword, temperature in the top one, in and out
+    const uint32_t scales = HS300x_FIXED_HUMD_SCALE_Q15 | (HS300x_FIXED_TEMP_SCALE_Q14 << 16);
+    const uint32_t offsets = HS300x_FIXED_TEMP_OFFSET << 16;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        uint32_t codes;
+        uint32_t result;
+
+        memcpy(&codes, &raw[i], sizeof(codes));
+        uint32_t humidity = smlabb(codes, scales, 1 << 14);
+        uint32_t temp = smlatt(codes, scales, 1 << 13);
+
+        // The top halfword of temp << 2 is temp >> 14
+        result = __SSUB16(__PKHBT(humidity >> 15, temp, 2), offsets);
+        memcpy(&fixed[i], &result, sizeof(result));
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        hs300x_convert_raw_fixed(&raw[i], &fixed[i]);
+    }
+#endif
 }
 
 /**
@@ -81,7 +211,7 @@ static void gpio_config_to_port_and_pin(gpio_config config, HW_GPIO_PORT *port,
 void hs300x_close(hs300x_handle_t* hs300x_handle)
 {
     ASSERT_WARNING(hs300x_handle->i2c_handle)
-    hs300x_error_t error = ad_i2c_close(hs300x_handle->i2c_handle, true);
+    hs300x_error_t error = hs300x_platform_i2c_close(hs300x_handle->i2c_handle);
     ASSERT_ERROR(error == HS300x_ERROR_NONE);
 }
 
@@ -114,6 +244,82 @@ hs300x_error_t hs300x_exit_programming_mode(hs300x_handle_t* hs300x_handle)
     return  hs300x_write(hs300x_handle, exit_programming_mode_cmd, sizeof(exit_programming_mode_cmd));
 }
 
+/**
+ * \brief Read a measurement started with hs300x_start_measurement() and convert the raw value to relative
+ * humidity percentage and degrees C per Section 7. Call it no sooner than hs300x_get_measurement_delay_ms()
+ * after starting the measurement.
+ *
+ * \param[in] hs300x_handle             handle of the HS300x
+ * \param[in] data_includes_temp        a boolean value indicating if the measurement should include temperature data
+ * \param[out] calculated_data          a pointer to a buffer where the data will be placed
+ *
+ * \return error indicating status of the operation
+ *
+ */
+hs300x_error_t hs300x_fetch_measurement(hs300x_handle_t* hs300x_handle, bool data_includes_temp, hs300x_data_t *calculated_data)
+{
+    uint8_t response[HS300x_MEASUREMENT_LENGTH_HUMIDITY_AND_TEMP] = {0};
+    hs300x_error_t error = hs300x_fetch_raw(hs300x_handle, data_includes_temp, response);
+
+    if(error == HS300x_ERROR_NONE || error == HS300x_ERROR_STALE_DATA)
+    {
+        hs300x_convert_raw_to_humid_temp(response, data_includes_temp, calculated_data);
+    }
+
+    return error;
+}
+
+/**
+ * \brief Read a measurement started with hs300x_start_measurement() as conversion codes. Call it no sooner
+ * than hs300x_get_measurement_delay_ms() after starting the measurement.
+ *
+ * \param[in] hs300x_handle             handle of the HS300x
+ * \param[in] data_includes_temp        a boolean value indicating if the measurement should include temperature data
+ * \param[out] raw                      a pointer to a buffer where the codes will be placed
+ *
+ * \return error indicating status of the operation
+ *
+ */
+hs300x_error_t hs300x_fetch_measurement_raw(hs300x_handle_t* hs300x_handle, bool data_includes_temp, hs300x_raw_t *raw)
+{
+    uint8_t response[HS300x_MEASUREMENT_LENGTH_HUMIDITY_AND_TEMP] = {0};
+    hs300x_error_t error = hs300x_fetch_raw(hs300x_handle, data_includes_temp, response);
+
+    if(error == HS300x_ERROR_NONE || error == HS300x_ERROR_STALE_DATA)
+    {
+        hs300x_parse_raw(response, data_includes_temp, raw);
+    }
+
+    return error;
+}
+
+/**
+ * \brief Read a measurement started with hs300x_start_measurement() without converting it. See Section 6.6.
+ *
+ * \param[in] hs300x_handle             handle of the HS300x
+ * \param[in] data_includes_temp        a boolean value indicating if the measurement should include temperature data
+ * \param[out] raw_data                 buffer of HS300x_MEASUREMENT_LENGTH_HUMIDITY_AND_TEMP bytes where the
+ *                                      measurement will be placed, status bits included
+ *
+ * \return error indicating status of the operation. HS300x_ERROR_STALE_DATA if the conversion has not
+ * completed yet, raw_data then holds the previous measurement.
+ *
+ */
+hs300x_error_t hs300x_fetch_raw(hs300x_handle_t* hs300x_handle, bool data_includes_temp, uint8_t *raw_data)
+{
+    // TODO handle 8 bit temperature (e.g. len == 3)
+    uint8_t len = data_includes_temp ? HS300x_MEASUREMENT_LENGTH_HUMIDITY_AND_TEMP : HS300x_MEASUREMENT_LENGTH_HUMIDITY_ONLY;
+    hs300x_error_t error = hs300x_read(hs300x_handle, raw_data, len);
+
+    if(error == HS300x_ERROR_NONE &&
+       ((raw_data[0] & HS300x_MASK_STATUS_0XC0) >> 6) == HS300x_DATA_STATUS_STALE)
+    {
+        error = HS300x_ERROR_STALE_DATA;
+    }
+
+    return error;
+}
+
 /**
  * \brief Get a measurement. This function will start the measurement (see Section 6.5), wait for the appropriate
  * amount of time for the measurement to complete (plus some additional margin), and convert the raw value to
@@ -131,20 +337,68 @@ hs300x_error_t hs300x_get_measurement(hs300x_handle_t* hs300x_handle, bool data_
     hs300x_error_t error = hs300x_start_measurement(hs300x_handle);
     if(error == HS300x_ERROR_NONE)
     {
-        float measurement_time = calc_measurement_time(hs300x_handle->humidity_res, hs300x_handle->temp_res);
-        // Round measurement time up and add some additional delay to account for worst case measurement time
-        uint32_t measurement_delay = HS300x_MEASUREMENT_TIME_MARGIN_ms + ((uint32_t)measurement_time + 1);
-        OS_DELAY_MS(measurement_delay);
+        HOTPATH_TRACE_TICKS_START(delay_start);
+        hs300x_platform_delay_ms(hs300x_get_measurement_delay_ms(hs300x_handle));
+        HOTPATH_TRACE_TICKS_STOP(HOTPATH_SITE_MEASUREMENT_DELAY, delay_start);
 
-        uint8_t response[HS300x_MEASUREMENT_LENGTH_HUMIDITY_AND_TEMP] = {0};
-        // TODO handle 8 bit temperature (e.g. len == 3)
-        uint8_t len = data_includes_temp ? HS300x_MEASUREMENT_LENGTH_HUMIDITY_AND_TEMP : HS300x_MEASUREMENT_LENGTH_HUMIDITY_ONLY;
-        error = hs300x_read(hs300x_handle, response, len);
+        error = hs300x_fetch_measurement(hs300x_handle, data_includes_temp, calculated_data);
+    }
 
-        if(error == HS300x_ERROR_NONE)
-        {
-            convert_raw_to_humid_temp(response, data_includes_temp, calculated_data);
-        }
+    return error;
+}
+
+/**
+ * \brief Get the typical time a conversion takes at the resolutions of the handle, without margin. A
+ * measurement read this soon after it was started may still be stale and has to be read again.
+ *
+ * \param[in] hs300x_handle             handle of the HS300x
+ *
+ * \return typical conversion time in microseconds, rounded up
+ *
+ */
+uint32_t hs300x_get_conversion_time_us(const hs300x_handle_t* hs300x_handle)
+{
+    float measurement_time = calc_measurement_time(hs300x_handle->humidity_res, hs300x_handle->temp_res);
+
+    return (uint32_t)(measurement_time * 1000) + 1;
+}
+
+/**
+ * \brief Get the time a measurement takes at the resolutions of the handle, rounded up and with some
+ * additional margin to account for the worst case measurement time
+ *
+ * \param[in] hs300x_handle             handle of the HS300x
+ *
+ * \return time from hs300x_start_measurement() to hs300x_fetch_measurement() in milliseconds
+ *
+ */
+uint32_t hs300x_get_measurement_delay_ms(const hs300x_handle_t* hs300x_handle)
+{
+    float measurement_time = calc_measurement_time(hs300x_handle->humidity_res, hs300x_handle->temp_res);
+
+    return HS300x_MEASUREMENT_TIME_MARGIN_ms + ((uint32_t)measurement_time + 1);
+}
+
+/**
+ * \brief Get a measurement as conversion codes. Same as hs300x_get_measurement(), without the conversion.
+ *
+ * \param[in] hs300x_handle             handle of the HS300x
+ * \param[in] data_includes_temp        a boolean value indicating if the measurement should include temperature data
+ * \param[out] raw                      a pointer to a buffer where the codes will be placed
+ *
+ * \return error indicating status of the operation
+ *
+ */
+hs300x_error_t hs300x_get_measurement_raw(hs300x_handle_t* hs300x_handle, bool data_includes_temp, hs300x_raw_t *raw)
+{
+    hs300x_error_t error = hs300x_start_measurement(hs300x_handle);
+    if(error == HS300x_ERROR_NONE)
+    {
+        HOTPATH_TRACE_TICKS_START(delay_start);
+        hs300x_platform_delay_ms(hs300x_get_measurement_delay_ms(hs300x_handle));
+        HOTPATH_TRACE_TICKS_STOP(HOTPATH_SITE_MEASUREMENT_DELAY, delay_start);
+
+        error = hs300x_fetch_measurement_raw(hs300x_handle, data_includes_temp, raw);
     }
 
     return error;
@@ -166,7 +420,7 @@ hs300x_error_t hs300x_get_resolution(hs300x_handle_t* hs300x_handle, hs300x_reso
     const uint8_t *cmd = type == HS300x_RESOLUTION_TYPE_HUMIDITY ? read_humidity_resolution_cmd : read_temp_resolution_cmd;
     hs300x_error_t error = hs300x_write(hs300x_handle, cmd, sizeof(read_humidity_resolution_cmd));
     // cmd takes 120us to process
-    hw_clk_delay_usec(HS300x_DELAY_120_us);
+    hs300x_platform_delay_us(HS300x_DELAY_120_us);
 
     if(error == HS300x_ERROR_NONE)
     {
@@ -203,7 +457,7 @@ hs300x_error_t hs300x_get_sensor_id(hs300x_handle_t *hs300x_handle, uint32_t* id
 {
    hs300x_error_t error = hs300x_write(hs300x_handle, read_sensor_id_upper_cmd, sizeof(read_sensor_id_upper_cmd));
    // cmd takes 120us to process
-   hw_clk_delay_usec(HS300x_DELAY_120_us);
+   hs300x_platform_delay_us(HS300x_DELAY_120_us);
 
    if(error == HS300x_ERROR_NONE)
    {
@@ -214,7 +468,7 @@ hs300x_error_t hs300x_get_sensor_id(hs300x_handle_t *hs300x_handle, uint32_t* id
         {
             error = hs300x_write(hs300x_handle, read_sensor_id_lower_cmd, sizeof(read_sensor_id_lower_cmd));
             // cmd takes 120us to process. See section 6.8
-            hw_clk_delay_usec(HS300x_DELAY_120_us);
+            hs300x_platform_delay_us(HS300x_DELAY_120_us);
 
             if(error == HS300x_ERROR_NONE)
             {
@@ -252,12 +506,30 @@ hs300x_error_t hs300x_get_sensor_id(hs300x_handle_t *hs300x_handle, uint32_t* id
  */
 ad_i2c_handle_t hs300x_open(const ad_i2c_controller_conf_t *i2c_conf)
 {
-    ad_i2c_handle_t sensor_i2c_handle = ad_i2c_open(i2c_conf);
+    ad_i2c_handle_t sensor_i2c_handle = hs300x_platform_i2c_open(i2c_conf);
     ASSERT_ERROR(sensor_i2c_handle);
 
     return sensor_i2c_handle;
 }
 
+/**
+ * \brief Extract the conversion codes from a raw measurement, dropping the status bits. See datasheet Section 7.
+ *
+ * \param[in] raw_data              raw measurement as read from the HS300x
+ * \param[in] data_includes_temp    a boolean value indicating if the measurement includes temperature data.
+ *                                  If not, the temperature code is set to 0.
+ * \param[out] raw                  a pointer to a buffer where the codes will be placed
+ *
+ * \return void
+ *
+ */
+void hs300x_parse_raw(const uint8_t *raw_data, bool data_includes_temp, hs300x_raw_t *raw)
+{
+    raw->humidity = ((raw_data[0] & HS300x_MASK_HUMIDITY_UPPER_0X3F) << 8) | raw_data[1];
+    raw->temp = data_includes_temp ?
+                (((raw_data[2] << 8) | (raw_data[3] & HS300x_MASK_TEMPERATURE_LOWER_0XFC)) >> 2) : 0;
+}
+
 /**
  * \brief Power cycle the HS300x
  *
@@ -272,20 +544,15 @@ ad_i2c_handle_t hs300x_open(const ad_i2c_controller_conf_t *i2c_conf)
  */
 void hs300x_power_cycle_sensor(gpio_config power_enable)
 {
-	// Get the port,pin for the power_enable pin
-    HW_GPIO_PORT port;
-    HW_GPIO_PIN pin;
-    gpio_config_to_port_and_pin(power_enable, &port, &pin);
-
-    hw_gpio_set_inactive(port, pin);
+    hs300x_platform_power_set(power_enable, false);
 
     // give sensor some time to power off
-    OS_DELAY_MS(HS300x_POWER_UP_DOWN_TIME_MARGIN_ms);
+    hs300x_platform_delay_ms(HS300x_POWER_UP_DOWN_TIME_MARGIN_ms);
 
-    hw_gpio_set_active(port, pin);
+    hs300x_platform_power_set(power_enable, true);
 
     // give sensor some time to power on
-    OS_DELAY_MS(HS300x_POWER_UP_DOWN_TIME_MARGIN_ms);
+    hs300x_platform_delay_ms(HS300x_POWER_UP_DOWN_TIME_MARGIN_ms);
 }
 
 
@@ -301,7 +568,11 @@ void hs300x_power_cycle_sensor(gpio_config power_enable)
  */
 hs300x_error_t hs300x_read(hs300x_handle_t* hs300x_handle, uint8_t *response_buffer, size_t response_length)
 {
-    return ad_i2c_read(hs300x_handle->i2c_handle, response_buffer, response_length, HW_I2C_F_ADD_STOP);
+    HOTPATH_TRACE_START(start);
+    hs300x_error_t error = hs300x_platform_i2c_read(hs300x_handle->i2c_handle, response_buffer, response_length);
+    HOTPATH_TRACE_STOP(HOTPATH_SITE_I2C_READ, start);
+
+    return error;
 }
 
 /* \brief Convenience function to convert hs300x_resolution_t to a string
@@ -320,7 +591,7 @@ hs300x_error_t hs300x_set_resolution(hs300x_handle_t* hs300x_handle, hs300x_reso
 
     hs300x_error_t error = hs300x_write(hs300x_handle, cmd, sizeof(read_humidity_resolution_cmd));
     // command takes 120us to process
-    hw_clk_delay_usec(HS300x_DELAY_120_us);
+    hs300x_platform_delay_us(HS300x_DELAY_120_us);
 
     if(error == HS300x_ERROR_NONE)
     {
@@ -339,7 +610,7 @@ hs300x_error_t hs300x_set_resolution(hs300x_handle_t* hs300x_handle, hs300x_reso
                 uint8_t new_resolution_cmd[] = {res_type, response[1] , response[2]};
                 error = hs300x_write(hs300x_handle, new_resolution_cmd, sizeof(new_resolution_cmd));
                 // update takes 14ms, see datasheet section 6.9
-                OS_DELAY_MS(HS300x_DELAY_14_ms);
+                hs300x_platform_delay_ms(HS300x_DELAY_14_ms);
 
                 if(error == HS300x_ERROR_NONE)
                 {
@@ -384,7 +655,11 @@ hs300x_error_t hs300x_start_measurement(hs300x_handle_t* hs300x_handle)
  */
 hs300x_error_t hs300x_write(hs300x_handle_t* hs300x_handle, const uint8_t *write_buffer, size_t write_length)
 {
-    return ad_i2c_write(hs300x_handle->i2c_handle, write_buffer, write_length, HW_I2C_F_ADD_STOP);
+    HOTPATH_TRACE_START(start);
+    hs300x_error_t error = hs300x_platform_i2c_write(hs300x_handle->i2c_handle, write_buffer, write_length);
+    HOTPATH_TRACE_STOP(HOTPATH_SITE_I2C_WRITE, start);
+
+    return error;
 }
 
 /**
@@ -435,7 +710,7 @@ static hs300x_error_t send_programming_mode_enter(hs300x_handle_t* hs300x_handle
 {
     hs300x_error_t error = hs300x_write(hs300x_handle, enter_programming_mode_cmd, sizeof(enter_programming_mode_cmd));
     // cmd takes 120us to process. See section 6.8
-    hw_clk_delay_usec(HS300x_DELAY_120_us);
+    hs300x_platform_delay_us(HS300x_DELAY_120_us);
 
     return error;
 }
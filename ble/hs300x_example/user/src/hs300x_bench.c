@@ -0,0 +1,438 @@
+/*
+ * hs300x_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "osal.h"
+
+#include "cycle_counter.h"
+#include "distribution.h"
+#include "ess_service.h"
+#include "hs300x.h"
+#include "hs300x_bench.h"
+#include "hs300x_task.h"
+#include "psychro.h"
+#include "sensor_service.h"
+
+#define BENCH_ITERATIONS                (256)
+#define BENCH_QUEUE_LEN                 (5)
+
+/* Raw measurements fed to the benchmarks, so the results do not depend on a single value */
+#define BENCH_RAW_SAMPLES               (4)
+
+/* Conversion codes converted per iteration of the batch benchmark, as in one L2CAP history packet */
+#define BENCH_BATCH_LENGTH              (16)
+
+/* Block size and repetitions of the fixed point batch check and throughput measurement */
+#define BENCH_FIXED_BLOCK_LENGTH        (256)
+#define BENCH_FIXED_RATE_BLOCKS         (256)
+
+typedef void (* bench_fn_t) (uint32_t iteration);
+
+typedef struct
+{
+    const char *name;
+    bench_fn_t fn;
+    uint32_t limit;             /**< Maximum mean per iteration, see CYCLE_COUNTER_LIMIT() */
+    bool needs_sensor_svc;
+    bool needs_ess_svc;
+} bench_case_t;
+
+/* Private function prototypes */
+static void bench_convert(uint32_t iteration);
+static void bench_convert_batch(uint32_t iteration);
+static void bench_convert_fixed_batch(uint32_t iteration);
+static void bench_distribution_put(uint32_t iteration);
+static void bench_ess_encode(uint32_t iteration);
+static void bench_fan_out(uint32_t iteration);
+static void bench_format(uint32_t iteration);
+static void bench_psychro(uint32_t iteration);
+static void bench_queue_hand_off(uint32_t iteration);
+static bool check_fixed_batch(void);
+static void measure_fixed_batch_rate(void);
+static uint32_t measure_overhead(void);
+static bool run_case(const bench_case_t *bench, uint32_t overhead);
+
+/* Private variables */
+static const uint8_t raw_samples[BENCH_RAW_SAMPLES][4] = {
+    { 0x19, 0x99, 0x64, 0xD8 },         // 40.0 %RH, 25.0 C
+    { 0x26, 0x66, 0x79, 0x04 },         // 60.0 %RH, 38.0 C
+    { 0x06, 0x66, 0x28, 0x58 },         // 10.0 %RH, -14.0 C
+    { 0x3F, 0xFF, 0xFF, 0xFC },         // 100.0 %RH, 125.0 C
+};
+
+__RETAINED static hs300x_raw_t batch_raw[BENCH_BATCH_LENGTH];
+__RETAINED static hs300x_data_t batch_data[BENCH_BATCH_LENGTH];
+__RETAINED static hs300x_fixed_t batch_fixed[BENCH_BATCH_LENGTH];
+__RETAINED static hs300x_raw_t fixed_block_raw[BENCH_FIXED_BLOCK_LENGTH];
+__RETAINED static hs300x_fixed_t fixed_block[BENCH_FIXED_BLOCK_LENGTH];
+__RETAINED static OS_QUEUE bench_q;
+__RETAINED static ble_service_t *bench_sensor_svc;
+__RETAINED static ble_service_t *bench_ess_svc;
+
+/* Results are written here so the compiler cannot drop the work being measured */
+static volatile uint32_t bench_sink;
+
+static const bench_case_t bench_cases[] = {
+    { "convert_raw_to_humid_temp",      bench_convert,          CYCLE_COUNTER_LIMIT(400, 200),      false, false },
+    { "convert_raw_batch_16",           bench_convert_batch,    CYCLE_COUNTER_LIMIT(1600, 400),     false, false },
+    { "convert_raw_fixed_batch_16",     bench_convert_fixed_batch, CYCLE_COUNTER_LIMIT(400, 400),   false, false },
+    { "distribution_put",               bench_distribution_put, CYCLE_COUNTER_LIMIT(3000, 500),     false, false },
+    { "psychro_compute",                bench_psychro,          CYCLE_COUNTER_LIMIT(2000, 500),     false, false },
+    { "format_sample",                  bench_format,           CYCLE_COUNTER_LIMIT(30000, 3000),   false, false },
+    { "sample_q_hand_off",              bench_queue_hand_off,   CYCLE_COUNTER_LIMIT(3000, 500),     false, false },
+    { "notify_all_connected",           bench_fan_out,          CYCLE_COUNTER_LIMIT(8000, 3000),    true,  false },
+    { "ess_encode",                     bench_ess_encode,       CYCLE_COUNTER_LIMIT(6000, 3000),    false, true  },
+};
+
+/**
+ * \brief Convert a raw measurement to humidity and temperature
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_convert(uint32_t iteration)
+{
+    hs300x_data_t data;
+
+    hs300x_convert_raw_to_humid_temp(raw_samples[iteration % BENCH_RAW_SAMPLES], true, &data);
+    bench_sink = (uint32_t)data.humidity_rh_pct;
+}
+
+/**
+ * \brief Convert BENCH_BATCH_LENGTH conversion codes at once, as a dump of the sample history is
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_convert_batch(uint32_t iteration)
+{
+    hs300x_convert_raw_batch(batch_raw, batch_data, BENCH_BATCH_LENGTH);
+    bench_sink = (uint32_t)batch_data[iteration % BENCH_BATCH_LENGTH].humidity_rh_pct;
+}
+
+/**
+ * \brief Convert BENCH_BATCH_LENGTH conversion codes to hundredths at once
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_convert_fixed_batch(uint32_t iteration)
+{
+    hs300x_convert_raw_fixed_batch(batch_raw, batch_fixed, BENCH_BATCH_LENGTH);
+    bench_sink = batch_fixed[iteration % BENCH_BATCH_LENGTH].humidity_x100;
+}
+
+/**
+ * \brief Add a measurement to the long term distribution
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_distribution_put(uint32_t iteration)
+{
+    distribution_put(&batch_raw[iteration % BENCH_BATCH_LENGTH]);
+}
+
+/**
+ * \brief Encode a measurement into the ESS characteristics and evaluate their triggers
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_ess_encode(uint32_t iteration)
+{
+    hs300x_data_t data;
+
+    hs300x_convert_raw_to_humid_temp(raw_samples[iteration % BENCH_RAW_SAMPLES], true, &data);
+    ess_service_update(bench_ess_svc, &data);
+}
+
+/**
+ * \brief Notify a measurement to all connected clients
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_fan_out(uint32_t iteration)
+{
+    hs300x_data_t data;
+
+    hs300x_convert_raw_to_humid_temp(raw_samples[iteration % BENCH_RAW_SAMPLES], true, &data);
+    sensor_service_notify_measurement_to_all_connected(bench_sensor_svc, &data);
+}
+
+/**
+ * \brief Format a measurement for the console, as hs300x_task_print_samples() does
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_format(uint32_t iteration)
+{
+    hs300x_data_t data;
+    char line[HS300x_TASK_SAMPLE_LINE_LEN];
+
+    hs300x_convert_raw_to_humid_temp(raw_samples[iteration % BENCH_RAW_SAMPLES], true, &data);
+    bench_sink = hs300x_task_format_sample(line, sizeof(line), HS300x_TASK_DEFAULT_SAMPLE_RATE_ms, &data);
+}
+
+/**
+ * \brief Compute the dew point, absolute humidity and heat index of a measurement
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_psychro(uint32_t iteration)
+{
+    hs300x_fixed_t fixed;
+    psychro_t derived;
+
+    hs300x_convert_raw_fixed(&batch_raw[iteration % BENCH_BATCH_LENGTH], &fixed);
+    psychro_compute(&fixed, &derived);
+    bench_sink = derived.dew_point_x100 + derived.abs_humidity_x100 + derived.heat_index_x100;
+}
+
+/**
+ * \brief Pass a sample through a queue, as the sampling task hands it to the BLE task
+ *
+ * \param[in] iteration         iteration number
+ *
+ * \return void
+ */
+static void bench_queue_hand_off(uint32_t iteration)
+{
+    hs300x_sample_t sample = { .seq = iteration };
+
+    OS_QUEUE_PUT(bench_q, &sample, OS_QUEUE_NO_WAIT);
+    OS_QUEUE_GET(bench_q, &sample, OS_QUEUE_NO_WAIT);
+    bench_sink = sample.seq;
+}
+
+/**
+ * \brief Check hs300x_convert_raw_fixed_batch() against hs300x_convert_raw_fixed() for every conversion code,
+ * and hs300x_convert_raw_fixed() against hs300x_convert_raw(). Prints one line:
+ * BENCH_CHECK,<name>,<kernel>,<codes>,<mismatches>,<max error>,<PASS|FAIL>, the error in hundredths.
+ *
+ * \return true if the batch matches bit for bit and the error is at most one hundredth
+ */
+static bool check_fixed_batch(void)
+{
+    uint32_t mismatches = 0;
+    uint32_t max_error = 0;
+
+    for(uint32_t base = 0; base <= HS300x_CALC_14BIT_MAX; base += BENCH_FIXED_BLOCK_LENGTH)
+    {
+        for(uint32_t i = 0; i < BENCH_FIXED_BLOCK_LENGTH; i++)
+        {
+            fixed_block_raw[i].humidity = base + i;
+            fixed_block_raw[i].temp = HS300x_CALC_14BIT_MAX - (base + i);
+        }
+
+        hs300x_convert_raw_fixed_batch(fixed_block_raw, fixed_block, BENCH_FIXED_BLOCK_LENGTH);
+
+        for(uint32_t i = 0; i < BENCH_FIXED_BLOCK_LENGTH; i++)
+        {
+            hs300x_fixed_t reference;
+            hs300x_data_t data;
+
+            hs300x_convert_raw_fixed(&fixed_block_raw[i], &reference);
+            if(memcmp(&reference, &fixed_block[i], sizeof(reference)) != 0)
+            {
+                mismatches++;
+            }
+
+            hs300x_convert_raw(&fixed_block_raw[i], &data);
+            int32_t humidity_error = reference.humidity_x100 - (int32_t)(data.humidity_rh_pct * 100.0f + 0.5f);
+            int32_t temp_error = reference.temp_x100 - (int32_t)(data.temp_deg_c * 100.0f + (data.temp_deg_c < 0 ? -0.5f : 0.5f));
+            uint32_t error = (uint32_t)abs(humidity_error) > (uint32_t)abs(temp_error) ?
+                             (uint32_t)abs(humidity_error) : (uint32_t)abs(temp_error);
+            if(error > max_error)
+            {
+                max_error = error;
+            }
+        }
+    }
+
+    bool pass = mismatches == 0 && max_error <= 1;
+    printf("BENCH_CHECK,convert_raw_fixed_batch,%s,%u,%lu,%lu,%s\r\n", HS300x_CONVERT_DSP ? "dsp" : "scalar",
+           HS300x_CALC_14BIT_MAX + 1, (unsigned long)mismatches, (unsigned long)max_error, pass ? "PASS" : "FAIL");
+
+    return pass;
+}
+
+/**
+ * \brief Measure the throughput of hs300x_convert_raw_fixed_batch() on blocks of BENCH_FIXED_BLOCK_LENGTH
+ * codes. Prints one line: BENCH_RATE,<name>,<samples>,<us>,<samples per us>.
+ *
+ * \return void
+ */
+static void measure_fixed_batch_rate(void)
+{
+    uint32_t samples = BENCH_FIXED_BLOCK_LENGTH * BENCH_FIXED_RATE_BLOCKS;
+
+    uint32_t start = cycle_counter_read();
+    for(uint32_t i = 0; i < BENCH_FIXED_RATE_BLOCKS; i++)
+    {
+        hs300x_convert_raw_fixed_batch(fixed_block_raw, fixed_block, BENCH_FIXED_BLOCK_LENGTH);
+    }
+    uint32_t us = cycle_counter_to_us(cycle_counter_read() - start);
+    bench_sink = fixed_block[0].humidity_x100;
+
+    // Two decimals, the host converts hundreds of samples per microsecond and the target a few
+    uint32_t rate_x100 = us ? (uint32_t)((uint64_t)samples * 100 / us) : 0;
+    printf("BENCH_RATE,convert_raw_fixed_batch,%lu,%lu,%lu.%02lu\r\n", (unsigned long)samples,
+           (unsigned long)us, (unsigned long)(rate_x100 / 100), (unsigned long)(rate_x100 % 100));
+}
+
+/**
+ * \brief Measure the cost of two back to back counter reads
+ *
+ * \return smallest difference seen
+ */
+static uint32_t measure_overhead(void)
+{
+    uint32_t overhead = UINT32_MAX;
+
+    for(uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        uint32_t start = cycle_counter_read();
+        uint32_t elapsed = cycle_counter_read() - start;
+
+        if(elapsed < overhead)
+        {
+            overhead = elapsed;
+        }
+    }
+
+    return overhead;
+}
+
+/**
+ * \brief Run one benchmark and print its result line
+ *
+ * \param[in] bench             benchmark to run
+ * \param[in] overhead          cost of reading the counter, removed from every iteration
+ *
+ * \return true if the mean is within the limit of the benchmark
+ */
+static bool run_case(const bench_case_t *bench, uint32_t overhead)
+{
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint64_t total = 0;
+
+    for(uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        uint32_t start = cycle_counter_read();
+        bench->fn(i);
+        uint32_t elapsed = cycle_counter_read() - start;
+
+        elapsed = elapsed > overhead ? elapsed - overhead : 0;
+        total += elapsed;
+        if(elapsed < min)
+        {
+            min = elapsed;
+        }
+        if(elapsed > max)
+        {
+            max = elapsed;
+        }
+    }
+
+    uint32_t mean = (uint32_t)(total / BENCH_ITERATIONS);
+    bool pass = mean <= bench->limit;
+
+    printf("BENCH,%s,%lu,%lu,%lu,%lu,%lu,%s,%s\r\n", bench->name, (unsigned long)BENCH_ITERATIONS,
+           (unsigned long)min, (unsigned long)mean, (unsigned long)max, (unsigned long)bench->limit,
+           CYCLE_COUNTER_UNIT, pass ? "PASS" : "FAIL");
+
+    return pass;
+}
+
+/**
+ * \brief Run the benchmarks of the sample hot path and print the results
+ *
+ * \param[in] sensor_svc        custom sensor service used for the fan-out benchmark, or NULL to skip it
+ * \param[in] ess_svc           environmental sensing service used for the encoding benchmark, or NULL to skip it
+ *
+ * \return number of benchmarks exceeding their limit
+ */
+uint32_t hs300x_bench_run(ble_service_t *sensor_svc, ble_service_t *ess_svc)
+{
+    uint32_t passed = 0;
+    uint32_t failed = 0;
+
+    bench_sensor_svc = sensor_svc;
+    bench_ess_svc = ess_svc;
+    if(ess_svc)
+    {
+        ess_service_save_state(ess_svc);
+    }
+    if(bench_q == NULL)
+    {
+        OS_QUEUE_CREATE(bench_q, sizeof(hs300x_sample_t), BENCH_QUEUE_LEN);
+        OS_ASSERT(bench_q);
+    }
+    for(uint32_t i = 0; i < BENCH_BATCH_LENGTH; i++)
+    {
+        hs300x_parse_raw(raw_samples[i % BENCH_RAW_SAMPLES], true, &batch_raw[i]);
+    }
+
+    cycle_counter_init();
+    uint32_t overhead = measure_overhead();
+
+    printf("BENCH,name,iterations,min,mean,max,limit,unit,result\r\n");
+
+    for(uint32_t i = 0; i < ARRAY_LENGTH(bench_cases); i++)
+    {
+        const bench_case_t *bench = &bench_cases[i];
+
+        if((bench->needs_sensor_svc && !sensor_svc) || (bench->needs_ess_svc && !ess_svc))
+        {
+            continue;
+        }
+
+        if(run_case(bench, overhead))
+        {
+            passed++;
+        }
+        else
+        {
+            failed++;
+        }
+    }
+
+    if(check_fixed_batch())
+    {
+        passed++;
+    }
+    else
+    {
+        failed++;
+    }
+    measure_fixed_batch_rate();
+
+    // The distribution and ESS benchmarks fed them made up samples
+    distribution_reset();
+    if(ess_svc)
+    {
+        ess_service_restore_state(ess_svc);
+    }
+
+    printf("BENCH_SUMMARY,%lu,%lu\r\n", (unsigned long)passed, (unsigned long)failed);
+
+    return failed;
+}
@@ -0,0 +1,173 @@
+/*
+ * hs300x_platform.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include "osal.h"
+#include "hw_clk.h"
+#include "hw_gpio.h"
+#include "hw_sys.h"
+#include "ad_i2c.h"
+#include "sys_timer.h"
+
+#include "hs300x_platform.h"
+
+/* Private function prototypes */
+static void gpio_config_to_port_and_pin(gpio_config config, HW_GPIO_PORT *port, HW_GPIO_PIN *pin);
+
+/**
+ * \brief Extract the port/pin from a gpio_config
+ *
+ * \param[in] config        gpio_config to extract information from
+ * \param[out] port         pointer where port information will be placed
+ * \param[out] pin          pointer where pin information will be placed
+ *
+ * \return void
+ */
+static void gpio_config_to_port_and_pin(gpio_config config, HW_GPIO_PORT *port, HW_GPIO_PIN *pin)
+{
+    *port = (config.pin & 0x3F) >> HW_GPIO_PIN_BITS;
+    *pin = (config.pin) & ((1 << HW_GPIO_PIN_BITS) - 1);
+}
+
+/**
+ * \brief Open the I2C controller of the HS300x
+ *
+ * \param[in] i2c_conf          pointer to the configuration of the I2C controller to open
+ *
+ * \return >0: non-NULL handle that should be used in subsequent API calls, NULL: error
+ *
+ * \sa ad_i2c_open()
+ */
+ad_i2c_handle_t hs300x_platform_i2c_open(const ad_i2c_controller_conf_t *i2c_conf)
+{
+    return ad_i2c_open(i2c_conf);
+}
+
+/**
+ * \brief Close the I2C controller of the HS300x
+ *
+ * \param[in] i2c_handle        I2C handle of the controller to close
+ *
+ * \return 0 on success, I2C adapter error code otherwise
+ *
+ * \sa ad_i2c_close()
+ */
+int hs300x_platform_i2c_close(ad_i2c_handle_t i2c_handle)
+{
+    return ad_i2c_close(i2c_handle, true);
+}
+
+/**
+ * \brief Read from the HS300x, ending the transfer with a STOP condition
+ *
+ * \param[in] i2c_handle        I2C handle of the HS300x
+ * \param[out] buffer           buffer where the data will be placed
+ * \param[in] length            number of bytes to read
+ *
+ * \return 0 on success, I2C adapter error code otherwise
+ */
+int hs300x_platform_i2c_read(ad_i2c_handle_t i2c_handle, uint8_t *buffer, size_t length)
+{
+    return ad_i2c_read(i2c_handle, buffer, length, HW_I2C_F_ADD_STOP);
+}
+
+/**
+ * \brief Write to the HS300x, ending the transfer with a STOP condition
+ *
+ * \param[in] i2c_handle        I2C handle of the HS300x
+ * \param[in] buffer            data to write
+ * \param[in] length            number of bytes to write
+ *
+ * \return 0 on success, I2C adapter error code otherwise
+ */
+int hs300x_platform_i2c_write(ad_i2c_handle_t i2c_handle, const uint8_t *buffer, size_t length)
+{
+    return ad_i2c_write(i2c_handle, buffer, length, HW_I2C_F_ADD_STOP);
+}
+
+/**
+ * \brief Block the calling task for a number of milliseconds. Other tasks run in the meantime.
+ *
+ * \param[in] ms                delay in milliseconds
+ *
+ * \return void
+ */
+void hs300x_platform_delay_ms(uint32_t ms)
+{
+    OS_DELAY_MS(ms);
+}
+
+/**
+ * \brief Busy wait for a number of microseconds
+ *
+ * \param[in] us                delay in microseconds
+ *
+ * \return void
+ */
+void hs300x_platform_delay_us(uint32_t us)
+{
+    hw_clk_delay_usec(us);
+}
+
+/**
+ * \brief Switch the supply of the HS300x
+ *
+ * \param[in] power_enable      GPIO config for the pin used to power the HS300x
+ * \param[in] on                true to power the sensor, false to remove power
+ *
+ * \return void
+ */
+void hs300x_platform_power_set(gpio_config power_enable, bool on)
+{
+    HW_GPIO_PORT port;
+    HW_GPIO_PIN pin;
+    gpio_config_to_port_and_pin(power_enable, &port, &pin);
+
+    if(on)
+    {
+        hw_gpio_set_active(port, pin);
+    }
+    else
+    {
+        hw_gpio_set_inactive(port, pin);
+    }
+}
+
+/**
+ * \brief Configure the I2C pins and the GPIO powering the HS300x
+ *
+ * \param[in] i2c_conf          configuration of the I2C controller of the HS300x
+ * \param[in] power_enable      GPIO config for the pin used to power the HS300x
+ *
+ * \return void
+ */
+void hs300x_platform_setup_hardware(const ad_i2c_controller_conf_t *i2c_conf, gpio_config *power_enable)
+{
+    HW_GPIO_PORT port;
+    HW_GPIO_PIN pin;
+    gpio_config_to_port_and_pin(power_enable[0], &port, &pin);
+
+    hw_sys_pd_com_enable();
+
+    ad_i2c_io_config(i2c_conf->id, i2c_conf->io, AD_IO_CONF_ON);
+
+    hw_gpio_configure_pin_power(port, pin, HW_GPIO_POWER_V33);
+    hw_gpio_configure(power_enable);
+    hw_gpio_pad_latch_enable(port, pin);
+
+    hw_sys_pd_com_disable();
+}
+
+/**
+ * \brief Get a free running time stamp, for timing conversions
+ *
+ * \return time since boot in microseconds, wrapping at 32 bits. The resolution is that of the low power
+ * clock, about 31 us with the 32.768 kHz crystal.
+ *
+ * \sa sys_timer_get_uptime_usec()
+ */
+uint32_t hs300x_platform_time_us(void)
+{
+    return (uint32_t)sys_timer_get_uptime_usec();
+}
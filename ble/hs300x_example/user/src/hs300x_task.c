@@ -9,29 +9,49 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "osal.h"
-#include "resmgmt.h"
-#include "hw_gpio.h"
-#include "sys_clock_mgr.h"
-#include "sys_power_mgr.h"
 
 #include "hs300x_task.h"
-#include <ad_i2c.h>
 #include "hs300x.h"
+#include "burst_capture.h"
+#include "calibration.h"
+#include "diag_counters.h"
+#include "hotpath_trace.h"
+#include "hs300x_platform.h"
 #include "platform_devices.h"
+#include "sample_bus.h"
+#include "sample_history.h"
+#include "sample_stream.h"
+#include "static_alloc.h"
+#include "time_sync.h"
+
+/* State of the sampling engine when it runs in the BLE task, see hs300x_task_engine_run() */
+typedef enum
+{
+    ENGINE_STATE_TRIGGER,       /**< Start a measurement at the deadline */
+    ENGINE_STATE_READ,          /**< Read the measurement at the deadline */
+} engine_state_t;
 
 /* Private function prototypes */
 static void hs300x_handle_init();
 static const char * hs300x_resolution_to_string(hs300x_resolution_t res);
-static hs300x_error_t perform_measurement(hs300x_data_t *sample);
-static void process_measurement(hs300x_data_t sample);
+static hs300x_error_t perform_measurement(hs300x_raw_t *raw);
+static void process_measurement(hs300x_raw_t raw, hs300x_sample_t *sample);
+static void report_measurement_error(hs300x_error_t error);
+static uint32_t sample_period_ms(void);
 
 /* Private variables */
 __RETAINED_RW static hs300x_handle_t hs300x_handle = {0};
 __RETAINED_RW static uint32_t sensor_id = 0xFFFFFFFF;
-__RETAINED_RW static uint32_t sample_rate_ms = 1000;
+__RETAINED_RW static uint32_t sample_rate_ms = HS300x_TASK_DEFAULT_SAMPLE_RATE_ms;
+__RETAINED_RW static uint32_t next_sample_seq = 1;
 __RETAINED_RW static OS_MUTEX sample_rate_mutex = NULL;
+__RETAINED static static_mutex_t sample_rate_mutex_storage;
 __RETAINED_RW static OS_QUEUE sample_q = NULL;
 __RETAINED_RW static OS_TASK measurement_notification_task = NULL;
+__RETAINED static sample_bus_consumer_t console_consumer;
+__RETAINED_RW static engine_state_t engine_state = ENGINE_STATE_TRIGGER;
+__RETAINED static OS_TICK_TIME engine_deadline;
+__RETAINED static OS_TICK_TIME engine_trigger_time;
 
 // See hs300x_resolution_t for resolution options
 hs300x_resolution_t user_humidity_resolution = HS300x_RESOLUTION_14_BITS;
@@ -73,11 +93,8 @@ static const char * hs300x_resolution_to_string(hs300x_resolution_t res)
 }
 
 /**
- * \brief HS300x sampling task. This task will read the sensor ID, set the measurement
- * resolution for both humidity and temperature to the user defined values set in
- * user_humidity_resolution and user_temperature_resolution respectively. Then a
- * measurement will be taken at a rate of sample_rate_ms. The results will be printed to the terminal
- * and put on queue
+ * \brief HS300x sampling task. Initializes the sensor with hs300x_task_init(), then takes a measurement
+ * with hs300x_task_sample() at a rate of sample_rate_ms.
  *
  * \param[in] pvParameters      Used to pass in a queue for measurements from the sensor
  *
@@ -85,10 +102,146 @@ static const char * hs300x_resolution_to_string(hs300x_resolution_t res)
  */
 void hs300x_task(void *pvParameters)
 {
-    sample_q = (OS_QUEUE)pvParameters;
+    hs300x_task_init((OS_QUEUE)pvParameters);
+    burst_capture_register_task(OS_GET_CURRENT_TASK(), BURST_CAPTURE_MAX_SAMPLES);
+
+    for(;;)
+    {
+        uint32_t notif;
+
+        // A requested burst runs between two periodic measurements
+        burst_capture_run(&hs300x_handle);
+
+        hs300x_task_sample();
+        hs300x_task_print_samples();
+
+#if APP_HOTPATH_TRACE && HOTPATH_TRACE_DUMP_INTERVAL
+        if(next_sample_seq % HOTPATH_TRACE_DUMP_INTERVAL == 0)
+        {
+            hotpath_trace_dump();
+        }
+#endif
+
+        // Delay for sample_rate_ms, or until a burst is requested
+        OS_TASK_NOTIFY_WAIT(0, OS_TASK_NOTIFY_ALL_BITS, &notif, OS_MS_2_TICKS(sample_period_ms()));
+    }
+}
+
+/**
+ * \brief Run the sampling engine from the event loop of another task, instead of in hs300x_task().
+ * Each sample takes two steps, each run when its deadline has passed: start a measurement, then read it
+ * once the conversion is done and publish it. Nothing blocks, so the calling task can handle other events
+ * while the sensor converts.
+ *
+ * \param[out] sample          the new sample, valid when true is returned
+ *
+ * \return true if a sample was taken. It is in the sample history but, unlike with hs300x_task_sample(),
+ * not on the queue: the caller publishes it.
+ */
+bool hs300x_task_engine_run(hs300x_sample_t *sample)
+{
+    OS_TICK_TIME now = OS_GET_TICK_COUNT();
+    hs300x_error_t error;
+
+    // A requested burst runs between two periodic measurements, then sampling starts over
+    if(engine_state == ENGINE_STATE_TRIGGER && burst_capture_run(&hs300x_handle))
+    {
+        engine_deadline = OS_GET_TICK_COUNT();
+        return false;
+    }
+
+    if((int32_t)(engine_deadline - now) > 0)
+    {
+        return false;
+    }
+
+    if(engine_state == ENGINE_STATE_TRIGGER)
+    {
+        engine_trigger_time = now;
+        error = hs300x_start_measurement(&hs300x_handle);
+        if(error == HS300x_ERROR_NONE)
+        {
+            // One extra tick, the conversion must not be read early because the delay rounded down
+            engine_state = ENGINE_STATE_READ;
+            engine_deadline = now + OS_MS_2_TICKS(hs300x_get_measurement_delay_ms(&hs300x_handle)) + 1;
+            return false;
+        }
+    }
+    else
+    {
+        hs300x_raw_t raw = {0};
+
+        error = hs300x_fetch_measurement_raw(&hs300x_handle, true, &raw);
+        if(error == HS300x_ERROR_NONE)
+        {
+            process_measurement(raw, sample);
+        }
+    }
+
+    // Successful or not, the next sample is triggered a sample period after this one was
+    engine_state = ENGINE_STATE_TRIGGER;
+    engine_deadline = engine_trigger_time + OS_MS_2_TICKS(sample_period_ms());
+
+    if(error != HS300x_ERROR_NONE)
+    {
+        report_measurement_error(error);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Start the sampling engine run by hs300x_task_engine_run(). The first sample is triggered
+ * straight away.
+ *
+ * \return void
+ */
+void hs300x_task_engine_start(void)
+{
+    engine_state = ENGINE_STATE_TRIGGER;
+    engine_deadline = OS_GET_TICK_COUNT();
+
+    // A burst busy waits in this task, which then handles no BLE event. Keep it short.
+    uint32_t max_burst = BURST_CAPTURE_SINGLE_TASK_MAX_us / hs300x_get_conversion_time_us(&hs300x_handle);
+    max_burst = (max_burst > BURST_CAPTURE_MAX_SAMPLES) ? BURST_CAPTURE_MAX_SAMPLES : max_burst;
+    burst_capture_register_task(OS_GET_CURRENT_TASK(), (max_burst > 0) ? (uint16_t)max_burst : 1);
+}
+
+/**
+ * \brief Get the time until hs300x_task_engine_run() has work to do
+ *
+ * \return ticks until the next step of the sampling engine, 0 if it is due
+ */
+OS_TICK_TIME hs300x_task_engine_ticks_to_deadline(void)
+{
+    if(engine_state == ENGINE_STATE_TRIGGER && burst_capture_get_state() == BURST_CAPTURE_STATE_REQUESTED)
+    {
+        return 0;
+    }
+
+    int32_t remaining = (int32_t)(engine_deadline - OS_GET_TICK_COUNT());
+
+    return remaining > 0 ? (OS_TICK_TIME)remaining : 0;
+}
+
+/**
+ * \brief Initialize the sampling engine. Reads the sensor ID and sets the measurement
+ * resolution for both humidity and temperature to the user defined values set in
+ * user_humidity_resolution and user_temperature_resolution respectively.
+ *
+ * \param[in] q                 queue the measurements are put on, NULL if the engine is run by
+ *                              hs300x_task_engine_run()
+ *
+ * \return void
+ */
+void hs300x_task_init(OS_QUEUE q)
+{
+    sample_q = q;
 
     printf("Starting HS300x example...\r\n");
-    OS_MUTEX_CREATE(sample_rate_mutex);
+    STATIC_MUTEX_CREATE(sample_rate_mutex, sample_rate_mutex_storage);
+    sample_bus_subscribe(&console_consumer, "console", NULL, 0);
 
     // enable power and open the I2C port
     hs300x_power_cycle_sensor(hs300x_handle.power_enable[0]);
@@ -109,6 +262,14 @@ void hs300x_task(void *pvParameters)
 
     printf("HS300x Sensor ID: %08lX\r\n", sensor_id);
 
+    // Load the calibration stored for this sensor, if any
+    calibration_t calibration;
+    calibration_error_t calibration_error = calibration_init(sensor_id);
+    calibration_get(&calibration);
+    printf("Calibration: %u humidity points, %u temperature points, error=%d\r\n",
+           calibration.count[CALIBRATION_CHANNEL_HUMIDITY], calibration.count[CALIBRATION_CHANNEL_TEMP],
+           calibration_error);
+
     // Set the humidity resolution
     error = hs300x_set_resolution(&hs300x_handle, user_humidity_resolution, HS300x_RESOLUTION_TYPE_HUMIDITY);
     ASSERT_ERROR(error == HS300x_ERROR_NONE);
@@ -132,24 +293,74 @@ void hs300x_task(void *pvParameters)
     // Exit programming mode
     error = hs300x_exit_programming_mode(&hs300x_handle);
     ASSERT_ERROR(error == HS300x_ERROR_NONE);
+}
 
-    for(;;)
+/**
+ * \brief Print the samples published since the last call to the console. The console reads the sample
+ * bus like any other consumer, so printing is kept out of the sampling path and may lag behind it.
+ * With APP_UART_STREAM the samples are written as binary frames instead of text, see sample_stream.h.
+ *
+ * \return void
+ */
+void hs300x_task_print_samples(void)
+{
+    const hs300x_sample_t *sample;
+    hs300x_data_t data;
+#if APP_UART_STREAM
+    sample_stream_record_t record;
+    uint8_t frame[SAMPLE_STREAM_FRAME_SIZE];
+#else
+    char line[HS300x_TASK_SAMPLE_LINE_LEN];
+#endif
+
+    while((sample = sample_bus_peek(&console_consumer)) != NULL)
     {
-        // Perform a measurement
-        hs300x_data_t sample = {0};
-        hs300x_error_t error = perform_measurement(&sample);
-        if(error == HS300x_ERROR_NONE)
+        hs300x_convert_raw(&sample->raw, &data);
+#if APP_UART_STREAM
+        record.seq = sample->seq;
+        // When the sample was taken, not when a consumer that fell behind gets to it
+        record.time_ms = sample->time_ms;
+        record.humidity_rh_pct = data.humidity_rh_pct;
+        record.temp_deg_c = data.temp_deg_c;
+        if(sample_bus_release(&console_consumer))
         {
-            process_measurement(sample);
+            fwrite(frame, 1, sample_stream_encode(&record, frame), stdout);
         }
-        else
+#else
+        hs300x_task_format_sample(line, sizeof(line), hs300x_task_get_sample_rate(), &data);
+        if(sample_bus_release(&console_consumer))
         {
-            printf("Error performing measurement: error=%d\r\n", error);
+            printf("%s", line);
         }
+#endif
+    }
+
+#if APP_UART_STREAM
+    fflush(stdout);
+#endif
+}
 
-        // Delay for sample_rate_ms
-        vTaskDelay(OS_MS_2_TICKS(hs300x_task_get_sample_rate()));
+/**
+ * \brief Take a single measurement. The results will be stored in the sample history, published on the
+ * sample bus and put on the queue. Call hs300x_task_print_samples() to print them.
+ *
+ * \return error indicating status of the measurement
+ */
+hs300x_error_t hs300x_task_sample(void)
+{
+    hs300x_raw_t raw = {0};
+    hs300x_sample_t sample;
+    hs300x_error_t error = perform_measurement(&raw);
+    if(error == HS300x_ERROR_NONE)
+    {
+        process_measurement(raw, &sample);
+    }
+    else
+    {
+        report_measurement_error(error);
     }
+
+    return error;
 }
 
 /**
@@ -166,6 +377,21 @@ void hs300x_task_event_queue_register(const OS_TASK task_handle)
     measurement_notification_task = task_handle;
 }
 
+/**
+ * \brief Format a measurement as it is printed on the console
+ *
+ * \param[out] buf             buffer where the line will be placed
+ * \param[in] size             size of buf. HS300x_TASK_SAMPLE_LINE_LEN fits any measurement.
+ * \param[in] rate_ms          sample rate in milliseconds
+ * \param[in] data             measurement to format
+ *
+ * \return number of characters written, excluding the terminating NUL
+ */
+int hs300x_task_format_sample(char *buf, size_t size, uint32_t rate_ms, const hs300x_data_t *data)
+{
+    return snprintf(buf, size, "Sample Rate (ms): %ld, Humidity (%%RH): %.3f, Temp (C): %.3f\r\n", rate_ms, data->humidity_rh_pct, data->temp_deg_c);
+}
+
 /**
  * \brief Get the sample rate for taking a measurement
  *
@@ -216,44 +442,88 @@ void hs300x_task_setup_hardware()
 {
     hs300x_handle_init();
 
-    hw_sys_pd_com_enable();
-
-    ad_i2c_io_config(hs300x_i2c_config->id,
-                     hs300x_i2c_config->io, AD_IO_CONF_ON);
-    ad_i2c_io_config(hs300x_i2c_config->id,
-                     hs300x_i2c_config->io, AD_IO_CONF_ON);
-
-    hw_gpio_configure_pin_power(HS300x_POWER_GPIO_PORT, HS300x_POWER_GPIO_PIN, HW_GPIO_POWER_V33);
-    hw_gpio_configure(hs300x_handle.power_enable);
-    hw_gpio_pad_latch_enable(HS300x_POWER_GPIO_PORT,HS300x_POWER_GPIO_PIN);
-
-    hw_sys_pd_com_disable();
+    hs300x_platform_setup_hardware(hs300x_i2c_config, hs300x_handle.power_enable);
 }
 
 /**
  * \brief Take a measurement from the HS300x
  *
- * \param[in] sample       buffer to place measurement
+ * \param[out] raw         buffer to place the conversion codes
  *
- * \return void
+ * \return error indicating status of the measurement
  */
-static hs300x_error_t perform_measurement(hs300x_data_t *sample)
+static hs300x_error_t perform_measurement(hs300x_raw_t *raw)
 {
-    return hs300x_get_measurement(&hs300x_handle, true, sample);
+    return hs300x_get_measurement_raw(&hs300x_handle, true, raw);
 }
 
 /**
- * \brief Process a measurement from the HS300x.
+ * \brief Process a measurement from the HS300x. The measurement is corrected with the calibration of the
+ * sensor and assigned the next sequence number. It is passed on as conversion codes, consumers convert it
+ * if they need units.
  *
- * \param[in] sample       sample to process
+ * \param[in] raw          measurement to process
+ * \param[out] sample      buffer where the sample will be placed
  *
  * \return void
  */
-static void process_measurement(hs300x_data_t sample)
+static void process_measurement(hs300x_raw_t raw, hs300x_sample_t *sample)
 {
-    printf("Sample Rate (ms): %ld, Humidity (%%RH): %.3f, Temp (C): %.3f\r\n", hs300x_task_get_sample_rate(), sample.humidity_rh_pct, sample.temp_deg_c);
+    memset(sample, 0, sizeof(*sample));
+    sample->seq = next_sample_seq++;
+    sample->time_ms = time_sync_local_ms();
+    sample->raw = raw;
+    calibration_apply(&sample->raw);
+    LATENCY_TRACE_STAMP(sample, LATENCY_STAMP_READ);
+
+    sample_history_put(sample);
+
+    HOTPATH_TRACE_START(publish_start);
+    sample_bus_publish(sample);
+    HOTPATH_TRACE_STOP(HOTPATH_SITE_BUS_PUBLISH, publish_start);
+
+    LATENCY_TRACE_STAMP(sample, LATENCY_STAMP_QUEUED);
 
-    OS_QUEUE_PUT(sample_q, &sample, OS_QUEUE_NO_WAIT);
+    // Without a queue the engine runs in the consuming task, which takes the sample directly
+    if(!sample_q)
+    {
+        return;
+    }
+
+    HOTPATH_TRACE_START(put_start);
+    if(OS_QUEUE_PUT(sample_q, sample, OS_QUEUE_NO_WAIT) != OS_QUEUE_OK)
+    {
+        DIAG_COUNTER_INC(queue_drops);
+    }
+    HOTPATH_TRACE_STOP(HOTPATH_SITE_QUEUE_PUT, put_start);
     if(measurement_notification_task)
     	OS_TASK_NOTIFY(measurement_notification_task, HS3001_MEASUREMENT_NOTIFY_MASK, OS_NOTIFY_SET_BITS);
 }
+
+/**
+ * \brief Count and print a failed measurement
+ *
+ * \param[in] error        error returned by the driver
+ *
+ * \return void
+ */
+static void report_measurement_error(hs300x_error_t error)
+{
+    diag_counters_measurement_error(error);
+    printf("Error performing measurement: error=%d\r\n", error);
+}
+
+/**
+ * \brief Get the time from the start of one measurement to the start of the next
+ *
+ * \return the sample rate in milliseconds. 0 with APP_UART_STREAM: each measurement starts as soon as
+ * the last one has been read, which is as fast as the resolution allows.
+ */
+static uint32_t sample_period_ms(void)
+{
+#if APP_UART_STREAM
+    return 0;
+#else
+    return hs300x_task_get_sample_rate();
+#endif
+}
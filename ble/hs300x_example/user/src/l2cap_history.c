@@ -0,0 +1,536 @@
+/*
+ * l2cap_history.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "ble_bufops.h"
+#include "ble_common.h"
+#include "ble_gap.h"
+#include "ble_l2cap.h"
+
+#include "burst_capture.h"
+#include "conn_policy.h"
+#include "l2cap_history.h"
+#include "sample_history.h"
+#include "stream_service.h"
+
+#if dg_configBLE_L2CAP_COC
+
+#define DATA_HEADER_SIZE        (1 + sizeof(uint32_t) + sizeof(uint8_t))
+#define DATA_RECORD_SIZE        (2 * sizeof(float))
+#define END_SIZE                (1 + 3 * sizeof(uint32_t))
+#define DATA_RECORDS_MAX        ((L2CAP_HISTORY_SDU_MAX - DATA_HEADER_SIZE) / DATA_RECORD_SIZE)
+#define BURST_HEADER_SIZE       (1 + sizeof(uint16_t) + sizeof(uint8_t))
+#define BURST_RECORD_SIZE       (sizeof(uint32_t) + HS300x_MEASUREMENT_LENGTH_HUMIDITY_AND_TEMP)
+#define BURST_END_SIZE          (1 + sizeof(uint8_t) + sizeof(uint16_t) + 2 * sizeof(uint32_t))
+
+/* State of a bulk transfer channel */
+typedef struct {
+        bool in_use;                    // Listening for, or connected to, a client
+        bool connected;                 // Channel is connected
+        bool active;                    // Transfer in progress
+        uint16_t conn_idx;
+        uint16_t scid;                  // Local channel ID
+        uint16_t mtu;                   // Largest SDU the peer accepts
+        uint16_t remote_credits;        // Credits the peer has granted us
+        uint8_t in_flight;              // SDUs passed to the BLE manager and not yet sent
+        uint32_t next_seq;              // Next sample to send
+        uint32_t samples_sent;
+        uint32_t bytes_sent;
+        OS_TICK_TIME start_time;
+        bool burst_pending;             // Burst requested on this channel, not captured yet
+        bool burst_active;              // Burst upload in progress
+        uint16_t burst_next;            // Next conversion of the burst to send
+} l2cap_history_channel_t;
+
+/* Private function prototypes */
+static l2cap_history_channel_t *find_channel(uint16_t conn_idx, uint16_t scid);
+static void finish_transfer(l2cap_history_channel_t *ch);
+static void handle_data_ind(l2cap_history_channel_t *ch, const ble_evt_l2cap_data_ind_t *evt);
+static void print_rate(const char *path, uint32_t samples, uint32_t bytes, uint32_t elapsed_ms);
+static void send_burst_data(l2cap_history_channel_t *ch);
+static void send_burst_end(l2cap_history_channel_t *ch, uint8_t status, const burst_capture_result_t *result);
+static void send_data(l2cap_history_channel_t *ch);
+
+/* Private variables */
+__RETAINED static l2cap_history_channel_t channels[L2CAP_HISTORY_MAX_CHANNELS];
+__RETAINED static ble_service_t *stream_service_handle;
+
+/**
+ * \brief Find the channel matching a connection and local channel ID
+ *
+ * \param[in] conn_idx      connection index
+ * \param[in] scid          local channel ID
+ *
+ * \return pointer to the channel, NULL if not found
+ */
+static l2cap_history_channel_t *find_channel(uint16_t conn_idx, uint16_t scid)
+{
+        for (int i = 0; i < L2CAP_HISTORY_MAX_CHANNELS; i++)
+        {
+                if (channels[i].in_use && channels[i].conn_idx == conn_idx && channels[i].scid == scid)
+                {
+                        return &channels[i];
+                }
+        }
+
+        return NULL;
+}
+
+/**
+ * \brief Complete a transfer: tell the client where to resume and log the achieved throughput, next to
+ * the throughput of the latest backlog the sample stream sent over GATT
+ *
+ * \param[in] ch            channel to complete the transfer on
+ *
+ * \return void
+ */
+static void finish_transfer(l2cap_history_channel_t *ch)
+{
+        uint8_t sdu[END_SIZE];
+        uint8_t *ptr = sdu;
+        uint32_t elapsed_ms = OS_TICKS_2_MS(OS_GET_TICK_COUNT() - ch->start_time);
+
+        put_u8_inc(&ptr, L2CAP_HISTORY_OPCODE_END);
+        put_u32_inc(&ptr, ch->next_seq);
+        put_u32_inc(&ptr, ch->samples_sent);
+        put_u32_inc(&ptr, elapsed_ms);
+
+        if (ble_l2cap_send(ch->conn_idx, ch->scid, sizeof(sdu), sdu) == BLE_STATUS_OK)
+        {
+                ch->in_flight++;
+        }
+        ch->active = false;
+        conn_policy_set_bulk(ch->conn_idx, false);
+
+        print_rate("L2CAP history", ch->samples_sent, ch->bytes_sent, elapsed_ms);
+
+        // The stream packs as many samples as the MTU allows per notification, so compare measured rates
+        stream_service_transfer_t transfer;
+
+        if (stream_service_handle && stream_service_get_last_transfer(stream_service_handle, &transfer))
+        {
+                print_rate("GATT stream backlog", transfer.samples, transfer.bytes, transfer.elapsed_ms);
+        }
+        else
+        {
+                printf("GATT stream backlog: none sent since boot\r\n");
+        }
+}
+
+/**
+ * \brief Handle a request from the client
+ *
+ * \param[in] ch            channel the request was received on
+ * \param[in] evt           pointer to the data indication event
+ *
+ * \return void
+ */
+static void handle_data_ind(l2cap_history_channel_t *ch, const ble_evt_l2cap_data_ind_t *evt)
+{
+        // Return the credits used by the client so it can always send another request
+        ble_l2cap_add_credits(ch->conn_idx, ch->scid, evt->local_credits_consumed);
+
+        if (evt->length < 1)
+        {
+                return;
+        }
+
+        switch (evt->data[0])
+        {
+        case L2CAP_HISTORY_OPCODE_START:
+                if (evt->length >= 1 + sizeof(uint32_t) && !ch->burst_pending && !ch->burst_active)
+                {
+                        ch->active = true;
+                        ch->next_seq = get_u32(&evt->data[1]);
+                        ch->samples_sent = 0;
+                        ch->bytes_sent = 0;
+                        ch->start_time = OS_GET_TICK_COUNT();
+                        conn_policy_set_bulk(ch->conn_idx, true);
+                        send_data(ch);
+                }
+                break;
+        case L2CAP_HISTORY_OPCODE_STOP:
+                if (ch->active)
+                {
+                        finish_transfer(ch);
+                }
+                break;
+        case L2CAP_HISTORY_OPCODE_BURST:
+                // The upload starts from l2cap_history_burst_complete() once the samples are captured
+                if (evt->length >= 1 + sizeof(uint16_t) && !ch->active &&
+                    burst_capture_request(get_u16(&evt->data[1]), OS_GET_CURRENT_TASK()))
+                {
+                        ch->burst_pending = true;
+                }
+                else
+                {
+                        send_burst_end(ch, L2CAP_HISTORY_BURST_STATUS_REJECTED, NULL);
+                }
+                break;
+        default:
+                break;
+        }
+}
+
+/**
+ * \brief Log the throughput of a transfer
+ *
+ * \param[in] path          name of the transfer path
+ * \param[in] samples       samples sent
+ * \param[in] bytes         bytes sent, protocol headers included
+ * \param[in] elapsed_ms    duration of the transfer
+ *
+ * \return void
+ */
+static void print_rate(const char *path, uint32_t samples, uint32_t bytes, uint32_t elapsed_ms)
+{
+        if (!elapsed_ms)
+        {
+                // Shorter than the tick, no rate can be given
+                printf("%s: %lu samples, %lu bytes in under 1 ms\r\n", path, samples, bytes);
+                return;
+        }
+
+        printf("%s: %lu samples, %lu bytes in %lu ms (%lu samples/s, %lu bytes/s)\r\n", path, samples, bytes,
+               elapsed_ms, (unsigned long)((uint64_t)samples * 1000 / elapsed_ms),
+               (unsigned long)((uint64_t)bytes * 1000 / elapsed_ms));
+}
+
+/**
+ * \brief Send as many BURST_DATA SDUs as flow control allows. Sends BURST_END and frees the capture
+ * buffer once all the conversions have been sent.
+ *
+ * \param[in] ch            channel to send on
+ *
+ * \return void
+ */
+static void send_burst_data(l2cap_history_channel_t *ch)
+{
+        burst_capture_result_t result;
+
+        if (!burst_capture_get_result(&result))
+        {
+                ch->burst_active = false;
+                return;
+        }
+
+        while (ch->burst_active && ch->in_flight < L2CAP_HISTORY_MAX_IN_FLIGHT && ch->remote_credits > 0)
+        {
+                if (ch->burst_next == result.count)
+                {
+                        uint8_t status = (result.error == HS300x_ERROR_NONE) ? L2CAP_HISTORY_BURST_STATUS_OK :
+                                                                               L2CAP_HISTORY_BURST_STATUS_SENSOR_ERROR;
+
+                        send_burst_end(ch, status, &result);
+                        ch->burst_active = false;
+                        conn_policy_set_bulk(ch->conn_idx, false);
+                        burst_capture_release();
+
+                        printf("Burst: %u of %u conversions in %lu us, %lu stale reads, error %d\r\n",
+                               result.count, result.requested, result.duration_us, result.stale_polls,
+                               result.error);
+                        break;
+                }
+
+                uint8_t sdu[L2CAP_HISTORY_SDU_MAX];
+                uint16_t sdu_max = (ch->mtu < sizeof(sdu)) ? ch->mtu : sizeof(sdu);
+                uint32_t count = (sdu_max - BURST_HEADER_SIZE) / BURST_RECORD_SIZE;
+
+                if (count > (uint32_t)(result.count - ch->burst_next))
+                {
+                        count = result.count - ch->burst_next;
+                }
+
+                uint8_t *ptr = sdu;
+                put_u8_inc(&ptr, L2CAP_HISTORY_OPCODE_BURST_DATA);
+                put_u16_inc(&ptr, ch->burst_next);
+                put_u8_inc(&ptr, count);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                        const burst_sample_t *sample = &result.samples[ch->burst_next + i];
+
+                        put_u32_inc(&ptr, sample->t_us);
+                        memcpy(ptr, sample->raw, sizeof(sample->raw));
+                        ptr += sizeof(sample->raw);
+                }
+
+                if (ble_l2cap_send(ch->conn_idx, ch->scid, ptr - sdu, sdu) != BLE_STATUS_OK)
+                {
+                        // BLE manager is out of buffers, retry on the next sent event
+                        break;
+                }
+
+                ch->in_flight++;
+                ch->burst_next += count;
+        }
+}
+
+/**
+ * \brief Send BURST_END
+ *
+ * \param[in] ch            channel to send on
+ * \param[in] status        one of L2CAP_HISTORY_BURST_STATUS_*
+ * \param[in] result        result of the burst, NULL if it was rejected
+ *
+ * \return void
+ */
+static void send_burst_end(l2cap_history_channel_t *ch, uint8_t status, const burst_capture_result_t *result)
+{
+        uint8_t sdu[BURST_END_SIZE];
+        uint8_t *ptr = sdu;
+
+        put_u8_inc(&ptr, L2CAP_HISTORY_OPCODE_BURST_END);
+        put_u8_inc(&ptr, status);
+        put_u16_inc(&ptr, result ? result->count : 0);
+        put_u32_inc(&ptr, result ? result->duration_us : 0);
+        put_u32_inc(&ptr, result ? result->stale_polls : 0);
+
+        if (ble_l2cap_send(ch->conn_idx, ch->scid, sizeof(sdu), sdu) == BLE_STATUS_OK)
+        {
+                ch->in_flight++;
+        }
+}
+
+/**
+ * \brief Send as many DATA SDUs as flow control allows. Sends END once the history is exhausted.
+ *
+ * \param[in] ch            channel to send on
+ *
+ * \return void
+ */
+static void send_data(l2cap_history_channel_t *ch)
+{
+        if (ch->burst_active)
+        {
+                send_burst_data(ch);
+                return;
+        }
+
+        while (ch->active && ch->in_flight < L2CAP_HISTORY_MAX_IN_FLIGHT && ch->remote_credits > 0)
+        {
+                hs300x_raw_t samples[DATA_RECORDS_MAX];
+                hs300x_data_t data[DATA_RECORDS_MAX];
+                uint8_t sdu[L2CAP_HISTORY_SDU_MAX];
+                uint16_t sdu_max = (ch->mtu < sizeof(sdu)) ? ch->mtu : sizeof(sdu);
+                uint32_t max_records = (sdu_max - DATA_HEADER_SIZE) / DATA_RECORD_SIZE;
+                uint32_t first_seq = ch->next_seq;
+
+                uint32_t count = sample_history_read(&first_seq, samples, NULL, max_records);
+                if (count == 0)
+                {
+                        finish_transfer(ch);
+                        break;
+                }
+
+                hs300x_convert_raw_batch(samples, data, count);
+
+                uint8_t *ptr = sdu;
+                put_u8_inc(&ptr, L2CAP_HISTORY_OPCODE_DATA);
+                put_u32_inc(&ptr, first_seq);
+                put_u8_inc(&ptr, count);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                        memcpy(ptr, &data[i].humidity_rh_pct, sizeof(float));
+                        ptr += sizeof(float);
+                        memcpy(ptr, &data[i].temp_deg_c, sizeof(float));
+                        ptr += sizeof(float);
+                }
+
+                if (ble_l2cap_send(ch->conn_idx, ch->scid, ptr - sdu, sdu) != BLE_STATUS_OK)
+                {
+                        // BLE manager is out of buffers, retry on the next sent event
+                        break;
+                }
+
+                ch->in_flight++;
+                ch->next_seq = first_seq + count;
+                ch->samples_sent += count;
+                ch->bytes_sent += ptr - sdu;
+        }
+}
+
+/**
+ * \brief Start uploading a completed burst on the channel that requested it. Called by the BLE task when
+ * notified with BURST_CAPTURE_NOTIFY_MASK.
+ *
+ * \return void
+ */
+void l2cap_history_burst_complete(void)
+{
+        for (int i = 0; i < L2CAP_HISTORY_MAX_CHANNELS; i++)
+        {
+                l2cap_history_channel_t *ch = &channels[i];
+
+                if (ch->in_use && ch->connected && ch->burst_pending)
+                {
+                        ch->burst_pending = false;
+                        ch->burst_active = true;
+                        ch->burst_next = 0;
+                        conn_policy_set_bulk(ch->conn_idx, true);
+                        send_burst_data(ch);
+                        return;
+                }
+        }
+
+        // The requester has gone, nobody will upload the samples
+        burst_capture_release();
+}
+
+/**
+ * \brief Start listening for a bulk transfer channel on a new connection
+ *
+ * \param[in] conn_idx      connection index
+ *
+ * \return void
+ */
+void l2cap_history_connected(uint16_t conn_idx)
+{
+        for (int i = 0; i < L2CAP_HISTORY_MAX_CHANNELS; i++)
+        {
+                l2cap_history_channel_t *ch = &channels[i];
+
+                if (!ch->in_use)
+                {
+                        memset(ch, 0, sizeof(*ch));
+                        if (ble_l2cap_listen(conn_idx, L2CAP_HISTORY_PSM, GAP_SEC_LEVEL_1,
+                                             L2CAP_HISTORY_INITIAL_CREDITS, &ch->scid) == BLE_STATUS_OK)
+                        {
+                                ch->in_use = true;
+                                ch->conn_idx = conn_idx;
+                        }
+                        return;
+                }
+        }
+}
+
+/**
+ * \brief Release the channels of a connection that has been terminated
+ *
+ * \param[in] conn_idx      connection index
+ *
+ * \return void
+ */
+void l2cap_history_disconnected(uint16_t conn_idx)
+{
+        for (int i = 0; i < L2CAP_HISTORY_MAX_CHANNELS; i++)
+        {
+                if (channels[i].in_use && channels[i].conn_idx == conn_idx)
+                {
+                        if (channels[i].burst_active)
+                        {
+                                burst_capture_release();
+                        }
+                        channels[i].in_use = false;
+                }
+        }
+}
+
+/**
+ * \brief Handle L2CAP events for the bulk transfer channels
+ *
+ * \param[in] hdr           pointer to the BLE event
+ *
+ * \return true if the event was handled, false otherwise
+ */
+bool l2cap_history_handle_event(const ble_evt_hdr_t *hdr)
+{
+        l2cap_history_channel_t *ch;
+
+        switch (hdr->evt_code)
+        {
+        case BLE_EVT_L2CAP_CONNECTED:
+        {
+                const ble_evt_l2cap_connected_t *evt = (const ble_evt_l2cap_connected_t *) hdr;
+                ch = find_channel(evt->conn_idx, evt->scid);
+                if (ch)
+                {
+                        ch->connected = true;
+                        ch->mtu = evt->mtu;
+                        ch->remote_credits = evt->remote_credits;
+                        ch->in_flight = 0;
+                }
+                return ch != NULL;
+        }
+        case BLE_EVT_L2CAP_DISCONNECTED:
+        {
+                const ble_evt_l2cap_disconnected_t *evt = (const ble_evt_l2cap_disconnected_t *) hdr;
+                ch = find_channel(evt->conn_idx, evt->scid);
+                if (ch)
+                {
+                        if (ch->active)
+                        {
+                                printf("L2CAP history: channel closed at seq %lu\r\n", ch->next_seq);
+                                conn_policy_set_bulk(ch->conn_idx, false);
+                        }
+                        if (ch->burst_active)
+                        {
+                                conn_policy_set_bulk(ch->conn_idx, false);
+                                burst_capture_release();
+                        }
+                        // Keep listening so the client can reopen the channel and resume
+                        ch->in_use = false;
+                        l2cap_history_connected(evt->conn_idx);
+                }
+                return ch != NULL;
+        }
+        case BLE_EVT_L2CAP_DATA_IND:
+        {
+                const ble_evt_l2cap_data_ind_t *evt = (const ble_evt_l2cap_data_ind_t *) hdr;
+                ch = find_channel(evt->conn_idx, evt->scid);
+                if (ch)
+                {
+                        handle_data_ind(ch, evt);
+                }
+                return ch != NULL;
+        }
+        case BLE_EVT_L2CAP_SENT:
+        {
+                const ble_evt_l2cap_sent_t *evt = (const ble_evt_l2cap_sent_t *) hdr;
+                ch = find_channel(evt->conn_idx, evt->scid);
+                if (ch)
+                {
+                        if (ch->in_flight)
+                        {
+                                ch->in_flight--;
+                        }
+                        ch->remote_credits = evt->remote_credits;
+                        send_data(ch);
+                }
+                return ch != NULL;
+        }
+        case BLE_EVT_L2CAP_REMOTE_CREDITS_CHANGED:
+        {
+                const ble_evt_l2cap_remote_credits_changed_t *evt = (const ble_evt_l2cap_remote_credits_changed_t *) hdr;
+                ch = find_channel(evt->conn_idx, evt->scid);
+                if (ch)
+                {
+                        ch->remote_credits = evt->remote_credits;
+                        send_data(ch);
+                }
+                return ch != NULL;
+        }
+        default:
+                return false;
+        }
+}
+
+/**
+ * \brief Initialize the bulk transfer channels
+ *
+ * \param[in] stream_service    sample stream service whose throughput is logged next to the transfers,
+ *                              NULL if it is not built
+ *
+ * \return void
+ */
+void l2cap_history_init(ble_service_t *stream_service)
+{
+        memset(channels, 0, sizeof(channels));
+        stream_service_handle = stream_service;
+}
+
+#endif /* dg_configBLE_L2CAP_COC */
@@ -0,0 +1,183 @@
+/*
+ * latency_trace.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdint.h>
+#include <string.h>
+#include "osal.h"
+
+#include "latency_trace.h"
+
+/*
+ * Log-linear histogram in microseconds: every power of two is split into LATENCY_SUB_BINS bins, so
+ * a percentile is within 12.5% of the actual value. Values below 8 us have a bin of their own.
+ * LATENCY_HIST_BINS covers up to 2^22 us (4.2 s); longer latencies go in the last bin.
+ */
+#define LATENCY_SUB_BITS                (2)
+#define LATENCY_SUB_BINS                (1 << LATENCY_SUB_BITS)
+#define LATENCY_HIST_BINS               (84)
+
+typedef struct
+{
+    uint32_t count;
+    uint16_t hist[LATENCY_HIST_BINS];   // Halved when a bin saturates, so recent samples keep their weight
+} latency_stage_hist_t;
+
+/* Private function prototypes */
+static void add_to_hist(latency_stage_hist_t *stage_hist, uint32_t us);
+static uint32_t bin_to_us(uint8_t bin);
+static uint8_t us_to_bin(uint32_t us);
+
+/*
+ * Private variables
+ *
+ * Only the BLE task records and reads the histograms, so they are not locked.
+ */
+__RETAINED static latency_stage_hist_t stage_hists[LATENCY_STAGE_COUNT];
+
+/**
+ * \brief Add a latency to the histogram of a stage. If its bin is full, all bins are halved first.
+ *
+ * \param[in] stage_hist        histogram of the stage
+ * \param[in] us                latency in microseconds
+ *
+ * \return void
+ */
+static void add_to_hist(latency_stage_hist_t *stage_hist, uint32_t us)
+{
+    uint8_t bin = us_to_bin(us);
+
+    if(stage_hist->hist[bin] == UINT16_MAX)
+    {
+        for(uint8_t i = 0; i < LATENCY_HIST_BINS; i++)
+        {
+            stage_hist->hist[i] /= 2;
+        }
+    }
+
+    stage_hist->hist[bin]++;
+    stage_hist->count++;
+}
+
+/**
+ * \brief Value reported for a histogram bin
+ *
+ * \param[in] bin               histogram bin
+ *
+ * \return middle of the range of the bin in microseconds
+ */
+static uint32_t bin_to_us(uint8_t bin)
+{
+    if(bin < 2 * LATENCY_SUB_BINS)
+    {
+        return bin;
+    }
+
+    uint8_t shift = bin / LATENCY_SUB_BINS - 1;
+    uint32_t low = (uint32_t)(LATENCY_SUB_BINS + bin % LATENCY_SUB_BINS) << shift;
+
+    return low + (1u << shift) / 2;
+}
+
+/**
+ * \brief Histogram bin of a latency
+ *
+ * \param[in] us                latency in microseconds
+ *
+ * \return histogram bin, limited to the last one
+ */
+static uint8_t us_to_bin(uint32_t us)
+{
+    if(us < 2 * LATENCY_SUB_BINS)
+    {
+        return us;
+    }
+
+    // Top LATENCY_SUB_BITS + 1 bits select the bin within the octave
+    uint8_t msb = 31 - __builtin_clz(us);
+    uint8_t shift = msb - LATENCY_SUB_BITS;
+    uint32_t bin = (shift + 1) * LATENCY_SUB_BINS + ((us >> shift) & (LATENCY_SUB_BINS - 1));
+
+    return bin < LATENCY_HIST_BINS ? bin : LATENCY_HIST_BINS - 1;
+}
+
+/**
+ * \brief Get the percentiles of a stage
+ *
+ * \param[in] stage             stage of the sample path
+ * \param[out] percentiles      buffer where the percentiles will be placed. All zero if nothing has been recorded.
+ *
+ * \return void
+ */
+void latency_trace_get(latency_stage_t stage, latency_percentiles_t *percentiles)
+{
+    const latency_stage_hist_t *stage_hist = &stage_hists[stage];
+    static const uint8_t pct[] = { 50, 95, 99 };
+    uint32_t *result[] = { &percentiles->p50_us, &percentiles->p95_us, &percentiles->p99_us };
+    uint32_t total = 0;
+
+    OS_ASSERT(stage < LATENCY_STAGE_COUNT);
+
+    memset(percentiles, 0, sizeof(*percentiles));
+    percentiles->count = stage_hist->count;
+
+    for(uint8_t bin = 0; bin < LATENCY_HIST_BINS; bin++)
+    {
+        total += stage_hist->hist[bin];
+    }
+
+    uint32_t seen = 0;
+    uint8_t next = 0;
+    for(uint8_t bin = 0; bin < LATENCY_HIST_BINS && next < ARRAY_LENGTH(pct); bin++)
+    {
+        seen += stage_hist->hist[bin];
+
+        // Nearest rank: the smallest bin holding at least pct% of the samples
+        while(next < ARRAY_LENGTH(pct) && seen && seen * 100 >= total * pct[next])
+        {
+            *result[next++] = bin_to_us(bin);
+        }
+    }
+}
+
+/**
+ * \brief Clear the histograms. Call before the tasks are started.
+ *
+ * \return void
+ */
+void latency_trace_init(void)
+{
+    cycle_counter_init();
+    latency_trace_reset();
+}
+
+/**
+ * \brief Add the stage latencies of a sample to the histograms. Called by the BLE task once the
+ * sample has been handed to the BLE stack.
+ *
+ * \param[in] stamps            LATENCY_STAMP_COUNT stamps of the sample
+ *
+ * \return void
+ */
+void latency_trace_record(const uint32_t *stamps)
+{
+    add_to_hist(&stage_hists[LATENCY_STAGE_PROCESS],
+                cycle_counter_to_us(stamps[LATENCY_STAMP_QUEUED] - stamps[LATENCY_STAMP_READ]));
+    add_to_hist(&stage_hists[LATENCY_STAGE_WAKEUP],
+                cycle_counter_to_us(stamps[LATENCY_STAMP_DEQUEUED] - stamps[LATENCY_STAMP_QUEUED]));
+    add_to_hist(&stage_hists[LATENCY_STAGE_SEND],
+                cycle_counter_to_us(stamps[LATENCY_STAMP_SENT] - stamps[LATENCY_STAMP_DEQUEUED]));
+    add_to_hist(&stage_hists[LATENCY_STAGE_TOTAL],
+                cycle_counter_to_us(stamps[LATENCY_STAMP_SENT] - stamps[LATENCY_STAMP_READ]));
+}
+
+/**
+ * \brief Clear the histograms of all stages
+ *
+ * \return void
+ */
+void latency_trace_reset(void)
+{
+    memset(stage_hists, 0, sizeof(stage_hists));
+}
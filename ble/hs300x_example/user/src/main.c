@@ -25,12 +25,47 @@
 #include "hs300x_task.h"
 #include "hs300x.h"
 #include "ble_task.h"
+#include "alarm.h"
+#include "sample_bus.h"
+#include "sample_history.h"
+#include "diag_counters.h"
+#include "distribution.h"
+#include "hotpath_trace.h"
+#include "latency_trace.h"
+#include "static_alloc.h"
+#include "time_sync.h"
 
 /* Task priorities */
 #define mainBLE_TASK_PRIORITY              ( OS_TASK_PRIORITY_NORMAL )
 #define mainHS3001_TASK_PRIORITY           ( OS_TASK_PRIORITY_NORMAL )
 
+/* Task stack sizes in bytes. Check the stack headroom reported by the Health characteristic of the
+ * diagnostics service after a long run before changing them, and keep at least 512 bytes spare. */
+#define mainBLE_TASK_STACK_SIZE            ( 4096 )
+#define mainHS3001_TASK_STACK_SIZE         ( 4096 )
+
+#define mainSAMPLE_Q_LENGTH                ( 5 )
+
+/* The application tasks and the sample queue are statically allocated, see static_alloc.h */
 __RETAINED static OS_QUEUE sample_q = NULL;
+__RETAINED static STATIC_STACK(ble_task_stack, mainBLE_TASK_STACK_SIZE);
+__RETAINED static static_task_t ble_task_storage;
+
+#if !APP_SINGLE_TASK
+/* With APP_SINGLE_TASK the BLE task samples the sensor itself and these are not needed */
+__RETAINED static hs300x_sample_t sample_q_buffer[mainSAMPLE_Q_LENGTH];
+__RETAINED static static_queue_t sample_q_storage;
+__RETAINED static STATIC_STACK(hs300x_task_stack, mainHS3001_TASK_STACK_SIZE);
+__RETAINED static static_task_t hs300x_task_storage;
+#endif
+
+/* Kernel tasks, needed by FreeRTOS when static allocation is supported */
+__RETAINED static STATIC_STACK(idle_task_stack, configMINIMAL_STACK_SIZE * sizeof(StackType_t));
+__RETAINED static static_task_t idle_task_storage;
+#if configUSE_TIMERS
+__RETAINED static STATIC_STACK(timer_task_stack, configTIMER_TASK_STACK_DEPTH * sizeof(StackType_t));
+__RETAINED static static_task_t timer_task_storage;
+#endif
 
 #if dg_configUSE_WDOG
 INITIALISED_PRIVILEGED_DATA int8_t idle_task_wdog_id = -1;
@@ -91,7 +126,15 @@ static void system_init( void *pvParameters )
         pm_set_wakeup_mode(true);
 
         /* Set the desired sleep mode. */
+#if APP_HOTPATH_TRACE || APP_LATENCY_TRACE
+        /*
+         * The traces time with the DWT cycle counter, which loses its count and its enable in
+         * extended sleep. Stay awake so spans that block, as the measurement delay does, hold.
+         */
+        pm_sleep_mode_set(pm_mode_active);
+#else
         pm_sleep_mode_set(pm_mode_extended_sleep);
+#endif
 
         /* Set the desired wakeup mode. */
         pm_set_sys_wakeup_mode(pm_sys_wakeup_mode_fast);
@@ -104,33 +147,55 @@ static void system_init( void *pvParameters )
         /* Initialize BLE Manager */
         ble_mgr_init();
 
+        /* Sample history is shared by the HS3001 task (producer) and the BLE task (bulk transfer) */
+        sample_history_init();
+        sample_bus_init();
+        distribution_init();
+        /* Alarm rules are loaded from NVMS, which the BLE Manager has brought up */
+        alarm_init();
+        time_sync_init();
+
+        diag_counters_init();
+#if APP_HOTPATH_TRACE
+        hotpath_trace_init();
+#endif
+#if APP_LATENCY_TRACE
+        latency_trace_init();
+#endif
+
+#if !APP_SINGLE_TASK
 		// create a queue to communicate measurements between the BLE task and HS3001 task
-        OS_QUEUE_CREATE(sample_q, sizeof(hs300x_data_t), 5);
+        STATIC_QUEUE_CREATE(sample_q, sizeof(hs300x_sample_t), sample_q_buffer, sample_q_storage);
+        OS_ASSERT(sample_q);
+#endif
 
         /* Start the BLE Peripheral application task. */
-        OS_TASK_CREATE("Ble Task",                /* The text name assigned to the task, for
+        STATIC_TASK_CREATE("Ble Task",            /* The text name assigned to the task, for
                                                      debug only; not used by the kernel. */
                        ble_task,             	  /* The function that implements the task. */
 					   sample_q,                  /* The parameter passed to the task. */
-                       4096,                      /* The number of bytes to allocate to the
-                                                     stack of the task. */
+                       ble_task_stack,            /* The stack of the task. */
 					   mainBLE_TASK_PRIORITY,	  /* The priority assigned to the task. */
+                       ble_task_storage,          /* The task control block. */
                        handle);                   /* The task handle. */
         OS_ASSERT(handle);
+        diag_counters_register_task(DIAG_TASK_BLE, handle);
 
-
+#if !APP_SINGLE_TASK
         /* Start the HS3001 sampling task. */
-        OS_TASK_CREATE("HS300x Sample Task",      /* The text name assigned to the task, for
+        STATIC_TASK_CREATE("HS300x Sample Task",  /* The text name assigned to the task, for
                                                      debug only; not used by the kernel. */
                        hs300x_task,               /* The function that implements the task. */
 					   sample_q,                  /* The parameter passed to the task. */
-                       4096,                      /* The number of bytes to allocate to the
-                                                     stack of the task. */
+                       hs300x_task_stack,         /* The stack of the task. */
 					   mainHS3001_TASK_PRIORITY,  /* The priority assigned to the task. */
+                       hs300x_task_storage,       /* The task control block. */
                        handle);                   /* The task handle. */
         OS_ASSERT(handle);
+        diag_counters_register_task(DIAG_TASK_HS300x, handle);
+#endif
 
-        /* the work of the SysInit task is done, delete it */
+        /* the work of the SysInit task is done, delete it. Its stack goes back to the heap. */
         OS_TASK_DELETE(OS_GET_CURRENT_TASK());
 }
 /*-----------------------------------------------------------*/
@@ -239,6 +304,30 @@ void vApplicationStackOverflowHook( OS_TASK pxTask, char *pcTaskName )
         ASSERT_ERROR(0);
 }
 
+/**
+ * @brief Provide the memory of the idle task
+ */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                    uint32_t *pulIdleTaskStackSize )
+{
+        *ppxIdleTaskTCBBuffer = &idle_task_storage;
+        *ppxIdleTaskStackBuffer = idle_task_stack;
+        *pulIdleTaskStackSize = ARRAY_LENGTH(idle_task_stack);
+}
+
+#if configUSE_TIMERS
+/**
+ * @brief Provide the memory of the timer service task
+ */
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                     uint32_t *pulTimerTaskStackSize )
+{
+        *ppxTimerTaskTCBBuffer = &timer_task_storage;
+        *ppxTimerTaskStackBuffer = timer_task_stack;
+        *pulTimerTaskStackSize = ARRAY_LENGTH(timer_task_stack);
+}
+#endif
+
 /**
  * @brief Application tick hook
  */
@@ -0,0 +1,94 @@
+/*
+ * measurement_broadcast.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdint.h>
+#include <string.h>
+#include "osal.h"
+#include "ble_bufops.h"
+#include "ble_common.h"
+#include "ble_gap.h"
+
+#include "measurement_broadcast.h"
+
+/* Private function prototypes */
+static void encode_measurement(const hs300x_sample_t *sample);
+
+/* Private variables */
+__RETAINED static uint8_t broadcast_data[MEASUREMENT_BROADCAST_DATA_SIZE];
+__RETAINED static gap_adv_ad_struct_t broadcast_adv_data[1];
+__RETAINED static gap_adv_ad_struct_t broadcast_scan_rsp[1];
+
+/**
+ * \brief Encode a sample into the manufacturer specific data
+ *
+ * \param[in] sample        sample to encode, NULL to encode an empty measurement
+ *
+ * \return void
+ */
+static void encode_measurement(const hs300x_sample_t *sample)
+{
+    uint8_t *ptr = broadcast_data;
+    uint32_t sensor_id = hs300x_task_get_sensor_id();
+    uint16_t seq = 0;
+    uint16_t humidity = 0;
+    int16_t temp = 0;
+
+    if(sample)
+    {
+        hs300x_fixed_t fixed;
+
+        hs300x_convert_raw_fixed(&sample->raw, &fixed);
+        seq = (uint16_t)sample->seq;
+        humidity = fixed.humidity_x100;
+        temp = fixed.temp_x100;
+    }
+
+    put_u16_inc(&ptr, MEASUREMENT_BROADCAST_COMPANY_ID);
+    put_u8_inc(&ptr, MEASUREMENT_BROADCAST_VERSION);
+    put_u16_inc(&ptr, (uint16_t)((sensor_id >> 16) ^ sensor_id));
+    put_u16_inc(&ptr, seq);
+    put_u16_inc(&ptr, humidity);
+    put_u16_inc(&ptr, (uint16_t)temp);
+}
+
+/**
+ * \brief Set the advertising data to broadcast measurements and the scan response to the local name.
+ * Must be called before advertising is started.
+ *
+ * \param[in] name          local name
+ * \param[in] name_len      length of the local name
+ *
+ * \return void
+ */
+void measurement_broadcast_start(const char *name, size_t name_len)
+{
+    encode_measurement(NULL);
+
+    broadcast_adv_data[0].type = GAP_DATA_TYPE_MANUFACTURER_SPEC;
+    broadcast_adv_data[0].len = sizeof(broadcast_data);
+    broadcast_adv_data[0].data = broadcast_data;
+
+    broadcast_scan_rsp[0].type = GAP_DATA_TYPE_LOCAL_NAME;
+    broadcast_scan_rsp[0].len = name_len;
+    broadcast_scan_rsp[0].data = (const uint8_t *)name;
+
+    ble_gap_adv_ad_struct_set(ARRAY_LENGTH(broadcast_adv_data), broadcast_adv_data,
+                              ARRAY_LENGTH(broadcast_scan_rsp), broadcast_scan_rsp);
+}
+
+/**
+ * \brief Update the broadcast measurement. Advertising continues without being restarted.
+ *
+ * \param[in] sample        latest sample
+ *
+ * \return void
+ */
+void measurement_broadcast_update(const hs300x_sample_t *sample)
+{
+    encode_measurement(sample);
+
+    ble_gap_adv_ad_struct_set(ARRAY_LENGTH(broadcast_adv_data), broadcast_adv_data,
+                              ARRAY_LENGTH(broadcast_scan_rsp), broadcast_scan_rsp);
+}
@@ -0,0 +1,100 @@
+/*
+ * nvms_record.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "osal.h"
+#include "ad_nvms.h"
+#include "ble_bufops.h"
+#include "nvms_record.h"
+#include "sample_stream.h"
+
+#define NVMS_RECORD_HEADER_SIZE                 (6)
+
+/**
+ * \brief Read the record of a slot
+ *
+ * \param[in] addr              slot address, one of NVMS_RECORD_ADDR_x
+ * \param[in] magic             magic of the setting stored there
+ * \param[out] payload          where the payload will be placed
+ * \param[in] max_length        size of the payload buffer, at most NVMS_RECORD_MAX_PAYLOAD
+ * \param[out] length           payload length
+ *
+ * \return NVMS_RECORD_OK if a valid record was read, the reason it was not otherwise
+ */
+nvms_record_status_t nvms_record_read(uint32_t addr, uint32_t magic, uint8_t *payload, uint16_t max_length,
+                                      uint16_t *length)
+{
+    uint8_t record[NVMS_RECORD_SLOT_SIZE];
+
+    *length = 0;
+
+    nvms_t nvms = ad_nvms_open(NVMS_RECORD_PARTITION);
+    if(!nvms || ad_nvms_read(nvms, addr, record, NVMS_RECORD_HEADER_SIZE) != NVMS_RECORD_HEADER_SIZE)
+    {
+        return NVMS_RECORD_STORAGE_ERROR;
+    }
+
+    if(get_u32(record) != magic)
+    {
+        return NVMS_RECORD_EMPTY;
+    }
+
+    uint16_t stored = get_u16(record + 4);
+    if(stored > max_length || stored > NVMS_RECORD_MAX_PAYLOAD)
+    {
+        return NVMS_RECORD_INVALID;
+    }
+    if(ad_nvms_read(nvms, addr + NVMS_RECORD_HEADER_SIZE, record + NVMS_RECORD_HEADER_SIZE, stored + 2) !=
+       stored + 2)
+    {
+        return NVMS_RECORD_STORAGE_ERROR;
+    }
+
+    const uint8_t *stored_payload = record + NVMS_RECORD_HEADER_SIZE;
+    if(get_u16(stored_payload + stored) != sample_stream_crc16(stored_payload, stored))
+    {
+        return NVMS_RECORD_INVALID;
+    }
+
+    memcpy(payload, stored_payload, stored);
+    *length = stored;
+
+    return NVMS_RECORD_OK;
+}
+
+/**
+ * \brief Write the record of a slot, replacing what it held
+ *
+ * \param[in] addr              slot address, one of NVMS_RECORD_ADDR_x
+ * \param[in] magic             magic of the setting stored there
+ * \param[in] payload           payload to store
+ * \param[in] length            payload length, at most NVMS_RECORD_MAX_PAYLOAD
+ *
+ * \return NVMS_RECORD_OK if the record was written, the reason it was not otherwise
+ */
+nvms_record_status_t nvms_record_write(uint32_t addr, uint32_t magic, const uint8_t *payload, uint16_t length)
+{
+    uint8_t record[NVMS_RECORD_SLOT_SIZE];
+    uint8_t *ptr = record;
+
+    if(length > NVMS_RECORD_MAX_PAYLOAD)
+    {
+        return NVMS_RECORD_INVALID;
+    }
+
+    put_u32_inc(&ptr, magic);
+    put_u16_inc(&ptr, length);
+    memcpy(ptr, payload, length);
+    ptr += length;
+    put_u16_inc(&ptr, sample_stream_crc16(payload, length));
+
+    nvms_t nvms = ad_nvms_open(NVMS_RECORD_PARTITION);
+    if(!nvms || ad_nvms_write(nvms, addr, record, ptr - record) != ptr - record)
+    {
+        return NVMS_RECORD_STORAGE_ERROR;
+    }
+
+    return NVMS_RECORD_OK;
+}
@@ -0,0 +1,189 @@
+/*
+ * psychro.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <math.h>
+#include "psychro.h"
+
+/* Saturation vapour pressure table: one entry per degree C from PSYCHRO_TABLE_MIN_x100 */
+#define PSYCHRO_TABLE_MIN_x100                  (PSYCHRO_DEW_POINT_MIN_x100)
+#define PSYCHRO_TABLE_LENGTH                    (206)
+
+/* Molar mass of water over the gas constant, in g K / J, times 1e5 */
+#define PSYCHRO_WATER_MW_OVER_R_e5              (216679)
+
+#define PSYCHRO_ZERO_C_x100                     (27315)
+
+/* Private function prototypes */
+static int16_t dew_point(uint32_t vapour_pressure);
+static int16_t heat_index(int32_t temp_x100, uint32_t humidity_x100);
+static uint32_t saturation_vapour_pressure(int32_t temp_x100);
+
+/* Private variables */
+
+/* Magnus saturation vapour pressure over water in mPa, from -80 C to 125 C */
+static const uint32_t svp_table[PSYCHRO_TABLE_LENGTH] = {
+    108, 127, 148, 173, 202, 236, 274, 318,
+    368, 426, 492, 567, 653, 750, 860, 986,
+    1127, 1287, 1468, 1671, 1901, 2158, 2447, 2771,
+    3134, 3539, 3992, 4497, 5060, 5686, 6382, 7155,
+    8011, 8960, 10010, 11171, 12452, 13865, 15423, 17137,
+    19021, 21092, 23364, 25855, 28584, 31571, 34836, 38403,
+    42297, 46543, 51169, 56205, 61683, 67636, 74102, 81117,
+    88723, 96964, 105885, 115534, 125965, 137232, 149392, 162508,
+    176645, 191871, 208259, 225886, 244833, 265184, 287031, 310468,
+    335593, 362514, 391339, 422185, 455173, 490431, 528093, 568301,
+    611200, 656946, 705700, 757632, 812918, 871743, 934300, 1000793,
+    1071430, 1146433, 1226030, 1310462, 1399976, 1494834, 1595306, 1701672,
+    1814226, 1933273, 2059129, 2192122, 2332596, 2480904, 2637415, 2802511,
+    2976588, 3160057, 3353343, 3556889, 3771149, 3996598, 4233724, 4483033,
+    4745050, 5020314, 5309386, 5612842, 5931279, 6265314, 6615581, 6982737,
+    7367458, 7770442, 8192406, 8634094, 9096266, 9579710, 10085234, 10613672,
+    11165880, 11742740, 12345158, 12974067, 13630424, 14315214, 15029448, 15774163,
+    16550428, 17359335, 18202007, 19079598, 19993287, 20944289, 21933843, 22963224,
+    24033735, 25146714, 26303529, 27505581, 28754305, 30051169, 31397675, 32795361,
+    34245797, 35750593, 37311389, 38929867, 40607743, 42346769, 44148737, 46015477,
+    47948855, 49950778, 52023192, 54168084, 56387477, 58683439, 61058077, 63513540,
+    66052018, 68675743, 71386990, 74188079, 77081369, 80069267, 83154220, 86338724,
+    89625316, 93016579, 96515143, 100123682, 103844918, 107681619, 111636598, 115712717,
+    119912885, 124240061, 128697247, 133287499, 138013918, 142879656, 147887913, 153041939,
+    158345035, 163800550, 169411885, 175182491, 181115870, 187215575, 193485211, 199928434,
+    206548950, 213350521, 220336958, 227512126, 234879941, 242444373
+};
+
+/**
+ * \brief Find the temperature at which the vapour pressure saturates, by searching the table and
+ * interpolating between two entries
+ *
+ * \param[in] vapour_pressure       vapour pressure in mPa
+ *
+ * \return dew point in 0.01 degrees C, clamped to the range of the table
+ */
+static int16_t dew_point(uint32_t vapour_pressure)
+{
+    uint32_t low = 0;
+    uint32_t high = PSYCHRO_TABLE_LENGTH - 1;
+
+    if(vapour_pressure <= svp_table[low])
+    {
+        return PSYCHRO_TABLE_MIN_x100;
+    }
+    if(vapour_pressure >= svp_table[high])
+    {
+        return PSYCHRO_TABLE_MIN_x100 + high * 100;
+    }
+
+    // svp_table[low] < vapour_pressure < svp_table[high]
+    while(high - low > 1)
+    {
+        uint32_t mid = (low + high) / 2;
+
+        if(svp_table[mid] <= vapour_pressure)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    uint32_t step = svp_table[high] - svp_table[low];
+
+    return PSYCHRO_TABLE_MIN_x100 + low * 100 + ((vapour_pressure - svp_table[low]) * 100 + step / 2) / step;
+}
+
+/**
+ * \brief Compute the heat index with the NOAA algorithm, which works in degrees F
+ *
+ * \param[in] temp_x100             temperature in 0.01 degrees C
+ * \param[in] humidity_x100         relative humidity in 0.01 %RH
+ *
+ * \return heat index in 0.01 degrees C
+ */
+static int16_t heat_index(int32_t temp_x100, uint32_t humidity_x100)
+{
+    float t = temp_x100 * 0.018f + 32.0f;
+    float rh = humidity_x100 * 0.01f;
+    float hi = 0.5f * (t + 61.0f + (t - 68.0f) * 1.2f + rh * 0.094f);
+
+    if((hi + t) * 0.5f >= 80.0f)
+    {
+        hi = -42.379f + 2.04901523f * t + 10.14333127f * rh - 0.22475541f * t * rh - 0.00683783f * t * t
+             - 0.05481717f * rh * rh + 0.00122874f * t * t * rh + 0.00085282f * t * rh * rh
+             - 0.00000199f * t * t * rh * rh;
+
+        if(rh < 13.0f && t >= 80.0f && t <= 112.0f)
+        {
+            hi -= ((13.0f - rh) * 0.25f) * sqrtf((17.0f - fabsf(t - 95.0f)) / 17.0f);
+        }
+        else if(rh > 85.0f && t >= 80.0f && t <= 87.0f)
+        {
+            hi += ((rh - 85.0f) * 0.1f) * ((87.0f - t) * 0.2f);
+        }
+    }
+
+    float hi_x100 = (hi - 32.0f) * (100.0f / 1.8f);
+
+    // The regression is far outside its range at the top of the sensor range
+    if(hi_x100 >= INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if(hi_x100 <= INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t)(hi_x100 + (hi_x100 < 0 ? -0.5f : 0.5f));
+}
+
+/**
+ * \brief Interpolate the saturation vapour pressure from the table
+ *
+ * \param[in] temp_x100             temperature in 0.01 degrees C
+ *
+ * \return saturation vapour pressure in mPa
+ */
+static uint32_t saturation_vapour_pressure(int32_t temp_x100)
+{
+    int32_t offset = temp_x100 - PSYCHRO_TABLE_MIN_x100;
+
+    if(offset <= 0)
+    {
+        return svp_table[0];
+    }
+
+    uint32_t i = offset / 100;
+    uint32_t frac = offset % 100;
+
+    if(i >= PSYCHRO_TABLE_LENGTH - 1)
+    {
+        return svp_table[PSYCHRO_TABLE_LENGTH - 1];
+    }
+
+    return svp_table[i] + ((svp_table[i + 1] - svp_table[i]) * frac + 50) / 100;
+}
+
+/**
+ * \brief Compute the dew point, absolute humidity and heat index of a measurement
+ *
+ * \param[in] fixed                 measurement in hundredths, see hs300x_convert_raw_fixed()
+ * \param[out] derived              buffer where the derived values will be placed
+ *
+ * \return void
+ */
+void psychro_compute(const hs300x_fixed_t *fixed, psychro_t *derived)
+{
+    uint32_t saturation = saturation_vapour_pressure(fixed->temp_x100);
+    uint32_t vapour_pressure = (uint32_t)(((uint64_t)saturation * fixed->humidity_x100 + 5000) / 10000);
+
+    // Ideal gas: rho = e * Mw / (R * T)
+    uint64_t kelvin_scaled = (uint64_t)(fixed->temp_x100 + PSYCHRO_ZERO_C_x100) * 10000;
+    uint64_t abs_humidity = ((uint64_t)vapour_pressure * PSYCHRO_WATER_MW_OVER_R_e5 + kelvin_scaled / 2) / kelvin_scaled;
+
+    derived->dew_point_x100 = dew_point(vapour_pressure);
+    derived->abs_humidity_x100 = abs_humidity > UINT16_MAX ? UINT16_MAX : (uint16_t)abs_humidity;
+    derived->heat_index_x100 = heat_index(fixed->temp_x100, fixed->humidity_x100);
+}
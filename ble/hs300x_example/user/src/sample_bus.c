@@ -0,0 +1,168 @@
+/*
+ * sample_bus.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "osal.h"
+#include "sample_bus.h"
+
+#if (SAMPLE_BUS_LENGTH & (SAMPLE_BUS_LENGTH - 1)) != 0
+#error "SAMPLE_BUS_LENGTH must be a power of two"
+#endif
+
+/*
+ * The slot of index i is slots[i % SAMPLE_BUS_LENGTH]. Samples 0 to published - 1 have been published.
+ * claimed is published + 1 while the producer writes the next slot, published otherwise: the sample
+ * SAMPLE_BUS_LENGTH before the one being written is no longer intact from the moment the slot is claimed.
+ */
+__RETAINED static hs300x_sample_t slots[SAMPLE_BUS_LENGTH];
+__RETAINED static volatile uint32_t published;
+__RETAINED static volatile uint32_t claimed;
+__RETAINED static sample_bus_consumer_t *consumers[SAMPLE_BUS_MAX_CONSUMERS];
+__RETAINED static volatile uint32_t consumer_count;
+
+/**
+ * \brief Initialize the sample bus. Must be called before any other sample_bus API
+ *
+ * \return void
+ */
+void sample_bus_init(void)
+{
+    published = 0;
+    claimed = 0;
+    consumer_count = 0;
+}
+
+/**
+ * \brief Get the number of published samples a consumer has not read yet
+ *
+ * \param[in] consumer          the consumer
+ *
+ * \return number of samples waiting, including any that have been overwritten already
+ */
+uint32_t sample_bus_lag(const sample_bus_consumer_t *consumer)
+{
+    return published - consumer->cursor;
+}
+
+/**
+ * \brief Get the next sample for a consumer, without copying it. Samples the consumer has fallen too far
+ * behind to read are skipped and counted as drops.
+ *
+ * \param[in] consumer          the consumer
+ *
+ * \return the sample in its slot, to be read in place and released with sample_bus_release(). NULL if
+ *         no new sample has been published.
+ */
+const hs300x_sample_t *sample_bus_peek(sample_bus_consumer_t *consumer)
+{
+    uint32_t lag = published - consumer->cursor;
+
+    if(lag == 0)
+    {
+        return NULL;
+    }
+
+    if(lag > consumer->max_lag)
+    {
+        consumer->max_lag = lag;
+    }
+
+    // Indexes wrap, so compare distances rather than values
+    uint32_t oldest = claimed - SAMPLE_BUS_LENGTH;
+    if((int32_t)(consumer->cursor - oldest) < 0)
+    {
+        consumer->drops += oldest - consumer->cursor;
+        consumer->cursor = oldest;
+    }
+
+    // The slot is read after the indexes are
+    __sync_synchronize();
+
+    return &slots[consumer->cursor % SAMPLE_BUS_LENGTH];
+}
+
+/**
+ * \brief Publish a sample to all consumers. The sample is copied once into the next slot, then the
+ * consumers with a task are notified. Never blocks.
+ *
+ * \param[in] sample            sample to publish
+ *
+ * \return void
+ */
+void sample_bus_publish(const hs300x_sample_t *sample)
+{
+    uint32_t index = published;
+
+    // Claim the slot before writing it, so consumers reading the sample it held can tell
+    claimed = index + 1;
+    __sync_synchronize();
+
+    slots[index % SAMPLE_BUS_LENGTH] = *sample;
+
+    __sync_synchronize();
+    published = index + 1;
+
+    for(uint32_t i = 0; i < consumer_count; i++)
+    {
+        if(consumers[i]->task)
+        {
+            OS_TASK_NOTIFY(consumers[i]->task, consumers[i]->notify_mask, OS_NOTIFY_SET_BITS);
+        }
+    }
+}
+
+/**
+ * \brief Release the sample returned by the last sample_bus_peek() and move to the next one
+ *
+ * \param[in] consumer          the consumer
+ *
+ * \return true if the sample was intact for the whole time it was read. false if its slot was reused in
+ *         the meantime: what was read must be discarded, the sample is counted as dropped.
+ */
+bool sample_bus_release(sample_bus_consumer_t *consumer)
+{
+    // The slot has been read before the indexes are checked again
+    __sync_synchronize();
+
+    bool intact = (claimed - consumer->cursor) <= SAMPLE_BUS_LENGTH;
+
+    if(intact)
+    {
+        consumer->received++;
+    }
+    else
+    {
+        consumer->drops++;
+    }
+    consumer->cursor++;
+
+    return intact;
+}
+
+/**
+ * \brief Subscribe a consumer to the bus. It receives the samples published from now on. Subscribe
+ * before the sampling engine is started.
+ *
+ * \param[out] consumer         storage of the consumer
+ * \param[in] name              name of the consumer, for debug only
+ * \param[in] task              task to notify of each new sample, or NULL if the consumer polls
+ * \param[in] notify_mask       notification bits to set in the task
+ *
+ * \return void
+ */
+void sample_bus_subscribe(sample_bus_consumer_t *consumer, const char *name, OS_TASK task, uint32_t notify_mask)
+{
+    OS_ASSERT(consumer_count < SAMPLE_BUS_MAX_CONSUMERS);
+
+    memset(consumer, 0, sizeof(*consumer));
+    consumer->name = name;
+    consumer->task = task;
+    consumer->notify_mask = notify_mask;
+    consumer->cursor = published;
+
+    consumers[consumer_count] = consumer;
+    __sync_synchronize();
+    consumer_count++;
+}
@@ -0,0 +1,120 @@
+/*
+ * sample_history.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "osal.h"
+#include "sample_history.h"
+#include "static_alloc.h"
+
+/* Private variables */
+__RETAINED static hs300x_raw_t history[SAMPLE_HISTORY_LENGTH];
+__RETAINED static uint32_t history_times_ms[SAMPLE_HISTORY_LENGTH];
+__RETAINED static uint32_t history_count;
+__RETAINED static uint32_t history_newest_seq;
+__RETAINED static OS_MUTEX history_mutex;
+__RETAINED static static_mutex_t history_mutex_storage;
+
+/**
+ * \brief Initialize the sample history. Must be called before any other sample_history API
+ *
+ * \return void
+ */
+void sample_history_init(void)
+{
+    history_count = 0;
+    history_newest_seq = 0;
+    STATIC_MUTEX_CREATE(history_mutex, history_mutex_storage);
+}
+
+/**
+ * \brief Add a sample to the history, overwriting the oldest sample when the history is full
+ *
+ * \param[in] sample        sample to add. Sequence numbers are expected to increment by one per sample
+ *
+ * \return void
+ */
+void sample_history_put(const hs300x_sample_t *sample)
+{
+    OS_MUTEX_GET(history_mutex, OS_MUTEX_FOREVER);
+
+    history[sample->seq % SAMPLE_HISTORY_LENGTH] = sample->raw;
+    history_times_ms[sample->seq % SAMPLE_HISTORY_LENGTH] = sample->time_ms;
+    history_newest_seq = sample->seq;
+    if(history_count < SAMPLE_HISTORY_LENGTH)
+    {
+        history_count++;
+    }
+
+    OS_MUTEX_PUT(history_mutex);
+}
+
+/**
+ * \brief Get the range of sequence numbers currently held in the history
+ *
+ * \param[out] oldest_seq   sequence number of the oldest sample available
+ * \param[out] newest_seq   sequence number of the newest sample available
+ *
+ * \return true if the history holds at least one sample, false otherwise
+ */
+bool sample_history_get_range(uint32_t *oldest_seq, uint32_t *newest_seq)
+{
+    OS_MUTEX_GET(history_mutex, OS_MUTEX_FOREVER);
+
+    *newest_seq = history_newest_seq;
+    *oldest_seq = history_newest_seq - history_count + 1;
+    bool available = (history_count > 0);
+
+    OS_MUTEX_PUT(history_mutex);
+
+    return available;
+}
+
+/**
+ * \brief Copy a contiguous block of samples out of the history
+ *
+ * \param[in,out] first_seq     on input, the first sequence number requested. On output, the sequence
+ *                              number of the first sample copied. This is later than requested if the
+ *                              requested samples have already been overwritten.
+ * \param[out] samples          buffer where the conversion codes of the samples will be placed, in
+ *                              sequence number order. Convert them with hs300x_convert_raw_batch().
+ * \param[out] times_ms         buffer where the times the samples were taken will be placed, in ms
+ *                              since boot. NULL if not needed.
+ * \param[in] max_samples       maximum number of samples to copy
+ *
+ * \return number of samples copied. 0 if no samples at or after first_seq are available
+ */
+uint32_t sample_history_read(uint32_t *first_seq, hs300x_raw_t *samples, uint32_t *times_ms, uint32_t max_samples)
+{
+    uint32_t copied = 0;
+
+    OS_MUTEX_GET(history_mutex, OS_MUTEX_FOREVER);
+
+    if(history_count > 0)
+    {
+        uint32_t oldest_seq = history_newest_seq - history_count + 1;
+        uint32_t seq = *first_seq;
+
+        // Sequence numbers wrap, so compare distances rather than values
+        if((int32_t)(seq - oldest_seq) < 0)
+        {
+            seq = oldest_seq;
+        }
+        *first_seq = seq;
+
+        while(copied < max_samples && (int32_t)(history_newest_seq - seq) >= 0)
+        {
+            if(times_ms)
+            {
+                times_ms[copied] = history_times_ms[seq % SAMPLE_HISTORY_LENGTH];
+            }
+            samples[copied++] = history[seq % SAMPLE_HISTORY_LENGTH];
+            seq++;
+        }
+    }
+
+    OS_MUTEX_PUT(history_mutex);
+
+    return copied;
+}
@@ -0,0 +1,84 @@
+/*
+ * sample_publish.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <stdbool.h>
+#include "adv_policy.h"
+#include "alarm.h"
+#include "alarm_service.h"
+#include "distribution.h"
+#include "ess_service.h"
+#include "latency_trace.h"
+#include "sample_history.h"
+#include "sample_publish.h"
+#include "sensor_service.h"
+#include "stream_service.h"
+
+/**
+ * \brief Notify the connected clients of a new sample
+ *
+ * \param[in] services      services to hand the sample to
+ * \param[in] sample        the new sample, already in the sample history
+ *
+ * \return void
+ */
+void sample_publish(const sample_publish_services_t *services, hs300x_sample_t *sample)
+{
+    hs300x_data_t data;
+
+    LATENCY_TRACE_STAMP(sample, LATENCY_STAMP_DEQUEUED);
+
+    // The alarm rules and the distribution read the sample bus. Evaluate the rules before indicating
+    // their changes below.
+    distribution_process_samples();
+    alarm_process_samples();
+
+    // Samples travel as conversion codes, the services need units
+    hs300x_convert_raw(&sample->raw, &data);
+
+    // Each client gets the Measurement Value and Derived Values at its own rate
+    sensor_service_notify_measurement_to_all_connected(services->sensor_service, &data);
+
+    if(services->ess_service)
+    {
+        // The trigger settings decide whether the sample is notified
+        ess_service_update(services->ess_service, &data);
+    }
+
+    if(services->alarm_service)
+    {
+        // The rules were evaluated above, indicate any change
+        bool raised = alarm_service_indicate_changes(services->alarm_service);
+
+#if APP_ADV_POLICY
+        if(raised)
+        {
+            // A client that is not connected learns of the raised alarm sooner
+            adv_policy_boost();
+        }
+#else
+        (void)raised;
+#endif
+    }
+
+    if(services->stream_service)
+    {
+        // The sample is already in the history, stream it to the clients that are up to date
+        stream_service_send_new_samples(services->stream_service);
+
+#if APP_ADV_POLICY
+        // Let the gateway back in before the history overwrites samples it has not acknowledged
+        if(stream_service_get_unacknowledged(services->stream_service) >=
+           SAMPLE_HISTORY_LENGTH * ADV_POLICY_BOOST_BACKLOG_PCT / 100)
+        {
+            adv_policy_boost();
+        }
+#endif
+    }
+
+#if APP_LATENCY_TRACE
+    LATENCY_TRACE_STAMP(sample, LATENCY_STAMP_SENT);
+    latency_trace_record(sample->stamps);
+#endif
+}
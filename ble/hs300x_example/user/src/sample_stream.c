@@ -0,0 +1,269 @@
+/*
+ * sample_stream.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "sample_stream.h"
+
+/* Private function prototypes */
+static size_t cobs_decode(const uint8_t *in, size_t length, uint8_t *out, size_t out_size);
+static size_t cobs_encode(const uint8_t *in, size_t length, uint8_t *out);
+static uint32_t get_le32(const uint8_t *ptr);
+static bool handle_frame(sample_stream_decoder_t *decoder, sample_stream_record_t *record);
+static uint8_t *put_le32(uint8_t *ptr, uint32_t value);
+
+/**
+ * \brief Decode a COBS encoded block
+ *
+ * \param[in] in           encoded block, without delimiters
+ * \param[in] length       length of the encoded block
+ * \param[out] out         buffer where the decoded bytes will be placed
+ * \param[in] out_size     size of out
+ *
+ * \return number of decoded bytes, 0 if the block is not valid COBS or does not fit
+ */
+static size_t cobs_decode(const uint8_t *in, size_t length, uint8_t *out, size_t out_size)
+{
+    size_t read = 0;
+    size_t written = 0;
+
+    while(read < length)
+    {
+        uint8_t code = in[read++];
+
+        if(code == 0 || read + code - 1 > length || written + code - 1 > out_size)
+        {
+            return 0;
+        }
+
+        memcpy(&out[written], &in[read], code - 1);
+        read += code - 1;
+        written += code - 1;
+
+        // A full block of 254 bytes is not followed by an implicit zero, nor is the last block
+        if(code != 0xFF && read < length)
+        {
+            if(written == out_size)
+            {
+                return 0;
+            }
+            out[written++] = 0;
+        }
+    }
+
+    return written;
+}
+
+/**
+ * \brief COBS encode a block of bytes, so the result has no 0x00
+ *
+ * \param[in] in           bytes to encode
+ * \param[in] length       number of bytes to encode
+ * \param[out] out         buffer of at least length + length / 254 + 1 bytes
+ *
+ * \return length of the encoded block
+ */
+static size_t cobs_encode(const uint8_t *in, size_t length, uint8_t *out)
+{
+    size_t code_idx = 0;
+    size_t written = 1;
+    uint8_t code = 1;
+
+    for(size_t i = 0; i < length; i++)
+    {
+        if(in[i] != 0)
+        {
+            out[written++] = in[i];
+            code++;
+        }
+
+        if(in[i] == 0 || code == 0xFF)
+        {
+            out[code_idx] = code;
+            code_idx = written++;
+            code = 1;
+        }
+    }
+    out[code_idx] = code;
+
+    return written;
+}
+
+/**
+ * \brief Read a little endian u32
+ *
+ * \param[in] ptr          first byte
+ *
+ * \return the value
+ */
+static uint32_t get_le32(const uint8_t *ptr)
+{
+    return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+}
+
+/**
+ * \brief Decode the frame collected by the decoder and check it
+ *
+ * \param[in] decoder      decoder holding a complete frame
+ * \param[out] record      buffer where the record will be placed
+ *
+ * \return true if the frame holds a valid record
+ */
+static bool handle_frame(sample_stream_decoder_t *decoder, sample_stream_record_t *record)
+{
+    uint8_t raw[SAMPLE_STREAM_RECORD_SIZE];
+    uint32_t value;
+
+    if(decoder->overflow ||
+       cobs_decode(decoder->frame, decoder->length, raw, sizeof(raw)) != SAMPLE_STREAM_RECORD_SIZE ||
+       raw[0] != SAMPLE_STREAM_RECORD_SAMPLE)
+    {
+        decoder->bad_frames++;
+        return false;
+    }
+
+    uint16_t crc = raw[SAMPLE_STREAM_RECORD_SIZE - 2] | (raw[SAMPLE_STREAM_RECORD_SIZE - 1] << 8);
+    if(crc != sample_stream_crc16(raw, SAMPLE_STREAM_RECORD_SIZE - 2))
+    {
+        decoder->crc_errors++;
+        return false;
+    }
+
+    record->seq = get_le32(&raw[1]);
+    record->time_ms = get_le32(&raw[5]);
+    value = get_le32(&raw[9]);
+    memcpy(&record->humidity_rh_pct, &value, sizeof(value));
+    value = get_le32(&raw[13]);
+    memcpy(&record->temp_deg_c, &value, sizeof(value));
+
+    if(decoder->synced && (int32_t)(record->seq - decoder->last_seq) > 1)
+    {
+        decoder->missing += record->seq - decoder->last_seq - 1;
+    }
+    decoder->last_seq = record->seq;
+    decoder->synced = true;
+    decoder->records++;
+
+    return true;
+}
+
+/**
+ * \brief Write a little endian u32
+ *
+ * \param[out] ptr         where to write the value
+ * \param[in] value        the value
+ *
+ * \return pointer past the value
+ */
+static uint8_t *put_le32(uint8_t *ptr, uint32_t value)
+{
+    ptr[0] = value;
+    ptr[1] = value >> 8;
+    ptr[2] = value >> 16;
+    ptr[3] = value >> 24;
+
+    return ptr + 4;
+}
+
+/**
+ * \brief Compute the CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) of a block
+ *
+ * \param[in] data         bytes to compute the CRC of
+ * \param[in] length       number of bytes
+ *
+ * \return the CRC
+ */
+uint16_t sample_stream_crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for(size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for(int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * \brief Feed one byte of the stream to the decoder
+ *
+ * \param[in] decoder      decoder state
+ * \param[in] byte         next byte of the stream
+ * \param[out] record      buffer where a decoded record will be placed
+ *
+ * \return true if the byte completed a valid record, now in record
+ */
+bool sample_stream_decode_byte(sample_stream_decoder_t *decoder, uint8_t byte, sample_stream_record_t *record)
+{
+    if(byte != 0)
+    {
+        if(decoder->length < sizeof(decoder->frame))
+        {
+            decoder->frame[decoder->length++] = byte;
+        }
+        else
+        {
+            decoder->overflow = true;
+        }
+        return false;
+    }
+
+    // Two delimiters in a row are not a frame
+    bool valid = decoder->length > 0 && handle_frame(decoder, record);
+
+    decoder->length = 0;
+    decoder->overflow = false;
+
+    return valid;
+}
+
+/**
+ * \brief Clear the state and counters of a decoder
+ *
+ * \param[out] decoder     decoder to clear
+ *
+ * \return void
+ */
+void sample_stream_decoder_init(sample_stream_decoder_t *decoder)
+{
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+/**
+ * \brief Encode a record into a frame, ready to be written out
+ *
+ * \param[in] record       record to encode
+ * \param[out] frame       buffer of SAMPLE_STREAM_FRAME_SIZE bytes
+ *
+ * \return length of the frame, delimiters included
+ */
+size_t sample_stream_encode(const sample_stream_record_t *record, uint8_t *frame)
+{
+    uint8_t raw[SAMPLE_STREAM_RECORD_SIZE];
+    uint8_t *ptr = raw;
+    uint32_t value;
+
+    *ptr++ = SAMPLE_STREAM_RECORD_SAMPLE;
+    ptr = put_le32(ptr, record->seq);
+    ptr = put_le32(ptr, record->time_ms);
+    memcpy(&value, &record->humidity_rh_pct, sizeof(value));
+    ptr = put_le32(ptr, value);
+    memcpy(&value, &record->temp_deg_c, sizeof(value));
+    ptr = put_le32(ptr, value);
+
+    uint16_t crc = sample_stream_crc16(raw, ptr - raw);
+    *ptr++ = crc;
+    *ptr++ = crc >> 8;
+
+    frame[0] = 0;
+    size_t length = 1 + cobs_encode(raw, sizeof(raw), &frame[1]);
+    frame[length++] = 0;
+
+    return length;
+}
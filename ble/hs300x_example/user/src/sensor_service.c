@@ -13,10 +13,16 @@
 #include "ble_att.h"
 #include "ble_bufops.h"
 #include "ble_common.h"
+#include "ble_gap.h"
 #include "ble_gatt.h"
 #include "ble_gatts.h"
 #include "ble_storage.h"
 #include "ble_uuid.h"
+#include "calibration.h"
+#include "diag_counters.h"
+#include "distribution.h"
+#include "hotpath_trace.h"
+#include "psychro.h"
 #include "sensor_service.h"
 
 /* Custom sensor service  structure*/
@@ -37,28 +43,83 @@ typedef struct {
         uint16_t measurement_user_desc_h;	        // Measurement Value User Description
         uint16_t measurement_ccc_h;		        // Measurement Value Client Characteristic Configuration Descriptor. Used for notifications
 
+        uint16_t derived_value_h;			// Derived Values Value
+        uint16_t derived_user_desc_h;			// Derived Values User Description
+        uint16_t derived_ccc_h;				// Derived Values Client Characteristic Configuration Descriptor. Used for notifications
+
+        uint16_t calibration_value_h;			// Calibration Value
+        uint16_t calibration_user_desc_h;		// Calibration User Description
+
+        uint16_t distribution_value_h;			// Distribution Value
+        uint16_t distribution_user_desc_h;		// Distribution User Description
+
+        uint32_t engine_sample_rate_ms;		        // Rate the sampling engine runs at. All per connection rates are multiples of it
+
 } sensor_service_t;
 
 
 /* Private function prototypes */
+static att_error_t calibration_att_error(calibration_error_t error);
 static void cleanup(ble_service_t *svc);
-static void handle_measurement_ccc_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt);
-static att_error_t handle_measurement_ccc_write(sensor_service_t *sample_service_handle, const ble_evt_gatts_write_req_t *evt);
+static void handle_calibration_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_calibration_write(sensor_service_t *sensor_service_handle, const ble_evt_gatts_write_req_t *evt);
+static void handle_ccc_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_ccc_write(sensor_service_t *sample_service_handle, const ble_evt_gatts_write_req_t *evt);
+static void handle_disconnected_evt(ble_service_t *svc, const ble_evt_gap_disconnected_t *evt);
+static void handle_distribution_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_distribution_write(sensor_service_t *sensor_service_handle, const ble_evt_gatts_write_req_t *evt);
 static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt);
 static void handle_sample_rate_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt);
 static att_error_t handle_sample_rate_write(sensor_service_t *sensor_service_handle, const ble_evt_gatts_write_req_t *evt);
 static void handle_sensor_id_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt);
 static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt);
+static uint32_t required_sample_rate(sensor_service_t *sensor_service_handle, uint16_t excluded_conn_idx);
+static void send_derived(sensor_service_t *sensor_service_handle, uint16_t conn_idx, const hs300x_data_t *value);
 
 /* Service Constants */
 static const char sensor_id_char_user_description[]  = "Sensor ID";
 static const char sample_rate_char_user_description[]  = "Sample Rate";
 static const char measurement_value_char_user_description[]  = "Measurement Value";
+static const char derived_value_char_user_description[]  = "Derived Values";
+static const char calibration_char_user_description[]  = "Calibration";
+static const char distribution_char_user_description[]  = "Distribution";
 
 /* Service Defines */
 #define SENSOR_ID_CHAR_SIZE 			sizeof(uint32_t)
 #define SAMPLE_RATE_CHAR_SIZE 			sizeof(uint32_t)
 #define MEASUREMENT_VALUE_CHAR_SIZE 	sizeof(hs300x_data_t)
+#define DERIVED_VALUE_CHAR_SIZE 	(3 * sizeof(uint16_t))
+
+/* Distribution write commands */
+#define DISTRIBUTION_CMD_RESET		(0x01)	// Clear the distribution
+#define DISTRIBUTION_CMD_SET_THRESHOLD	(0x02)	// Followed by the humidity threshold in %RH
+
+/* Private variables */
+__RETAINED static sensor_service_t sensor_service;
+
+/**
+ * \brief Map the outcome of a calibration write to the error reported to the client
+ *
+ * \param[in] error          outcome of the write
+ *
+ * \return att_error_t to respond with
+ */
+static att_error_t calibration_att_error(calibration_error_t error)
+{
+	switch (error)
+	{
+	case CALIBRATION_ERROR_NONE:
+		return ATT_ERROR_OK;
+	case CALIBRATION_ERROR_LENGTH:
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	case CALIBRATION_ERROR_INVALID:
+		return ATT_ERROR_OUT_OF_RANGE;
+	case CALIBRATION_ERROR_SENSOR_ID:
+		return ATT_ERROR_APPLICATION_ERROR;
+	default:
+		return ATT_ERROR_UNLIKELY;
+	}
+}
 
 /**
  * \brief Service cleanup function.
@@ -72,38 +133,100 @@ static void cleanup(ble_service_t *svc)
 	sensor_service_t *sensor_service_handle = (sensor_service_t *) svc;
 
 	ble_storage_remove_all(sensor_service_handle->measurement_ccc_h);
+	ble_storage_remove_all(sensor_service_handle->derived_ccc_h);
+}
+
+/**
+ * \brief This function is called when their is a read request for the Calibration. The value is longer
+ * than the default ATT MTU, clients that have not exchanged a larger MTU read it with Read Blob requests.
+ *
+ * \param[in] sensor_service_handle         pointer sensor service handle
+ * \param[in] evt          		    pointer to the read request
+ *
+ * \return void
+ */
+static void handle_calibration_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	calibration_t calibration;
+	uint8_t value[CALIBRATION_ENCODED_MAX_SIZE];
+	uint16_t length;
+
+	calibration_get(&calibration);
+	length = calibration_encode(&calibration, value);
+
+	if (evt->offset > length)
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_INVALID_OFFSET, 0, NULL);
+		return;
+	}
 
-	OS_FREE(sensor_service_handle);
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, length - evt->offset, value + evt->offset);
 }
 
 /**
- * \brief This function is called when their is a read request for the Measurement Value Characteristic CCC
+ * \brief This function is called when their is a write request for the Calibration. The calibration is
+ * checked, stored and applied from the next measurement before the write is confirmed.
+ *
+ * \param[in] sensor_service_handle         pointer sensor service handle
+ * \param[in] evt          	            pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_calibration_write(sensor_service_t *sensor_service_handle, const ble_evt_gatts_write_req_t *evt)
+{
+	calibration_t calibration;
+	att_error_t error;
+
+	// The whole calibration must be written at once, so a client needs an MTU that fits it
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+
+	error = calibration_att_error(calibration_decode(evt->value, evt->length, &calibration));
+	if(error == ATT_ERROR_OK)
+	{
+		error = calibration_att_error(calibration_set(&calibration));
+	}
+
+	if(error == ATT_ERROR_OK)
+	{
+		ble_gatts_write_cfm(evt->conn_idx, evt->handle, error);
+	}
+
+	return error;
+}
+
+/**
+ * \brief This function is called when their is a read request for the Measurement Value or Derived Values
+ * Characteristic CCC
  *
  * \param[in] sensor_service_handle         pointer sensor service handle
  * \param[in] evt          		    pointer to the read request
  *
  * \return void
  */
-static void handle_measurement_ccc_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt)
+static void handle_ccc_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt)
 {
 	uint16_t ccc = 0x0000;
 
-	// Extract the CCC value from the ble storage
-	ble_storage_get_u16(evt->conn_idx, sensor_service_handle->measurement_ccc_h, &ccc);
+	// Extract the CCC value from the ble storage, where it is kept under its own handle
+	ble_storage_get_u16(evt->conn_idx, evt->handle, &ccc);
 
 	// Send a read confirmation with the value from storage
 	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, sizeof(ccc), &ccc);
 }
 
 /**
- * \brief This function is called when their is a write request for the Measurement Value Characteristic CCC
+ * \brief This function is called when their is a write request for the Measurement Value or Derived Values
+ * Characteristic CCC
  *
  * \param[in] sensor_service_handle         pointer sensor service handle
  * \param[in] evt          	            pointer to the write request
  *
  * \return att_error_t indicating the status of the request.
  */
-static att_error_t handle_measurement_ccc_write(sensor_service_t *sample_service_handle, const ble_evt_gatts_write_req_t *evt)
+static att_error_t handle_ccc_write(sensor_service_t *sample_service_handle, const ble_evt_gatts_write_req_t *evt)
 {
 	att_error_t error = ATT_ERROR_OK;
 
@@ -121,10 +244,98 @@ static att_error_t handle_measurement_ccc_write(sensor_service_t *sample_service
 		uint16_t ccc = get_u16(evt->value);
 
 		// Store the CCC value to ble storage
-		ble_storage_put_u32(evt->conn_idx, sample_service_handle->measurement_ccc_h, ccc, true);
+		ble_storage_put_u32(evt->conn_idx, evt->handle, ccc, true);
 
 		// Respond to the write requst
-		ble_gatts_write_cfm(evt->conn_idx, sample_service_handle->measurement_ccc_h, error);
+		ble_gatts_write_cfm(evt->conn_idx, evt->handle, error);
+	}
+
+	return error;
+}
+
+/**
+ * \brief This function is called when a client disconnects. The sample rate requested by the client
+ * no longer applies.
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the disconnected event
+ *
+ * \return void
+ */
+static void handle_disconnected_evt(ble_service_t *svc, const ble_evt_gap_disconnected_t *evt)
+{
+	sensor_service_t *sensor_service_handle = (sensor_service_t *) svc;
+
+	if(sensor_service_handle->cb && sensor_service_handle->cb->sample_rate_required_cb)
+	{
+		sensor_service_handle->cb->sample_rate_required_cb(svc, required_sample_rate(sensor_service_handle, evt->conn_idx));
+	}
+}
+
+/**
+ * \brief This function is called when their is a read request for the Distribution. The summary is
+ * computed from the samples since the last reset.
+ *
+ * \param[in] sensor_service_handle         pointer sensor service handle
+ * \param[in] evt          		    pointer to the read request
+ *
+ * \return void
+ */
+static void handle_distribution_read(sensor_service_t *sensor_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	distribution_summary_t summary;
+	uint8_t value[DISTRIBUTION_SUMMARY_SIZE];
+	uint16_t length;
+
+	distribution_get_summary(&summary);
+	length = distribution_encode_summary(&summary, value);
+
+	if (evt->offset > length)
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_INVALID_OFFSET, 0, NULL);
+		return;
+	}
+
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, length - evt->offset, value + evt->offset);
+}
+
+/**
+ * \brief This function is called when their is a write request for the Distribution: a command to reset
+ * it or to set the humidity threshold of the summary
+ *
+ * \param[in] sensor_service_handle         pointer sensor service handle
+ * \param[in] evt          	            pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_distribution_write(sensor_service_t *sensor_service_handle, const ble_evt_gatts_write_req_t *evt)
+{
+	att_error_t error = ATT_ERROR_OK;
+
+	// Verify the write request is valid
+	if(evt->offset)
+	{
+		error = ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+	else if(evt->length == 1 && evt->value[0] == DISTRIBUTION_CMD_RESET)
+	{
+		distribution_reset();
+	}
+	else if(evt->length == 2 && evt->value[0] == DISTRIBUTION_CMD_SET_THRESHOLD)
+	{
+		if(!distribution_set_threshold(evt->value[1]))
+		{
+			error = ATT_ERROR_OUT_OF_RANGE;
+		}
+	}
+	else
+	{
+		error = ATT_ERROR_REQUEST_NOT_SUPPORTED;
+	}
+
+	if(error == ATT_ERROR_OK)
+	{
+		ble_gatts_write_cfm(evt->conn_idx, evt->handle, error);
 	}
 
 	return error;
@@ -155,9 +366,17 @@ static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *
 	{
 		handle_sample_rate_read(sensor_service_handle, evt);
 	}
-	else if(evt->handle == sensor_service_handle->measurement_ccc_h )
+	else if(evt->handle == sensor_service_handle->measurement_ccc_h || evt->handle == sensor_service_handle->derived_ccc_h)
+	{
+		handle_ccc_read(sensor_service_handle, evt);
+	}
+	else if(evt->handle == sensor_service_handle->calibration_value_h)
 	{
-		handle_measurement_ccc_read(sensor_service_handle, evt);
+		handle_calibration_read(sensor_service_handle, evt);
+	}
+	else if(evt->handle == sensor_service_handle->distribution_value_h)
+	{
+		handle_distribution_read(sensor_service_handle, evt);
 	}
 	// Otherwise read operations are not permitted
 	else
@@ -225,6 +444,9 @@ static att_error_t handle_sample_rate_write(sensor_service_t *sensor_service_han
 	{
 		uint32_t data = get_u32(evt->value);
 
+		// Each client has its own sample rate. 0 means the client has no requirement.
+		ble_storage_put_u32(evt->conn_idx, sensor_service_handle->sample_rate_value_h, data, false);
+
 		/*
 		 * The application should get the data written by the peer device.
 		 */
@@ -283,9 +505,17 @@ static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t
 	{
 		status = handle_sample_rate_write(sensor_service_handle, evt);
 	}
-	else if(evt->handle == sensor_service_handle->measurement_ccc_h)
+	else if(evt->handle == sensor_service_handle->measurement_ccc_h || evt->handle == sensor_service_handle->derived_ccc_h)
 	{
-		status = handle_measurement_ccc_write(sensor_service_handle, evt);
+		status = handle_ccc_write(sensor_service_handle, evt);
+	}
+	else if(evt->handle == sensor_service_handle->calibration_value_h)
+	{
+		status = handle_calibration_write(sensor_service_handle, evt);
+	}
+	else if(evt->handle == sensor_service_handle->distribution_value_h)
+	{
+		status = handle_distribution_write(sensor_service_handle, evt);
 	}
 
 	/* If the status is anything other than ATT_ERROR_OK, inform the client the write is rejected
@@ -297,6 +527,70 @@ static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t
 	}
 }
 
+/**
+ * \brief Compute the fastest sample rate requested by the connected clients
+ *
+ * \param[in] sensor_service_handle         pointer service handle
+ * \param[in] excluded_conn_idx             connection to ignore, e.g. because it is being disconnected
+ *
+ * \return the fastest requested sample rate in milliseconds, 0 if no client has a requirement
+ */
+static uint32_t required_sample_rate(sensor_service_t *sensor_service_handle, uint16_t excluded_conn_idx)
+{
+	gap_device_t devices[BLE_GAP_MAX_CONNECTED];
+	size_t num_conn = ARRAY_LENGTH(devices);
+	uint32_t required = 0;
+
+	ble_gap_get_devices(GAP_DEVICE_FILTER_CONNECTED, NULL, &num_conn, devices);
+
+	while ((num_conn--) > 0)
+	{
+		uint32_t rate = 0;
+
+		if (devices[num_conn].conn_idx != excluded_conn_idx &&
+		    ble_storage_get_u32(devices[num_conn].conn_idx, sensor_service_handle->sample_rate_value_h, &rate) == BLE_STATUS_OK &&
+		    rate != 0 && (required == 0 || rate < required))
+		{
+			required = rate;
+		}
+	}
+
+	return required;
+}
+
+/**
+ * \brief Compute the dew point, absolute humidity and heat index of a measurement and notify them
+ *
+ * \param[in] sensor_service_handle         pointer service handle
+ * \param[in] conn_idx                      connection index of the client to send notification to
+ * \param[in] value                         measurement value the derived values are computed from
+ *
+ * \return void
+ */
+static void send_derived(sensor_service_t *sensor_service_handle, uint16_t conn_idx, const hs300x_data_t *value)
+{
+	hs300x_fixed_t fixed;
+	psychro_t derived;
+	uint8_t pdu[DERIVED_VALUE_CHAR_SIZE];
+	uint8_t *ptr = pdu;
+
+	// Round to the nearest 0.01 unit
+	fixed.humidity_x100 = (uint16_t)(value->humidity_rh_pct * 100.0f + 0.5f);
+	fixed.temp_x100 = (int16_t)(value->temp_deg_c * 100.0f + (value->temp_deg_c < 0 ? -0.5f : 0.5f));
+	psychro_compute(&fixed, &derived);
+
+	put_u16_inc(&ptr, (uint16_t)derived.dew_point_x100);
+	put_u16_inc(&ptr, derived.abs_humidity_x100);
+	put_u16_inc(&ptr, (uint16_t)derived.heat_index_x100);
+
+	HOTPATH_TRACE_START(send_start);
+	if (ble_gatts_send_event(conn_idx, sensor_service_handle->derived_value_h, GATT_EVENT_NOTIFICATION, sizeof(pdu), pdu) != BLE_STATUS_OK)
+	{
+		DIAG_COUNTER_INC(notify_failures);
+	}
+	HOTPATH_TRACE_STOP(HOTPATH_SITE_NOTIFY_SEND, send_start);
+}
+
 /**
  * \brief This function is called when their is a write request for an attribute in our custom sensor service
  *
@@ -311,22 +605,23 @@ ble_service_t *sensor_service_init(const sensor_service_cb_t *cb)
 	uint16_t num_attr;
 	att_uuid_t uuid;
 
-	// Allocate memory for the service handle
-	sensor_service_handle = (sensor_service_t *) OS_MALLOC(sizeof(sensor_service_t));
+	// The service handle is statically allocated, there is a single instance of the service
+	sensor_service_handle = &sensor_service;
 	memset(sensor_service_handle, 0, sizeof(sensor_service_t));
 
 	// Declare handlers for specific BLE events
 	sensor_service_handle->svc.read_req  = handle_read_req;
 	sensor_service_handle->svc.write_req = handle_write_req;
+	sensor_service_handle->svc.disconnected_evt = handle_disconnected_evt;
 	sensor_service_handle->svc.cleanup   = cleanup;
 	sensor_service_handle->cb = cb;
 
 	/*
 	 * 0 --> Number of Included Services
-	 * 3 --> Number of Characteristic Declarations
-	 * 4 --> Number of Descriptors
+	 * 6 --> Number of Characteristic Declarations
+	 * 8 --> Number of Descriptors
 	 */
-	num_attr = ble_gatts_get_num_attr(0, 3, 4);
+	num_attr = ble_gatts_get_num_attr(0, 6, 8);
 
 	// Service declaration
 	ble_uuid_from_string("00000000-1111-2222-2222-333333333333", &uuid);
@@ -394,6 +689,68 @@ ble_service_t *sensor_service_init(const sensor_service_cb_t *cb)
                                  0,
                                  &sensor_service_handle->measurement_ccc_h);
 
+	// Characteristic declaration for Derived Values
+	ble_uuid_from_string("EEEEEEEE-FFFF-0000-1111-222222222222", &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_NOTIFY,
+	                             ATT_PERM_NONE,
+	                             DERIVED_VALUE_CHAR_SIZE,
+	                             0,
+	                             NULL,
+	                             &sensor_service_handle->derived_value_h);
+
+	// Define descriptor of type Characteristic User Description for Derived Values
+	ble_uuid_create16(UUID_GATT_CHAR_USER_DESCRIPTION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+                                 ATT_PERM_READ,
+                                 sizeof(derived_value_char_user_description)-1, // -1 to account for NULL char
+                                 0,
+                                 &sensor_service_handle->derived_user_desc_h);
+
+	// Define descriptor of type Cleint Characteristic Configuration Descriptor for Derived Values
+	ble_uuid_create16(UUID_GATT_CLIENT_CHAR_CONFIGURATION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+                                 ATT_PERM_RW,
+                                 2,
+                                 0,
+                                 &sensor_service_handle->derived_ccc_h);
+
+	// Characteristic declaration for Calibration
+	ble_uuid_from_string("33333333-4444-5555-6666-777777777777", &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_READ | GATT_PROP_WRITE,
+	                             ATT_PERM_RW,
+	                             CALIBRATION_ENCODED_MAX_SIZE,
+	                             GATTS_FLAG_CHAR_READ_REQ,
+	                             NULL,
+	                             &sensor_service_handle->calibration_value_h);
+
+	// Define descriptor of type Characteristic User Description for Calibration
+	ble_uuid_create16(UUID_GATT_CHAR_USER_DESCRIPTION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+                                 ATT_PERM_READ,
+                                 sizeof(calibration_char_user_description)-1, // -1 to account for NULL char
+                                 0,
+                                 &sensor_service_handle->calibration_user_desc_h);
+
+	// Characteristic declaration for Distribution
+	ble_uuid_from_string("55555555-6666-7777-8888-999999999999", &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_READ | GATT_PROP_WRITE,
+	                             ATT_PERM_RW,
+	                             DISTRIBUTION_SUMMARY_SIZE,
+	                             GATTS_FLAG_CHAR_READ_REQ,
+	                             NULL,
+	                             &sensor_service_handle->distribution_value_h);
+
+	// Define descriptor of type Characteristic User Description for Distribution
+	ble_uuid_create16(UUID_GATT_CHAR_USER_DESCRIPTION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+                                 ATT_PERM_READ,
+                                 sizeof(distribution_char_user_description)-1, // -1 to account for NULL char
+                                 0,
+                                 &sensor_service_handle->distribution_user_desc_h);
+
 	/*
 	 * Register all the attribute handles so that they can be updated
 	 * by the BLE manager automatically.
@@ -406,6 +763,13 @@ ble_service_t *sensor_service_init(const sensor_service_cb_t *cb)
                                    &sensor_service_handle->measurement_value_h,
                                    &sensor_service_handle->measurement_user_desc_h,
                                    &sensor_service_handle->measurement_ccc_h,
+                                   &sensor_service_handle->derived_value_h,
+                                   &sensor_service_handle->derived_user_desc_h,
+                                   &sensor_service_handle->derived_ccc_h,
+                                   &sensor_service_handle->calibration_value_h,
+                                   &sensor_service_handle->calibration_user_desc_h,
+                                   &sensor_service_handle->distribution_value_h,
+                                   &sensor_service_handle->distribution_user_desc_h,
                                    0);
 
 	// Calculate the last attribute handle of the BLE service
@@ -424,6 +788,18 @@ ble_service_t *sensor_service_init(const sensor_service_cb_t *cb)
 	                    sizeof(measurement_value_char_user_description)-1,
 	                    measurement_value_char_user_description);
 
+	ble_gatts_set_value(sensor_service_handle->derived_user_desc_h,
+	                    sizeof(derived_value_char_user_description)-1,
+	                    derived_value_char_user_description);
+
+	ble_gatts_set_value(sensor_service_handle->calibration_user_desc_h,
+	                    sizeof(calibration_char_user_description)-1,
+	                    calibration_char_user_description);
+
+	ble_gatts_set_value(sensor_service_handle->distribution_user_desc_h,
+	                    sizeof(distribution_char_user_description)-1,
+	                    distribution_char_user_description);
+
 	// Register the BLE service in BLE framework
 	ble_service_add(&sensor_service_handle->svc);
 
@@ -468,7 +844,30 @@ void sensor_service_get_sensor_id_cfm(ble_service_t *svc, uint16_t conn_idx, att
 
 
 /**
- * \brief This function should be called by the application to notify a client of a new Measurement Value
+ * \brief Check whether a client has notifications enabled on the Measurement Value or Derived Values,
+ * whether it wrote the CCC on this connection or it was stored when the client bonded
+ *
+ * \param[in] svc         	pointer to service handle
+ * \param[in] conn_idx          connection index of the client
+ *
+ * \return true if notifications are enabled on either characteristic
+ */
+bool sensor_service_notifications_enabled(ble_service_t *svc, uint16_t conn_idx)
+{
+	sensor_service_t *sensor_service_handle = (sensor_service_t *) svc;
+	uint16_t ccc = 0x0000;
+	uint16_t derived_ccc = 0x0000;
+
+	ble_storage_get_u16(conn_idx, sensor_service_handle->measurement_ccc_h, &ccc);
+	ble_storage_get_u16(conn_idx, sensor_service_handle->derived_ccc_h, &derived_ccc);
+
+	return ((ccc | derived_ccc) & GATT_CCC_NOTIFICATIONS) != 0;
+}
+
+/**
+ * \brief This function should be called by the application to notify a client of a new Measurement Value.
+ * Clients that enabled notifications of the Derived Values also receive the dew point, absolute humidity
+ * and heat index computed from it, at the same rate.
  *
  * \param[in] svc         	pointer to service handle
  * \param[in] conn_idx          connection index of the client to send notification to
@@ -481,16 +880,53 @@ void sensor_service_notify_measurement(ble_service_t *svc, uint16_t conn_idx, co
 	sensor_service_t *sensor_service_handle = (sensor_service_t *) svc;
 
 	uint16_t ccc = 0x0000;
+	uint16_t derived_ccc = 0x0000;
 
 	ble_storage_get_u16(conn_idx, sensor_service_handle->measurement_ccc_h, &ccc);
+	ble_storage_get_u16(conn_idx, sensor_service_handle->derived_ccc_h, &derived_ccc);
 
 	/*
 	 * Check if the notifications are enabled from the peer device,
 	 * otherwise don't send anything.
 	 */
-	if (ccc & GATT_CCC_NOTIFICATIONS)
+	if ((ccc | derived_ccc) & GATT_CCC_NOTIFICATIONS)
 	{
-		ble_gatts_send_event(conn_idx, sensor_service_handle->measurement_value_h, GATT_EVENT_NOTIFICATION, MEASUREMENT_VALUE_CHAR_SIZE, (uint8_t *)value);
+		uint32_t rate = 0;
+
+		/*
+		 * Clients asking for a slower rate than the sampling engine runs at only receive every Nth sample.
+		 * Half an engine period of tolerance keeps a rate that is a multiple of the engine rate from slipping
+		 * by a sample due to scheduling jitter.
+		 */
+		ble_storage_get_u32(conn_idx, sensor_service_handle->sample_rate_value_h, &rate);
+		if (rate > sensor_service_handle->engine_sample_rate_ms)
+		{
+			uint32_t last_sent = 0;
+			OS_TICK_TIME now = OS_GET_TICK_COUNT();
+
+			if (ble_storage_get_u32(conn_idx, sensor_service_handle->measurement_value_h, &last_sent) == BLE_STATUS_OK &&
+			    OS_TICKS_2_MS(now - last_sent) + sensor_service_handle->engine_sample_rate_ms / 2 < rate)
+			{
+				return;
+			}
+
+			ble_storage_put_u32(conn_idx, sensor_service_handle->measurement_value_h, now, false);
+		}
+
+		if (ccc & GATT_CCC_NOTIFICATIONS)
+		{
+			HOTPATH_TRACE_START(send_start);
+			if (ble_gatts_send_event(conn_idx, sensor_service_handle->measurement_value_h, GATT_EVENT_NOTIFICATION, MEASUREMENT_VALUE_CHAR_SIZE, (uint8_t *)value) != BLE_STATUS_OK)
+			{
+				DIAG_COUNTER_INC(notify_failures);
+			}
+			HOTPATH_TRACE_STOP(HOTPATH_SITE_NOTIFY_SEND, send_start);
+		}
+
+		if (derived_ccc & GATT_CCC_NOTIFICATIONS)
+		{
+			send_derived(sensor_service_handle, conn_idx, value);
+		}
 	}
 }
 
@@ -504,20 +940,62 @@ void sensor_service_notify_measurement(ble_service_t *svc, uint16_t conn_idx, co
  */
 void sensor_service_notify_measurement_to_all_connected(ble_service_t *svc, const hs300x_data_t *value)
 {
-	uint8_t num_conn;
-	uint16_t *conn_idx_array;
+	gap_device_t devices[BLE_GAP_MAX_CONNECTED];
+	size_t num_conn = ARRAY_LENGTH(devices);
 
-	ble_gap_get_connected(&num_conn, &conn_idx_array);
+	// Fills the array on the stack, unlike ble_gap_get_connected() which allocates one per call
+	ble_gap_get_devices(GAP_DEVICE_FILTER_CONNECTED, NULL, &num_conn, devices);
 
 	while ((num_conn--) > 0)
 	{
-		sensor_service_notify_measurement(svc, conn_idx_array[num_conn], value);
+		sensor_service_notify_measurement(svc, devices[num_conn].conn_idx, value);
 	}
+}
 
-	if (conn_idx_array)
-	{
-		OS_FREE(conn_idx_array);
-	}
+/**
+ * \brief Get the sample rate requested by a client
+ *
+ * \param[in] svc         	pointer to service handle
+ * \param[in] conn_idx          connection index of the client
+ *
+ * \return the sample rate in milliseconds, 0 if the client has not requested one
+ */
+uint32_t sensor_service_get_conn_sample_rate(ble_service_t *svc, uint16_t conn_idx)
+{
+	sensor_service_t *sensor_service_handle = (sensor_service_t *) svc;
+	uint32_t rate = 0;
+
+	ble_storage_get_u32(conn_idx, sensor_service_handle->sample_rate_value_h, &rate);
+
+	return rate;
+}
+
+/**
+ * \brief Get the fastest sample rate requested by any connected client. The sampling engine should run
+ * at this rate.
+ *
+ * \param[in] svc         	pointer to service handle
+ *
+ * \return the sample rate in milliseconds, 0 if no client has requested one
+ */
+uint32_t sensor_service_get_required_sample_rate(ble_service_t *svc)
+{
+	return required_sample_rate((sensor_service_t *) svc, BLE_CONN_IDX_INVALID);
+}
+
+/**
+ * \brief This function should be called by the application when the sampling engine rate changes
+ *
+ * \param[in] svc         	pointer to service handle
+ * \param[in] rate_ms           rate of the sampling engine in milliseconds
+ *
+ * \return void
+ */
+void sensor_service_set_engine_sample_rate(ble_service_t *svc, uint32_t rate_ms)
+{
+	sensor_service_t *sensor_service_handle = (sensor_service_t *) svc;
+
+	sensor_service_handle->engine_sample_rate_ms = rate_ms;
 }
 
 /**
@@ -0,0 +1,846 @@
+/*
+ * stream_service.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "osal.h"
+#include "ble_att.h"
+#include "ble_bufops.h"
+#include "ble_common.h"
+#include "ble_gap.h"
+#include "ble_gatt.h"
+#include "ble_gattc.h"
+#include "ble_gatts.h"
+#include "ble_storage.h"
+#include "ble_uuid.h"
+#include "diag_counters.h"
+#include "sample_history.h"
+#include "stream_service.h"
+#include "time_sync.h"
+
+/* Default ATT MTU, used until the client exchanges a larger one */
+#define STREAM_SERVICE_DEFAULT_MTU              (23)
+
+/* Stream state of a connection. Only used from the BLE task, so no locking is needed. */
+typedef struct {
+        bool in_use;
+        bool streaming;                         // Notifications enabled, the history is sent from next_seq
+        bool backlog;                           // Draining a backlog, see STREAM_SERVICE_BACKLOG_SAMPLES
+        uint16_t conn_idx;
+        uint32_t next_seq;                      // Sequence number of the next sample to send
+        uint8_t in_flight;                      // Notifications handed to the stack and not yet sent
+        bool timing;                            // Timing the transfer from the start of the stream
+        uint32_t start_ms;                      // Local time the stream started
+        stream_service_transfer_t transfer;     // Sent since the stream started
+} stream_conn_t;
+
+/* Stream service structure */
+typedef struct {
+        ble_service_t svc;
+
+        // Attribute handles of BLE service
+        uint16_t stream_value_h;                // Sample Stream Value, also the storage key of the acknowledgement
+        uint16_t stream_user_desc_h;            // Sample Stream User Description
+        uint16_t stream_ccc_h;                  // Sample Stream Client Characteristic Configuration Descriptor
+
+        uint16_t time_value_h;                  // Time Value
+        uint16_t time_user_desc_h;              // Time User Description
+
+        stream_conn_t conns[BLE_GAP_MAX_CONNECTED];
+
+        const stream_service_cb_t *cb;          // Application callbacks, NULL if none
+
+        bool acked;                             // A client acknowledged samples since boot
+        uint32_t latest_ack;                    // Latest acknowledgement written by any client
+
+        bool transferred;                       // A backlog has been sent since boot
+        stream_service_transfer_t last_transfer;        // Latest backlog sent, see stream_service_get_last_transfer()
+} stream_service_t;
+
+
+/* Private function prototypes */
+static void cleanup(ble_service_t *svc);
+static stream_conn_t *find_conn(stream_service_t *stream_service_handle, uint16_t conn_idx, bool allocate);
+static void handle_ccc_read(stream_service_t *stream_service_handle, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_ccc_write(stream_service_t *stream_service_handle, const ble_evt_gatts_write_req_t *evt);
+static void handle_connected_evt(ble_service_t *svc, const ble_evt_gap_connected_t *evt);
+static void handle_disconnected_evt(ble_service_t *svc, const ble_evt_gap_disconnected_t *evt);
+static void handle_event_sent(ble_service_t *svc, const ble_evt_gatts_event_sent_t *evt);
+static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt);
+static void handle_stream_read(stream_service_t *stream_service_handle, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_stream_write(stream_service_t *stream_service_handle, const ble_evt_gatts_write_req_t *evt);
+static void handle_time_read(stream_service_t *stream_service_handle, const ble_evt_gatts_read_req_t *evt);
+static att_error_t handle_time_write(stream_service_t *stream_service_handle, const ble_evt_gatts_write_req_t *evt);
+static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt);
+static void send_samples(stream_service_t *stream_service_handle, stream_conn_t *conn);
+static void set_backlog(stream_service_t *stream_service_handle, stream_conn_t *conn, bool draining);
+static void start_stream(stream_service_t *stream_service_handle, uint16_t conn_idx);
+
+/* Service Constants */
+static const char stream_char_user_description[]  = "Sample Stream";
+static const char time_char_user_description[]    = "Time";
+
+/* Private variables */
+__RETAINED static stream_service_t stream_service;
+
+/**
+ * \brief Service cleanup function.
+ *
+ * \param[in] svc          pointer BLE service
+ *
+ * \return void
+ */
+static void cleanup(ble_service_t *svc)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+
+	ble_storage_remove_all(stream_service_handle->stream_ccc_h);
+	ble_storage_remove_all(stream_service_handle->stream_value_h);
+}
+
+/**
+ * \brief Find the stream state of a connection
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] conn_idx                  connection index
+ * \param[in] allocate                  allocate a cleared state if the connection has none
+ *
+ * \return pointer to the state, NULL if not found
+ */
+static stream_conn_t *find_conn(stream_service_t *stream_service_handle, uint16_t conn_idx, bool allocate)
+{
+	stream_conn_t *free_conn = NULL;
+
+	for (int i = 0; i < BLE_GAP_MAX_CONNECTED; i++)
+	{
+		stream_conn_t *conn = &stream_service_handle->conns[i];
+
+		if (conn->in_use && conn->conn_idx == conn_idx)
+		{
+			return conn;
+		}
+		if (!conn->in_use && !free_conn)
+		{
+			free_conn = conn;
+		}
+	}
+
+	if (!allocate || !free_conn)
+	{
+		return NULL;
+	}
+
+	memset(free_conn, 0, sizeof(*free_conn));
+	free_conn->in_use = true;
+	free_conn->conn_idx = conn_idx;
+
+	return free_conn;
+}
+
+/**
+ * \brief This function is called when their is a read request for the Sample Stream CCC
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_ccc_read(stream_service_t *stream_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	uint16_t ccc = 0x0000;
+
+	// Extract the CCC value from the ble storage
+	ble_storage_get_u16(evt->conn_idx, stream_service_handle->stream_ccc_h, &ccc);
+
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, sizeof(ccc), &ccc);
+}
+
+/**
+ * \brief This function is called when their is a write request for the Sample Stream CCC. Enabling
+ * notifications starts the stream after the acknowledgement, disabling them stops it.
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] evt                       pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_ccc_write(stream_service_t *stream_service_handle, const ble_evt_gatts_write_req_t *evt)
+{
+	uint16_t ccc;
+
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+	if(evt->length != sizeof(uint16_t))
+	{
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	}
+
+	ccc = get_u16(evt->value);
+	ble_storage_put_u32(evt->conn_idx, stream_service_handle->stream_ccc_h, ccc, true);
+	ble_gatts_write_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK);
+
+	if (ccc & GATT_CCC_NOTIFICATIONS)
+	{
+		start_stream(stream_service_handle, evt->conn_idx);
+	}
+	else
+	{
+		stream_conn_t *conn = find_conn(stream_service_handle, evt->conn_idx, false);
+
+		if (conn)
+		{
+			conn->streaming = false;
+			set_backlog(stream_service_handle, conn, false);
+		}
+	}
+
+	return ATT_ERROR_OK;
+}
+
+/**
+ * \brief This function is called when a client connects. A bonded client that left notifications
+ * enabled gets the samples it missed without writing the CCC again.
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the connected event
+ *
+ * \return void
+ */
+static void handle_connected_evt(ble_service_t *svc, const ble_evt_gap_connected_t *evt)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+	uint16_t ccc = 0x0000;
+
+	ble_storage_get_u16(evt->conn_idx, stream_service_handle->stream_ccc_h, &ccc);
+	if (ccc & GATT_CCC_NOTIFICATIONS)
+	{
+		start_stream(stream_service_handle, evt->conn_idx);
+	}
+}
+
+/**
+ * \brief This function is called when a client disconnects. Its acknowledgement stays in the BLE
+ * storage if it is bonded, the stream state is dropped.
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the disconnected event
+ *
+ * \return void
+ */
+static void handle_disconnected_evt(ble_service_t *svc, const ble_evt_gap_disconnected_t *evt)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+	stream_conn_t *conn = find_conn(stream_service_handle, evt->conn_idx, false);
+
+	if (conn)
+	{
+		conn->in_use = false;
+	}
+}
+
+/**
+ * \brief This function is called when a notification has been sent. The stream continues with the
+ * samples not sent yet.
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the event sent event
+ *
+ * \return void
+ */
+static void handle_event_sent(ble_service_t *svc, const ble_evt_gatts_event_sent_t *evt)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+	stream_conn_t *conn = find_conn(stream_service_handle, evt->conn_idx, false);
+
+	if (!conn || evt->handle != stream_service_handle->stream_value_h)
+	{
+		return;
+	}
+
+	if (conn->in_flight)
+	{
+		conn->in_flight--;
+	}
+	send_samples(stream_service_handle, conn);
+}
+
+/**
+ * \brief This function is called when their is a read request for any attribute of the service
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the read request
+ *
+ * \return void
+ */
+static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+
+	if (evt->handle == stream_service_handle->stream_value_h)
+	{
+		handle_stream_read(stream_service_handle, evt);
+	}
+	else if (evt->handle == stream_service_handle->stream_ccc_h)
+	{
+		handle_ccc_read(stream_service_handle, evt);
+	}
+	else if (evt->handle == stream_service_handle->time_value_h)
+	{
+		handle_time_read(stream_service_handle, evt);
+	}
+	// Otherwise read operations are not permitted
+	else
+	{
+		ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_READ_NOT_PERMITTED, 0, NULL);
+	}
+}
+
+/**
+ * \brief This function is called when their is a read request for the Sample Stream. The client gets
+ * its acknowledgement and the range of the history.
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_stream_read(stream_service_t *stream_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	uint8_t value[STREAM_SERVICE_STATUS_SIZE];
+	uint8_t *ptr = value;
+	uint32_t ack = 0;
+	uint32_t oldest_seq;
+	uint32_t newest_seq;
+
+	ble_storage_get_u32(evt->conn_idx, stream_service_handle->stream_value_h, &ack);
+	if (!sample_history_get_range(&oldest_seq, &newest_seq))
+	{
+		oldest_seq = 0;
+		newest_seq = 0;
+	}
+
+	put_u32_inc(&ptr, ack);
+	put_u32_inc(&ptr, oldest_seq);
+	put_u32_inc(&ptr, newest_seq);
+
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, sizeof(value), value);
+}
+
+/**
+ * \brief This function is called when their is a write request for the Sample Stream, the client
+ * acknowledging the samples it received. The acknowledgement decides where the stream starts on the
+ * next connection, the samples sent on this one are not sent again.
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] evt                       pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_stream_write(stream_service_t *stream_service_handle, const ble_evt_gatts_write_req_t *evt)
+{
+	uint32_t ack;
+	uint32_t oldest_seq;
+	uint32_t newest_seq;
+
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+	if(evt->length != sizeof(uint32_t))
+	{
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	}
+
+	ack = get_u32(evt->value);
+	sample_history_get_range(&oldest_seq, &newest_seq);
+
+	// Sequence numbers wrap, so compare distances rather than values
+	if ((int32_t)(ack - newest_seq) > 0)
+	{
+		return ATT_ERROR_OUT_OF_RANGE;
+	}
+
+	// Kept across connections for bonded clients
+	ble_storage_put_u32(evt->conn_idx, stream_service_handle->stream_value_h, ack, true);
+	stream_service_handle->acked = true;
+	stream_service_handle->latest_ack = ack;
+	ble_gatts_write_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK);
+
+	return ATT_ERROR_OK;
+}
+
+/**
+ * \brief This function is called when their is a read request for the Time
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] evt                       pointer to the read request
+ *
+ * \return void
+ */
+static void handle_time_read(stream_service_t *stream_service_handle, const ble_evt_gatts_read_req_t *evt)
+{
+	uint8_t value[STREAM_SERVICE_TIME_SIZE];
+	uint8_t *ptr = value;
+	time_sync_status_t status;
+	uint64_t utc_ms;
+
+	time_sync_to_utc(time_sync_local_ms(), &utc_ms);
+	time_sync_get_status(&status);
+
+	put_u32_inc(&ptr, (uint32_t)utc_ms);
+	put_u32_inc(&ptr, (uint32_t)(utc_ms >> 32));
+	put_u32_inc(&ptr, (uint32_t)status.drift_ppb);
+	put_u16_inc(&ptr, status.syncs);
+
+	ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, sizeof(value), value);
+}
+
+/**
+ * \brief This function is called when their is a write request for the Time. The time applies from
+ * when the request is received, so it is late by the delay over the link.
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] evt                       pointer to the write request
+ *
+ * \return att_error_t indicating the status of the request.
+ */
+static att_error_t handle_time_write(stream_service_t *stream_service_handle, const ble_evt_gatts_write_req_t *evt)
+{
+	uint64_t utc_ms;
+
+	if(evt->offset)
+	{
+		return ATT_ERROR_ATTRIBUTE_NOT_LONG;
+	}
+	if(evt->length != sizeof(uint64_t))
+	{
+		return ATT_ERROR_INVALID_VALUE_LENGTH;
+	}
+
+	utc_ms = get_u32(evt->value) | ((uint64_t)get_u32(evt->value + 4) << 32);
+	if (utc_ms == 0)
+	{
+		return ATT_ERROR_OUT_OF_RANGE;
+	}
+
+	time_sync_set(utc_ms, time_sync_local_ms());
+	ble_gatts_write_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK);
+
+	return ATT_ERROR_OK;
+}
+
+/**
+ * \brief This function is called when their is a write request for an attribute in the service
+ *
+ * \param[in] svc          pointer BLE service
+ * \param[in] evt          pointer to the write request
+ *
+ * \return void
+ */
+static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+	att_error_t status = ATT_ERROR_WRITE_NOT_PERMITTED;
+
+	if (evt->handle == stream_service_handle->stream_ccc_h)
+	{
+		status = handle_ccc_write(stream_service_handle, evt);
+	}
+	else if (evt->handle == stream_service_handle->stream_value_h)
+	{
+		status = handle_stream_write(stream_service_handle, evt);
+	}
+	else if (evt->handle == stream_service_handle->time_value_h)
+	{
+		status = handle_time_write(stream_service_handle, evt);
+	}
+
+	/* If the status is anything other than ATT_ERROR_OK, inform the client the write is rejected.
+	 * Otherwise the write handlers above have already responded. */
+	if (status != ATT_ERROR_OK)
+	{
+		ble_gatts_write_cfm(evt->conn_idx, evt->handle, status);
+	}
+}
+
+/**
+ * \brief Send the samples from next_seq on, packed to the MTU of the connection, until the client
+ * is up to date or STREAM_SERVICE_MAX_IN_FLIGHT notifications are waiting to be sent.
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] conn                      stream state of the connection
+ *
+ * \return void
+ */
+static void send_samples(stream_service_t *stream_service_handle, stream_conn_t *conn)
+{
+	hs300x_raw_t samples[STREAM_SERVICE_MAX_SAMPLES];
+	uint32_t times_ms[STREAM_SERVICE_MAX_SAMPLES];
+	uint8_t value[STREAM_SERVICE_NOTIFICATION_MAX_SIZE];
+	uint16_t mtu = STREAM_SERVICE_DEFAULT_MTU;
+	uint32_t max_samples;
+
+	if (ble_gattc_get_mtu(conn->conn_idx, &mtu) != BLE_STATUS_OK)
+	{
+		mtu = STREAM_SERVICE_DEFAULT_MTU;
+	}
+	if (mtu > STREAM_SERVICE_MAX_MTU)
+	{
+		mtu = STREAM_SERVICE_MAX_MTU;
+	}
+	max_samples = (mtu - STREAM_SERVICE_ATT_HEADER_SIZE - STREAM_SERVICE_HEADER_SIZE) / STREAM_SERVICE_SAMPLE_SIZE;
+
+	while (conn->streaming && conn->in_flight < STREAM_SERVICE_MAX_IN_FLIGHT)
+	{
+		uint32_t first_seq = conn->next_seq;
+		uint32_t count = sample_history_read(&first_seq, samples, times_ms, max_samples);
+		uint8_t *ptr = value;
+		uint64_t first_utc_ms;
+		uint64_t utc_ms;
+
+		if (!count)
+		{
+			if (conn->timing && conn->backlog)
+			{
+				conn->transfer.elapsed_ms = time_sync_local_ms() - conn->start_ms;
+				stream_service_handle->last_transfer = conn->transfer;
+				stream_service_handle->transferred = true;
+			}
+			conn->timing = false;
+			set_backlog(stream_service_handle, conn, false);
+			break;
+		}
+
+		time_sync_to_utc(times_ms[0], &first_utc_ms);
+
+		put_u32_inc(&ptr, first_seq);
+		put_u8_inc(&ptr, count);
+		put_u32_inc(&ptr, (uint32_t)(first_utc_ms / 1000));
+		put_u16_inc(&ptr, (uint16_t)(first_utc_ms % 1000));
+		for (uint32_t i = 0; i < count; i++)
+		{
+			// Offsets follow the drift correction once the time is set
+			if (time_sync_to_utc(times_ms[i], &utc_ms))
+			{
+				put_u32_inc(&ptr, (uint32_t)(utc_ms - first_utc_ms));
+			}
+			else
+			{
+				put_u32_inc(&ptr, times_ms[i] - times_ms[0]);
+			}
+			put_u16_inc(&ptr, samples[i].humidity);
+			put_u16_inc(&ptr, samples[i].temp);
+		}
+
+		// Leave next_seq as it is if the stack is out of buffers, the samples go with the next attempt
+		if (ble_gatts_send_event(conn->conn_idx, stream_service_handle->stream_value_h,
+		                         GATT_EVENT_NOTIFICATION, ptr - value, value) != BLE_STATUS_OK)
+		{
+			DIAG_COUNTER_INC(notify_failures);
+			break;
+		}
+
+		conn->next_seq = first_seq + count;
+		conn->in_flight++;
+		if (conn->timing)
+		{
+			conn->transfer.samples += count;
+			conn->transfer.bytes += STREAM_SERVICE_ATT_HEADER_SIZE + (ptr - value);
+		}
+	}
+
+	if (conn->streaming && conn->in_flight >= STREAM_SERVICE_MAX_IN_FLIGHT && !conn->backlog)
+	{
+		uint32_t oldest_seq;
+		uint32_t newest_seq;
+
+		if (sample_history_get_range(&oldest_seq, &newest_seq) &&
+		    (int32_t)(newest_seq - conn->next_seq) + 1 >= STREAM_SERVICE_BACKLOG_SAMPLES)
+		{
+			set_backlog(stream_service_handle, conn, true);
+		}
+	}
+}
+
+/**
+ * \brief Record whether a connection is draining a backlog, and let the application know of a change
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] conn                      stream state of the connection
+ * \param[in] draining                  true while draining a backlog
+ *
+ * \return void
+ */
+static void set_backlog(stream_service_t *stream_service_handle, stream_conn_t *conn, bool draining)
+{
+	if (conn->backlog == draining)
+	{
+		return;
+	}
+
+	conn->backlog = draining;
+	if (stream_service_handle->cb && stream_service_handle->cb->backlog_changed_cb)
+	{
+		stream_service_handle->cb->backlog_changed_cb(&stream_service_handle->svc, conn->conn_idx, draining);
+	}
+}
+
+/**
+ * \brief Start streaming to a client, after its acknowledgement if it has one, else from the next sample.
+ * An acknowledgement ahead of the history is from before a reboot, the client then gets the whole history.
+ *
+ * \param[in] stream_service_handle     pointer service handle
+ * \param[in] conn_idx                  connection index of the client
+ *
+ * \return void
+ */
+static void start_stream(stream_service_t *stream_service_handle, uint16_t conn_idx)
+{
+	stream_conn_t *conn = find_conn(stream_service_handle, conn_idx, true);
+	uint32_t ack;
+	uint32_t oldest_seq;
+	uint32_t newest_seq;
+
+	// Enabling notifications again while streaming must not send samples twice
+	if (!conn || conn->streaming)
+	{
+		return;
+	}
+
+	// The history is empty before the first sample, newest_seq is then 0 and oldest_seq the first sample 1
+	sample_history_get_range(&oldest_seq, &newest_seq);
+
+	if (ble_storage_get_u32(conn_idx, stream_service_handle->stream_value_h, &ack) != BLE_STATUS_OK)
+	{
+		conn->next_seq = newest_seq + 1;
+	}
+	else if ((int32_t)(ack - newest_seq) > 0)
+	{
+		/*
+		 * An acknowledgement newer than any sample was stored before a reboot restarted the sequence
+		 * numbers, as handle_stream_write() would reject it now. Send everything kept since, and
+		 * store where that starts so a reconnection before the next acknowledgement resumes there.
+		 */
+		conn->next_seq = oldest_seq;
+		ble_storage_put_u32(conn_idx, stream_service_handle->stream_value_h, oldest_seq - 1, true);
+	}
+	else
+	{
+		conn->next_seq = ack + 1;
+	}
+	conn->streaming = true;
+
+	// Time the transfer until the client is up to date, in case this is a backlog
+	conn->timing = true;
+	conn->start_ms = time_sync_local_ms();
+	memset(&conn->transfer, 0, sizeof(conn->transfer));
+
+	send_samples(stream_service_handle, conn);
+}
+
+/**
+ * \brief Initialize the stream service. sample_history_init() and time_sync_init() must have been called.
+ *
+ * \param[in] cb           application callbacks, NULL if none
+ *
+ * \return pointer to the handle created for this service
+ */
+ble_service_t *stream_service_init(const stream_service_cb_t *cb)
+{
+	stream_service_t *stream_service_handle;
+	uint16_t num_attr;
+	att_uuid_t uuid;
+
+	// The service handle is statically allocated, there is a single instance of the service
+	stream_service_handle = &stream_service;
+	memset(stream_service_handle, 0, sizeof(stream_service_t));
+	stream_service_handle->cb = cb;
+
+	// Declare handlers for specific BLE events
+	stream_service_handle->svc.connected_evt    = handle_connected_evt;
+	stream_service_handle->svc.disconnected_evt = handle_disconnected_evt;
+	stream_service_handle->svc.read_req         = handle_read_req;
+	stream_service_handle->svc.write_req        = handle_write_req;
+	stream_service_handle->svc.event_sent       = handle_event_sent;
+	stream_service_handle->svc.cleanup          = cleanup;
+
+	/*
+	 * 0 --> Number of Included Services
+	 * 2 --> Number of Characteristic Declarations
+	 * 3 --> Number of Descriptors
+	 */
+	num_attr = ble_gatts_get_num_attr(0, 2, 3);
+
+	// Service declaration
+	ble_uuid_from_string("BBBBBBBB-1111-2222-3333-444444444444", &uuid);
+	ble_gatts_add_service(&uuid, GATT_SERVICE_PRIMARY, num_attr);
+
+	// Characteristic declaration for Sample Stream
+	ble_uuid_from_string("BBBBBBBB-5555-6666-7777-888888888888", &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_READ | GATT_PROP_WRITE | GATT_PROP_NOTIFY,
+	                             ATT_PERM_RW,
+	                             STREAM_SERVICE_NOTIFICATION_MAX_SIZE,
+	                             GATTS_FLAG_CHAR_READ_REQ,
+	                             NULL,
+	                             &stream_service_handle->stream_value_h);
+
+	// Define descriptor of type Characteristic User Description for Sample Stream
+	ble_uuid_create16(UUID_GATT_CHAR_USER_DESCRIPTION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_READ,
+	                         sizeof(stream_char_user_description)-1, // -1 to account for NULL char
+	                         0,
+	                         &stream_service_handle->stream_user_desc_h);
+
+	// Define descriptor of type Client Characteristic Configuration Descriptor for Sample Stream
+	ble_uuid_create16(UUID_GATT_CLIENT_CHAR_CONFIGURATION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_RW,
+	                         2,
+	                         0,
+	                         &stream_service_handle->stream_ccc_h);
+
+	// Characteristic declaration for Time
+	ble_uuid_from_string("BBBBBBBB-9999-AAAA-CCCC-DDDDDDDDDDDD", &uuid);
+	ble_gatts_add_characteristic(&uuid,
+	                             GATT_PROP_READ | GATT_PROP_WRITE,
+	                             ATT_PERM_RW,
+	                             STREAM_SERVICE_TIME_SIZE,
+	                             GATTS_FLAG_CHAR_READ_REQ,
+	                             NULL,
+	                             &stream_service_handle->time_value_h);
+
+	// Define descriptor of type Characteristic User Description for Time
+	ble_uuid_create16(UUID_GATT_CHAR_USER_DESCRIPTION, &uuid);
+	ble_gatts_add_descriptor(&uuid,
+	                         ATT_PERM_READ,
+	                         sizeof(time_char_user_description)-1, // -1 to account for NULL char
+	                         0,
+	                         &stream_service_handle->time_user_desc_h);
+
+	/*
+	 * Register all the attribute handles so that they can be updated
+	 * by the BLE manager automatically.
+	 */
+	ble_gatts_register_service(&stream_service_handle->svc.start_h,
+	                           &stream_service_handle->stream_value_h,
+	                           &stream_service_handle->stream_user_desc_h,
+	                           &stream_service_handle->stream_ccc_h,
+	                           &stream_service_handle->time_value_h,
+	                           &stream_service_handle->time_user_desc_h,
+	                           0);
+
+	// Calculate the last attribute handle of the BLE service
+	stream_service_handle->svc.end_h = stream_service_handle->svc.start_h + num_attr;
+
+	// Set default values for User Descriptions
+	ble_gatts_set_value(stream_service_handle->stream_user_desc_h,
+	                    sizeof(stream_char_user_description)-1,
+	                    stream_char_user_description);
+
+	ble_gatts_set_value(stream_service_handle->time_user_desc_h,
+	                    sizeof(time_char_user_description)-1,
+	                    time_char_user_description);
+
+	// Register the BLE service in BLE framework
+	ble_service_add(&stream_service_handle->svc);
+
+	// Return the service handle
+	return &stream_service_handle->svc;
+}
+
+/**
+ * \brief Get the latest backlog sent, to compare the throughput of the stream with other transfers. It is
+ * timed from the start of the stream, on a CCC write or a reconnection, until the client is up to date.
+ *
+ * \param[in] svc          pointer to service handle
+ * \param[out] transfer    the transfer
+ *
+ * \return true if a backlog has been sent since boot, false otherwise
+ */
+bool stream_service_get_last_transfer(ble_service_t *svc, stream_service_transfer_t *transfer)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+
+	*transfer = stream_service_handle->last_transfer;
+
+	return stream_service_handle->transferred;
+}
+
+/**
+ * \brief Get the number of samples in the history newer than the latest acknowledgement written by any
+ * client. Samples beyond the size of the history are lost unless a client catches up first.
+ *
+ * \param[in] svc          pointer to service handle
+ *
+ * \return number of samples, 0 if no client has acknowledged samples since boot
+ */
+uint32_t stream_service_get_unacknowledged(ble_service_t *svc)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+	uint32_t oldest_seq;
+	uint32_t newest_seq;
+
+	if (!stream_service_handle->acked || !sample_history_get_range(&oldest_seq, &newest_seq))
+	{
+		return 0;
+	}
+
+	// Sequence numbers wrap, so compare distances rather than values
+	if ((int32_t)(stream_service_handle->latest_ack - oldest_seq) < 0)
+	{
+		return newest_seq - oldest_seq + 1;
+	}
+
+	return newest_seq - stream_service_handle->latest_ack;
+}
+
+/**
+ * \brief Check whether a client has notifications of the Sample Stream enabled, whether it wrote the
+ * CCC on this connection or it was stored when the client bonded
+ *
+ * \param[in] svc          pointer to service handle
+ * \param[in] conn_idx     connection index of the client
+ *
+ * \return true if notifications are enabled
+ */
+bool stream_service_notifications_enabled(ble_service_t *svc, uint16_t conn_idx)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+	uint16_t ccc = 0x0000;
+
+	ble_storage_get_u16(conn_idx, stream_service_handle->stream_ccc_h, &ccc);
+
+	return (ccc & GATT_CCC_NOTIFICATIONS) != 0;
+}
+
+/**
+ * \brief This function should be called by the application after each sample, once it is in the
+ * sample history. Every client that is streaming and up to date gets it, the others get it in turn.
+ *
+ * \param[in] svc          pointer to service handle
+ *
+ * \return void
+ */
+void stream_service_send_new_samples(ble_service_t *svc)
+{
+	stream_service_t *stream_service_handle = (stream_service_t *) svc;
+
+	for (int i = 0; i < BLE_GAP_MAX_CONNECTED; i++)
+	{
+		stream_conn_t *conn = &stream_service_handle->conns[i];
+
+		if (conn->in_use)
+		{
+			send_samples(stream_service_handle, conn);
+		}
+	}
+}
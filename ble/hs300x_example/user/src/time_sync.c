@@ -0,0 +1,164 @@
+/*
+ * time_sync.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include <string.h>
+#include "osal.h"
+#include "static_alloc.h"
+#include "time_sync.h"
+
+/* Private function prototypes */
+static uint64_t to_utc(uint32_t local_ms);
+
+/* Private variables */
+__RETAINED static time_sync_status_t status;
+__RETAINED static uint64_t sync_utc_ms;         // UTC time of the latest setting
+__RETAINED static uint32_t sync_local_ms;       // Local time of the latest setting
+__RETAINED static uint32_t tick_wraps;          // Times the OS tick count wrapped
+__RETAINED static OS_TICK_TIME last_tick;       // OS tick count at the previous time_sync_local_ticks()
+__RETAINED static OS_MUTEX time_sync_mutex;
+__RETAINED static static_mutex_t time_sync_mutex_storage;
+
+/**
+ * \brief Map a local time to UTC from the latest setting. Must be called with the mutex held.
+ *
+ * \param[in] local_ms          local time from time_sync_local_ms()
+ *
+ * \return UTC time in ms since the Unix epoch
+ */
+static uint64_t to_utc(uint32_t local_ms)
+{
+    // Local times wrap, so take the distance from the setting rather than compare values
+    int32_t elapsed = (int32_t)(local_ms - sync_local_ms);
+
+    return sync_utc_ms + elapsed + (int64_t)elapsed * status.drift_ppb / 1000000000;
+}
+
+/**
+ * \brief Get the state of the mapping
+ *
+ * \param[out] status_out       where the state will be placed
+ *
+ * \return void
+ */
+void time_sync_get_status(time_sync_status_t *status_out)
+{
+    OS_MUTEX_GET(time_sync_mutex, OS_MUTEX_FOREVER);
+    *status_out = status;
+    OS_MUTEX_PUT(time_sync_mutex);
+}
+
+/**
+ * \brief Initialize the mapping, with the time not set. Must be called before any other time_sync API
+ *
+ * \return void
+ */
+void time_sync_init(void)
+{
+    STATIC_MUTEX_CREATE(time_sync_mutex, time_sync_mutex_storage);
+    memset(&status, 0, sizeof(status));
+    sync_utc_ms = 0;
+    sync_local_ms = 0;
+}
+
+/**
+ * \brief Get the local time base, in ms since boot. It is converted from time_sync_local_ticks(), so the
+ * result wraps at 2^32 ms like any uint32_t and differences across the wrap hold. Converting the 32 bit
+ * tick count itself would wrap wherever ticks * 1000 overflows.
+ *
+ * \return local time in ms since boot
+ */
+uint32_t time_sync_local_ms(void)
+{
+    // OS_MS_2_TICKS(1000) is the tick rate, dividing by it stays exact for rates that do not divide 1000
+    return (uint32_t)(time_sync_local_ticks() * 1000 / OS_MS_2_TICKS(1000));
+}
+
+/**
+ * \brief Get the OS tick count extended to 64 bits, which does not wrap. For spans longer than the 32 bit
+ * tick count or the ms time base can hold. Must be called at least once per wrap of the tick count, which
+ * every sample does through time_sync_local_ms().
+ *
+ * \return ticks since boot
+ */
+uint64_t time_sync_local_ticks(void)
+{
+    uint64_t ticks;
+
+    OS_ENTER_CRITICAL_SECTION();
+    OS_TICK_TIME now = OS_GET_TICK_COUNT();
+    if(now < last_tick)
+    {
+        tick_wraps++;
+    }
+    last_tick = now;
+    ticks = ((uint64_t)tick_wraps << 32) | now;
+    OS_LEAVE_CRITICAL_SECTION();
+
+    return ticks;
+}
+
+/**
+ * \brief Set the UTC time. If the previous setting is far enough back, the error of the mapping since
+ * then updates the drift estimate.
+ *
+ * \param[in] utc_ms            UTC time in ms since the Unix epoch
+ * \param[in] local_ms          time_sync_local_ms() at which utc_ms applies
+ *
+ * \return void
+ */
+void time_sync_set(uint64_t utc_ms, uint32_t local_ms)
+{
+    OS_MUTEX_GET(time_sync_mutex, OS_MUTEX_FOREVER);
+
+    uint32_t elapsed_local = local_ms - sync_local_ms;
+
+    if(status.synced && elapsed_local >= TIME_SYNC_MIN_INTERVAL_ms)
+    {
+        int64_t elapsed_utc = (int64_t)(utc_ms - sync_utc_ms);
+        int64_t drift_ppb = (elapsed_utc - elapsed_local) * 1000000000 / elapsed_local;
+
+        if(drift_ppb >= -TIME_SYNC_MAX_DRIFT_PPB && drift_ppb <= TIME_SYNC_MAX_DRIFT_PPB)
+        {
+            // The first estimate is taken as it is, the next ones are smoothed
+            if(status.drift_estimates == 0)
+            {
+                status.drift_ppb = (int32_t)drift_ppb;
+            }
+            else
+            {
+                status.drift_ppb += ((int32_t)drift_ppb - status.drift_ppb) >> TIME_SYNC_DRIFT_SMOOTHING_SHIFT;
+            }
+            status.drift_estimates++;
+        }
+    }
+
+    sync_utc_ms = utc_ms;
+    sync_local_ms = local_ms;
+    status.synced = true;
+    status.syncs++;
+
+    OS_MUTEX_PUT(time_sync_mutex);
+}
+
+/**
+ * \brief Map a local time, such as the time a sample was taken, to UTC
+ *
+ * \param[in] local_ms          local time from time_sync_local_ms()
+ * \param[out] utc_ms           UTC time in ms since the Unix epoch, 0 if the time is not set
+ *
+ * \return true if the time is set, false otherwise
+ */
+bool time_sync_to_utc(uint32_t local_ms, uint64_t *utc_ms)
+{
+    OS_MUTEX_GET(time_sync_mutex, OS_MUTEX_FOREVER);
+
+    bool synced = status.synced;
+
+    *utc_ms = synced ? to_utc(local_ms) : 0;
+
+    OS_MUTEX_PUT(time_sync_mutex);
+
+    return synced;
+}